@@ -22,6 +22,8 @@
 		-wind noise presets for resonant filters
 		-realtime reverb
 		-echo filter
+		-chorus and flanger
+		-multi-tap delay and early reflections
 		-randomization settings
 		-filter presets
 
@@ -33,6 +35,28 @@
 		1.4		(02/26/2020)	added echo filter plugin
 		1.5		(05/24/2021)	added noise generator plugin
 		1.6		(05/29/2021)	added resonance to the lowpass filter plugin
+		1.7		(10/18/2026)	added voice plugin, session capture and offline replay
+		1.8		(10/18/2026)	added render cache for voices with static effect parameters
+		1.9		(10/18/2026)	added shared feedback delay network reverb with per voice sends
+		1.10	(10/18/2026)	added effect buses shared by many voices
+		1.11	(10/18/2026)	added partitioned FFT convolution with impulse responses
+		1.12	(10/18/2026)	added 4th and 8th order Butterworth and Linkwitz-Riley lowpass and highpass filters
+		1.13	(10/18/2026)	added zero delay feedback state variable filter with per sample cutoff modulation
+		1.14	(10/18/2026)	added wind generator with gust modulated resonant bandpass filters and presets
+		1.15	(10/18/2026)	added pink, brown and velvet noise colors to the noise generator
+		1.16	(10/18/2026)	noise made by a counter based hash, keyed per voice and channel
+		1.17	(10/18/2026)	added randomization ranges applied from precomputed tables when voices spawn
+		1.18	(10/18/2026)	added binary preset banks with precomputed coefficients, used in place
+		1.19	(10/18/2026)	added quality tiers per voice, set by hand or from the loudness and priority of the voice
+		1.20	(10/18/2026)	added a governor lowering the quality tier of the least audible voices to meet a CPU budget
+		1.21	(10/18/2026)	voices with a low lowpass cutoff run their filters at 1/2 or 1/4 of the sampling rate
+		1.22	(10/18/2026)	added chorus and flanger plugin reading a modulated delay line with up to 4 taps at once
+		1.23	(10/18/2026)	added multi-tap delays reading many damped taps of one delay line, for early reflections
+		1.24	(10/18/2026)	lowpass, highpass, echo mix and feedback, and noise gain changes are ramped across a block
+		1.25	(10/18/2026)	lowpass and highpass filters share reference counted coefficients keyed by their rounded parameters
+		1.26	(10/18/2026)	added named filter groups whose lowpass and highpass are set once for every member voice
+		1.27	(10/18/2026)	added setters and getters over arrays of playing sounds, sharing cache locks and lookups
+		1.28	(10/18/2026)	added CUTE_DSP_FAST_MATH, polynomial approximations of sin, cos and the dB conversions
 */
 #ifndef CUTE_SOUND_H
 #	error Please include cute_sound.h before including cute_dsp.h.
@@ -59,11 +83,29 @@ cs_plugin_interface_t cd_make_highpass_plugin();
 */
 cs_plugin_interface_t cd_make_echo_plugin();
 
+/*
+	Helper function to create a plugin interface for the chorus.
+	Called internally, but exposed for use if needed.
+*/
+cs_plugin_interface_t cd_make_chorus_plugin();
+
 /*
 	Helper function to create a plugin interface for the noise generator.
 	Called internally, but exposed for use if needed.
 */
 cs_plugin_interface_t cd_make_noise_plugin();
+
+/*
+	Helper function to create the plugin interface that keeps track of every playing sound.
+	Registered before all the filters. Called internally, but exposed for use if needed.
+*/
+cs_plugin_interface_t cd_make_voice_plugin();
+
+/*
+	Helper function to create the plugin interface that feeds every voice into the buses
+	and applies its dry gain. Registered after all the filters. Called internally, but exposed for use if needed.
+*/
+cs_plugin_interface_t cd_make_bus_send_plugin();
 /* END PLUGIN INTERFACE FUNCTIONS */
 
 /* BEGIN FORWARD DECLARATIONS */
@@ -77,6 +119,9 @@ typedef struct cd_context_t cd_context_t;
 /*
 	cute_dsp lowpass filter type. 
 	Implemented using a second order (6dB/Octave roll off) Butterworth filter with resonance.
+	Contexts can instead make 4th and 8th order filters, and Linkwitz-Riley filters,
+		from cascaded biquad sections, see filter_order in cd_context_def_t.
+	Parameter changes are ramped across the next block, see cd_set_lowpass_parameters.
 */
 struct cd_lowpass_t;
 typedef struct cd_lowpass_t cd_lowpass_t;
@@ -85,10 +130,24 @@ typedef struct cd_lowpass_t cd_lowpass_t;
 	cute_dsp highpass filter type
 	Implemented using a second order (6dB/Octave roll off) Butterworth filter
 		converted from the second order Butterworth lowpass transfer function.
+	Higher orders are cascaded biquad sections, like the lowpass filter.
 */
 struct cd_highpass_t;
 typedef struct cd_highpass_t cd_highpass_t;
 
+/*
+	cute_dsp state variable filter type
+	Implemented using a topology preserving (zero delay feedback) state variable filter,
+	which computes its lowpass, bandpass and highpass outputs together and stays stable
+	when its cutoff changes every sample.
+	Designable parameters:
+		cutoff    - cutoff frequency in hz, optionally modulated per sample
+		resonance - boost around the cutoff, between 0 and 1
+		mix       - gains of the lowpass, bandpass and highpass outputs
+*/
+struct cd_svf_t;
+typedef struct cd_svf_t cd_svf_t;
+
 /*
 	cute_dsp echo filter type
 	Implemented using a ring buffer.
@@ -100,24 +159,163 @@ typedef struct cd_highpass_t cd_highpass_t;
 struct cd_echo_t;
 typedef struct cd_echo_t cd_echo_t;
 
+/*
+	cute_dsp chorus type
+	Implemented using a ring buffer read by up to 4 taps at once, one per lane of an SSE register,
+	at delays swept around the center by a sine LFO with the taps spread evenly over its cycle.
+	Delays of 10 to 30ms make a chorus, delays under 5ms with feedback make a flanger.
+	Designable parameters:
+		delay    - center delay time in seconds
+		depth    - how far the delay swings on either side of the center, in seconds
+		rate     - frequency of the LFO in hz
+		mix      - mix factor of the loudness of the taps
+		feedback - amount of the taps fed back into the ring buffer
+		taps     - number of delayed copies, between 1 and 4
+*/
+struct cd_chorus_t;
+typedef struct cd_chorus_t cd_chorus_t;
+
 /*
 	cute_dsp noise generator type
-	Implemented using white noise generated by 
-	an xorshift128 PRNG.
+	Implemented using white noise generated by hashing
+	the index of every sample with a key of the generator,
+	4 samples at a time in the lanes of an SSE register.
+	Pink, brown and velvet noise are filtered from it.
 	Designable parameters:
 		amplitude_db   - mix of the noise in decibels. keeps gain updated.
 		amplitude_gain - mix of the noise in linear gain. keeps db updated.
+		color          - spectrum of the noise, see cd_noise_color_t.
 */
 struct cd_noise_t;
 typedef struct cd_noise_t cd_noise_t;
 
+/*
+	cute_dsp wind type
+	Implemented using a table of white noise shared by every wind of the context, read at a
+	different position by each one, through two resonant bandpass state variable filters whose
+	cutoff and loudness follow a pair of gust LFOs evaluated once per block.
+	Designable parameters, see cd_wind_def_t and cd_get_wind_preset.
+*/
+struct cd_wind_t;
+typedef struct cd_wind_t cd_wind_t;
+
+/*
+	cute_dsp reverb type
+	Implemented using a feedback delay network of 8 delay lines processed 4 at a time with SSE,
+	mixed through a Hadamard matrix with a damping lowpass in every line.
+	Designable parameters:
+		decay   - time in seconds for the tail to fall by 60dB
+		damping - how much faster the high frequencies decay, between 0 and 1
+*/
+struct cd_reverb_t;
+typedef struct cd_reverb_t cd_reverb_t;
+
+/*
+	cute_dsp impulse response type
+	An impulse response split into partitions that grow 4x in size along the response,
+	each transformed into its spectrum once, when the impulse response is made.
+	Shared by every convolver made from it.
+*/
+struct cd_impulse_response_t;
+typedef struct cd_impulse_response_t cd_impulse_response_t;
+
+/*
+	cute_dsp convolver type
+	Convolves a channel with an impulse response using overlap-save FFTs over the partitions
+	of the impulse response, with a frequency domain delay line per partition size.
+	The output is delayed by CUTE_DSP_CONVOLUTION_BLOCK frames, whatever the length of the response.
+*/
+struct cd_convolver_t;
+typedef struct cd_convolver_t cd_convolver_t;
+
+/*
+	cute_dsp tap set type
+	The delays, gains and damping of a set of taps, e.g. the early reflections of a room,
+	turned into whole sample offsets, interpolation weights and filter coefficients once.
+	Shared by every multi-tap delay made from it.
+*/
+struct cd_tap_set_t;
+typedef struct cd_tap_set_t cd_tap_set_t;
+
+/*
+	cute_dsp multi-tap delay type
+	Writes a channel into one delay line and reads every tap of a tap set from it,
+	each with its own delay, gain and one pole lowpass damping.
+*/
+struct cd_multitap_t;
+typedef struct cd_multitap_t cd_multitap_t;
+
+/*
+	cute_dsp preset bank type
+	A view of a binary file of named presets, sorted by name, with the filter coefficients of
+	every preset precomputed for each of its sampling rates. Read in place, e.g. memory mapped.
+*/
+struct cd_preset_bank_t;
+typedef struct cd_preset_bank_t cd_preset_bank_t;
+
+/*
+	cute_dsp bus type
+	Sums the voices sent to it and runs its own lowpass, highpass, echo, early reflections, convolution and reverb
+	once per block for all of them, instead of once per voice.
+*/
+struct cd_bus_t;
+typedef struct cd_bus_t cd_bus_t;
+
+/*
+	cute_dsp filter group type
+	Holds the lowpass and highpass parameters of a category of voices, set once for all of them.
+*/
+struct cd_filter_group_t;
+typedef struct cd_filter_group_t cd_filter_group_t;
+
 #define CUTE_DSP_MAX_FRAME_LENGTH (4096)
 #define CUTE_DSP_DEFAULT_ECHO_MAX_DELAY (0.5f)
+#define CUTE_DSP_CHORUS_MAX_DELAY (0.05f)	// of the center delay plus the depth, in seconds
+#define CUTE_DSP_CHORUS_MAX_TAPS (4)
 #define CUTE_DSP_NOISE_INAUDIBLE (-96.f)
+#define CUTE_DSP_BROWN_NOISE_CUTOFF (20.f)
+#define CUTE_DSP_VELVET_NOISE_DENSITY (2000.f)
+#define CUTE_DSP_DEFAULT_REVERB_DECAY (1.5f)
+#define CUTE_DSP_DEFAULT_REVERB_DAMPING (0.3f)
+#define CUTE_DSP_MAX_BUSES (8)
+#define CUTE_DSP_MAX_BUS_NAME (32)
+#define CUTE_DSP_MAX_FILTER_GROUPS (16)
+#define CUTE_DSP_MAX_FILTER_GROUP_NAME (32)
+#define CUTE_DSP_MAX_RANDOMIZATIONS (64)
+#define CUTE_DSP_RANDOMIZATION_STEPS (64)	// values of a cutoff or noise range, see cd_set_randomization
+#define CUTE_DSP_RESONANCE_STEPS (8)
+#define CUTE_DSP_MAX_PRESET_NAME (32)
+#define CUTE_DSP_QUALITY_REDUCED_DB (-36.f)	// auto tier voices below this loudness plus priority, in dBFS, are reduced
+#define CUTE_DSP_QUALITY_MINIMAL_DB (-60.f)
+#define CUTE_DSP_QUALITY_HYSTERESIS_DB (3.f)	// voices go back up a tier this far above its threshold
+#define CUTE_DSP_QUALITY_RELEASE_DB (0.5f)	// per mix block, the loudness estimate falls at most this fast
+#define CUTE_DSP_GOVERNOR_STEP_DB (6.f)	// per mix block over budget, the governor degrades voices this much louder
+#define CUTE_DSP_GOVERNOR_RELEASE_DB (1.f)	// per mix block with headroom, it restores them this much quieter
+#define CUTE_DSP_GOVERNOR_HEADROOM (0.75f)	// of the budget, below which voices are restored
+#define CUTE_DSP_GOVERNOR_SPAN_DB (12.f)	// voices up to this far above the minimal ones are reduced
+#define CUTE_DSP_MULTIRATE_BANDWIDTH (0.45f)	// of the reduced Nyquist frequency, that the lowpass and highpass cutoffs must be below
+#define CUTE_DSP_MULTIRATE_HYSTERESIS (0.8f)	// of the bandwidth, the cutoffs must fall below to lower the rate
+#define CUTE_DSP_CONVOLUTION_BLOCK (128)	// smallest partition of impulse responses, in frames
 
 /* END FORWARD DECLARATIONS */
 
 /* BEGIN DSP CONTEXT API */
+// pole layout of the cascaded lowpass and highpass filters
+typedef enum cd_filter_alignment_t
+{
+	CD_FILTER_BUTTERWORTH,	// flattest passband, -3dB at the cutoff
+	CD_FILTER_LINKWITZ_RILEY,	// two Butterworth filters of half the order, -6dB at the cutoff, lowpass and highpass sum flat
+} cd_filter_alignment_t;
+
+// how much of the lowpass, highpass, echo and noise processing a voice gets, see cd_set_quality_tier
+typedef enum cd_quality_tier_t
+{
+	CD_TIER_FULL,	// every filter as designed
+	CD_TIER_REDUCED,	// one biquad section instead of the cascade of a higher filter order, echo delays rounded to whole samples, one chorus tap
+	CD_TIER_MINIMAL,	// the filters are skipped, only the dry gain and bus sends of the voice apply
+	CD_TIER_AUTO,	// picked every mix block from the loudness and priority of the voice
+	CD_TIER_COUNT = CD_TIER_AUTO
+} cd_quality_tier_t;
 
 typedef struct cd_context_def_t
 {
@@ -131,15 +329,25 @@ typedef struct cd_context_def_t
 		unsigned int use_highpass : 1;
 		unsigned int use_echo : 1;
 		unsigned int use_noise : 1;
+		unsigned int use_reverb : 1;	// adds a bus named "reverb" with only a reverb, see cd_get_reverb_return
+		unsigned int use_chorus : 1;
 	};
 
 	// optional parameters
 	float echo_max_delay_s;	// set to 0 to use default of 0.5s
 	size_t rand_seed;
+	size_t render_cache_bytes;	// memory budget of the render cache, set to 0 to disable it
+	unsigned filter_order;	// 2, 4 or 8 for a 12, 24 or 48dB per octave lowpass and highpass, set to 0 to use default of 2
+	cd_filter_alignment_t filter_alignment;
+	cd_quality_tier_t quality_tier;	// of voices when they spawn, CD_TIER_FULL by default
+	float cpu_budget;	// fraction of each mix block's duration the plugins may take, see cd_set_cpu_budget, 0 disables
+	unsigned multirate_limit;	// of voices when they spawn, see cd_set_multirate_limit, 0 or 1 disables
 } cd_context_def_t;
 
 /*
 	Allocatees the singleton dsp context that manages memory for all the filters.
+	Passing a NULL sound_ctx makes a detached context that registers no plugins
+	and doesn't replace the singleton, for driving the cd_sample_* functions offline.
 */
 cd_context_t* cd_make_context(cs_context_t* sound_ctx, cd_context_def_t def);
 
@@ -191,6 +399,17 @@ void cd_set_lowpass_resonance(cs_playing_sound_t* playing_sound, float resonance
 */
 float cd_get_lowpass_resonance(const cs_playing_sound_t* playing_sound);
 
+/*
+	Sets the cutoff frequency and resonance of a single lowpass filter, and updates its coefficients.
+	Out of range parameters are ignored, same as cd_set_lowpass_cutoff.
+	Coefficients are shared by every filter of the context with the same cutoff rounded to 0.01Hz,
+	resonance rounded to 0.001 and sampling rate, so only the first filter of a design computes it.
+	The new coefficients are targets: the next block ramps from the last ones to them linearly, sample
+	by sample, so a sweep set once per block doesn't zipper and costs no trig in the mix. Changes made
+	before the first block apply at once. The same goes for the highpass, echo mix and feedback, and noise gain.
+*/
+void cd_set_lowpass_parameters(cd_lowpass_t* filter, float cutoff_freq_in_hz, float resonance);
+
 /*
 	Processes the next audio frame using the given lowpass filter.
 */
@@ -213,7 +432,7 @@ void cd_release_highpass(cd_context_t* context, cd_highpass_t** filter);
 /*
 	Sets the cutoff frequency in a highpass filter, and updates the filter coefficients.
 	Cutoff frequency parameter is in samples per second.
-	Calls cd_set_highpass_cutoff_frequency_radians with the converted value
+	The coefficients are shared and ramped to across the next block, like cd_set_lowpass_parameters.
 */
 void cd_set_highpass_cutoff_frequency(cd_highpass_t* filter, float cutoff_freq_in_hz);
 
@@ -241,6 +460,48 @@ void cd_sample_highpass(cd_context_t* context, cd_highpass_t* filter, const floa
 
 /* END HIGHPASS FILTER API */
 
+/* BEGIN STATE VARIABLE FILTER API */
+/*
+	Constructs a state variable filter. Dynamically allocated, it is not part of the playing sounds.
+	Initialized as a lowpass filter with cutoff frequency 20000Hz and no resonance.
+*/
+cd_svf_t* cd_make_svf(cd_context_t* context);
+
+/*
+	Releases memory of the state variable filter and sets to NULL.
+*/
+void cd_release_svf(cd_context_t* context, cd_svf_t** filter);
+
+/*
+	Sets the cutoff frequency and resonance, and updates the filter coefficients.
+	Resonance is in the range of [0, 1], and moves the poles like the lowpass filter's resonance.
+	Out of range parameters are ignored, same as cd_set_lowpass_parameters.
+*/
+void cd_set_svf_parameters(cd_svf_t* filter, float cutoff_freq_in_hz, float resonance);
+
+/*
+	Sets the gains of the three outputs summed into the output of the filter.
+	(1, 0, 0) is a lowpass, (0, 1, 0) a bandpass, (0, 0, 1) a highpass and (1, 0, 1) a notch filter.
+*/
+void cd_set_svf_mix(cd_svf_t* filter, float lowpass, float bandpass, float highpass);
+
+/*
+	Gets the cutoff frequency in hz and the resonance set by cd_set_svf_parameters.
+*/
+float cd_get_svf_cutoff(const cd_svf_t* filter);
+float cd_get_svf_resonance(const cd_svf_t* filter);
+
+/*
+	Processes the next audio frame with the given state variable filter.
+	@param cutoff_in_hz
+		Optional cutoff of every sample, NULL to use the cutoff set by cd_set_svf_parameters.
+		Each sample costs one tangent approximation and one division instead of the sine and division
+		of cd_set_lowpass_parameters, and is clamped to [20Hz, 0.45 * sampling rate].
+*/
+void cd_sample_svf(cd_context_t* context, cd_svf_t* filter, const float* input, const float* cutoff_in_hz, float** output, unsigned num_samples);
+
+/* END STATE VARIABLE FILTER API */
+
 /* BEGIN ECHO FILTER API */
 /*
 	Constructs an echo filter from the dsp context's memory pool.
@@ -266,7 +527,7 @@ void cd_set_echo_delay(cs_playing_sound_t* playing_sound, float t);
 
 /*
 	Sets the mix factor of the echo filter.
-	Effectively is the loudness of the delayed samples.
+	Effectively is the loudness of the delayed samples. Ramped to across the next block.
 	@param a
 		Delay mix factor. Generally between 0 and 1.
 */
@@ -274,7 +535,7 @@ void cd_set_echo_mix(cs_playing_sound_t* playing_sound, float a);
 
 /*
 	Sets the feedback factor of the echo filter.
-	Effectively is the amount that the echoes will echo on themselves.
+	Effectively is the amount that the echoes will echo on themselves. Ramped to across the next block.
 	@param b
 		Feedback factor. Generally between 0 and 1.
 */
@@ -304,6 +565,12 @@ float cd_get_echo_mix(const cs_playing_sound_t* playing_sound);
 */
 float cd_get_echo_feedback(const cs_playing_sound_t* playing_sound);
 
+/*
+	Sets the delay time, mix and feedback factor of an echo filter and the filters chained after it.
+	A delay longer than the max delay is ignored.
+*/
+void cd_set_echo_parameters(cd_echo_t* filter, float t, float a, float b);
+
 /*
 	Processes the next audio frame with the given echo filter.
 */
@@ -311,7 +578,224 @@ void cd_sample_echo(cd_context_t* context, cd_echo_t* filter, const float* input
 
 /* END ECHO FILTER API */
 
+/* BEGIN CHORUS API */
+/*
+	Constructs a chorus from the dsp context's memory pool.
+	Its ring buffer is part of the pool object, so making one never allocates
+		while the pool has room.
+*/
+cd_chorus_t* cd_make_chorus(cd_context_t* context);
+
+/*
+	Adds the chorus and its ring buffer back to the context memory pool.
+*/
+void cd_release_chorus(cd_context_t* context, cd_chorus_t** filter);
+
+/*
+	Sets the center delay time of the chorus.
+	The delay plus the depth is limited by CUTE_DSP_CHORUS_MAX_DELAY.
+	@param t
+		Delay time in seconds.
+*/
+void cd_set_chorus_delay(cs_playing_sound_t* playing_sound, float t);
+
+/*
+	Sets how far the delay of the chorus swings on either side of its center.
+	The delay plus the depth is limited by CUTE_DSP_CHORUS_MAX_DELAY.
+	@param t
+		Depth in seconds.
+*/
+void cd_set_chorus_depth(cs_playing_sound_t* playing_sound, float t);
+
+/*
+	Sets the frequency of the LFO sweeping the delay of the chorus.
+	@param hz
+		Frequency in hz. Generally between 0.1 and 5.
+*/
+void cd_set_chorus_rate(cs_playing_sound_t* playing_sound, float hz);
+
+/*
+	Sets the mix factor of the chorus.
+	Effectively is the loudness of the delayed taps.
+	@param a
+		Mix factor. Generally between 0 and 1.
+*/
+void cd_set_chorus_mix(cs_playing_sound_t* playing_sound, float a);
+
+/*
+	Sets the feedback factor of the chorus.
+	Effectively is the strength of the flanging resonances.
+	@param b
+		Feedback factor. Between -1 and 1, exclusive.
+*/
+void cd_set_chorus_feedback(cs_playing_sound_t* playing_sound, float b);
+
+/*
+	Sets the number of delayed copies of the chorus, spread evenly over the cycle of its LFO.
+	Every tap count costs about the same.
+	@param taps
+		Between 1 and CUTE_DSP_CHORUS_MAX_TAPS.
+*/
+void cd_set_chorus_taps(cs_playing_sound_t* playing_sound, unsigned taps);
+
+/*
+	@return
+		Retrieves the max delay plus depth of choruses, in seconds.
+*/
+float cd_get_chorus_max_delay(const cs_playing_sound_t* playing_sound);
+
+/*
+	@return
+		Retrieves the center delay time of the chorus in seconds.
+*/
+float cd_get_chorus_delay(const cs_playing_sound_t* playing_sound);
+
+/*
+	@return
+		Retrieves the depth of the chorus in seconds.
+*/
+float cd_get_chorus_depth(const cs_playing_sound_t* playing_sound);
+
+/*
+	@return
+		Retrieves the frequency of the chorus LFO in hz.
+*/
+float cd_get_chorus_rate(const cs_playing_sound_t* playing_sound);
+
+/*
+	@return
+		Retrieves the chorus's mix factor.
+*/
+float cd_get_chorus_mix(const cs_playing_sound_t* playing_sound);
+
+/*
+	@return
+		Retrieves the chorus's feedback factor.
+*/
+float cd_get_chorus_feedback(const cs_playing_sound_t* playing_sound);
+
+/*
+	@return
+		Retrieves the number of taps of the chorus.
+*/
+unsigned cd_get_chorus_taps(const cs_playing_sound_t* playing_sound);
+
+/*
+	Sets the delay time, depth, rate, mix, feedback and tap count of a chorus and the choruses chained after it.
+	A delay plus depth longer than CUTE_DSP_CHORUS_MAX_DELAY is ignored.
+*/
+void cd_set_chorus_parameters(cd_chorus_t* filter, float t, float depth, float hz, float a, float b, unsigned taps);
+
+/*
+	Processes the next audio frame with the given chorus.
+*/
+void cd_sample_chorus(cd_context_t* context, cd_chorus_t* filter, const float* input, float** output, unsigned num_samples);
+
+/* END CHORUS API */
+
+/* BEGIN CONVOLUTION API */
+/*
+	Splits an impulse response into partitions and transforms them into spectra.
+	Slow, call at load time. The samples are copied and can be freed afterwards.
+	The impulse response must be at the sampling rate of the context.
+	@param channels
+		One or two channels of frame_count samples. Mono impulse responses are used for both channels.
+*/
+cd_impulse_response_t* cd_make_impulse_response(cd_context_t* context, const float* const* channels, int channel_count, unsigned frame_count);
+
+/*
+	Releases memory of the impulse response and sets to NULL.
+	Every convolver made from it must be released first.
+*/
+void cd_release_impulse_response(cd_context_t* context, cd_impulse_response_t** impulse_response);
+
+/*
+	@return
+		Retrieves the length of the impulse response in seconds.
+*/
+float cd_get_impulse_response_length(const cd_impulse_response_t* impulse_response);
+
+/*
+	Constructs a convolver with one channel of the impulse response.
+	Its delay lines are dynamically allocated and sized for the impulse response.
+	@param channel_index
+		Channel of the impulse response, 1 uses the first channel of mono impulse responses.
+*/
+cd_convolver_t* cd_make_convolver(cd_context_t* context, const cd_impulse_response_t* impulse_response, int channel_index);
+
+/*
+	Releases memory of the convolver and sets to NULL.
+*/
+void cd_release_convolver(cd_context_t* context, cd_convolver_t** filter);
+
+/*
+	Processes the next audio frame with the given convolver.
+	The output is only the convolved signal, without the dry input.
+	Long impulse responses do most of their work on the blocks where their largest partitions fill up.
+*/
+void cd_sample_convolver(cd_context_t* context, cd_convolver_t* filter, const float* input, float** output, unsigned num_samples);
+
+/* END CONVOLUTION API */
+
+/* BEGIN MULTI-TAP DELAY API */
+typedef struct cd_tap_def_t
+{
+	float delay;	// in seconds, fractions of a sample are interpolated
+	float gains[2];	// linear, of the first and second channel, so a mono input can come back from both sides
+	float damping_hz;	// cutoff of a one pole lowpass on the tap, e.g. for absorbing walls, 0 for none
+} cd_tap_def_t;
+
+/*
+	Prepares a set of taps, e.g. precomputed early reflections of a room.
+	Call at load time, the tap definitions are copied and can be freed afterwards.
+	@param taps
+		tap_count tap definitions, in any order. Typically 8 to 32 of them.
+*/
+cd_tap_set_t* cd_make_tap_set(cd_context_t* context, const cd_tap_def_t* taps, int tap_count);
+
+/*
+	Releases memory of the tap set and sets to NULL.
+	Every multi-tap delay made from it must be released first.
+*/
+void cd_release_tap_set(cd_context_t* context, cd_tap_set_t** tap_set);
+
+/*
+	@return
+		Retrieves the longest delay of the tap set in seconds.
+*/
+float cd_get_tap_set_length(const cd_tap_set_t* tap_set);
+
+/*
+	Constructs a multi-tap delay reading the taps of the tap set.
+	Its delay line is dynamically allocated and sized for the longest tap.
+	@param channel_index
+		Picks the gains of the taps used by this delay.
+*/
+cd_multitap_t* cd_make_multitap(cd_context_t* context, const cd_tap_set_t* tap_set, int channel_index);
+
+/*
+	Releases memory of the multi-tap delay and sets to NULL.
+*/
+void cd_release_multitap(cd_context_t* context, cd_multitap_t** filter);
+
+/*
+	Processes the next audio frame with the given multi-tap delay.
+	The output is the sum of the taps only, add a tap with a delay of 0 to keep the dry input.
+*/
+void cd_sample_multitap(cd_context_t* context, cd_multitap_t* filter, const float* input, float** output, unsigned num_samples);
+
+/* END MULTI-TAP DELAY API */
+
 /* BEGIN NOISE GENERATOR API */
+// every color has about the same rms as the white noise
+typedef enum cd_noise_color_t
+{
+	CD_NOISE_WHITE,	// flat spectrum
+	CD_NOISE_PINK,	// -3dB per octave, Voss-McCartney with 16 rows
+	CD_NOISE_BROWN,	// -6dB per octave, leaky integration of white noise above 20Hz
+	CD_NOISE_VELVET,	// 2000 impulses per second of random sign, at random places, decorrelates cheaply
+} cd_noise_color_t;
+
 /*
 	Constructs a noise generator filter from the dsp context's memory pool.
 	Initialized with an amplitude of 0 gain so its effects are inaudible
@@ -326,6 +810,7 @@ void cd_release_noise(cd_context_t* context, cd_noise_t** filter);
 
 /*
 	Fetches noise generator from playing sound and sets noise amplitude in decibels.
+	The gain is ramped to across the next block.
 */
 void cd_set_noise_amplitude_db(cs_playing_sound_t* playing_sound, float db);
 
@@ -344,1163 +829,8415 @@ float cd_get_noise_amplitude_db(const cs_playing_sound_t* playing_sound);
 */
 float cd_get_noise_amplitude_gain(const cs_playing_sound_t* playing_sound);
 
+/*
+	Sets the noise amplitude in decibels of a noise generator and the generators chained after it.
+*/
+void cd_set_noise_generator_amplitude_db(cd_noise_t* filter, float db);
+
+/*
+	Fetches noise generator from playing sound and sets the color of its noise.
+*/
+void cd_set_noise_color(cs_playing_sound_t* playing_sound, cd_noise_color_t color);
+
+/*
+	Gets the color of the noise.
+*/
+cd_noise_color_t cd_get_noise_color(const cs_playing_sound_t* playing_sound);
+
+/*
+	Sets the color of a noise generator and the generators chained after it.
+*/
+void cd_set_noise_generator_color(cd_noise_t* filter, cd_noise_color_t color);
+
+/*
+	Keys the noise of a generator and the generators chained after it, which take the channels after
+	the given one, and restarts them at the first sample of their stream. Sample n of a stream is a hash
+	of n and a key made from the context's rand_seed, the stream and the channel, so it doesn't depend on
+	what else is playing, or on the order or thread the generators run on.
+	The noise plugin uses the id of the voice as the stream. Generators made directly are on stream 0,
+	each on a channel of its own.
+*/
+void cd_set_noise_generator_stream(cd_context_t* context, cd_noise_t* filter, unsigned stream, unsigned channel);
+
+/*
+	Moves a noise generator and the generators chained after it to the given sample of their stream.
+	White noise carries on exactly as if the samples before it were made, the colors restart their filters.
+*/
+void cd_seek_noise_generator(cd_noise_t* filter, unsigned position);
+
 /*
 	Processes the next audio frame with the given noise generator
 */
 void cd_sample_noise(cd_context_t* context, cd_noise_t* filter, const float* input, float** output, unsigned num_samples);
 
 /* END NOISE GENERATOR API */
-#define CUTE_DSP_H
-#endif
-/* END HEADER SECTION */
-/**********************************************************************************************/
 
-/**********************************************************************************************/
-/* BEGIN IMPLEMENTATION SECTION */
-#ifdef CUTE_DSP_IMPLEMENTATION
-#ifndef CUTE_DSP_IMPLEMENTATION_ONCE
-#define CUTE_DSP_IMPLEMENTATION_ONCE
+/* BEGIN WIND API */
+typedef enum cd_wind_preset_t
+{
+	CD_WIND_BREEZE,	// soft, slow gusts of low rumble
+	CD_WIND_GALE,	// loud, fast gusts over a wide band
+	CD_WIND_HOWLING,	// gusts through a whistling resonance
+} cd_wind_preset_t;
 
-/* HELPER MACROS */
-#if !defined(CUTE_DSP_ALLOC)
-	#include <stdlib.h> // malloc, free
-	#include <string.h> // memcpy, memset
-	#define CUTE_DSP_ALLOC(size, mem_ctx) malloc(size)
-	#define CUTE_DSP_FREE(mem, mem_ctx)   free(mem)
-#endif
+typedef struct cd_wind_def_t
+{
+	float amplitude_db;	// rms loudness at the peak of a gust
+	float cutoff;	// center of the bandpass in hz, halfway up a gust
+	float resonance;	// [0, 1], same as the lowpass filter, 1 is taken just below it
+	float cutoff_depth;	// octaves gusts move the cutoffs by
+	float gust_depth;	// [0, 1], how much quieter the wind is between gusts
+	float gust_rate;	// gusts per second
+	float whistle_gain;	// loudness of the second bandpass relative to the first, 0 to skip it
+	float whistle_cutoff;	// in hz, moved by the gusts like the cutoff
+	float whistle_resonance;	// [0, 1], close to 1 for a tone, 1 is taken just below it
+} cd_wind_def_t;
 
-#define CUTE_DSP_ASSERT_INTERNAL *(int*)0 = 0
-#define CUTE_DSP_ASSERT(X) do { if(!(X)) CUTE_DSP_ASSERT_INTERNAL; } while (0)
+/*
+	@return
+		The parameters of one of the built in kinds of wind, to use as is or as a starting point.
+*/
+cd_wind_def_t cd_get_wind_preset(cd_wind_preset_t preset);
 
-#if !defined(CUTE_DSP_MATH)
-	#include <math.h> // sinf, cosf, absf, atan2f
-	#define CUTE_DSP_MATH
-	#define CUTE_DSP_SIN(angle_rad) (sinf(angle_rad))
-	#define CUTE_DSP_COS(angle_rad) (cosf(angle_rad))
-	#define CUTE_DSP_ABS(val)       (fabsf(val))
-	#define CUTE_DSP_PI				(3.1415926f)
-	#define CUTE_DSP_SQRT_2 		(1.4142136f)
-	#define CUTE_DSP_CLAMP(val, least, most) ( (val) < (least) ? (least) : ( (val) > (most) ? (most) : (val) ) )
-	#define CUTE_DSP_LERP_FLOAT(start, end, factor) ((start) + (factor) * ((end) - (start)))
+/*
+	Constructs a wind. Dynamically allocated, it is not part of the playing sounds.
+	The first wind of a context also makes the noise shared by every wind, 256KB at most sampling rates.
+	Each wind starts at a random position of the shared noise and of its gusts, so winds with the same
+	parameters don't sound alike.
+*/
+cd_wind_t* cd_make_wind(cd_context_t* context, cd_wind_def_t def);
 
-	/* more here */
-#endif
+/*
+	Releases memory of the wind and sets to NULL. The shared noise lives until the context is released.
+*/
+void cd_release_wind(cd_context_t* context, cd_wind_t** wind);
 
-#if !defined(CUTE_DSP_DEFINES)
-	#define CUTE_DSP_DEFINES
-	#define CUTE_DSP_MONO (1)
-	#define CUTE_DSP_STEREO (2)
-	#define CUTE_DSP_INVALID_PLUGIN_ID (-1)
+/*
+	Sets the parameters of the wind, which take effect on the next block.
+	Cutoffs are limited to [20, 20,000] Hz and resonances to [0, 1].
+*/
+void cd_set_wind_parameters(cd_wind_t* wind, cd_wind_def_t def);
 
-	// default cutoff frequencies for LPF and HPF chosen 
-	// such that their effect is inaudible (at the edges of human hearing)
-	// unless changed
-	#define CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF (20.0f)
-	#define CUTE_DSP_DEFAULT_LOWPASS_CUTOFF  (20000.0f)
+/*
+	Gets the parameters of the wind.
+*/
+cd_wind_def_t cd_get_wind_parameters(const cd_wind_t* wind);
 
-	// rand max
-	#define CUTE_DSP_PRNG_MAX ((size_t)(-1))
+/*
+	Processes the next audio frame with the given wind, adding it to the input like the noise generator.
+	@param input
+		Samples the wind is added to, NULL for the wind alone.
+*/
+void cd_sample_wind(cd_context_t* context, cd_wind_t* wind, const float* input, float** output, unsigned num_samples);
 
-	#define CUTE_DSP_DB_TO_GAIN(db) (powf(10, db / 20.f))
-	#define CUTE_DSP_GAIN_TO_DB(gain) (20.f * log10f(gain))
-#endif
+/* END WIND API */
+
+/* BEGIN REVERB API */
+/*
+	Constructs a stereo reverb with the default decay and damping.
+	The delay lines are dynamically allocated and sized for the context's sampling rate.
+*/
+cd_reverb_t* cd_make_reverb(cd_context_t* context);
+
+/*
+	Releases memory of the reverb and sets to NULL.
+*/
+void cd_release_reverb(cd_context_t* context, cd_reverb_t** reverb);
+
+/*
+	Sets the decay time and damping of a reverb.
+	Safe to call from the game thread, the new gains are worked out on the next sample call.
+	@param decay_s
+		Time in seconds for the tail to fall by 60dB. Limited to [0.1, 30].
+	@param damping
+		0 decays every frequency evenly, 1 makes the tail very dark. Limited to [0, 1].
+*/
+void cd_set_reverb_parameters(cd_reverb_t* reverb, float decay_s, float damping);
+
+/*
+	@return
+		Retrieves the decay time of the reverb in seconds.
+*/
+float cd_get_reverb_decay(const cd_reverb_t* reverb);
+
+/*
+	@return
+		Retrieves the damping of the reverb.
+*/
+float cd_get_reverb_damping(const cd_reverb_t* reverb);
+
+/*
+	Processes the next stereo audio frame with the given reverb.
+	The output is only the reverberated signal, without the dry input.
+	out_left and out_right point to the two halves of the same context output buffer.
+*/
+void cd_sample_reverb(cd_context_t* context, cd_reverb_t* reverb, const float* left, const float* right, float** out_left, float** out_right, unsigned num_samples);
+
+/*
+	Sets how much of a playing sound is sent to the shared reverb, after all of its filters.
+	Requires use_reverb in the context definition. Voices start with a send of 0.
+	Same as cd_set_bus_send with the "reverb" bus.
+	@param send
+		Linear gain of the send. Generally between 0 and 1.
+*/
+void cd_set_reverb_send(cs_playing_sound_t* playing_sound, float send);
+
+/*
+	@return
+		Retrieves the reverb send level of the playing sound.
+*/
+float cd_get_reverb_send(const cs_playing_sound_t* playing_sound);
+
+/*
+	@return
+		The reverb shared by every voice of the context, NULL without use_reverb.
+*/
+cd_reverb_t* cd_get_shared_reverb(cd_context_t* context);
+
+/*
+	The shared reverb is heard through a silent stereo loaded sound owned by the context.
+	Play it looped once with cute_sound, its volume and pan set the reverb return level.
+	The reverb runs once per mix block for all voices combined, one block behind the voices.
+	@return
+		The return sound of the shared reverb, NULL without use_reverb.
+*/
+cs_loaded_sound_t* cd_get_reverb_return(cd_context_t* context);
+
+/* END REVERB API */
+
+/* BEGIN BUS API */
+typedef struct cd_bus_def_t
+{
+	const char* name;	// copied, at most CUTE_DSP_MAX_BUS_NAME - 1 characters
+	const cd_tap_set_t* reflections;	// multi-tap delay after the echo, NULL for none. Must outlive the bus
+	const cd_impulse_response_t* impulse_response;	// convolved after the reflections, NULL for none. Must outlive the bus
+
+	// effects run by the bus, in this order
+	struct
+	{
+		unsigned int use_lowpass : 1;
+		unsigned int use_highpass : 1;
+		unsigned int use_echo : 1;
+		unsigned int use_reverb : 1;	// the bus then returns only the reverberated signal
+	};
+} cd_bus_def_t;
+
+/*
+	Adds a bus to the context. Every effect starts out inaudible, like the voice filters.
+	Buses live until the context is released, at most CUTE_DSP_MAX_BUSES per context.
+	The bus is heard through its return sound, see cd_get_bus_return.
+	Call from the game thread before sending voices to it.
+*/
+cd_bus_t* cd_make_bus(cd_context_t* context, cd_bus_def_t def);
+
+/*
+	@return
+		The bus with the given name, NULL if there is none.
+*/
+cd_bus_t* cd_find_bus(cd_context_t* context, const char* name);
+
+/*
+	Buses are heard through a silent stereo loaded sound owned by the bus.
+	Play it looped once with cute_sound, its volume and pan set the return level of the bus.
+	The bus runs once per mix block for all voices combined, one block behind the voices.
+	@return
+		The return sound of the bus.
+*/
+cs_loaded_sound_t* cd_get_bus_return(cd_bus_t* bus);
+
+/*
+	Sets how much of a playing sound is sent to a bus, after all of its filters.
+	Voices start with a send of 0 to every bus.
+	@param send
+		Linear gain of the send. Generally between 0 and 1.
+*/
+void cd_set_bus_send(cs_playing_sound_t* playing_sound, const cd_bus_t* bus, float send);
+
+/*
+	@return
+		Retrieves the send level of the playing sound to the bus.
+*/
+float cd_get_bus_send(const cs_playing_sound_t* playing_sound, const cd_bus_t* bus);
+
+/*
+	Sets the gain of the playing sound heard directly, after all of its filters.
+	Set to 0 for voices that should only be heard through buses.
+	Voices start with a dry gain of 1.
+*/
+void cd_set_dry_gain(cs_playing_sound_t* playing_sound, float gain);
+
+/*
+	@return
+		Retrieves the dry gain of the playing sound.
+*/
+float cd_get_dry_gain(const cs_playing_sound_t* playing_sound);
+
+/*
+	Sets the cutoff frequency and resonance of both channels of the bus lowpass filter.
+*/
+void cd_set_bus_lowpass(cd_bus_t* bus, float cutoff_freq_in_hz, float resonance);
+
+/*
+	Sets the cutoff frequency of both channels of the bus highpass filter.
+*/
+void cd_set_bus_highpass(cd_bus_t* bus, float cutoff_freq_in_hz);
+
+/*
+	Sets the delay time, mix and feedback factor of both channels of the bus echo filter.
+	Limited by the max echo delay of the context.
+*/
+void cd_set_bus_echo(cd_bus_t* bus, float t, float a, float b);
+
+/*
+	@return
+		The reverb of the bus, to be set up with cd_set_reverb_parameters. NULL without use_reverb.
+*/
+cd_reverb_t* cd_get_bus_reverb(cd_bus_t* bus);
+
+/*
+	Processes the next stereo audio frame with the effects of the bus.
+	out_left and out_right point into the bus output, valid until the bus is sampled again.
+*/
+void cd_sample_bus(cd_context_t* context, cd_bus_t* bus, const float* left, const float* right, float** out_left, float** out_right, unsigned num_samples);
+
+/* END BUS API */
+
+/* BEGIN FILTER GROUP API */
+/*
+	Adds a named filter group to the context, for a whole category of sounds whose lowpass and highpass
+	are set together, e.g. every sound muffled while the listener is underwater.
+	Groups live until the context is released, at most CUTE_DSP_MAX_FILTER_GROUPS per context.
+	Call from the game thread.
+*/
+cd_filter_group_t* cd_make_filter_group(cd_context_t* context, const char* name);
+
+/*
+	@return
+		The filter group with the given name, NULL if there is none.
+*/
+cd_filter_group_t* cd_find_filter_group(cd_context_t* context, const char* name);
+
+/*
+	Adds a playing sound to a filter group, or takes it out of its group if group is NULL.
+	A sound is in at most one group. A new member takes the filters the group has set right away, so join
+	right after inserting the sound, e.g. paused, for its first block to use the parameters of the group.
+	Members keep their own parameters until the group sets a filter, and a parameter set on a member
+	afterwards holds until the group sets that filter again.
+*/
+void cd_join_filter_group(cs_playing_sound_t* playing_sound, cd_filter_group_t* group);
+
+/*
+	@return
+		The filter group of the playing sound, NULL if it is in none.
+*/
+cd_filter_group_t* cd_get_filter_group(const cs_playing_sound_t* playing_sound);
+
+/*
+	Sets the cutoff frequency and resonance of the lowpass filter of every member of the group.
+	The coefficients are looked up once for the whole group, and every member is pointed to them right
+	away without designing anything, however many members the group has. Call from the game thread.
+	Out of range parameters are ignored, same as cd_set_lowpass_cutoff.
+*/
+void cd_set_filter_group_lowpass(cd_filter_group_t* group, float cutoff_freq_in_hz, float resonance);
+
+/*
+	Sets the cutoff frequency of the highpass filter of every member of the group, like cd_set_filter_group_lowpass.
+*/
+void cd_set_filter_group_highpass(cd_filter_group_t* group, float cutoff_freq_in_hz);
+
+/*
+	@return
+		The parameters last set on the group, or the defaults of the filters if they weren't set.
+*/
+float cd_get_filter_group_lowpass_cutoff(const cd_filter_group_t* group);
+float cd_get_filter_group_lowpass_resonance(const cd_filter_group_t* group);
+float cd_get_filter_group_highpass_cutoff(const cd_filter_group_t* group);
+
+/* END FILTER GROUP API */
+
+/* BEGIN BATCH PARAMETER API */
+/*
+	Setters and getters over arrays of playing sounds, value i going to playing_sounds[i], for games that
+	update thousands of voices per frame. Each is the same as calling the single setter on every sound,
+	e.g. cd_set_lowpass_cutoffs and cd_set_lowpass_cutoff, out of range values are ignored the same way,
+	but the context is fetched once, the lowpass and highpass look their coefficients up under one lock
+	per CUTE_DSP_BATCH_SIZE sounds, neighbours setting the same value share a single lookup, and the noise
+	gains are converted in one pass before they are written.
+	Call from the game thread.
+*/
+void cd_set_lowpass_cutoffs(cs_playing_sound_t** playing_sounds, const float* cutoffs_in_hz, int count);
+void cd_set_lowpass_resonances(cs_playing_sound_t** playing_sounds, const float* resonances, int count);
+void cd_set_highpass_cutoffs(cs_playing_sound_t** playing_sounds, const float* cutoffs_in_hz, int count);
+void cd_set_echo_delays(cs_playing_sound_t** playing_sounds, const float* delays, int count);
+void cd_set_echo_mixes(cs_playing_sound_t** playing_sounds, const float* mixes, int count);
+void cd_set_echo_feedbacks(cs_playing_sound_t** playing_sounds, const float* feedbacks, int count);
+void cd_set_noise_amplitudes_db(cs_playing_sound_t** playing_sounds, const float* dbs, int count);
+
+/*
+	Fills values[i] with the parameter of playing_sounds[i], like the single getters.
+*/
+void cd_get_lowpass_cutoffs(cs_playing_sound_t** playing_sounds, float* cutoffs_in_hz, int count);
+void cd_get_lowpass_resonances(cs_playing_sound_t** playing_sounds, float* resonances, int count);
+void cd_get_highpass_cutoffs(cs_playing_sound_t** playing_sounds, float* cutoffs_in_hz, int count);
+void cd_get_echo_delays(cs_playing_sound_t** playing_sounds, float* delays, int count);
+void cd_get_echo_mixes(cs_playing_sound_t** playing_sounds, float* mixes, int count);
+void cd_get_echo_feedbacks(cs_playing_sound_t** playing_sounds, float* feedbacks, int count);
+void cd_get_noise_amplitudes_db(cs_playing_sound_t** playing_sounds, float* dbs, int count);
+
+/* END BATCH PARAMETER API */
+
+/* BEGIN RANDOMIZATION API */
+// ranges of a cd_randomization_t that are applied
+typedef enum cd_randomize_t
+{
+	CD_RANDOMIZE_LOWPASS_CUTOFF    = 1 << 0,
+	CD_RANDOMIZE_LOWPASS_RESONANCE = 1 << 1,
+	CD_RANDOMIZE_HIGHPASS_CUTOFF   = 1 << 2,
+	CD_RANDOMIZE_ECHO_DELAY        = 1 << 3,
+	CD_RANDOMIZE_NOISE_DB          = 1 << 4,
+} cd_randomize_t;
+
+// each range is a min and a max, parameters that aren't randomized keep their defaults
+typedef struct cd_randomization_t
+{
+	unsigned flags;	// cd_randomize_t
+	float lowpass_cutoff[2];	// in hz, picked evenly in octaves
+	float lowpass_resonance[2];
+	float highpass_cutoff[2];	// in hz, picked evenly in octaves
+	float echo_delay[2];	// in seconds, at most the max delay of the context
+	float noise_db[2];
+} cd_randomization_t;
+
+/*
+	Sets the ranges the voices of a loaded sound pick their parameters from when they spawn, replacing
+	its previous ranges. A NULL sound sets the ranges of every sound without ranges of its own.
+	Slow, call at load time: the coefficients of CUTE_DSP_RANDOMIZATION_STEPS cutoffs (times
+	CUTE_DSP_RESONANCE_STEPS resonances) and noise gains are computed here, and a spawning voice copies
+	the ones it picks instead of calling the setters. Echo delays are picked from the whole range.
+	The picks are a hash of the context's rand_seed and the voice, so replays pick the same.
+	Call from the game thread. At most CUTE_DSP_MAX_RANDOMIZATIONS sounds per context.
+	@return
+		0 if the context has no room left.
+*/
+int cd_set_randomization(cd_context_t* context, const cs_loaded_sound_t* sound, const cd_randomization_t* randomization);
+
+/*
+	Stops randomizing the voices of a loaded sound, which then use the ranges of NULL if there are any.
+*/
+void cd_clear_randomization(cd_context_t* context, const cs_loaded_sound_t* sound);
+
+/* END RANDOMIZATION API */
+
+/* BEGIN PRESET BANK API */
+// parameters of a preset, with the same ranges as the setters
+typedef struct cd_preset_t
+{
+	const char* name;	// at most CUTE_DSP_MAX_PRESET_NAME - 1 characters, unique in the bank
+	float lowpass_cutoff;	// in hz
+	float lowpass_resonance;
+	float highpass_cutoff;	// in hz
+	float echo_delay;	// in seconds
+	float echo_mix;
+	float echo_feedback;
+	float noise_db;
+} cd_preset_t;
+
+typedef struct cd_preset_bank_def_t
+{
+	const cd_preset_t* presets;
+	unsigned preset_count;
+	const float* sampling_rates;	// the coefficients are computed for each
+	unsigned sampling_rate_count;
+	unsigned filter_order;	// and alignment of the contexts using the bank, see cd_context_def_t
+	cd_filter_alignment_t filter_alignment;
+} cd_preset_bank_def_t;
+
+/*
+	Writes a preset bank file, running the setters for every preset at every sampling rate.
+	Slow, for tools baking banks offline.
+	@return
+		0 if the file couldn't be written or two presets have the same name.
+*/
+int cd_write_preset_bank(const char* path, cd_preset_bank_def_t def);
+
+/*
+	Opens a preset bank in memory for a context, reading only its header.
+	The memory is used in place and must outlive the bank, memory map the file to load it with no copy.
+	@return
+		NULL if the data isn't a preset bank, or has no coefficients for the sampling rate, filter order
+		and alignment of the context.
+*/
+cd_preset_bank_t* cd_open_preset_bank(const cd_context_t* context, const void* data, size_t size);
+
+/*
+	Releases the bank and sets to NULL. The memory it was opened on isn't touched.
+*/
+void cd_close_preset_bank(cd_preset_bank_t** bank);
+
+/*
+	@return
+		The number of presets in the bank.
+*/
+unsigned cd_get_preset_count(const cd_preset_bank_t* bank);
+
+/*
+	Finds a preset by name with a binary search, call once and keep the index.
+	@return
+		The index of the preset, -1 if there is none.
+*/
+int cd_find_preset(const cd_preset_bank_t* bank, const char* name);
+
+/*
+	@return
+		The parameters of the preset at index, its name points into the bank.
+*/
+cd_preset_t cd_get_preset(const cd_preset_bank_t* bank, int index);
+
+/*
+	Applies a preset to every filter of a playing sound. The precomputed coefficients are copied,
+	no setter runs. Filters the context doesn't use are skipped.
+*/
+void cd_apply_preset(cs_playing_sound_t* playing_sound, const cd_preset_bank_t* bank, int index);
+
+/*
+	Applies a preset to filters and the filters chained after them, any of them can be NULL.
+	A delay longer than the max delay of the echo is ignored.
+*/
+void cd_apply_preset_to_filters(const cd_preset_bank_t* bank, int index, cd_lowpass_t* lowpass, cd_highpass_t* highpass, cd_echo_t* echo, cd_noise_t* noise);
+
+/* END PRESET BANK API */
+
+/* BEGIN QUALITY TIER API */
+/*
+	Sets the quality tier of a playing sound. The change fades from the old tier to the new one
+	over the next mix block, so it can be made at any time.
+	Voices playing from the render cache or a bus return skip the filters at every tier.
+*/
+void cd_set_quality_tier(cs_playing_sound_t* playing_sound, cd_quality_tier_t tier);
+
+/*
+	@return
+		The tier the playing sound was mixed at in the last block, which CD_TIER_AUTO resolves to.
+*/
+cd_quality_tier_t cd_get_quality_tier(const cs_playing_sound_t* playing_sound);
+
+/*
+	Sets how much louder than its own level a voice counts when CD_TIER_AUTO picks its tier.
+	The level is measured from the samples of the sound, before cute_sound applies its volume and
+	pan, so fold the distance attenuation and importance of the voice into the priority, e.g.
+	-20 for a voice 10x further than the listener's reference distance.
+	Voices start with a priority of 0.
+*/
+void cd_set_voice_priority(cs_playing_sound_t* playing_sound, float priority_db);
+
+/*
+	@return
+		Retrieves the priority of the playing sound.
+*/
+float cd_get_voice_priority(const cs_playing_sound_t* playing_sound);
+
+typedef struct cd_quality_stats_t
+{
+	unsigned voices[CD_TIER_COUNT];	// mixed at each tier in their last block
+	unsigned long long samples[CD_TIER_COUNT];	// filtered at each tier since the context was made, across channels
+	unsigned long long transitions;	// blocks faded from one tier to another
+} cd_quality_stats_t;
+
+/*
+	@return
+		How many voices play at each tier, and how much audio went through each tier.
+*/
+cd_quality_stats_t cd_get_quality_stats(cd_context_t* context);
+
+/* END QUALITY TIER API */
+
+/* BEGIN GOVERNOR API */
+/*
+	Sets the fraction of the duration of a mix block that the cute_dsp plugins may spend on it,
+	e.g. 0.25 for 2.9 ms of a 512 frame block at 44100 Hz. Over budget, the governor lowers the
+	quality tier of the voices with the lowest loudness plus priority, see cd_set_voice_priority,
+	and raises them again once the blocks fit the budget with headroom. 0 disables the governor.
+	The time is measured from the first to the last plugin of every voice, so it includes the
+	resampling and panning cute_sound does between them.
+*/
+void cd_set_cpu_budget(cd_context_t* context, float budget);
+
+typedef struct cd_governor_stats_t
+{
+	unsigned long long blocks;	// timed since the context was made
+	unsigned long long blocks_over_budget;
+	unsigned long long interventions;	// blocks after which more voices were degraded
+	unsigned long long degraded_samples;	// mixed below the tier of their voice, across channels
+	float load;	// time of the last block over its duration
+	float peak_load;
+	float threshold_db;	// voices below this loudness plus priority are minimal, and reduced up to CUTE_DSP_GOVERNOR_SPAN_DB above it
+	unsigned voices_degraded;	// in the last block
+	unsigned peak_voices_degraded;
+} cd_governor_stats_t;
+
+/*
+	@return
+		How often and how hard the governor intervened. The threshold is -1000 while it isn't.
+*/
+cd_governor_stats_t cd_get_governor_stats(cd_context_t* context);
+
+/* END GOVERNOR API */
+
+/* BEGIN MULTIRATE API */
+/*
+	Lets a playing sound run its lowpass and highpass at the sampling rate divided by up to the
+	factor, 2 or 4, whenever their cutoffs allow it. The noise and echo stay at the full rate.
+	The voice is decimated and interpolated back with halfband filters, which delays it by 13
+	samples at a factor of 2 and 39 at a factor of 4, and removes what is above the bandwidth of
+	the reduced rate, e.g. 2480 Hz at a factor of 4 and 44100 Hz. Changes of factor crossfade over
+	one mix block. Blocks whose length isn't a multiple of the factor run at a lower one.
+	@param factor
+		0 or 1 keeps the voice at the full rate.
+*/
+void cd_set_multirate_limit(cs_playing_sound_t* playing_sound, unsigned factor);
+
+/*
+	@return
+		The factor the sampling rate of the playing sound was divided by in the last block.
+*/
+unsigned cd_get_multirate_factor(const cs_playing_sound_t* playing_sound);
+
+typedef struct cd_multirate_stats_t
+{
+	unsigned voices[3];	// mixed at the full rate, 1/2 and 1/4 of it in their last block
+	unsigned long long samples[3];	// filtered at each rate by the voices, across channels
+	unsigned long long transitions;
+} cd_multirate_stats_t;
+
+cd_multirate_stats_t cd_get_multirate_stats(cd_context_t* context);
+
+/* END MULTIRATE API */
+
+/* BEGIN CAPTURE API */
+/*
+	Starts streaming every voice spawn/free, parameter change and mix call of the context
+	to a compact binary capture file, so a session can be replayed offline with cd_replay_capture.
+	Voices that are already playing are recorded with their current parameters, but not their
+	filter state, so start the capture before spawning sounds for a bit exact replay.
+	@param capture_input
+		Nonzero to also store every input block. Without it the replay is fed silence.
+	@return
+		1 on success, 0 if the file couldn't be opened.
+*/
+int cd_begin_capture(cd_context_t* context, const char* path, int capture_input);
+
+/*
+	Writes the buffered capture events to the file.
+	Call this once per frame from the game thread. The mix thread never writes to the file,
+	it sets a full buffer aside and fills a second one. When both are full the capture drops
+	every event from then on, so the file stays a valid, shorter session.
+*/
+void cd_flush_capture(cd_context_t* context);
+
+/*
+	@return
+		The events the capture dropped because cd_flush_capture wasn't called often enough.
+*/
+unsigned cd_get_dropped_capture_events(const cd_context_t* context);
+
+/*
+	Flushes and closes the capture file.
+*/
+void cd_end_capture(cd_context_t* context);
+
+typedef struct cd_replay_stats_t
+{
+	unsigned spawns;
+	unsigned frees;
+	unsigned parameters;
+	unsigned mixes;
+	unsigned blocks;
+	unsigned long long samples;
+	unsigned long long tier_samples[CD_TIER_COUNT];
+	unsigned output_hash;	// FNV-1a hash of every output sample, equal across bit exact replays
+} cd_replay_stats_t;
+
+/*
+	Re-drives a fresh detached context (no cute_sound context) with a capture loaded in memory.
+	Every voice is rebuilt with the filters enabled in the capture, and every mix call runs
+	the same filter chain in the same order as cute_sound did, so the output is bit exact.
+	@return
+		1 on success, 0 if the data isn't a valid capture.
+*/
+int cd_replay_capture(const void* data, size_t size, cd_replay_stats_t* stats);
+
+/*
+	Replays a capture with every voice at the given tier instead of the captured ones,
+	to profile what each tier costs. CD_TIER_AUTO picks them from the loudness and captured priorities.
+*/
+int cd_replay_capture_at_tier(const void* data, size_t size, cd_quality_tier_t tier, cd_replay_stats_t* stats);
+
+/* END CAPTURE API */
+
+/* BEGIN RENDER CACHE API */
+/*
+	Plays the sound from the render cache: a pre-rendered copy of its loaded sound through the lowpass,
+	highpass and echo filters, keyed on the loaded sound and the current parameters of those filters.
+	While it plays from the cache the voice skips the filters entirely. Call after setting the
+	parameters and before the sound is first mixed, e.g. with the sound inserted paused.
+	On a miss the render is queued for cd_update_render_cache and the sound plays through the filters.
+	Sounds with pitch shifting or an audible noise generator are never cached.
+	Changing a filter parameter afterwards hands the sound back to the filters from the next mix,
+	starting from empty filter state.
+	@return
+		1 if the sound plays from the cache.
+*/
+int cd_use_render_cache(cs_playing_sound_t* playing_sound);
+
+/*
+	Renders queued cache entries, up to max_frames frames per call so a whole asset is never rendered at once.
+	Call once per frame from the game thread or from a single loader thread, never from the mix thread.
+	@return
+		Number of entries still waiting to be rendered.
+*/
+int cd_update_render_cache(cd_context_t* context, unsigned max_frames);
+
+/*
+	Drops every unreferenced cache entry of a loaded sound, or of all loaded sounds if loaded_sound is NULL.
+	Call before freeing a loaded sound, from the thread that calls cd_update_render_cache.
+*/
+void cd_evict_render_cache(cd_context_t* context, const cs_loaded_sound_t* loaded_sound);
+
+typedef struct cd_render_cache_stats_t
+{
+	unsigned entries;
+	unsigned pending;	// entries waiting to be rendered
+	size_t bytes;
+	size_t budget;
+	unsigned hits;
+	unsigned misses;
+	unsigned evictions;
+} cd_render_cache_stats_t;
+
+/*
+	@return
+		Occupancy and hit rate of the render cache.
+*/
+cd_render_cache_stats_t cd_get_render_cache_stats(cd_context_t* context);
+
+/* END RENDER CACHE API */
+#define CUTE_DSP_H
+#endif
+/* END HEADER SECTION */
+/**********************************************************************************************/
+
+/**********************************************************************************************/
+/* BEGIN IMPLEMENTATION SECTION */
+#ifdef CUTE_DSP_IMPLEMENTATION
+#ifndef CUTE_DSP_IMPLEMENTATION_ONCE
+#define CUTE_DSP_IMPLEMENTATION_ONCE
+
+/* HELPER MACROS */
+#if !defined(CUTE_DSP_ALLOC)
+	#include <stdlib.h> // malloc, free
+	#include <string.h> // memcpy, memset
+	#define CUTE_DSP_ALLOC(size, mem_ctx) malloc(size)
+	#define CUTE_DSP_FREE(mem, mem_ctx)   free(mem)
+#endif
+
+#define CUTE_DSP_ASSERT_INTERNAL *(int*)0 = 0
+#define CUTE_DSP_ASSERT(X) do { if(!(X)) CUTE_DSP_ASSERT_INTERNAL; } while (0)
+
+#if !defined(CUTE_DSP_MATH)
+	#include <math.h> // sinf, cosf, absf, atan2f
+	#define CUTE_DSP_MATH
+	#if defined(CUTE_DSP_FAST_MATH)
+		// polynomial approximations with bounded error, see FAST MATH IMPLEMENTATION
+		#define CUTE_DSP_SIN(angle_rad) (cd_fast_sin(angle_rad))
+		#define CUTE_DSP_COS(angle_rad) (cd_fast_cos(angle_rad))
+	#else
+		#define CUTE_DSP_SIN(angle_rad) (sinf(angle_rad))
+		#define CUTE_DSP_COS(angle_rad) (cosf(angle_rad))
+	#endif
+	#define CUTE_DSP_ABS(val)       (fabsf(val))
+	#define CUTE_DSP_PI				(3.1415926f)
+	#define CUTE_DSP_SQRT_2 		(1.4142136f)
+	#define CUTE_DSP_CLAMP(val, least, most) ( (val) < (least) ? (least) : ( (val) > (most) ? (most) : (val) ) )
+	#define CUTE_DSP_LERP_FLOAT(start, end, factor) ((start) + (factor) * ((end) - (start)))
+
+	/* more here */
+#endif
+
+#if !defined(CUTE_DSP_DEFINES)
+	#define CUTE_DSP_DEFINES
+	#define CUTE_DSP_MONO (1)
+	#define CUTE_DSP_STEREO (2)
+	#define CUTE_DSP_INVALID_PLUGIN_ID (-1)
+
+	// default cutoff frequencies for LPF and HPF chosen 
+	// such that their effect is inaudible (at the edges of human hearing)
+	// unless changed
+	#define CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF (20.0f)
+	#define CUTE_DSP_DEFAULT_LOWPASS_CUTOFF  (20000.0f)
+
+	// rand max
+	#define CUTE_DSP_PRNG_MAX ((size_t)(-1))
+
+	#if defined(CUTE_DSP_FAST_MATH)
+		// 10^(db / 20) = 2^(db log2(10) / 20), and 4 at a time for the batched setters
+		#define CUTE_DSP_DB_TO_GAIN(db) (cd_fast_exp2((db) * 0.16609640f))
+		#define CUTE_DSP_DB_TO_GAIN_PS(db) (cd_exp2_ps(_mm_mul_ps((db), _mm_set1_ps(0.16609640f))))
+		#define CUTE_DSP_GAIN_TO_DB(gain) (6.0205999f * cd_fast_log2(gain))
+	#else
+		#define CUTE_DSP_DB_TO_GAIN(db) (powf(10, db / 20.f))
+		#define CUTE_DSP_GAIN_TO_DB(gain) (20.f * log10f(gain))
+	#endif
+
+	// block index of voices that haven't been mixed yet
+	#define CUTE_DSP_INVALID_BLOCK (~0u)
+
+	// cached renders run until the echo falls below -60 dB, and give the biquads time to ring out
+	#define CUTE_DSP_RENDER_CACHE_ECHO_FLOOR (0.001f)
+	#define CUTE_DSP_RENDER_CACHE_FILTER_TAIL_S (0.05f)
+	#define CUTE_DSP_RENDER_CACHE_MAX_TAIL_S (4.f)
+
+	// reverb delay lines, two SSE lanes of four
+	#define CUTE_DSP_REVERB_LINES (8)
+	#define CUTE_DSP_REVERB_BASE_RATE (44100.f)
+	// keeps the decaying feedback out of the denormal range, far below anything audible
+	#define CUTE_DSP_REVERB_DENORMAL_GUARD (1e-20f)
+
+	// partitions grow 4x per level, the last level holds the rest of the impulse response
+	#define CUTE_DSP_CONVOLUTION_LEVELS (4)
+
+	// added to the damping filters of multi-tap delays, so fading inputs don't leave them denormal
+	#define CUTE_DSP_MULTITAP_DENORMAL_GUARD (1e-20f)
+
+	// threshold of the governor while it leaves every voice alone, below any loudness plus priority
+	#define CUTE_DSP_GOVERNOR_IDLE_DB (-1000.f)
+
+	// halfband filters of 15 taps, of which the center and 4 on each side aren't 0
+	#define CUTE_DSP_MULTIRATE_STAGES (2)
+	#define CUTE_DSP_HALFBAND_DECIMATOR_HISTORY (14)
+	#define CUTE_DSP_HALFBAND_INTERPOLATOR_HISTORY (7)
+	// filters running at a reduced rate are designed for cutoffs below this fraction of it
+	#define CUTE_DSP_MULTIRATE_MAX_CUTOFF (0.45f)
+
+	// keys of the coefficient cache, cutoffs are rounded to 0.01Hz and resonances to 0.001
+	#define CUTE_DSP_COEFFICIENT_CUTOFF_STEPS (100.f)	// per Hz
+	#define CUTE_DSP_COEFFICIENT_RESONANCE_STEPS (1000.f)
+	#define CUTE_DSP_COEFFICIENT_BUCKETS (256)	// power of 2
+	#define CUTE_DSP_COEFFICIENT_POOL (256)	// entries made with the context, the rest come from the heap
+	#define CUTE_DSP_COEFFICIENT_UNUSED (256)	// unreferenced entries kept at most, the oldest is reused past them
+	#define CUTE_DSP_BATCH_SIZE (64)	// sounds a batched setter handles per lock of the coefficient cache
+#endif
+
+#if !defined(CUTE_DSP_ATOMIC)
+	#define CUTE_DSP_ATOMIC
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+		#define CUTE_DSP_ATOMIC_EXCHANGE(ptr, val) _InterlockedExchange((volatile long*)(ptr), (long)(val))
+	#else
+		#define CUTE_DSP_ATOMIC_EXCHANGE(ptr, val) __sync_lock_test_and_set((ptr), (val))
+		#define CUTE_DSP_ATOMIC_RELEASE(ptr) __sync_lock_release(ptr)
+	#endif
+#endif
+
+// stores 0 after everything written before it, a plain store with release semantics where the compiler has one
+#if !defined(CUTE_DSP_ATOMIC_RELEASE)
+	#define CUTE_DSP_ATOMIC_RELEASE(ptr) CUTE_DSP_ATOMIC_EXCHANGE(ptr, 0)
+#endif
+
+// the governor's clock, define CUTE_DSP_TIMER and CUTE_DSP_SECONDS() to use another one
+#if !defined(CUTE_DSP_TIMER)
+	#define CUTE_DSP_TIMER
+	#if defined(_WIN32)
+		#include <windows.h> // QueryPerformanceCounter
+		static double cd_seconds(void)
+		{
+			LARGE_INTEGER counter, frequency;
+			QueryPerformanceCounter(&counter);
+			QueryPerformanceFrequency(&frequency);
+			return (double)counter.QuadPart / (double)frequency.QuadPart;
+		}
+	#else
+		#include <time.h> // clock_gettime
+		static double cd_seconds(void)
+		{
+			struct timespec now;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+		}
+	#endif
+	#define CUTE_DSP_SECONDS() (cd_seconds())
+#endif
+
+#include <stdio.h> // capture files
+#include <xmmintrin.h> // reverb delay lines, convolution FFTs
+#include <emmintrin.h> // wind and colored noise PRNGs
 /* END HELPER MACROS */
 
-/* BEGIN OPAQUE STRUCT IMPLEMENTATION */
-typedef struct cd_memory_pool_object_t
+/* BEGIN OPAQUE STRUCT IMPLEMENTATION */
+typedef struct cd_memory_pool_object_t
+{
+	struct cd_memory_pool_object_t* next;
+} cd_memory_pool_object_t;
+
+typedef struct cd_memory_pool_t
+{
+	unsigned size_per_object;
+	unsigned max_objects;
+	unsigned pool_size;
+	unsigned num_objects;
+	char* pool;
+	cd_memory_pool_object_t* free_list;
+} cd_memory_pool_t;
+
+typedef struct cd_memory_pool_def_t
+{
+	unsigned size_per_object;
+	unsigned max_objects;
+} cd_memory_pool_def_t;
+
+typedef struct cd_ring_buffer_t
+{
+	float* buffer;
+	int current_index;
+	int max_elements;
+} cd_ring_buffer_t;
+
+// xorshift PRNG
+typedef size_t uint64_t;
+typedef struct cd_random_t
+{
+	uint64_t a;
+	uint64_t b;
+} cd_random_t;
+
+// spinlock guarding state shared between the game and mix threads
+typedef volatile long cd_lock_t;
+
+// pre-rendered voice output, see BEGIN RENDER CACHE IMPLEMENTATION
+typedef struct cd_render_key_t
+{
+	const cs_loaded_sound_t* sound;	// NULL once the loaded sound is evicted
+	float lowpass_cutoff;
+	float lowpass_resonance;
+	float highpass_cutoff;
+	float echo_offset;	// in samples
+	float echo_mix;
+	float echo_feedback;
+} cd_render_key_t;
+
+typedef struct cd_render_entry_t
+{
+	struct cd_render_entry_t* prev;	// least recently used order
+	struct cd_render_entry_t* next;
+	cd_render_key_t key;
+	float* samples;		// every channel one after another, frames + tail_frames each
+	unsigned channel_count;
+	unsigned frames;	// length of the loaded sound
+	unsigned tail_frames;
+	unsigned rendered;
+	int ready;			// ready entries are never written again
+	int refs;			// voices playing the entry
+	size_t bytes;
+} cd_render_entry_t;
+
+typedef struct cd_render_cache_t
+{
+	cd_render_entry_t* newest;
+	cd_render_entry_t* oldest;
+	cd_lock_t lock;		// guards the list, refs and ready
+	size_t bytes;
+	size_t budget;
+
+	// render in progress, only touched by cd_update_render_cache
+	cd_context_t* render_context;
+	cd_render_entry_t* rendering;
+	cd_lowpass_t* lowpass;
+	cd_highpass_t* highpass;
+	cd_echo_t* echo;
+
+	unsigned hits;
+	unsigned misses;
+	unsigned evictions;
+} cd_render_cache_t;
+
+// the parameters and coefficients of a lowpass or highpass filter
+typedef struct cd_filter_design_t
+{
+	float freq_cutoff;
+	float resonance;
+	float x_coeff;
+	float x1_coeff;	// highpass only
+	float y1_coeff;
+	float y2_coeff;
+	float b0[4];	// cascade sections, see cd_biquad_cascade_t
+	float b1[4];
+	float b2[4];
+	float a1[4];
+	float a2[4];
+} cd_filter_design_t;
+
+// a design shared by every filter of the same parameters, see BEGIN COEFFICIENT CACHE IMPLEMENTATION
+typedef struct cd_coefficients_t
+{
+	cd_filter_design_t design;
+	struct cd_coefficients_t* next;	// in its bucket
+	struct cd_coefficients_t* newer;	// unreferenced entries, reused oldest first
+	struct cd_coefficients_t* older;
+	struct cd_coefficient_cache_t* cache;
+	float sampling_rate;
+	int highpass;
+	int cutoff_key;	// quantized parameters
+	int resonance_key;
+	int refs;	// filters using the entry
+	unsigned dropped_clock;	// mix clock of the context when refs last fell to 0
+} cd_coefficients_t;
+
+typedef struct cd_coefficient_cache_t
+{
+	cd_coefficients_t* buckets[CUTE_DSP_COEFFICIENT_BUCKETS];
+	cd_coefficients_t* newest;	// unreferenced entries
+	cd_coefficients_t* oldest;
+	unsigned unused;	// entries on the unreferenced list
+	cd_memory_pool_t entries;
+	cd_lock_t lock;		// guards the buckets, the unreferenced list and refs
+	const unsigned* mix_clock;	// of the context mixing the filters on another thread, NULL for detached contexts
+	int order;	// of the cascades, see cd_biquad_cascade_order
+	cd_filter_alignment_t alignment;
+	unsigned hits;
+	unsigned misses;
+} cd_coefficient_cache_t;
+
+// a preset as stored in a preset bank file, see BEGIN PRESET BANK IMPLEMENTATION
+typedef struct cd_preset_record_t
+{
+	char name[CUTE_DSP_MAX_PRESET_NAME];	// 0 terminated
+	float lowpass_cutoff;
+	float lowpass_resonance;
+	float highpass_cutoff;
+	float echo_delay;
+	float echo_mix;
+	float echo_feedback;
+	float noise_db;
+	float noise_gain;
+} cd_preset_record_t;
+
+typedef struct cd_preset_bank_t
+{
+	const cd_preset_record_t* presets;
+	const cd_filter_design_t* designs;	// lowpass and highpass of every preset, at the rate of the context
+	unsigned preset_count;
+	float sampling_rate;
+} cd_preset_bank_t;
+
+// cd_randomization_t of a sound with its precomputed steps, see cd_set_randomization
+typedef struct cd_randomization_table_t
+{
+	const cs_loaded_sound_t* sound;	// NULL for sounds without ranges of their own
+	cd_randomization_t def;
+	unsigned cutoff_steps;	// of the lowpass designs, which go through the cutoffs of each resonance
+	unsigned resonance_steps;
+	cd_filter_design_t* lowpass;	// NULL unless the lowpass is randomized
+	cd_filter_design_t* highpass;
+	float noise_gains[CUTE_DSP_RANDOMIZATION_STEPS];
+} cd_randomization_table_t;
+
+// quality tier of a voice, resolved once per mix block by cd_update_quality
+typedef struct cd_quality_t
+{
+	cd_quality_tier_t requested;	// may be CD_TIER_AUTO
+	cd_quality_tier_t tier;	// of the current block
+	cd_quality_tier_t previous_tier;	// of the last block, faded out over the current one
+	float priority_db;
+	float loudness_db;	// of the input in dBFS, rises at once and falls slowly
+	cd_quality_tier_t cap;	// lowest tier the governor allows
+} cd_quality_t;
+
+// halfband stages of a voice running its filters at a reduced rate, see BEGIN MULTIRATE IMPLEMENTATION
+typedef struct cd_multirate_t
+{
+	unsigned limit;
+	unsigned factor;	// of the current block
+	unsigned previous_factor;	// of the last block, faded out over the current one
+	float decimators[CUTE_DSP_STEREO][CUTE_DSP_MULTIRATE_STAGES][CUTE_DSP_HALFBAND_DECIMATOR_HISTORY];
+	float interpolators[CUTE_DSP_STEREO][CUTE_DSP_MULTIRATE_STAGES][CUTE_DSP_HALFBAND_INTERPOLATOR_HISTORY];
+} cd_multirate_t;
+
+// per playing sound bookkeeping, owned by the voice plugin that runs before every filter
+typedef struct cd_voice_t
+{
+	struct cd_voice_t* next;
+	struct cd_voice_t* prev_active;
+	struct cd_voice_t* next_active;
+	const cs_playing_sound_t* sound;
+	unsigned id;
+	unsigned channel_count;
+	unsigned mixed_block;	// block index this voice was last mixed in
+
+	// render cache playback, the filters are bypassed while cache is set
+	cd_render_entry_t* cache;
+	unsigned cache_position;
+	unsigned cache_loops;
+	volatile int cache_detach;	// set by parameter changes, the mix thread drops the entry
+
+	float sends[CUTE_DSP_MAX_BUSES];	// indexed by bus
+	float dry_gain;
+	cd_bus_t* bus_return;	// plays the output of this bus, the filters are bypassed
+	cd_filter_group_t* filter_group;
+
+	// ranges of the sound, only valid while the filters of the voice are made
+	const cd_randomization_table_t* randomization;
+	uint32_t random_key;
+
+	cd_quality_t quality;
+	cd_multirate_t multirate;
+} cd_voice_t;
+
+// parameter setters recorded by the capture
+typedef enum cd_capture_parameter_t
+{
+	CD_CAPTURE_LOWPASS_CUTOFF,
+	CD_CAPTURE_LOWPASS_RESONANCE,
+	CD_CAPTURE_HIGHPASS_CUTOFF,
+	CD_CAPTURE_ECHO_DELAY,
+	CD_CAPTURE_ECHO_MIX,
+	CD_CAPTURE_ECHO_FEEDBACK,
+	CD_CAPTURE_NOISE_DB,
+	CD_CAPTURE_NOISE_GAIN,
+	CD_CAPTURE_DRY_GAIN,
+	CD_CAPTURE_NOISE_COLOR,
+	CD_CAPTURE_NOISE_SEEK_HIGH,	// 16 bits each, so they fit a float exactly
+	CD_CAPTURE_NOISE_SEEK_LOW,
+	CD_CAPTURE_QUALITY_TIER,
+	CD_CAPTURE_PRIORITY,
+	CD_CAPTURE_GOVERNOR_CAP,	// recorded from the mix thread, so replays needn't time anything
+	CD_CAPTURE_MULTIRATE_LIMIT,
+	CD_CAPTURE_CHORUS_DELAY,
+	CD_CAPTURE_CHORUS_DEPTH,
+	CD_CAPTURE_CHORUS_RATE,
+	CD_CAPTURE_CHORUS_MIX,
+	CD_CAPTURE_CHORUS_FEEDBACK,
+	CD_CAPTURE_CHORUS_TAPS,
+	CD_CAPTURE_BUS_SEND = 128,	// plus the bus index
+} cd_capture_parameter_t;
+
+// events recorded by the capture
+enum
+{
+	CD_CAPTURE_SPAWN = 1,
+	CD_CAPTURE_FREE,
+	CD_CAPTURE_PARAMETER,
+	CD_CAPTURE_MIX
+};
+
+// times the plugins of every voice from the mix thread, see BEGIN GOVERNOR IMPLEMENTATION
+typedef struct cd_governor_t
+{
+	float budget;
+	double mix_start;	// of the voice being mixed, 0 between voices
+	double block_time;	// spent on the current block so far
+	unsigned block_frames;
+	float threshold_db;
+	float min_score;	// lowest and highest loudness plus priority of the block
+	float max_score;
+	unsigned voices_degraded;	// so far in the block
+	cd_governor_stats_t stats;
+} cd_governor_t;
+
+// binary capture of a session, see BEGIN CAPTURE IMPLEMENTATION for the format
+typedef struct cd_capture_t
+{
+	FILE* file;
+	unsigned char* buffer;	// filled by the events
+	unsigned size;
+	unsigned char* pending;	// a full buffer set aside for cd_flush_capture to write
+	unsigned pending_size;
+	unsigned dropped;	// events since both buffers were full
+	int capture_input;
+	cd_lock_t lock;
+} cd_capture_t;
+
+typedef struct cd_context_t
+{
+	float sampling_rate;
+	unsigned channel_count;
+	cd_memory_pool_t voices;
+	cd_memory_pool_t lowpass_filters;
+	cd_memory_pool_t highpass_filters;
+	cd_memory_pool_t echo_filters;
+	cd_memory_pool_t noise_generators;
+	cd_memory_pool_t choruses;
+	unsigned pool_size;
+	cs_plugin_id_t voice_id;
+	cs_plugin_id_t lowpass_id;
+	cs_plugin_id_t highpass_id;
+	cs_plugin_id_t echo_id;
+	cs_plugin_id_t noise_id;
+	cs_plugin_id_t chorus_id;
+	cs_plugin_id_t bus_send_id;
+	float* current_output;
+	float output1[CUTE_DSP_MAX_FRAME_LENGTH * CUTE_DSP_STEREO]; // number of samples is frames * channels
+	float output2[CUTE_DSP_MAX_FRAME_LENGTH * CUTE_DSP_STEREO];
+
+	// voice bookkeeping
+	cd_voice_t* active_voices;
+	cd_lock_t voice_lock;
+	unsigned voice_counter;
+	unsigned block_index;	// advances whenever a voice is mixed a second time
+	unsigned mix_clock;	// advances with every channel of a voice mixed, see cd_make_coefficients
+	cd_context_def_t def;
+	cd_capture_t capture;
+	cd_render_cache_t render_cache;
+	cd_coefficient_cache_t coefficients;	// of every lowpass and highpass filter
+
+	// buses, fed by the send plugin and played by their return voices
+	cd_bus_t* buses[CUTE_DSP_MAX_BUSES];
+	volatile unsigned bus_count;
+	cd_bus_t* reverb_bus;
+	cd_filter_group_t* filter_groups[CUTE_DSP_MAX_FILTER_GROUPS];
+	unsigned filter_group_count;
+	void* silence_memory;
+	float* silence;	// samples of every bus return sound
+	float* wind_noise;	// shared by every wind, made with the first one
+
+	// optional filter default parameters
+	float echo_max_delay_s;
+	cd_random_t random_generator;
+	unsigned noise_generator_counter;	// channel of the next generator made on stream 0
+
+	// randomization ranges by sound, see cd_set_randomization
+	cd_randomization_table_t* randomizations[CUTE_DSP_MAX_RANDOMIZATIONS];
+	unsigned randomization_count;
+
+	// quality tiers, see cd_fade_tiers
+	float tier_fade[CUTE_DSP_MAX_FRAME_LENGTH];	// output of the tier faded in
+	unsigned long long tier_samples[CD_TIER_COUNT];
+	unsigned long long tier_transitions;
+
+	cd_governor_t governor;
+
+	// multirate voices, see cd_mix_multirate
+	float multirate_work[CUTE_DSP_MAX_FRAME_LENGTH + CUTE_DSP_HALFBAND_DECIMATOR_HISTORY];	// history followed by the input of a halfband
+	float multirate_stages[CUTE_DSP_MULTIRATE_STAGES][CUTE_DSP_MAX_FRAME_LENGTH / 2];
+	float multirate_input[CUTE_DSP_MAX_FRAME_LENGTH];	// of both factors of a transition
+	float multirate_fade[CUTE_DSP_MAX_FRAME_LENGTH];	// output of the factor faded out
+	float multirate_output[CUTE_DSP_MAX_FRAME_LENGTH];
+	unsigned long long multirate_samples[3];
+	unsigned long long multirate_transitions;
+
+} cd_context_t;
+
+static cd_context_t* g_dsp_context = 0;
+
+// up to 4 biquad sections, evaluated one per SSE lane, see cd_sample_biquad_cascade
+typedef struct cd_biquad_cascade_t
+{
+	int order;	// 0 for the single section Butterworth filters of order 2
+	cd_filter_alignment_t alignment;
+	float x1[4];	// input and output history of every section
+	float x2[4];
+	float y1[4];
+	float y2[4];
+	float smoothed[5][4];	// b0, b1, b2, a1 and a2 reached by the last block, ramped to the design of the filter over the next
+	int running;	// 0 until the first block after a reset, parameters set before it apply at once
+} cd_biquad_cascade_t;
+
+typedef struct cd_lowpass_t
+{
+	struct cd_lowpass_t* next;
+	float freq_cutoff;
+	float sampling_rate;
+	float resonance;
+	float y1;
+	float y2;
+	cd_coefficients_t* coefficients;	// of freq_cutoff and resonance at sampling_rate
+	cd_coefficients_t* reduced[CUTE_DSP_MULTIRATE_STAGES];	// at sampling_rate over 2 and 4, NULL until the voice has a multirate limit
+	unsigned factor;	// of the reduced rate the mix thread runs the filter at, see cd_design_multirate
+	float smoothed[3];	// x_coeff, y1_coeff and y2_coeff reached by the last block, ramped to the coefficients over the next
+	int running;	// 0 until the first block after a reset, parameters set before it apply at once
+	cd_biquad_cascade_t cascade;
+} cd_lowpass_t;
+
+typedef struct cd_highpass_t
+{
+	struct cd_highpass_t* next;
+	float freq_cutoff;
+	float sampling_rate;
+	float y1;
+	float y2;
+	float x1;
+	float x2;
+	cd_coefficients_t* coefficients;	// of freq_cutoff at sampling_rate
+	cd_coefficients_t* reduced[CUTE_DSP_MULTIRATE_STAGES];	// at sampling_rate over 2 and 4, NULL until the voice has a multirate limit
+	unsigned factor;	// of the reduced rate the mix thread runs the filter at, see cd_design_multirate
+	float smoothed[4];	// x_coeff, x1_coeff, y1_coeff and y2_coeff reached by the last block, ramped to the coefficients over the next
+	int running;	// 0 until the first block after a reset, parameters set before it apply at once
+	cd_biquad_cascade_t cascade;
+} cd_highpass_t;
+
+typedef struct cd_svf_t
+{
+	float freq_cutoff;
+	float resonance;
+	float radians_per_hz;	// pi / sampling rate
+	float k;	// damping, 1 / Q
+	float a1;	// coefficients of the fixed cutoff
+	float a2;
+	float a3;
+	float lowpass_gain;
+	float bandpass_gain;
+	float highpass_gain;
+	float ic1eq;	// states of the two integrators
+	float ic2eq;
+} cd_svf_t;
+
+typedef struct cd_echo_t
+{
+	struct cd_echo_t* next;
+	cd_ring_buffer_t xvalues;
+	cd_ring_buffer_t yvalues;
+	float mix;
+	float feedback;
+	float smoothed_mix;	// reached by the last block, ramped to mix and feedback over the next
+	float smoothed_feedback;
+	int running;	// 0 until the first block, parameters set before it apply at once
+	float offset;
+	float sampling_rate;
+	float max_samples;
+} cd_echo_t;
+
+typedef struct cd_chorus_t
+{
+	struct cd_chorus_t* next;
+	cd_ring_buffer_t line;	// input plus feedback, stored in the pool object right after the chorus
+	float delay;	// center, in samples
+	float depth;	// in samples
+	float rate;	// in hz
+	float phase;	// of the LFO, in cycles
+	float mix;
+	float feedback;
+	unsigned taps;
+	float sampling_rate;
+	float max_samples;
+} cd_chorus_t;
+
+// one partition size of an impulse response
+typedef struct cd_convolution_level_t
+{
+	unsigned size;	// frames per partition, the FFTs are twice as long
+	unsigned start;	// frame of the impulse response where the first partition starts
+	unsigned count;
+} cd_convolution_level_t;
+
+typedef struct cd_impulse_response_t
+{
+	void* memory;
+	int channel_count;
+	unsigned frame_count;
+	float sampling_rate;
+	int level_count;
+	cd_convolution_level_t levels[CUTE_DSP_CONVOLUTION_LEVELS];
+	float* spectra[CUTE_DSP_STEREO][CUTE_DSP_CONVOLUTION_LEVELS];	// count spectra per level, see cd_real_fft
+	unsigned fft_size;	// complex FFT length of the largest partition
+	unsigned history;	// ring buffer length of the convolvers, a power of two
+	float* twiddles_re;	// per FFT stage of half length m, m entries starting at m
+	float* twiddles_im;
+	unsigned* bit_reverse;	// for fft_size, shifted down for smaller FFTs
+} cd_impulse_response_t;
+
+typedef struct cd_convolver_t
+{
+	struct cd_convolver_t* next;
+	const cd_impulse_response_t* impulse_response;
+	int channel_index;
+	void* memory;
+	float* input;	// rings of impulse_response->history frames, indexed by position
+	float* output;
+	float* delay_lines[CUTE_DSP_CONVOLUTION_LEVELS];	// input spectra, count per level
+	unsigned heads[CUTE_DSP_CONVOLUTION_LEVELS];
+	float* work_re;
+	float* work_im;
+	float* accumulator;
+	unsigned position;	// frames processed
+} cd_convolver_t;
+
+typedef struct cd_tap_set_t
+{
+	void* memory;
+	int tap_count;
+	int group_count;	// of 4 taps, the lanes past tap_count have a gain of 0
+	float sampling_rate;
+	float length;	// longest delay, in seconds
+	int history;	// samples of past input read by the longest tap
+	int* offsets;	// whole samples of delay, group_count * 4 of each
+	float* fractions;	// of a sample, weight of the older sample
+	float* gains[CUTE_DSP_STEREO];
+	float* damping;	// one pole coefficients, 1 for undamped taps
+} cd_tap_set_t;
+
+typedef struct cd_multitap_t
+{
+	struct cd_multitap_t* next;
+	const cd_tap_set_t* tap_set;
+	int channel_index;
+	void* memory;
+	float* line;	// the history, then the input written since, moved back to the start when full
+	int capacity;
+	int position;	// where the next input sample is written, at least history
+	float* states;	// of the damping filters, one per tap
+} cd_multitap_t;
+
+// rows of the pink noise, the lowest one changes every 2^15 samples
+#define CUTE_DSP_PINK_NOISE_ROWS (16)
+
+typedef struct cd_noise_t
+{
+	struct cd_noise_t* next;
+	float amplitude_db;
+	float amplitude_gain;
+	float smoothed_gain;	// reached by the last block, ramped to amplitude_gain over the next
+	int running;	// 0 until the first block, parameters set before it apply at once
+	cd_noise_color_t color;
+
+	uint32_t key;	// of the stream and channel, see cd_set_noise_generator_stream
+	uint32_t position;	// index in the stream of the next sample made
+
+	// colored noise, see cd_next_colored_noise
+	float pending[4];	// made in groups of 4, the end of the last group
+	unsigned pending_count;
+	unsigned group_counter;
+	float rows[CUTE_DSP_PINK_NOISE_ROWS];
+	float high_rows;	// sum of the rows above 1
+	float brown;
+	float brown_leak;
+	int velvet_spacing;
+	int velvet_period;	// start of the current period and place of its impulse, from the current group
+	int velvet_impulse;
+} cd_noise_t;
+
+typedef struct cd_wind_t
+{
+	cd_wind_def_t def;
+	unsigned position;	// read position in the shared noise
+	float radians_per_hz;	// pi / sampling rate
+	float gain;	// reached at the end of the last block, the next block ramps from it
+	float phases[2];	// of the gust LFOs, in radians
+	float body_k;	// damping of the bandpass filters, 1 / Q
+	float whistle_k;
+	float body_ic1eq;	// states of the bandpass filters
+	float body_ic2eq;
+	float whistle_ic1eq;
+	float whistle_ic2eq;
+} cd_wind_t;
+
+typedef struct cd_reverb_t
+{
+	float* memory;	// every delay line one after another
+	float* lines[CUTE_DSP_REVERB_LINES];
+	int lengths[CUTE_DSP_REVERB_LINES];
+	int positions[CUTE_DSP_REVERB_LINES];
+	float gains[CUTE_DSP_REVERB_LINES];	// per line decay, so every line falls 60dB in decay seconds
+	float damping_states[CUTE_DSP_REVERB_LINES];
+	float damping_coeff;
+	float sampling_rate;
+	float decay;
+	float damping;
+	volatile int dirty;	// parameters changed, gains are recomputed on the mix thread
+} cd_reverb_t;
+
+typedef struct cd_bus_t
+{
+	char name[CUTE_DSP_MAX_BUS_NAME];
+	unsigned index;
+	cd_lowpass_t* lowpass;	// stereo pairs, NULL for effects the bus doesn't use
+	cd_highpass_t* highpass;
+	cd_echo_t* echo;
+	cd_multitap_t* reflections;
+	cd_convolver_t* convolver;
+	cd_reverb_t* reverb;
+	cs_loaded_sound_t return_sound;
+	float send[CUTE_DSP_STEREO][CUTE_DSP_MAX_FRAME_LENGTH];	// voices sent to the bus since its last block
+	float output[CUTE_DSP_STEREO][CUTE_DSP_MAX_FRAME_LENGTH];
+} cd_bus_t;
+
+typedef struct cd_filter_group_t
+{
+	char name[CUTE_DSP_MAX_FILTER_GROUP_NAME];
+	cd_context_t* context;
+	cd_coefficients_t* lowpass;	// at the rate of the context, shared by the members
+	cd_coefficients_t* highpass;
+	cd_coefficients_t* lowpass_reduced[CUTE_DSP_MULTIRATE_STAGES];	// at the reduced rates, shared by the members with a multirate limit
+	cd_coefficients_t* highpass_reduced[CUTE_DSP_MULTIRATE_STAGES];
+	float lowpass_cutoff;
+	float lowpass_resonance;
+	float highpass_cutoff;
+	int lowpass_set;	// members joining take the filters the group has set
+	int highpass_set;
+} cd_filter_group_t;
+
+/* END OPAQUE STRUCT IMPLEMENTATION */
+/* BEGIN FUNCTION IMPLEMENTATION */
+
+/* BEGIN FAST MATH IMPLEMENTATION */
+#if defined(CUTE_DSP_FAST_MATH)
+/*
+	Approximations selected by CUTE_DSP_FAST_MATH, made of SSE2 adds and multiplies without calls into libm.
+	The 4 wide forms convert 4 values at once, and the scalar forms run them on one lane, so a value comes
+	out the same bits either way. Largest errors measured over their ranges:
+	- exp2: 2.3e-7 relative, for x in [-126, 126], clamped outside
+	- log2: 1.5e-7 absolute for x in [0.5, 2], 1.1e-7 relative elsewhere, 0 gives -127 rather than -inf
+	- sin and cos: 1.8e-7 absolute, for |x| up to 1000 radians
+	- dB to gain 9.1e-7 relative, gain to dB 8.1e-6 dB absolute, for -120 to 24 dB
+	One at a time they cost about the same as glibc's, gain to dB 1.5 times less, and 4 at a time 4 times less.
+*/
+#define CUTE_DSP_PI_HIGH (3.140625f)	// pi in 8 bits, n * CUTE_DSP_PI_HIGH is exact below 2^15
+#define CUTE_DSP_PI_LOW (9.67653589793e-4f)
+
+// 2^x, the nearest integer power times a minimax polynomial of degree 5 for the rest in [-1/2, 1/2]
+static __m128 cd_exp2_ps(__m128 x)
+{
+	__m128i n;
+	__m128 y, p;
+	x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.f)), _mm_set1_ps(126.f));
+	n = _mm_cvtps_epi32(x);
+	y = _mm_sub_ps(x, _mm_cvtepi32_ps(n));
+	p = _mm_add_ps(_mm_set1_ps(9.67554134e-3f), _mm_mul_ps(y, _mm_set1_ps(1.32764720e-3f)));
+	p = _mm_add_ps(_mm_set1_ps(5.55071327e-2f), _mm_mul_ps(y, p));
+	p = _mm_add_ps(_mm_set1_ps(2.40221197e-1f), _mm_mul_ps(y, p));
+	p = _mm_add_ps(_mm_set1_ps(6.93146967e-1f), _mm_mul_ps(y, p));
+	p = _mm_add_ps(_mm_set1_ps(1.00000007f), _mm_mul_ps(y, p));
+	return _mm_mul_ps(p, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23)));
+}
+
+// log2 of positive x, the exponent plus 2 atanh(t) / ln(2) of the mantissa m in [0.707, 1.414), t = (m - 1) / (m + 1),
+// by a minimax polynomial of t of degree 5
+static __m128 cd_log2_ps(__m128 x)
+{
+	__m128i bits = _mm_castps_si128(x);
+	__m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+	__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+	__m128 above = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+	__m128 t, t2, p;
+
+	// mantissas above sqrt(2) are halved, with one more power of 2
+	m = _mm_sub_ps(m, _mm_and_ps(above, _mm_mul_ps(m, _mm_set1_ps(0.5f))));
+	e = _mm_sub_epi32(e, _mm_castps_si128(above));
+	t = _mm_div_ps(_mm_sub_ps(m, _mm_set1_ps(1.f)), _mm_add_ps(m, _mm_set1_ps(1.f)));
+	t2 = _mm_mul_ps(t, t);
+	p = _mm_add_ps(_mm_set1_ps(9.61470809e-1f), _mm_mul_ps(t2, _mm_set1_ps(5.98973886e-1f)));
+	p = _mm_add_ps(_mm_set1_ps(2.88539129f), _mm_mul_ps(t2, p));
+	p = _mm_mul_ps(t, p);
+	return _mm_add_ps(_mm_cvtepi32_ps(e), p);
+}
+
+// sin(x - k pi) by a minimax polynomial of degree 9, |x - k pi| <= pi / 2, negated for odd n
+static __m128 cd_sin_reduced_ps(__m128 x, __m128 k, __m128i n)
+{
+	__m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(CUTE_DSP_PI_HIGH))), _mm_mul_ps(k, _mm_set1_ps(CUTE_DSP_PI_LOW)));
+	__m128 r2 = _mm_mul_ps(r, r);
+	__m128 p = _mm_add_ps(_mm_set1_ps(-1.98008978e-4f), _mm_mul_ps(r2, _mm_set1_ps(2.59048850e-6f)));
+	p = _mm_add_ps(_mm_set1_ps(8.33289982e-3f), _mm_mul_ps(r2, p));
+	p = _mm_add_ps(_mm_set1_ps(-1.66666476e-1f), _mm_mul_ps(r2, p));
+	p = _mm_add_ps(_mm_set1_ps(9.99999977e-1f), _mm_mul_ps(r2, p));
+	return _mm_xor_ps(_mm_mul_ps(r, p), _mm_castsi128_ps(_mm_slli_epi32(n, 31)));
+}
+
+static __m128 cd_sin_ps(__m128 x)
+{
+	__m128i n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.f / CUTE_DSP_PI)));
+	return cd_sin_reduced_ps(x, _mm_cvtepi32_ps(n), n);
+}
+
+// cos(x) = sin(x + pi / 2), reduced by n - 1/2 periods so the half period is never rounded into x
+static __m128 cd_cos_ps(__m128 x)
+{
+	__m128i n = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.f / CUTE_DSP_PI)), _mm_set1_ps(0.5f)));
+	return cd_sin_reduced_ps(x, _mm_sub_ps(_mm_cvtepi32_ps(n), _mm_set1_ps(0.5f)), n);
+}
+
+static float cd_fast_exp2(float x) { return _mm_cvtss_f32(cd_exp2_ps(_mm_set_ss(x))); }
+static float cd_fast_log2(float x) { return _mm_cvtss_f32(cd_log2_ps(_mm_set1_ps(x))); }
+static float cd_fast_sin(float x) { return _mm_cvtss_f32(cd_sin_ps(_mm_set_ss(x))); }
+static float cd_fast_cos(float x) { return _mm_cvtss_f32(cd_cos_ps(_mm_set_ss(x))); }
+#endif
+/* END FAST MATH IMPLEMENTATION */
+
+
+/* BEGIN PLUGIN INTERFACE IMPLEMENTATION */
+static cd_context_t* cd_get_context(void);
+static cd_voice_t* cd_make_voice(cd_context_t* context, const cs_playing_sound_t* sound);
+static void cd_release_voice(cd_context_t* context, cd_voice_t* voice);
+static void cd_capture_voice_mix(cd_context_t* context, const cd_voice_t* voice, int channel_index, const float* samples, int sample_count);
+static void cd_capture_parameter(cd_context_t* context, const cs_playing_sound_t* playing_sound, int parameter, float value);
+static void cd_capture_parameters(cd_context_t* context, cs_playing_sound_t** playing_sounds, int parameter, const float* values, int count);
+static void cd_mix_cached_voice(cd_context_t* context, cd_voice_t* voice, int channel_index, int sample_count, float** samples_out);
+static void cd_release_render_reference(cd_context_t* context, cd_voice_t* voice);
+static void cd_parameter_changed(cd_context_t* context, const cs_playing_sound_t* playing_sound, int parameter, float value);
+static void cd_release_render_cache(cd_context_t* context);
+static void cd_mix_bus_return(cd_context_t* context, cd_bus_t* bus, int channel_index, int sample_count, float** samples_out);
+static void cd_accumulate_bus_send(float* send, const float* samples, float gain, int sample_count);
+static void cd_apply_dry_gain(cd_context_t* context, const float* input, float** output, unsigned num_samples, float gain);
+static const cd_randomization_table_t* cd_find_randomization(const cd_context_t* context, const cs_loaded_sound_t* sound);
+static void cd_randomize_lowpass(cd_context_t* context, const cs_playing_sound_t* sound, cd_lowpass_t* filter);
+static void cd_randomize_highpass(cd_context_t* context, const cs_playing_sound_t* sound, cd_highpass_t* filter);
+static void cd_randomize_echo(cd_context_t* context, const cs_playing_sound_t* sound, cd_echo_t* filter);
+static void cd_randomize_noise(cd_context_t* context, const cs_playing_sound_t* sound, cd_noise_t* filter);
+static void cd_release_randomizations(cd_context_t* context);
+static int cd_update_quality(cd_quality_t* quality, const float* samples, unsigned sample_count);
+static void cd_end_governor_block(cd_context_t* context);
+static void cd_govern_voice(cd_context_t* context, cd_voice_t* voice);
+static void cd_sample_lowpass_tiers(cd_context_t* context, cd_lowpass_t* filter, const float* input, float** output, unsigned sample_count, const cd_quality_t* quality);
+static void cd_sample_highpass_tiers(cd_context_t* context, cd_highpass_t* filter, const float* input, float** output, unsigned sample_count, const cd_quality_t* quality);
+static void cd_sample_echo_tiers(cd_context_t* context, cd_echo_t* filter, const float* input, float** output, unsigned sample_count, const cd_quality_t* quality);
+static void cd_sample_noise_tiers(cd_context_t* context, cd_noise_t* filter, const float* input, float** output, unsigned sample_count, const cd_quality_t* quality);
+static void cd_sample_chorus_tiers(cd_context_t* context, cd_chorus_t* filter, const float* input, float** output, unsigned sample_count, const cd_quality_t* quality);
+static void cd_update_voice_multirate(cd_context_t* context, cd_voice_t* voice, const cs_playing_sound_t* sound, unsigned sample_count);
+static void cd_mix_voice_multirate(cd_context_t* context, cd_voice_t* voice, const cs_playing_sound_t* sound, int channel_index, const float* samples_in, unsigned sample_count, float** samples_out);
+static void cd_reduce_filters(cd_lowpass_t* lowpass, cd_highpass_t* highpass, unsigned limit);
+
+static void cd_voice_on_make_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void** playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	*playing_sound_udata = cd_make_voice(ctx, sound);
+
+	// unused parameters
+	(void)cs_ctx;
+}
+
+static void cd_voice_on_free_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	cd_release_voice(ctx, (cd_voice_t*)playing_sound_udata);
+
+	// unused parameters
+	(void)cs_ctx;
+	(void)sound;
+}
+
+static void cd_voice_on_mix(cs_context_t* cs_ctx, void* plugin_instance, int channel_index, const float* samples_in, int sample_count, float** samples_out, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* context = (cd_context_t*)plugin_instance;
+	cd_voice_t* voice = (cd_voice_t*)playing_sound_udata;
+	cd_governor_t* governor = &context->governor;
+	if (governor->budget > 0.f && channel_index == 0)
+		governor->mix_start = CUTE_DSP_SECONDS();
+	++context->mix_clock;
+
+	// cute_sound mixes every voice once per block, so seeing a voice twice starts the next block
+	if (channel_index == 0)
+	{
+		if (voice->mixed_block == context->block_index)
+		{
+			++context->block_index;
+			cd_end_governor_block(context);
+		}
+		voice->mixed_block = context->block_index;
+		governor->block_frames = (unsigned)sample_count;
+
+		cd_govern_voice(context, voice);
+		if (cd_update_quality(&voice->quality, samples_in, (unsigned)sample_count))
+		{
+			++governor->voices_degraded;
+			governor->stats.degraded_samples += (unsigned)sample_count * voice->channel_count;
+		}
+		if (voice->quality.tier != voice->quality.previous_tier)
+			++context->tier_transitions;
+		if (!voice->cache && !voice->bus_return)
+			cd_update_voice_multirate(context, voice, sound, (unsigned)sample_count);
+	}
+	context->tier_samples[voice->quality.tier] += (unsigned)sample_count;
+
+	if (context->capture.file)
+		cd_capture_voice_mix(context, voice, channel_index, samples_in, sample_count);
+
+	// parameter changes hand the voice back to the filters at the start of a block
+	if (voice->cache && voice->cache_detach && channel_index == 0)
+		cd_release_render_reference(context, voice);
+
+	if (voice->bus_return)
+		cd_mix_bus_return(context, voice->bus_return, channel_index, sample_count, samples_out);
+	else if (voice->cache)
+		cd_mix_cached_voice(context, voice, channel_index, sample_count, samples_out);
+	else if (voice->multirate.factor > 1 || voice->multirate.previous_factor > 1)
+		cd_mix_voice_multirate(context, voice, sound, channel_index, samples_in, (unsigned)sample_count, samples_out);
+	else
+		*samples_out = (float*)samples_in;
+
+	// unused parameters
+	(void)cs_ctx;
+}
+
+cs_plugin_interface_t cd_make_voice_plugin(void)
+{
+	cs_plugin_interface_t plugin;
+	plugin.plugin_instance = cd_get_context();
+	plugin.on_make_playing_sound_fn = cd_voice_on_make_playing_sound;
+	plugin.on_free_playing_sound_fn = cd_voice_on_free_playing_sound;
+	plugin.on_mix_fn = cd_voice_on_mix;
+
+	return plugin;
+}
+
+// voices playing from the render cache or a bus return skip every filter, multirate voices run them in the voice plugin
+static int cd_voice_bypasses_filters(const cd_context_t* context, const cs_playing_sound_t* sound)
+{
+	const cd_voice_t* voice = (const cd_voice_t*)sound->plugin_udata[context->voice_id];
+	return voice->cache != 0 || voice->bus_return || voice->multirate.factor > 1 || voice->multirate.previous_factor > 1;
+}
+
+static const cd_quality_t* cd_voice_quality(const cd_context_t* context, const cs_playing_sound_t* sound)
+{
+	return &((const cd_voice_t*)sound->plugin_udata[context->voice_id])->quality;
+}
+
+static cd_lowpass_t* cd_make_lowpass_channels(cd_context_t* ctx, int channel_count)
+{
+	cd_lowpass_t* lowpass = cd_make_lowpass_filter(ctx);
+	if (channel_count == 2)
+		lowpass->next = cd_make_lowpass_filter(ctx);
+	return lowpass;
+}
+
+static void cd_lowpass_on_make_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void** playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	cd_lowpass_t* lowpass = cd_make_lowpass_channels(ctx, sound->loaded_sound->channel_count);
+	cd_randomize_lowpass(ctx, sound, lowpass);
+	cd_reduce_filters(lowpass, NULL, ((const cd_voice_t*)sound->plugin_udata[ctx->voice_id])->multirate.limit);
+	*playing_sound_udata = lowpass;
+
+	// unused parameters
+	(void)cs_ctx;
+}
+
+static void cd_lowpass_on_free_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	cd_lowpass_t* filter = (cd_lowpass_t*)playing_sound_udata;
+	if(filter->next)
+	{
+		cd_release_lowpass(ctx, &(filter->next));
+	}
+	cd_release_lowpass(ctx, &filter);
+
+	// unused parameters
+	(void)cs_ctx;
+	(void)sound;
+}
+
+static void cd_lowpass_on_mix(cs_context_t* cs_ctx, void* plugin_instance, int channel_index, const float* samples_in, int sample_count, float** samples_out, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_lowpass_t* filter = 0;
+	cd_context_t* context = (cd_context_t*)plugin_instance;
+	if (cd_voice_bypasses_filters(context, sound))
+	{
+		*samples_out = (float*)samples_in;
+		return;
+	}
+
+	switch(channel_index)
+	{
+	case 0:
+		filter = (cd_lowpass_t*)playing_sound_udata;
+		break;
+	case 1:
+		filter = (cd_lowpass_t*)playing_sound_udata;
+		filter = filter->next;
+		break;
+	}
+	cd_sample_lowpass_tiers(context, filter, samples_in, samples_out, (unsigned)sample_count, cd_voice_quality(context, sound));
+
+	// unused parameters
+	(void)cs_ctx;
+	(void)sound;
+}
+
+cs_plugin_interface_t cd_make_lowpass_plugin(void)
+{
+	cs_plugin_interface_t plugin;
+	plugin.plugin_instance = cd_get_context();
+	plugin.on_make_playing_sound_fn = cd_lowpass_on_make_playing_sound;
+	plugin.on_free_playing_sound_fn = cd_lowpass_on_free_playing_sound;
+	plugin.on_mix_fn = cd_lowpass_on_mix;
+
+	return plugin;
+}
+
+static cd_highpass_t* cd_make_highpass_channels(cd_context_t* ctx, int channel_count)
+{
+	cd_highpass_t* filter = cd_make_highpass_filter(ctx);
+	if (channel_count == 2)
+		filter->next = cd_make_highpass_filter(ctx);
+	return filter;
+}
+
+static void cd_highpass_on_make_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void** playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	cd_highpass_t* highpass = cd_make_highpass_channels(ctx, sound->loaded_sound->channel_count);
+	cd_randomize_highpass(ctx, sound, highpass);
+	cd_reduce_filters(NULL, highpass, ((const cd_voice_t*)sound->plugin_udata[ctx->voice_id])->multirate.limit);
+	*playing_sound_udata = highpass;
+}
+
+static void cd_highpass_on_free_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	cd_highpass_t* filter = (cd_highpass_t*)playing_sound_udata;
+	if(filter->next)
+	{
+		cd_release_highpass(ctx, &(filter->next));
+	}
+	cd_release_highpass(ctx, &filter);
+}
+
+static void cd_highpass_on_mix(cs_context_t* cs_ctx, void* plugin_instance, int channel_index, const float* samples_in, int sample_count, float** samples_out, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_highpass_t* filter = 0;
+	cd_context_t* context = (cd_context_t*)plugin_instance;
+	if (cd_voice_bypasses_filters(context, sound))
+	{
+		*samples_out = (float*)samples_in;
+		return;
+	}
+
+	switch(channel_index)
+	{
+	case 0:
+		filter = (cd_highpass_t*)playing_sound_udata;
+		break;
+	case 1:
+		filter = (cd_highpass_t*)playing_sound_udata;
+		filter = filter->next;
+		break;
+	}
+	cd_sample_highpass_tiers(context, filter, samples_in, samples_out, (unsigned)sample_count, cd_voice_quality(context, sound));
+}
+
+cs_plugin_interface_t cd_make_highpass_plugin()
+{
+	cs_plugin_interface_t plugin;
+	plugin.plugin_instance = cd_get_context();
+	plugin.on_make_playing_sound_fn = cd_highpass_on_make_playing_sound;
+	plugin.on_free_playing_sound_fn = cd_highpass_on_free_playing_sound;
+	plugin.on_mix_fn = cd_highpass_on_mix;
+
+	return plugin;
+}
+
+static cd_echo_t* cd_make_echo_channels(cd_context_t* ctx, int channel_count)
+{
+	cd_echo_t* echo = cd_make_echo_filter(ctx);
+	if (channel_count == 2)
+		echo->next = cd_make_echo_filter(ctx);
+	return echo;
+}
+
+static void cd_echo_on_make_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void** playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	cd_echo_t* echo = cd_make_echo_channels(ctx, sound->loaded_sound->channel_count);
+	cd_randomize_echo(ctx, sound, echo);
+	*playing_sound_udata = echo;
+
+	// unused parameters
+	(void)cs_ctx;
+}
+
+static void cd_echo_on_free_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	cd_echo_t* filter = (cd_echo_t*)playing_sound_udata;
+	if (filter->next)
+	{
+		cd_release_echo_filter(ctx, &(filter->next));
+	}
+	cd_release_echo_filter(ctx, &filter);
+
+	// unused parameters
+	(void)cs_ctx;
+	(void)sound;
+}
+
+static void cd_echo_on_mix(cs_context_t* cs_ctx, void* plugin_instance, int channel_index, const float* samples_in, int sample_count, float** samples_out, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_echo_t* filter = 0;
+	cd_context_t* context = (cd_context_t*)plugin_instance;
+	if (cd_voice_bypasses_filters(context, sound))
+	{
+		*samples_out = (float*)samples_in;
+		return;
+	}
+
+	switch (channel_index)
+	{
+	case 0:
+		filter = (cd_echo_t*)playing_sound_udata;
+		break;
+	case 1:
+		filter = (cd_echo_t*)playing_sound_udata;
+		filter = filter->next;
+		break;
+	}
+	cd_sample_echo_tiers(context, filter, samples_in, samples_out, (unsigned)sample_count, cd_voice_quality(context, sound));
+
+	// unused parameters
+	(void)cs_ctx;
+	(void)sound;
+}
+
+cs_plugin_interface_t cd_make_echo_plugin(void)
+{
+	cs_plugin_interface_t plugin;
+	plugin.plugin_instance = cd_get_context();
+	plugin.on_make_playing_sound_fn = cd_echo_on_make_playing_sound;
+	plugin.on_free_playing_sound_fn = cd_echo_on_free_playing_sound;
+	plugin.on_mix_fn = cd_echo_on_mix;
+
+	return plugin;
+}
+
+static cd_chorus_t* cd_make_chorus_channels(cd_context_t* ctx, int channel_count)
+{
+	cd_chorus_t* chorus = cd_make_chorus(ctx);
+	if (channel_count == 2)
+	{
+		// a quarter cycle apart, so the sides sweep apart
+		chorus->next = cd_make_chorus(ctx);
+		chorus->next->phase = 0.25f;
+	}
+	return chorus;
+}
+
+static void cd_chorus_on_make_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void** playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	*playing_sound_udata = cd_make_chorus_channels(ctx, sound->loaded_sound->channel_count);
+
+	// unused parameters
+	(void)cs_ctx;
+}
+
+static void cd_chorus_on_free_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	cd_chorus_t* filter = (cd_chorus_t*)playing_sound_udata;
+	if (filter->next)
+	{
+		cd_release_chorus(ctx, &(filter->next));
+	}
+	cd_release_chorus(ctx, &filter);
+
+	// unused parameters
+	(void)cs_ctx;
+	(void)sound;
+}
+
+// isn't part of the render cache, so it runs on cached voices too, only bus returns skip it
+static void cd_chorus_on_mix(cs_context_t* cs_ctx, void* plugin_instance, int channel_index, const float* samples_in, int sample_count, float** samples_out, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_chorus_t* filter = 0;
+	cd_context_t* context = (cd_context_t*)plugin_instance;
+	const cd_voice_t* voice = (const cd_voice_t*)sound->plugin_udata[context->voice_id];
+	if (voice->bus_return)
+	{
+		*samples_out = (float*)samples_in;
+		return;
+	}
+
+	switch (channel_index)
+	{
+	case 0:
+		filter = (cd_chorus_t*)playing_sound_udata;
+		break;
+	case 1:
+		filter = (cd_chorus_t*)playing_sound_udata;
+		filter = filter->next;
+		break;
+	}
+	cd_sample_chorus_tiers(context, filter, samples_in, samples_out, (unsigned)sample_count, &voice->quality);
+
+	// unused parameters
+	(void)cs_ctx;
+}
+
+cs_plugin_interface_t cd_make_chorus_plugin(void)
+{
+	cs_plugin_interface_t plugin;
+	plugin.plugin_instance = cd_get_context();
+	plugin.on_make_playing_sound_fn = cd_chorus_on_make_playing_sound;
+	plugin.on_free_playing_sound_fn = cd_chorus_on_free_playing_sound;
+	plugin.on_mix_fn = cd_chorus_on_mix;
+
+	return plugin;
+}
+
+static cd_noise_t* cd_make_noise_channels(cd_context_t* ctx, int channel_count)
+{
+	cd_noise_t* noise = cd_make_noise_generator(ctx);
+	if (channel_count == 2)
+		noise->next = cd_make_noise_generator(ctx);
+	return noise;
+}
+
+static void cd_noise_on_make_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void** playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	const cd_voice_t* voice = (const cd_voice_t*)sound->plugin_udata[ctx->voice_id];
+	cd_noise_t* noise = cd_make_noise_channels(ctx, sound->loaded_sound->channel_count);
+	cd_set_noise_generator_stream(ctx, noise, voice->id, 0);
+	cd_randomize_noise(ctx, sound, noise);
+	*playing_sound_udata = noise;
+
+	// unused parameters
+	(void)cs_ctx;
+}
+
+static void cd_noise_on_free_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* ctx = (cd_context_t*)plugin_instance;
+	cd_noise_t* filter = (cd_noise_t*)playing_sound_udata;
+	if (filter->next)
+	{
+		cd_release_noise(ctx, &(filter->next));
+	}
+
+	cd_release_noise(ctx, &filter);
+
+	// unused parameters
+	(void)cs_ctx;
+	(void)sound;
+}
+
+static void cd_noise_on_mix(cs_context_t* cs_ctx, void* plugin_instance, int channel_index, const float* samples_in, int sample_count, float** samples_out, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_noise_t* filter = 0;
+	cd_context_t* context = (cd_context_t*)plugin_instance;
+	if (cd_voice_bypasses_filters(context, sound))
+	{
+		*samples_out = (float*)samples_in;
+		return;
+	}
+
+	switch (channel_index)
+	{
+	case 0:
+		filter = (cd_noise_t*)playing_sound_udata;
+		break;
+	case 1:
+		filter = (cd_noise_t*)playing_sound_udata;
+		filter = filter->next;
+		break;
+	}
+	cd_sample_noise_tiers(context, filter, samples_in, samples_out, (unsigned)sample_count, cd_voice_quality(context, sound));
+
+	// unused parameters
+	(void)cs_ctx;
+	(void)sound;
+}
+
+cs_plugin_interface_t cd_make_noise_plugin(void)
+{
+	cs_plugin_interface_t plugin;
+	plugin.plugin_instance = cd_get_context();
+	plugin.on_make_playing_sound_fn = cd_noise_on_make_playing_sound;
+	plugin.on_free_playing_sound_fn = cd_noise_on_free_playing_sound;
+	plugin.on_mix_fn = cd_noise_on_mix;
+
+	return plugin;
+}
+
+static void cd_bus_send_on_make_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void** playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	// the send levels live in the voice
+	*playing_sound_udata = 0;
+
+	// unused parameters
+	(void)cs_ctx;
+	(void)plugin_instance;
+	(void)sound;
+}
+
+static void cd_bus_send_on_free_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	// unused parameters
+	(void)cs_ctx;
+	(void)plugin_instance;
+	(void)playing_sound_udata;
+	(void)sound;
+}
+
+static void cd_bus_send_on_mix(cs_context_t* cs_ctx, void* plugin_instance, int channel_index, const float* samples_in, int sample_count, float** samples_out, void* playing_sound_udata, const cs_playing_sound_t* sound)
+{
+	cd_context_t* context = (cd_context_t*)plugin_instance;
+	const cd_voice_t* voice = (const cd_voice_t*)sound->plugin_udata[context->voice_id];
+	cd_governor_t* governor = &context->governor;
+	unsigned i = 0;
+	*samples_out = (float*)samples_in;
+
+	// sums the filtered voice into every bus it is sent to, mono voices feed both sides
+	for (; !voice->bus_return && i < context->bus_count; ++i)
+	{
+		cd_bus_t* bus = context->buses[i];
+		float send = voice->sends[i];
+		if (send == 0.f)
+			continue;
+		cd_accumulate_bus_send(bus->send[channel_index], samples_in, send, sample_count);
+		if (voice->channel_count == 1)
+			cd_accumulate_bus_send(bus->send[1], samples_in, send, sample_count);
+	}
+
+	if (!voice->bus_return && voice->dry_gain != 1.f)
+		cd_apply_dry_gain(context, samples_in, samples_out, (unsigned)sample_count, voice->dry_gain);
+
+	// the last plugin on the last channel of every voice, cute_sound runs each plugin over all channels before the next
+	if (governor->mix_start != 0.0 && (unsigned)channel_index + 1 == voice->channel_count)
+	{
+		governor->block_time += CUTE_DSP_SECONDS() - governor->mix_start;
+		governor->mix_start = 0.0;
+	}
+
+	// unused parameters
+	(void)cs_ctx;
+	(void)playing_sound_udata;
+}
+
+cs_plugin_interface_t cd_make_bus_send_plugin(void)
+{
+	cs_plugin_interface_t plugin;
+	plugin.plugin_instance = cd_get_context();
+	plugin.on_make_playing_sound_fn = cd_bus_send_on_make_playing_sound;
+	plugin.on_free_playing_sound_fn = cd_bus_send_on_free_playing_sound;
+	plugin.on_mix_fn = cd_bus_send_on_mix;
+
+	return plugin;
+}
+
+/* END PLUGIN INTERFACE IMPLEMENTATION */
+
+/* BEGIN MEMORY POOL IMPLEMENTATION */
+void cd_make_memory_pool(cd_memory_pool_t* mem_pool, cd_memory_pool_def_t def)
+{
+	char* pool = NULL;
+	unsigned i = 0;
+
+	CUTE_DSP_ASSERT(mem_pool);
+	mem_pool->size_per_object = def.size_per_object;
+	mem_pool->max_objects = def.max_objects;
+	mem_pool->pool_size = def.max_objects * def.size_per_object;
+	mem_pool->num_objects = 0;
+	mem_pool->free_list = NULL;
+	
+	pool = CUTE_DSP_ALLOC(mem_pool->pool_size, 0);
+	mem_pool->pool = pool;
+	CUTE_DSP_ASSERT(pool);
+
+	// initialize free list
+	for(i = 0; i < def.max_objects; ++i)
+	{
+		cd_memory_pool_object_t* obj = (cd_memory_pool_object_t *)(mem_pool->pool + i * def.size_per_object);
+		obj->next = mem_pool->free_list;
+		mem_pool->free_list = obj;
+	}
+}
+
+void cd_release_memory_pool(cd_memory_pool_t* mem_pool)
+{
+	CUTE_DSP_ASSERT(mem_pool);
+	if(mem_pool->pool)
+	{
+		CUTE_DSP_FREE(mem_pool->pool, 0);
+		mem_pool->pool = NULL;
+	}
+}
+
+void* cd_memory_pool_alloc(cd_memory_pool_t* mem_pool)
+{
+	CUTE_DSP_ASSERT(mem_pool);
+
+	// case the pool is empty
+	if(mem_pool->free_list == NULL)
+	{
+		// allocate from the heap normally
+		void* object = CUTE_DSP_ALLOC(mem_pool->size_per_object, 0);
+		CUTE_DSP_ASSERT(object);
+		++mem_pool->num_objects;
+		return object;
+	}
+	else
+	{
+		// pull another object from the free list
+		cd_memory_pool_object_t* object = mem_pool->free_list;
+		mem_pool->free_list = mem_pool->free_list->next;
+		++mem_pool->num_objects;
+		return object;
+	}
+}
+
+void cd_memory_pool_free(cd_memory_pool_t* mem_pool, void* object)
+{
+	char* obj = (char *)object;
+	size_t obj_distance, pool_distance;
+	CUTE_DSP_ASSERT(object && mem_pool);
+
+	obj_distance = obj - mem_pool->pool;
+	pool_distance = (mem_pool->pool + mem_pool->pool_size) - mem_pool->pool;
+
+	// case object isn't in the pool
+	if(pool_distance < obj_distance && obj_distance >= 0)
+	{
+		CUTE_DSP_FREE(object, 0);
+	}
+	// case object is in the pool
+	else
+	{
+		// put it back on the free list
+		cd_memory_pool_object_t* mem_obj = (cd_memory_pool_object_t*)(object);
+		mem_obj->next = mem_pool->free_list;
+		mem_pool->free_list = mem_obj;
+	}
+	
+	--mem_pool->num_objects;
+}
+/* END MEMORY POOL IMPLEMENTATION */
+
+/* BEGIN RING BUFFER IMPLEMENTATION */
+
+void cd_ring_buffer_init(cd_ring_buffer_t* buff, int num_elements)
+{
+	if (num_elements)
+	{
+		buff->buffer = (float*)CUTE_DSP_ALLOC((sizeof(float) * num_elements), 0);
+		buff->current_index = 0;
+		buff->max_elements = num_elements;
+		memset(buff->buffer, 0, sizeof(float) * num_elements);
+	}
+	else
+	{
+		buff->buffer = 0;
+		buff->current_index = 0;
+		buff->max_elements = 0;
+	}
+}
+
+static inline void cd_ring_buffer_put(cd_ring_buffer_t* buff, float value)
+{
+	buff->buffer[buff->current_index] = value;
+	buff->current_index = (buff->current_index + 1) % buff->max_elements;
+}
+
+static inline float cd_ring_buffer_get(cd_ring_buffer_t* buff, int delay)
+{
+	int index = buff->current_index - delay - 1;
+	index %= buff->max_elements;
+	if (index < 0) index += buff->max_elements;
+	return buff->buffer[index];
+}
+
+void cd_ring_buffer_release(cd_ring_buffer_t* buff)
+{
+	CUTE_DSP_ASSERT(buff);
+	if(buff->buffer)
+		CUTE_DSP_FREE(buff->buffer, 0);
+	buff->buffer = 0;
+	buff->current_index = 0;
+	buff->max_elements = 0;
+}
+
+/* END RING BUFFER IMPLEMENTATION */
+
+/* BEGIN RANDOM IMPLEMENTATION */
+
+void cd_random_seed(cd_random_t* prng, uint64_t seed)
+{
+	prng->a = seed / 2;
+	prng->b = seed;
+}
+
+uint64_t cd_random_rand(cd_random_t* prng)
+{
+	uint64_t t = prng->a;
+	uint64_t const s = prng->b;
+	prng->a = s;
+	t ^= t << 23;
+	t ^= t >> 17;
+	t ^= s ^ (s >> 26);
+	prng->b = t;
+	return t + s;
+}
+
+float cd_random_rand_between(cd_random_t* prng, float min_val, float max_val)
+{
+	uint64_t raw = cd_random_rand(prng);
+	double scale = (double)raw / (double)CUTE_DSP_PRNG_MAX;
+	return (float)((double)min_val + scale * ((double)max_val - (double)min_val));
+}
+
+// seeds 4 xorshift32 PRNGs from prng, distinct even when prng is seeded with 0, and never 0 where xorshift32 gets stuck
+static __m128i cd_random_seed4(cd_random_t* prng)
+{
+	uint32_t seeds[4];
+	int i = 0;
+	for (; i < 4; ++i)
+		seeds[i] = (uint32_t)cd_random_rand(prng);
+	__m128i x = _mm_loadu_si128((const __m128i*)seeds);
+	x = _mm_xor_si128(x, _mm_set_epi32((int)0x9e3779b9, (int)0x7f4a7c15, (int)0x85ebca6b, (int)0xc2b2ae35));
+	return _mm_or_si128(x, _mm_set1_epi32(1));
+}
+
+static __m128i cd_random_rand4(__m128i x)
+{
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+	return _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+}
+
+// 23 random bits of mantissa in [1, 2), then [-1, 1)
+static __m128 cd_random_to_float4(__m128i x)
+{
+	__m128 one_to_two = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(x, 9), _mm_set1_epi32(0x3f800000)));
+	return _mm_sub_ps(_mm_mul_ps(one_to_two, _mm_set1_ps(2.f)), _mm_set1_ps(3.f));
+}
+
+static float cd_random_to_float(uint32_t x)
+{
+	float one_to_two;
+	x = (x >> 9) | 0x3f800000;
+	memcpy(&one_to_two, &x, 4);
+	return one_to_two * 2.f - 3.f;
+}
+
+/*
+	Counter based random numbers: value n of a stream is a hash of n and the key of the stream, so any
+	block of a stream is made without the values before it. The key comes from the seed and the stream
+	through the splitmix64 finalizer, n goes through a Weyl sequence xored with the key, then through
+	the lowbias32 finalizer.
+*/
+#define CUTE_DSP_WEYL_STEP (0x9e3779b9u)
+
+static uint32_t cd_random_key(uint64_t seed, unsigned stream, unsigned channel)
+{
+	unsigned long long z = (unsigned long long)seed + (((unsigned long long)stream << 32 | channel) + 1) * 0x9e3779b97f4a7c15ull;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return (uint32_t)(z ^ (z >> 31));
+}
+
+static uint32_t cd_random_hash(uint32_t key, uint32_t n)
+{
+	uint32_t x = n * CUTE_DSP_WEYL_STEP ^ key;
+	x ^= x >> 16;
+	x *= 0x21f0aaadu;
+	x ^= x >> 15;
+	x *= 0x735a2d97u;
+	return x ^ (x >> 15);
+}
+
+// SSE2 has no 32 bit multiply, so the even and odd lanes are multiplied to 64 bits and their low halves put back together
+static __m128i cd_random_mul4(__m128i x, uint32_t c)
+{
+	const __m128i m = _mm_set1_epi32((int)c);
+	__m128i even = _mm_mul_epu32(x, m);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), m);
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// cd_random_hash of 4 values, from their Weyl sequence n * CUTE_DSP_WEYL_STEP
+static __m128i cd_random_hash4(__m128i key, __m128i weyl)
+{
+	__m128i x = _mm_xor_si128(weyl, key);
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+	x = cd_random_mul4(x, 0x21f0aaadu);
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+	x = cd_random_mul4(x, 0x735a2d97u);
+	return _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+}
+
+// Weyl sequence of the 4 values from n, and the step to the next 4
+#define cd_random_weyl4(n) _mm_add_epi32(_mm_set1_epi32((int)((n) * CUTE_DSP_WEYL_STEP)), _mm_set_epi32((int)(3u * CUTE_DSP_WEYL_STEP), (int)(2u * CUTE_DSP_WEYL_STEP), (int)CUTE_DSP_WEYL_STEP, 0))
+#define CUTE_DSP_WEYL_STEP4 _mm_set1_epi32((int)(4u * CUTE_DSP_WEYL_STEP))
+
+// channel of the key of the randomization picks of a voice, never one of its noise channels
+#define CUTE_DSP_RANDOMIZATION_CHANNEL (~0u)
+
+// pick n of a key, in [0, steps)
+static unsigned cd_random_pick(uint32_t key, unsigned n, unsigned steps)
+{
+	return (unsigned)(((unsigned long long)cd_random_hash(key, n) * steps) >> 32);
+}
+
+/* END RANDOM IMPLEMENTATION */
+
+/* BEGIN LOCK IMPLEMENTATION */
+
+static void cd_lock(cd_lock_t* lock)
+{
+	while (CUTE_DSP_ATOMIC_EXCHANGE(lock, 1))
+		;
+}
+
+static void cd_unlock(cd_lock_t* lock)
+{
+	CUTE_DSP_ATOMIC_RELEASE(lock);
+}
+
+/* END LOCK IMPLEMENTATION */
+
+/* BEGIN CONTEXT IMPLEMENTATION */
+static cd_context_t* cd_get_context(void)
+{
+	return g_dsp_context;
+}
+
+#define cd_context_swap_buffers(context)	\
+{	\
+	if (context->current_output == context->output1)	\
+	{	\
+		context->current_output = context->output2;	\
+	}	\
+	else	\
+	{	\
+		context->current_output = context->output1;	\
+	}	\
+}
+
+static void cd_release_buses(cd_context_t* context);
+static void cd_release_filter_groups(cd_context_t* context);
+static void cd_make_coefficient_cache(cd_context_t* context);
+static void cd_release_coefficient_cache(cd_context_t* context);
+static int cd_chorus_line_length(float sampling_rate);
+
+cd_context_t* cd_make_context(cs_context_t* sound_ctx, cd_context_def_t def)
+{
+	cd_memory_pool_def_t voice_def;
+	cd_memory_pool_def_t lowpass_def;
+	cd_memory_pool_def_t highpass_def;
+	cd_memory_pool_def_t echo_def;
+	cd_memory_pool_def_t noise_def;
+	cd_memory_pool_def_t chorus_def;
+
+	cd_context_t* context = (cd_context_t *)CUTE_DSP_ALLOC(sizeof(cd_context_t), 0);
+	CUTE_DSP_ASSERT(context && def.playing_pool_count);
+	CUTE_DSP_ASSERT(def.filter_order == 0 || def.filter_order == 2 || def.filter_order == 4 || def.filter_order == 8);
+	CUTE_DSP_ASSERT(def.quality_tier <= CD_TIER_AUTO);
+	CUTE_DSP_ASSERT(def.cpu_budget >= 0.f && def.cpu_budget - def.cpu_budget == 0.f);	// finite
+	CUTE_DSP_ASSERT(def.multirate_limit <= 2 || def.multirate_limit == 4);
+	memset(context, 0, sizeof(cd_context_t));
+
+	// detached contexts don't replace the singleton used by the plugins
+	if (sound_ctx)
+		g_dsp_context = context;
+
+	context->def = def;
+	context->sampling_rate = def.sampling_rate;
+	context->render_cache.budget = def.render_cache_bytes;
+	context->pool_size = def.playing_pool_count * 2;
+	context->channel_count = CUTE_DSP_STEREO;
+	memset(context->output1, 0, sizeof(float) * CUTE_DSP_MAX_FRAME_LENGTH);
+	memset(context->output2, 0, sizeof(float) * CUTE_DSP_MAX_FRAME_LENGTH);
+	context->current_output = context->output1;
+	cd_make_coefficient_cache(context);
+	if (sound_ctx)
+		context->coefficients.mix_clock = &context->mix_clock;
+
+	/* voice bookkeeping, registered first so it runs before every filter */
+	voice_def.max_objects = def.playing_pool_count;
+	voice_def.size_per_object = sizeof(cd_voice_t);
+	cd_make_memory_pool(&context->voices, voice_def);
+	if (sound_ctx)
+	{
+		cs_plugin_interface_t voice_interface = cd_make_voice_plugin();
+		context->voice_id = cs_add_plugin(sound_ctx, &voice_interface);
+	}
+	else
+	{
+		context->voice_id = CUTE_DSP_INVALID_PLUGIN_ID;
+	}
+
+	/* set up filters =========================================== */
+	/* noise filter */
+	if (def.use_noise)
+	{
+		noise_def.max_objects = context->pool_size;
+		noise_def.size_per_object = sizeof(cd_noise_t);
+		cd_make_memory_pool(&context->noise_generators, noise_def);
+
+		if (sound_ctx)
+		{
+			cs_plugin_interface_t noise_interface = cd_make_noise_plugin();
+			context->noise_id = cs_add_plugin(sound_ctx, &noise_interface);
+		}
+		else
+		{
+			context->noise_id = CUTE_DSP_INVALID_PLUGIN_ID;
+		}
+
+		cd_random_seed(&context->random_generator, def.rand_seed);
+	}
+	else
+	{
+		memset(&context->noise_generators, 0, sizeof(cd_memory_pool_t));
+		context->noise_id = CUTE_DSP_INVALID_PLUGIN_ID;
+	}
+
+	/* lowpass filter, the pool also holds the filters of the buses */
+	lowpass_def.max_objects = (def.use_lowpass ? context->pool_size : 0) + CUTE_DSP_MAX_BUSES * CUTE_DSP_STEREO;
+	lowpass_def.size_per_object = sizeof(cd_lowpass_t);
+	cd_make_memory_pool(&context->lowpass_filters, lowpass_def);
+	if (def.use_lowpass && sound_ctx)
+	{
+		cs_plugin_interface_t lowpass_interface = cd_make_lowpass_plugin();
+		context->lowpass_id = cs_add_plugin(sound_ctx, &lowpass_interface);
+	}
+	else
+	{
+		context->lowpass_id = CUTE_DSP_INVALID_PLUGIN_ID;
+	}
+
+	/* highpass filter, the pool also holds the filters of the buses */
+	highpass_def.max_objects = (def.use_highpass ? context->pool_size : 0) + CUTE_DSP_MAX_BUSES * CUTE_DSP_STEREO;
+	highpass_def.size_per_object = sizeof(cd_highpass_t);
+	cd_make_memory_pool(&context->highpass_filters, highpass_def);
+	if (def.use_highpass && sound_ctx)
+	{
+		cs_plugin_interface_t highpass_interface = cd_make_highpass_plugin();
+		context->highpass_id = cs_add_plugin(sound_ctx, &highpass_interface);
+	}
+	else
+	{
+		context->highpass_id = CUTE_DSP_INVALID_PLUGIN_ID;
+	}
+
+	/* echo filter, the pool also holds the filters of the buses */
+	echo_def.max_objects = (def.use_echo ? context->pool_size : 0) + CUTE_DSP_MAX_BUSES * CUTE_DSP_STEREO;
+	echo_def.size_per_object = sizeof(cd_echo_t);
+	cd_make_memory_pool(&context->echo_filters, echo_def);
+	if (def.use_echo && sound_ctx)
+	{
+		cs_plugin_interface_t echo_interface = cd_make_echo_plugin();
+		context->echo_id = cs_add_plugin(sound_ctx, &echo_interface);
+	}
+	else
+	{
+		context->echo_id = CUTE_DSP_INVALID_PLUGIN_ID;
+	}
+
+	if (def.echo_max_delay_s == 0.f)
+		context->echo_max_delay_s = CUTE_DSP_DEFAULT_ECHO_MAX_DELAY;
+	else
+		context->echo_max_delay_s = def.echo_max_delay_s;
+
+	/* chorus, the ring buffer of every chorus is allocated with it */
+	chorus_def.max_objects = context->pool_size;
+	chorus_def.size_per_object = sizeof(cd_chorus_t) + sizeof(float) * cd_chorus_line_length(context->sampling_rate);
+	if (def.use_chorus)
+	{
+		cd_make_memory_pool(&context->choruses, chorus_def);
+		if (sound_ctx)
+		{
+			cs_plugin_interface_t chorus_interface = cd_make_chorus_plugin();
+			context->chorus_id = cs_add_plugin(sound_ctx, &chorus_interface);
+		}
+		else
+		{
+			context->chorus_id = CUTE_DSP_INVALID_PLUGIN_ID;
+		}
+	}
+	else
+	{
+		// choruses made by hand come from the heap
+		memset(&context->choruses, 0, sizeof(cd_memory_pool_t));
+		context->choruses.size_per_object = chorus_def.size_per_object;
+		context->chorus_id = CUTE_DSP_INVALID_PLUGIN_ID;
+	}
+
+	memset(&context->governor, 0, sizeof(cd_governor_t));
+	context->governor.budget = def.cpu_budget;
+	context->governor.threshold_db = CUTE_DSP_GOVERNOR_IDLE_DB;
+	context->governor.min_score = -CUTE_DSP_GOVERNOR_IDLE_DB;
+	context->governor.max_score = CUTE_DSP_GOVERNOR_IDLE_DB;
+	context->governor.stats.threshold_db = CUTE_DSP_GOVERNOR_IDLE_DB;
+
+	/* bus sends, the plugin runs after every filter */
+	if (sound_ctx)
+	{
+		cs_plugin_interface_t bus_send_interface = cd_make_bus_send_plugin();
+		context->bus_send_id = cs_add_plugin(sound_ctx, &bus_send_interface);
+	}
+	else
+	{
+		context->bus_send_id = CUTE_DSP_INVALID_PLUGIN_ID;
+	}
+
+	if (def.use_reverb)
+	{
+		cd_bus_def_t reverb_def;
+		memset(&reverb_def, 0, sizeof(cd_bus_def_t));
+		reverb_def.name = "reverb";
+		reverb_def.use_reverb = 1;
+		context->reverb_bus = cd_make_bus(context, reverb_def);
+	}
+
+	return context;
+}
+
+void cd_release_context(cd_context_t** context)
+{
+	CUTE_DSP_ASSERT(context && *context);
+
+	if ((*context)->capture.file)
+		cd_end_capture(*context);
+	cd_release_render_cache(*context);
+	cd_release_buses(*context);
+	cd_release_filter_groups(*context);
+	cd_release_randomizations(*context);
+	cd_release_coefficient_cache(*context);
+
+	// unused pools are zeroed, so they have no memory to release
+	cd_release_memory_pool(&(*context)->voices);
+	cd_release_memory_pool(&(*context)->lowpass_filters);
+	cd_release_memory_pool(&(*context)->highpass_filters);
+	cd_release_memory_pool(&(*context)->echo_filters);
+	cd_release_memory_pool(&(*context)->noise_generators);
+	cd_release_memory_pool(&(*context)->choruses);
+	if ((*context)->wind_noise)
+		CUTE_DSP_FREE((*context)->wind_noise, 0);
+
+	if (g_dsp_context == *context)
+		g_dsp_context = 0;
+	CUTE_DSP_FREE(*context, 0);
+	*context = 0;
+}
+
+/* END CONTEXT IMPLEMENTATION */
+
+/* BEGIN VOICE IMPLEMENTATION */
+static void cd_capture_voice(cd_context_t* context, const cd_voice_t* voice, int event);
+static void cd_capture_voice_parameter(cd_context_t* context, const cd_voice_t* voice, int parameter, float value);
+
+static cd_voice_t* cd_make_voice(cd_context_t* context, const cs_playing_sound_t* sound)
+{
+	cd_voice_t* voice = NULL;
+	unsigned i = 0;
+	CUTE_DSP_ASSERT(context && sound);
+
+	// voices are made on the game thread and released on the mix thread
+	cd_lock(&context->voice_lock);
+	voice = (cd_voice_t*)cd_memory_pool_alloc(&context->voices);
+	CUTE_DSP_ASSERT(voice);
+	voice->next = 0;
+	voice->sound = sound;
+	voice->id = ++context->voice_counter;
+	voice->channel_count = sound->loaded_sound->channel_count;
+	voice->mixed_block = CUTE_DSP_INVALID_BLOCK;
+	voice->cache = 0;
+	voice->cache_position = 0;
+	voice->cache_loops = 0;
+	voice->cache_detach = 0;
+	memset(voice->sends, 0, sizeof(voice->sends));
+	voice->dry_gain = 1.f;
+	voice->bus_return = 0;
+	voice->filter_group = 0;
+	voice->randomization = cd_find_randomization(context, sound->loaded_sound);
+	voice->random_key = voice->randomization ? cd_random_key(context->def.rand_seed, voice->id, CUTE_DSP_RANDOMIZATION_CHANNEL) : 0;
+	memset(&voice->quality, 0, sizeof(voice->quality));
+	voice->quality.requested = context->def.quality_tier;
+	voice->quality.loudness_db = CUTE_DSP_QUALITY_REDUCED_DB;
+	memset(&voice->multirate, 0, sizeof(voice->multirate));
+	voice->multirate.limit = context->def.multirate_limit;
+	voice->multirate.factor = voice->multirate.previous_factor = 1;
+	for (; i < context->bus_count; ++i)
+		if (sound->loaded_sound == &context->buses[i]->return_sound)
+			voice->bus_return = context->buses[i];
+	voice->prev_active = 0;
+	voice->next_active = context->active_voices;
+	if (context->active_voices)
+		context->active_voices->prev_active = voice;
+	context->active_voices = voice;
+	cd_unlock(&context->voice_lock);
+
+	if (context->capture.file)
+	{
+		cd_capture_voice(context, voice, CD_CAPTURE_SPAWN);
+		if (voice->quality.requested != CD_TIER_FULL)
+			cd_capture_voice_parameter(context, voice, CD_CAPTURE_QUALITY_TIER, (float)voice->quality.requested);
+		if (voice->multirate.limit > 1)
+			cd_capture_voice_parameter(context, voice, CD_CAPTURE_MULTIRATE_LIMIT, (float)voice->multirate.limit);
+	}
+	return voice;
+}
+
+static void cd_release_voice(cd_context_t* context, cd_voice_t* voice)
+{
+	CUTE_DSP_ASSERT(context && voice);
+	if (context->capture.file)
+		cd_capture_voice(context, voice, CD_CAPTURE_FREE);
+	if (voice->cache)
+		cd_release_render_reference(context, voice);
+
+	cd_lock(&context->voice_lock);
+	if (voice->prev_active)
+		voice->prev_active->next_active = voice->next_active;
+	else
+		context->active_voices = voice->next_active;
+	if (voice->next_active)
+		voice->next_active->prev_active = voice->prev_active;
+	cd_memory_pool_free(&context->voices, voice);
+	cd_unlock(&context->voice_lock);
+}
+
+/* END VOICE IMPLEMENTATION */
+
+/* BEGIN BIQUAD CASCADE IMPLEMENTATION */
+/*
+	Sections of a cascade depend on each other sample by sample, so rather than one section per call the
+	sections are skewed in time: SSE lane k runs section k on sample n - k, fed by the output lane k - 1
+	produced on the previous step. One step of 4 lanes costs about the same as one sample of a single
+	biquad, whatever the order. Orders below 8 fill the spare lanes with sections that pass their input
+	through. The first and last 3 steps of every call only update the lanes that are inside the block,
+	so the cascade adds no delay.
+*/
+
+// bilinear transform designs of the sections, at w radians per sample
+static void cd_design_biquad_cascade(cd_filter_design_t* design, int order, cd_filter_alignment_t alignment, float w, float resonance, int highpass)
+{
+	int sections = order / 2, resonant = 0, k;
+	float half_order = alignment == CD_FILTER_LINKWITZ_RILEY ? (float)order / 2.f : (float)order;
+	float angles[4];
+	float cos_w = CUTE_DSP_COS(w), sin_w = CUTE_DSP_SIN(w);
+
+	// angle of the poles of each section from the imaginary axis, Linkwitz-Riley repeats each Butterworth section
+	for (k = 0; k < sections; ++k)
+	{
+		int pole = alignment == CD_FILTER_LINKWITZ_RILEY ? k % (sections / 2 > 0 ? sections / 2 : 1) : k;
+		angles[k] = half_order < 2.f ? CUTE_DSP_PI / 2.f : CUTE_DSP_PI / 2.f - CUTE_DSP_PI * (2.f * (float)pole + 1.f) / (2.f * half_order);
+		if (angles[k] <= angles[resonant])
+			resonant = k;
+	}
+
+	// resonance moves the poles of the sharpest section towards the imaginary axis, like the single section lowpass
+	angles[resonant] *= 1.f - resonance;
+
+	for (k = 0; k < 4; ++k)
+	{
+		float alpha, a0;
+		if (k >= sections)
+		{
+			design->b0[k] = 1.f;
+			design->b1[k] = design->b2[k] = design->a1[k] = design->a2[k] = 0.f;
+			continue;
+		}
+
+		// alpha = sin(w) / 2Q, with 1/Q = 2 sin(angle)
+		alpha = sin_w * CUTE_DSP_SIN(angles[k]);
+		a0 = 1.f / (1.f + alpha);
+		if (highpass)
+		{
+			design->b0[k] = (1.f + cos_w) * 0.5f * a0;
+			design->b1[k] = -(1.f + cos_w) * a0;
+		}
+		else
+		{
+			design->b0[k] = (1.f - cos_w) * 0.5f * a0;
+			design->b1[k] = (1.f - cos_w) * a0;
+		}
+		design->b2[k] = design->b0[k];
+		design->a1[k] = 2.f * cos_w * a0;
+		design->a2[k] = (alpha - 1.f) * a0;
+	}
+}
+
+// order 0 keeps the single section filters
+static int cd_biquad_cascade_order(unsigned filter_order, cd_filter_alignment_t alignment)
+{
+	if (filter_order > 2 || alignment == CD_FILTER_LINKWITZ_RILEY)
+		return filter_order > 2 ? (int)filter_order : 2;
+	return 0;
+}
+
+static void cd_make_biquad_cascade(const cd_context_t* context, cd_biquad_cascade_t* cascade)
+{
+	memset(cascade, 0, sizeof(cd_biquad_cascade_t));
+	cascade->alignment = context->def.filter_alignment;
+	cascade->order = cd_biquad_cascade_order(context->def.filter_order, cascade->alignment);
+}
+
+// clears the history of every section, the next block starts at the current coefficients
+static void cd_reset_biquad_cascade(cd_biquad_cascade_t* cascade)
+{
+	memset(cascade->x1, 0, sizeof(cascade->x1));
+	memset(cascade->x2, 0, sizeof(cascade->x2));
+	memset(cascade->y1, 0, sizeof(cascade->y1));
+	memset(cascade->y2, 0, sizeof(cascade->y2));
+	cascade->running = 0;
+}
+
+#define cd_cascade_blend(mask, a, b) _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b))
+
+// the coefficients ramp by steps of a sample up to the last input, lane k lags k samples behind
+#define cd_cascade_ramp(c, target, k, step) \
+	(c = _mm_loadu_ps(cascade->smoothed[k]), \
+	step = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(target), c), ramp), \
+	_mm_storeu_ps(cascade->smoothed[k], _mm_loadu_ps(target)))
+
+static void cd_sample_biquad_cascade(cd_biquad_cascade_t* cascade, const cd_filter_design_t* design, const float* input, float* samples, unsigned num_samples)
+{
+	const __m128 lanes = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+	const __m128 ramp = _mm_set1_ps(num_samples ? 1.f / (float)num_samples : 0.f);
+	__m128 b0, b1, b2, a1, a2, db0, db1, db2, da1, da2;
+	__m128 x1 = _mm_loadu_ps(cascade->x1);
+	__m128 x2 = _mm_loadu_ps(cascade->x2);
+	__m128 y1 = _mm_loadu_ps(cascade->y1);
+	__m128 y2 = _mm_loadu_ps(cascade->y2);
+	__m128 x, y;
+	unsigned n = 0, steps = num_samples + 3;
+
+	if (!cascade->running)
+	{
+		memcpy(cascade->smoothed[0], design->b0, sizeof(design->b0));
+		memcpy(cascade->smoothed[1], design->b1, sizeof(design->b1));
+		memcpy(cascade->smoothed[2], design->b2, sizeof(design->b2));
+		memcpy(cascade->smoothed[3], design->a1, sizeof(design->a1));
+		memcpy(cascade->smoothed[4], design->a2, sizeof(design->a2));
+		cascade->running = 1;
+	}
+	cd_cascade_ramp(b0, design->b0, 0, db0);
+	cd_cascade_ramp(b1, design->b1, 1, db1);
+	cd_cascade_ramp(b2, design->b2, 2, db2);
+	cd_cascade_ramp(a1, design->a1, 3, da1);
+	cd_cascade_ramp(a2, design->a2, 4, da2);
+
+	for (; n < steps; ++n)
+	{
+		if (n < num_samples)
+		{
+			b0 = _mm_add_ps(b0, db0);
+			b1 = _mm_add_ps(b1, db1);
+			b2 = _mm_add_ps(b2, db2);
+			a1 = _mm_add_ps(a1, da1);
+			a2 = _mm_add_ps(a2, da2);
+		}
+
+		// lane 0 takes the next input, every other lane the previous output of the lane before it
+		x = _mm_move_ss(_mm_shuffle_ps(y1, y1, _MM_SHUFFLE(2, 1, 0, 0)), _mm_set_ss(n < num_samples ? input[n] : 0.f));
+		y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, x), _mm_mul_ps(b1, x1)), _mm_add_ps(_mm_mul_ps(b2, x2), _mm_add_ps(_mm_mul_ps(a1, y1), _mm_mul_ps(a2, y2))));
+
+		if (n >= 3 && n < num_samples)
+		{
+			x2 = x1;
+			x1 = x;
+			y2 = y1;
+			y1 = y;
+		}
+		else
+		{
+			// lane k is inside the block while 0 <= n - k < num_samples
+			__m128 active = _mm_and_ps(_mm_cmple_ps(lanes, _mm_set1_ps((float)n)), _mm_cmpgt_ps(lanes, _mm_set1_ps((float)n - (float)num_samples)));
+			x2 = cd_cascade_blend(active, x1, x2);
+			x1 = cd_cascade_blend(active, x, x1);
+			y2 = cd_cascade_blend(active, y1, y2);
+			y1 = cd_cascade_blend(active, y, y1);
+		}
+
+		if (n >= 3)
+			_mm_store_ss(samples + n - 3, _mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 3, 3)));
+	}
+
+	_mm_storeu_ps(cascade->x1, x1);
+	_mm_storeu_ps(cascade->x2, x2);
+	_mm_storeu_ps(cascade->y1, y1);
+	_mm_storeu_ps(cascade->y2, y2);
+}
+
+#undef cd_cascade_ramp
+/* END BIQUAD CASCADE IMPLEMENTATION */
+
+/* BEGIN COEFFICIENT CACHE IMPLEMENTATION */
+/*
+	Every lowpass and highpass filter points to the coefficients of its parameters in a cache of the
+	context, keyed by the cutoff rounded to 0.01Hz, the resonance rounded to 0.001 and the sampling
+	rate. Voices sharing parameters share one entry, so a setter only looks the design up and only the
+	first filter of a design pays for the sines. Both channels of a filter hold the same entry.
+	Entries are reference counted. Unreferenced entries stay in the cache and are reused oldest first
+	once the entries made with the context run out, so sweeping a parameter doesn't allocate. Entries
+	dropped while the mix thread may still read them aren't reused until it is a block further.
+	Designs are made from the rounded parameters, whichever value was set first, so every filter of a
+	key runs the same coefficients.
+*/
+
+static int cd_coefficient_cutoff_key(float freq_in_hz)
+{
+	return (int)(freq_in_hz * CUTE_DSP_COEFFICIENT_CUTOFF_STEPS + 0.5f);
+}
+
+static int cd_coefficient_resonance_key(float resonance)
+{
+	return (int)(resonance * CUTE_DSP_COEFFICIENT_RESONANCE_STEPS + 0.5f);
+}
+
+static void cd_design_lowpass(cd_filter_design_t* design, int order, cd_filter_alignment_t alignment, float sampling_rate, float freq_in_hz, float resonance)
+{
+	float cutoff = 2.f * CUTE_DSP_PI * freq_in_hz;
+	float theta = resonance * CUTE_DSP_PI / 4.f;
+	float R = sampling_rate;
+	float R2 = R * R;
+	float g = 2.f * cutoff * CUTE_DSP_SIN(CUTE_DSP_PI / 4.f - theta) * R;
+	float d = 1.f / (R2 + g + cutoff * cutoff);
+	memset(design, 0, sizeof(cd_filter_design_t));
+	design->freq_cutoff = freq_in_hz;
+	design->resonance = resonance;
+	design->x_coeff = (cutoff * cutoff) * d;
+	design->y1_coeff = (2.f * R2 + g) * d;
+	design->y2_coeff = -1.f * R2 * d;
+	if (order)
+		cd_design_biquad_cascade(design, order, alignment, cutoff / R, resonance, 0);
+}
+
+static void cd_design_highpass(cd_filter_design_t* design, int order, cd_filter_alignment_t alignment, float sampling_rate, float freq_in_hz)
+{
+	float T = 2.f * CUTE_DSP_PI * freq_in_hz / sampling_rate;
+	float Y = 1.f / (1 + CUTE_DSP_SQRT_2 * T + T * T);
+	memset(design, 0, sizeof(cd_filter_design_t));
+	design->freq_cutoff = freq_in_hz;
+	design->x_coeff = Y;
+	design->x1_coeff = -2.f * Y;
+	design->y1_coeff = (2.f + CUTE_DSP_SQRT_2 * T) * Y;
+	design->y2_coeff = -Y;
+	if (order)
+		cd_design_biquad_cascade(design, order, alignment, T, 0.f, 1);
+}
+
+// the design of the rounded parameters, as the cache holds it
+static void cd_design_filter(cd_filter_design_t* design, int highpass, int order, cd_filter_alignment_t alignment, float sampling_rate, int cutoff_key, int resonance_key)
+{
+	float freq_in_hz = (float)cutoff_key / CUTE_DSP_COEFFICIENT_CUTOFF_STEPS;
+	if (highpass)
+		cd_design_highpass(design, order, alignment, sampling_rate, freq_in_hz);
+	else
+		cd_design_lowpass(design, order, alignment, sampling_rate, freq_in_hz, (float)resonance_key / CUTE_DSP_COEFFICIENT_RESONANCE_STEPS);
+}
+
+static unsigned cd_coefficient_bucket(int highpass, float sampling_rate, int cutoff_key, int resonance_key)
+{
+	unsigned rate, hash;
+	memcpy(&rate, &sampling_rate, sizeof(rate));
+	hash = (unsigned)cutoff_key * 2654435761u ^ (unsigned)resonance_key * 40503u ^ rate * 31u ^ (unsigned)highpass;
+	return (hash ^ (hash >> 16)) & (CUTE_DSP_COEFFICIENT_BUCKETS - 1);
+}
+
+static void cd_make_coefficient_cache(cd_context_t* context)
+{
+	cd_coefficient_cache_t* cache = &context->coefficients;
+	cd_memory_pool_def_t def;
+	memset(cache, 0, sizeof(cd_coefficient_cache_t));
+	def.max_objects = CUTE_DSP_COEFFICIENT_POOL;
+	def.size_per_object = sizeof(cd_coefficients_t);
+	cd_make_memory_pool(&cache->entries, def);
+	cache->alignment = context->def.filter_alignment;
+	cache->order = cd_biquad_cascade_order(context->def.filter_order, cache->alignment);
+}
+
+static void cd_release_coefficient_cache(cd_context_t* context)
+{
+	cd_coefficient_cache_t* cache = &context->coefficients;
+	unsigned i;
+	for (i = 0; i < CUTE_DSP_COEFFICIENT_BUCKETS; ++i)
+	{
+		while (cache->buckets[i])
+		{
+			cd_coefficients_t* entry = cache->buckets[i];
+			cache->buckets[i] = entry->next;
+			cd_memory_pool_free(&cache->entries, entry);
+		}
+	}
+	cd_release_memory_pool(&cache->entries);
+}
+
+static void cd_unlink_unused_coefficients(cd_coefficient_cache_t* cache, cd_coefficients_t* entry)
+{
+	if (entry->newer)
+		entry->newer->older = entry->older;
+	else
+		cache->newest = entry->older;
+	if (entry->older)
+		entry->older->newer = entry->newer;
+	else
+		cache->oldest = entry->newer;
+	entry->newer = entry->older = NULL;
+	--cache->unused;
+}
+
+// the mix thread may still read an entry dropped while it mixed a channel, or the one before when the clock
+// was read just as it advanced
+static int cd_coefficients_in_use(const cd_coefficient_cache_t* cache, const cd_coefficients_t* entry)
+{
+	return cache->mix_clock && *cache->mix_clock - entry->dropped_clock < 2;
+}
+
+// takes the oldest unreferenced entry out of the cache
+static cd_coefficients_t* cd_evict_coefficients(cd_coefficient_cache_t* cache)
+{
+	cd_coefficients_t* entry = cache->oldest;
+	cd_coefficients_t** link;
+	cd_unlink_unused_coefficients(cache, entry);
+	link = cache->buckets + cd_coefficient_bucket(entry->highpass, entry->sampling_rate, entry->cutoff_key, entry->resonance_key);
+	while (*link != entry)
+		link = &(*link)->next;
+	*link = entry->next;
+	return entry;
+}
+
+// a new entry, or the oldest unreferenced one once the pool is used up. Entries taken from the heap past the
+// pool are freed again once the mix thread is done with them. While no voice is mixed the clock stands still,
+// so past CUTE_DSP_COEFFICIENT_UNUSED entries the oldest is reused anyway, a channel is mixed long before
+// that many more are dropped.
+static cd_coefficients_t* cd_make_coefficients(cd_coefficient_cache_t* cache)
+{
+	while (cache->entries.num_objects > CUTE_DSP_COEFFICIENT_POOL && cache->oldest && !cd_coefficients_in_use(cache, cache->oldest))
+		cd_memory_pool_free(&cache->entries, cd_evict_coefficients(cache));
+
+	if (cache->entries.free_list || !cache->oldest
+		|| (cd_coefficients_in_use(cache, cache->oldest) && cache->unused < CUTE_DSP_COEFFICIENT_UNUSED))
+		return (cd_coefficients_t*)cd_memory_pool_alloc(&cache->entries);
+	return cd_evict_coefficients(cache);
+}
+
+// the entry of the quantized parameters, found or made while the lock is held
+static cd_coefficients_t* cd_find_coefficients(cd_coefficient_cache_t* cache, int highpass, float sampling_rate, int cutoff_key, int resonance_key, const cd_filter_design_t* design)
+{
+	unsigned bucket = cd_coefficient_bucket(highpass, sampling_rate, cutoff_key, resonance_key);
+	cd_coefficients_t* entry;
+	for (entry = cache->buckets[bucket]; entry; entry = entry->next)
+	{
+		if (entry->cutoff_key == cutoff_key && entry->resonance_key == resonance_key
+			&& entry->sampling_rate == sampling_rate && entry->highpass == highpass)
+			break;
+	}
+
+	if (entry)
+	{
+		++cache->hits;
+		if (!entry->refs)
+			cd_unlink_unused_coefficients(cache, entry);
+		return entry;
+	}
+
+	++cache->misses;
+	entry = cd_make_coefficients(cache);
+	CUTE_DSP_ASSERT(entry);
+	entry->cache = cache;
+	entry->sampling_rate = sampling_rate;
+	entry->highpass = highpass;
+	entry->cutoff_key = cutoff_key;
+	entry->resonance_key = resonance_key;
+	entry->refs = 0;
+	entry->newer = entry->older = NULL;
+
+	// precomputed designs are only taken if they were made from the same rounded parameters
+	if (design && design->freq_cutoff == (float)cutoff_key / CUTE_DSP_COEFFICIENT_CUTOFF_STEPS
+		&& (highpass || design->resonance == (float)resonance_key / CUTE_DSP_COEFFICIENT_RESONANCE_STEPS))
+		entry->design = *design;
+	else
+		cd_design_filter(&entry->design, highpass, cache->order, cache->alignment, sampling_rate, cutoff_key, resonance_key);
+	entry->next = cache->buckets[bucket];
+	cache->buckets[bucket] = entry;
+	return entry;
+}
+
+// unreferenced entries stay in the cache, newest first, while the lock is held
+static void cd_drop_coefficients(cd_coefficient_cache_t* cache, cd_coefficients_t* entry)
+{
+	CUTE_DSP_ASSERT(entry->refs > 0);
+	if (--entry->refs)
+		return;
+	entry->dropped_clock = cache->mix_clock ? *cache->mix_clock : 0;
+	++cache->unused;
+	entry->older = cache->newest;
+	if (cache->newest)
+		cache->newest->newer = entry;
+	else
+		cache->oldest = entry;
+	cache->newest = entry;
+}
+
+static cd_coefficients_t* cd_acquire_coefficients(cd_coefficient_cache_t* cache, int highpass, float sampling_rate, float freq_in_hz, float resonance)
+{
+	cd_coefficients_t* entry;
+	cd_lock(&cache->lock);
+	entry = cd_find_coefficients(cache, highpass, sampling_rate, cd_coefficient_cutoff_key(freq_in_hz), highpass ? 0 : cd_coefficient_resonance_key(resonance), NULL);
+	++entry->refs;
+	cd_unlock(&cache->lock);
+	return entry;
+}
+
+static void cd_release_coefficients(cd_coefficients_t* entry)
+{
+	cd_coefficient_cache_t* cache = entry->cache;
+	cd_lock(&cache->lock);
+	cd_drop_coefficients(cache, entry);
+	cd_unlock(&cache->lock);
+}
+
+// points a filter to the coefficients of the parameters, design is taken on a miss if it holds them already
+static void cd_use_coefficients(cd_coefficients_t** coefficients, int highpass, float sampling_rate, float freq_in_hz, float resonance, const cd_filter_design_t* design)
+{
+	cd_coefficients_t* previous = *coefficients;
+	cd_coefficient_cache_t* cache = previous->cache;
+	int cutoff_key = cd_coefficient_cutoff_key(freq_in_hz);
+	int resonance_key = highpass ? 0 : cd_coefficient_resonance_key(resonance);
+	cd_coefficients_t* entry;
+
+	// the keys of a referenced entry never change, so setting the same parameters again takes no lock
+	if (previous->cutoff_key == cutoff_key && previous->resonance_key == resonance_key && previous->sampling_rate == sampling_rate)
+		return;
+
+	cd_lock(&cache->lock);
+	entry = cd_find_coefficients(cache, highpass, sampling_rate, cutoff_key, resonance_key, design);
+	++entry->refs;
+	cd_drop_coefficients(cache, previous);
+	cd_unlock(&cache->lock);
+	*coefficients = entry;
+}
+
+// the other channel of a filter takes a reference to the same entry, without a lookup
+static void cd_share_coefficients(cd_coefficients_t** coefficients, cd_coefficients_t* shared)
+{
+	cd_coefficients_t* previous = *coefficients;
+	if (previous == shared)
+		return;
+	cd_lock(&shared->cache->lock);
+	++shared->refs;
+	cd_drop_coefficients(shared->cache, previous);
+	cd_unlock(&shared->cache->lock);
+	*coefficients = shared;
+}
+
+// the cutoff of a design at the rate of a multirate stage, below its Nyquist frequency
+static float cd_reduced_cutoff(float sampling_rate, unsigned stage, float freq_in_hz)
+{
+	float most = CUTE_DSP_MULTIRATE_MAX_CUTOFF * sampling_rate / (float)(2u << stage);
+	return freq_in_hz < most ? freq_in_hz : most;
+}
+
+// takes the designs of the stages up to the limit a filter doesn't hold yet, they are kept until it is released
+static void cd_acquire_reduced_coefficients(cd_coefficient_cache_t* cache, cd_coefficients_t** reduced, unsigned limit, int highpass, float sampling_rate, float freq_in_hz, float resonance)
+{
+	unsigned stage = 0;
+	for (; stage < CUTE_DSP_MULTIRATE_STAGES && (2u << stage) <= limit; ++stage)
+	{
+		if (!reduced[stage])
+			reduced[stage] = cd_acquire_coefficients(cache, highpass, sampling_rate / (float)(2u << stage), cd_reduced_cutoff(sampling_rate, stage, freq_in_hz), resonance);
+	}
+}
+
+static void cd_release_reduced_coefficients(cd_coefficients_t** reduced)
+{
+	unsigned stage = 0;
+	for (; stage < CUTE_DSP_MULTIRATE_STAGES && reduced[stage]; ++stage)
+		cd_release_coefficients(reduced[stage]);
+}
+
+// follows a change of the parameters at the reduced rates a filter holds designs of
+static void cd_use_reduced_coefficients(cd_coefficients_t** reduced, int highpass, float sampling_rate, float freq_in_hz, float resonance)
+{
+	unsigned stage = 0;
+	for (; stage < CUTE_DSP_MULTIRATE_STAGES && reduced[stage]; ++stage)
+		cd_use_coefficients(reduced + stage, highpass, sampling_rate / (float)(2u << stage), cd_reduced_cutoff(sampling_rate, stage, freq_in_hz), resonance, NULL);
+}
+
+static void cd_share_reduced_coefficients(cd_coefficients_t** reduced, cd_coefficients_t* const* shared)
+{
+	unsigned stage = 0;
+	for (; stage < CUTE_DSP_MULTIRATE_STAGES && reduced[stage]; ++stage)
+		cd_share_coefficients(reduced + stage, shared[stage]);
+}
+
+// the coefficients of the rate the mix thread runs a lowpass or highpass at
+#define cd_mixed_coefficients(filter) ((filter)->factor > 1 ? (filter)->reduced[(filter)->factor >> 2] : (filter)->coefficients)
+/* END COEFFICIENT CACHE IMPLEMENTATION */
+
+/* BEGIN LOWPASS IMPLEMENTATION */
+void cd_set_lowpass_parameters(cd_lowpass_t* filter, float freq_in_hz, float resonance)
+{
+	if (resonance < 0.f || resonance > 1.f
+		|| freq_in_hz < CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF 
+		|| freq_in_hz > CUTE_DSP_DEFAULT_LOWPASS_CUTOFF)
+		return;
+	
+	filter->resonance = resonance;
+	filter->freq_cutoff = freq_in_hz;
+	cd_use_coefficients(&filter->coefficients, 0, filter->sampling_rate, freq_in_hz, resonance, NULL);
+	cd_use_reduced_coefficients(filter->reduced, 0, filter->sampling_rate, freq_in_hz, resonance);
+}
+
+// the filter and the other channel chained after it, which shares its coefficients
+static void cd_set_lowpass_channels(cd_lowpass_t* filter, float freq_in_hz, float resonance)
+{
+	cd_lowpass_t* next = filter->next;
+	cd_set_lowpass_parameters(filter, freq_in_hz, resonance);
+	if (!next)
+		return;
+	next->freq_cutoff = filter->freq_cutoff;
+	next->resonance = filter->resonance;
+	cd_share_coefficients(&next->coefficients, filter->coefficients);
+	cd_share_reduced_coefficients(next->reduced, filter->reduced);
+}
+
+cd_lowpass_t* cd_make_lowpass_filter(cd_context_t* context)
+{
+	cd_lowpass_t* filter = NULL;
+	CUTE_DSP_ASSERT(context);
+
+	filter = (cd_lowpass_t*)cd_memory_pool_alloc(&context->lowpass_filters);
+	CUTE_DSP_ASSERT(filter);
+
+	filter->sampling_rate = context->sampling_rate;
+	filter->next = 0;
+	cd_make_biquad_cascade(context, &filter->cascade);
+	filter->freq_cutoff = CUTE_DSP_DEFAULT_LOWPASS_CUTOFF;
+	filter->resonance = 0.f;
+	filter->coefficients = cd_acquire_coefficients(&context->coefficients, 0, filter->sampling_rate, filter->freq_cutoff, filter->resonance);
+	memset(filter->reduced, 0, sizeof(filter->reduced));
+	filter->factor = 1;
+	filter->y1 = filter->y2 = 0.f;
+	filter->running = 0;
+	return filter;
+}
+
+void cd_release_lowpass(cd_context_t* context, cd_lowpass_t** filter)
+{
+	CUTE_DSP_ASSERT(filter && *filter);
+	cd_release_coefficients((*filter)->coefficients);
+	cd_release_reduced_coefficients((*filter)->reduced);
+	cd_memory_pool_free(&context->lowpass_filters, *filter);
+	*filter = NULL;
+}
+
+static void cd_apply_lowpass_cutoff(cd_lowpass_t* filter, float cutoff_freq_in_hz)
+{
+	cd_set_lowpass_channels(filter, cutoff_freq_in_hz, filter->resonance);
+}
+
+static void cd_apply_lowpass_resonance(cd_lowpass_t* filter, float resonance)
+{
+	cd_set_lowpass_channels(filter, filter->freq_cutoff, resonance);
+}
+
+void cd_set_lowpass_cutoff(cs_playing_sound_t* playing_sound, float cutoff_freq_in_hz)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	cd_lowpass_t* filter = (cd_lowpass_t*)playing_sound->plugin_udata[ctx->lowpass_id];
+	cd_apply_lowpass_cutoff(filter, cutoff_freq_in_hz);
+	cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_LOWPASS_CUTOFF, cutoff_freq_in_hz);
+}
+
+float cd_get_lowpass_cutoff(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	const cd_lowpass_t* filter = (const cd_lowpass_t*)playing_sound->plugin_udata[ctx->lowpass_id];
+	return filter->freq_cutoff;
+}
+
+void cd_set_lowpass_resonance(cs_playing_sound_t* playing_sound, float resonance)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	cd_lowpass_t* filter = (cd_lowpass_t*)playing_sound->plugin_udata[ctx->lowpass_id];
+	cd_apply_lowpass_resonance(filter, resonance);
+	cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_LOWPASS_RESONANCE, resonance);
+}
+
+float cd_get_lowpass_resonance(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	const cd_lowpass_t* filter = (const cd_lowpass_t*)playing_sound->plugin_udata[ctx->lowpass_id];
+	return filter->resonance;
+}
+
+// the second order Butterworth filter, also run by the reduced tier in place of the cascade
+static void cd_sample_lowpass_section(cd_lowpass_t* filter, const float* input, float* samples, unsigned num_samples)
+{
+	int i = 0;
+	float ramp = num_samples ? 1.f / (float)num_samples : 0.f;
+	const cd_filter_design_t* design = &cd_mixed_coefficients(filter)->design;
+	float x_coeff, y1_coeff, y2_coeff, x_step, y1_step, y2_step;
+	if (!filter->running)
+	{
+		filter->smoothed[0] = design->x_coeff;
+		filter->smoothed[1] = design->y1_coeff;
+		filter->smoothed[2] = design->y2_coeff;
+		filter->running = 1;
+	}
+	x_coeff = filter->smoothed[0];
+	y1_coeff = filter->smoothed[1];
+	y2_coeff = filter->smoothed[2];
+	x_step = (design->x_coeff - x_coeff) * ramp;
+	y1_step = (design->y1_coeff - y1_coeff) * ramp;
+	y2_step = (design->y2_coeff - y2_coeff) * ramp;
+	filter->smoothed[0] = design->x_coeff;
+	filter->smoothed[1] = design->y1_coeff;
+	filter->smoothed[2] = design->y2_coeff;
+
+	for(; i < (int)num_samples; ++i)
+	{
+		x_coeff += x_step;
+		y1_coeff += y1_step;
+		y2_coeff += y2_step;
+		*samples = x_coeff * *input++ + 
+					y1_coeff * filter->y1 + 
+					y2_coeff * filter->y2;
+		filter->y2 = filter->y1;
+		filter->y1 = *samples++;
+	}
+}
+
+void cd_sample_lowpass(cd_context_t* context, cd_lowpass_t* filter, const float* input, float** output, unsigned num_samples)
+{
+	float* samples = context->current_output;
+
+	if (filter->cascade.order)
+		cd_sample_biquad_cascade(&filter->cascade, &cd_mixed_coefficients(filter)->design, input, samples, num_samples);
+	else
+		cd_sample_lowpass_section(filter, input, samples, num_samples);
+
+	*output = context->current_output;
+	cd_context_swap_buffers(context);
+}
+/* END LOWPASS IMPLEMENTATION */
+
+/* BEGIN HIGHPASS IMPLEMENTATION */
+cd_highpass_t* cd_make_highpass_filter(cd_context_t* context)
+{
+	cd_highpass_t* filter = NULL;
+	CUTE_DSP_ASSERT(context);
+
+	filter = (cd_highpass_t*)cd_memory_pool_alloc(&context->highpass_filters);
+	CUTE_DSP_ASSERT(filter);
+
+	filter->sampling_rate = context->sampling_rate;
+	filter->next = 0;
+	cd_make_biquad_cascade(context, &filter->cascade);
+	filter->freq_cutoff = CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF;
+	filter->coefficients = cd_acquire_coefficients(&context->coefficients, 1, filter->sampling_rate, filter->freq_cutoff, 0.f);
+	memset(filter->reduced, 0, sizeof(filter->reduced));
+	filter->factor = 1;
+	filter->x1 = filter->x2 = filter->y1 = filter->y2 = 0;
+	filter->running = 0;
+	return filter;
+}
+
+void cd_release_highpass(cd_context_t* context, cd_highpass_t** filter)
+{
+	CUTE_DSP_ASSERT(context && filter && *filter);
+	cd_release_coefficients((*filter)->coefficients);
+	cd_release_reduced_coefficients((*filter)->reduced);
+	cd_memory_pool_free(&context->highpass_filters, *filter);
+	*filter = NULL;
+}
+
+// designs one channel, freq_cutoff is left to the caller
+static void cd_set_highpass_channel_cutoff(cd_highpass_t* filter, float cutoff_freq_in_hz)
+{
+	cd_use_coefficients(&filter->coefficients, 1, filter->sampling_rate, cutoff_freq_in_hz, 0.f, NULL);
+	cd_use_reduced_coefficients(filter->reduced, 1, filter->sampling_rate, cutoff_freq_in_hz, 0.f);
+}
+
+void cd_set_highpass_cutoff_frequency(cd_highpass_t* filter, float cutoff_freq_in_hz)
+{
+	cd_highpass_t* next = filter->next;
+	filter->freq_cutoff = cutoff_freq_in_hz;
+	cd_set_highpass_channel_cutoff(filter, cutoff_freq_in_hz);
+	if (!next)
+		return;
+	cd_share_coefficients(&next->coefficients, filter->coefficients);
+	cd_share_reduced_coefficients(next->reduced, filter->reduced);
+}
+
+void cd_set_highpass_cutoff(cs_playing_sound_t* playing_sound, float cutoff_freq_in_hz)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	cd_highpass_t* filter = (cd_highpass_t*)playing_sound->plugin_udata[ctx->highpass_id];
+	cd_set_highpass_cutoff_frequency(filter, cutoff_freq_in_hz);
+	cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_HIGHPASS_CUTOFF, cutoff_freq_in_hz);
+}
+
+float cd_get_highpass_cutoff_frequency(const cd_highpass_t* filter)
+{
+	return filter->freq_cutoff;
+}
+
+float cd_get_highpass_cutoff(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	const cd_highpass_t* filter = (const cd_highpass_t*)playing_sound->plugin_udata[ctx->highpass_id];
+	return cd_get_highpass_cutoff_frequency(filter);
+}
+
+// the second order Butterworth filter, also run by the reduced tier in place of the cascade
+static void cd_sample_highpass_section(cd_highpass_t* filter, const float* input, float* samples, unsigned num_samples)
+{
+	unsigned i = 0;
+	float ramp = num_samples ? 1.f / (float)num_samples : 0.f;
+	const cd_filter_design_t* design = &cd_mixed_coefficients(filter)->design;
+	float x_coeff, x1_coeff, y1_coeff, y2_coeff, x_step, x1_step, y1_step, y2_step;
+	if (!filter->running)
+	{
+		filter->smoothed[0] = design->x_coeff;
+		filter->smoothed[1] = design->x1_coeff;
+		filter->smoothed[2] = design->y1_coeff;
+		filter->smoothed[3] = design->y2_coeff;
+		filter->running = 1;
+	}
+	x_coeff = filter->smoothed[0];
+	x1_coeff = filter->smoothed[1];
+	y1_coeff = filter->smoothed[2];
+	y2_coeff = filter->smoothed[3];
+	x_step = (design->x_coeff - x_coeff) * ramp;
+	x1_step = (design->x1_coeff - x1_coeff) * ramp;
+	y1_step = (design->y1_coeff - y1_coeff) * ramp;
+	y2_step = (design->y2_coeff - y2_coeff) * ramp;
+	filter->smoothed[0] = design->x_coeff;
+	filter->smoothed[1] = design->x1_coeff;
+	filter->smoothed[2] = design->y1_coeff;
+	filter->smoothed[3] = design->y2_coeff;
+
+	for(; i < num_samples; ++i)
+	{
+		x_coeff += x_step;
+		x1_coeff += x1_step;
+		y1_coeff += y1_step;
+		y2_coeff += y2_step;
+		*samples = x_coeff  * *input +
+					x1_coeff * filter->x1 +
+					x_coeff  * filter->x2 +
+					y1_coeff * filter->y1 +
+					y2_coeff * filter->y2;
+		filter->x2 = filter->x1;
+		filter->x1 = *input++;
+		filter->y2 = filter->y1;
+		filter->y1 = *samples++;
+	}
+}
+
+void cd_sample_highpass(cd_context_t* context, cd_highpass_t* filter, const float* input, float** output, unsigned num_samples)
+{
+	float* samples = context->current_output;
+
+	if (filter->cascade.order)
+		cd_sample_biquad_cascade(&filter->cascade, &cd_mixed_coefficients(filter)->design, input, samples, num_samples);
+	else
+		cd_sample_highpass_section(filter, input, samples, num_samples);
+
+	*output = context->current_output;
+	cd_context_swap_buffers(context);
+}
+/* END HIGHPASS IMPLEMENTATION */
+
+/* BEGIN STATE VARIABLE FILTER IMPLEMENTATION */
+/*
+	Trapezoidal integration of the analog state variable filter, solved for the zero delay feedback
+	loop each sample (see Zavalishin, The Art of VA Filter Design, and Simper's SVF notes).
+	With g = tan(pi * cutoff / sampling rate):
+		a1 = 1 / (1 + g * (g + k)), a2 = g * a1, a3 = g * a2
+	tan is approximated by its [5/4] Pade approximant n / d, so the coefficients share one division:
+		a1 = d^2 / q, a2 = n * d / q, a3 = n^2 / q, with q = d^2 + n * (n + k * d)
+	The integrator states are unchanged by coefficient updates, so fast sweeps don't blow up.
+*/
+
+// highest angle pi * cutoff / sampling rate, 0.45 of the sampling rate, where the approximation is within 0.01%
+#define CUTE_DSP_SVF_MAX_ANGLE (1.4137167f)
+
+// modulated cutoffs are turned into coefficients 4 at a time, a chunk ahead of the filter itself
+#define CUTE_DSP_SVF_CHUNK (64)
+
+#define cd_svf_coefficients(angle, k, a1, a2, a3)	\
+{	\
+	float x2 = (angle) * (angle);	\
+	float n = (angle) * (945.f - 105.f * x2 + x2 * x2);	\
+	float d = 945.f - 420.f * x2 + 15.f * x2 * x2;	\
+	float q = 1.f / (d * d + n * (n + (k) * d));	\
+	a1 = d * d * q;	\
+	a2 = n * d * q;	\
+	a3 = n * n * q;	\
+}
+
+cd_svf_t* cd_make_svf(cd_context_t* context)
+{
+	cd_svf_t* filter = NULL;
+	CUTE_DSP_ASSERT(context);
+
+	filter = (cd_svf_t*)CUTE_DSP_ALLOC(sizeof(cd_svf_t), 0);
+	CUTE_DSP_ASSERT(filter);
+	memset(filter, 0, sizeof(cd_svf_t));
+
+	filter->radians_per_hz = CUTE_DSP_PI / context->sampling_rate;
+	filter->lowpass_gain = 1.f;
+	cd_set_svf_parameters(filter, CUTE_DSP_DEFAULT_LOWPASS_CUTOFF, 0.f);
+	return filter;
+}
+
+void cd_release_svf(cd_context_t* context, cd_svf_t** filter)
+{
+	CUTE_DSP_ASSERT(context && filter && *filter);
+	CUTE_DSP_FREE(*filter, 0);
+	*filter = NULL;
+	(void)context; /* unused parameter */
+}
+
+void cd_set_svf_parameters(cd_svf_t* filter, float cutoff_freq_in_hz, float resonance)
+{
+	float angle;
+	CUTE_DSP_ASSERT(filter);
+	if (resonance < 0.f || resonance > 1.f
+		|| cutoff_freq_in_hz < CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF
+		|| cutoff_freq_in_hz > CUTE_DSP_DEFAULT_LOWPASS_CUTOFF)
+		return;
+
+	filter->freq_cutoff = cutoff_freq_in_hz;
+	filter->resonance = resonance;
+
+	// same pole angle as the lowpass filter, sqrt(2) without resonance
+	filter->k = 2.f * CUTE_DSP_SIN(CUTE_DSP_PI / 4.f * (1.f - resonance));
+	angle = CUTE_DSP_CLAMP(cutoff_freq_in_hz * filter->radians_per_hz, 0.f, CUTE_DSP_SVF_MAX_ANGLE);
+	cd_svf_coefficients(angle, filter->k, filter->a1, filter->a2, filter->a3);
+}
+
+void cd_set_svf_mix(cd_svf_t* filter, float lowpass, float bandpass, float highpass)
+{
+	CUTE_DSP_ASSERT(filter);
+	filter->lowpass_gain = lowpass;
+	filter->bandpass_gain = bandpass;
+	filter->highpass_gain = highpass;
+}
+
+float cd_get_svf_cutoff(const cd_svf_t* filter)
+{
+	return filter->freq_cutoff;
+}
+
+float cd_get_svf_resonance(const cd_svf_t* filter)
+{
+	return filter->resonance;
+}
+
+// coefficients of count modulated cutoffs, count is a multiple of 4
+static void cd_svf_modulated_coefficients(const cd_svf_t* filter, const float* cutoff_in_hz, float* a1, float* a2, float* a3, unsigned count)
+{
+	const __m128 scale = _mm_set1_ps(filter->radians_per_hz);
+	const __m128 min_angle = _mm_set1_ps(CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF * filter->radians_per_hz);
+	const __m128 max_angle = _mm_set1_ps(CUTE_DSP_SVF_MAX_ANGLE);
+	const __m128 k = _mm_set1_ps(filter->k);
+	unsigned i = 0;
+
+	for (; i < count; i += 4)
+	{
+		__m128 angle = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(cutoff_in_hz + i), scale), min_angle), max_angle);
+		__m128 x2 = _mm_mul_ps(angle, angle);
+		__m128 x4 = _mm_mul_ps(x2, x2);
+		__m128 n = _mm_mul_ps(angle, _mm_add_ps(_mm_sub_ps(_mm_set1_ps(945.f), _mm_mul_ps(_mm_set1_ps(105.f), x2)), x4));
+		__m128 d = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(945.f), _mm_mul_ps(_mm_set1_ps(420.f), x2)), _mm_mul_ps(_mm_set1_ps(15.f), x4));
+		__m128 q = _mm_div_ps(_mm_set1_ps(1.f), _mm_add_ps(_mm_mul_ps(d, d), _mm_mul_ps(n, _mm_add_ps(n, _mm_mul_ps(k, d)))));
+		_mm_storeu_ps(a1 + i, _mm_mul_ps(_mm_mul_ps(d, d), q));
+		_mm_storeu_ps(a2 + i, _mm_mul_ps(_mm_mul_ps(n, d), q));
+		_mm_storeu_ps(a3 + i, _mm_mul_ps(_mm_mul_ps(n, n), q));
+	}
+}
+
+void cd_sample_svf(cd_context_t* context, cd_svf_t* filter, const float* input, const float* cutoff_in_hz, float** output, unsigned num_samples)
+{
+	unsigned start = 0, i;
+	float* samples = context->current_output;
+	float ic1eq = filter->ic1eq, ic2eq = filter->ic2eq;
+	float a1[CUTE_DSP_SVF_CHUNK], a2[CUTE_DSP_SVF_CHUNK], a3[CUTE_DSP_SVF_CHUNK];
+	float cutoffs[CUTE_DSP_SVF_CHUNK];
+
+	// the highpass output is input - k * bandpass - lowpass, folded into the gains of the other two
+	float gain_input = filter->highpass_gain;
+	float gain_band = filter->bandpass_gain - filter->k * filter->highpass_gain;
+	float gain_low = filter->lowpass_gain - filter->highpass_gain;
+
+#define cd_svf_tick(v0, a1, a2, a3, out)	\
+	{	\
+		float v3 = v0 - ic2eq;	\
+		float v1 = a1 * ic1eq + a2 * v3;	\
+		float v2 = ic2eq + a2 * ic1eq + a3 * v3;	\
+		ic1eq = 2.f * v1 - ic1eq;	\
+		ic2eq = 2.f * v2 - ic2eq;	\
+		out = gain_input * v0 + gain_band * v1 + gain_low * v2;	\
+	}
+
+	if (!cutoff_in_hz)
+	{
+		for (i = 0; i < num_samples; ++i)
+			cd_svf_tick(input[i], filter->a1, filter->a2, filter->a3, samples[i]);
+	}
+
+	for (; cutoff_in_hz && start < num_samples; start += CUTE_DSP_SVF_CHUNK)
+	{
+		// the last chunk is padded to a multiple of 4 with its last cutoff
+		unsigned count = num_samples - start < CUTE_DSP_SVF_CHUNK ? num_samples - start : CUTE_DSP_SVF_CHUNK;
+		unsigned padded = (count + 3) & ~3u;
+		const float* chunk = cutoff_in_hz + start;
+		if (padded != count)
+		{
+			memcpy(cutoffs, chunk, sizeof(float) * count);
+			for (i = count; i < padded; ++i)
+				cutoffs[i] = chunk[count - 1];
+			chunk = cutoffs;
+		}
+		cd_svf_modulated_coefficients(filter, chunk, a1, a2, a3, padded);
+
+		for (i = 0; i < count; ++i)
+			cd_svf_tick(input[start + i], a1[i], a2[i], a3[i], samples[start + i]);
+	}
+
+#undef cd_svf_tick
+
+	filter->ic1eq = ic1eq;
+	filter->ic2eq = ic2eq;
+	*output = context->current_output;
+	cd_context_swap_buffers(context);
+}
+/* END STATE VARIABLE FILTER IMPLEMENTATION */
+
+/* BEGIN ECHO IMPLEMENTATION */
+
+cd_echo_t* cd_make_echo_filter(cd_context_t* context)
+{
+	cd_echo_t* filter = NULL;
+	CUTE_DSP_ASSERT(context);
+
+	filter = (cd_echo_t*)cd_memory_pool_alloc(&context->echo_filters);
+	CUTE_DSP_ASSERT(filter);
+
+	filter->sampling_rate = context->sampling_rate;
+	filter->max_samples = context->echo_max_delay_s * filter->sampling_rate;
+	filter->feedback = 0.f;
+	filter->offset = 0.f;
+	filter->mix = 0.f;
+	filter->running = 0;
+	cd_ring_buffer_init(&filter->xvalues, (int)filter->max_samples);
+	cd_ring_buffer_init(&filter->yvalues, (int)filter->max_samples);
+	filter->next = NULL;
+
+	return filter;
+}
+
+void cd_release_echo_filter(cd_context_t* context, cd_echo_t** filter)
+{
+	CUTE_DSP_ASSERT(context && filter && *filter);
+	cd_ring_buffer_release(&(*filter)->xvalues);
+	cd_ring_buffer_release(&(*filter)->yvalues);
+	cd_memory_pool_free(&context->echo_filters, *filter);
+	*filter = NULL;
+}
+
+// echo and noise parameters are applied to every channel of the playing sound
+static void cd_apply_echo_delay(cd_context_t* ctx, cd_echo_t* filter, float t)
+{
+	if (t > ctx->echo_max_delay_s) return;
+	for (; filter; filter = filter->next)
+		filter->offset = t * filter->sampling_rate;
+}
+
+static void cd_apply_echo_mix(cd_echo_t* filter, float a)
+{
+	for (; filter; filter = filter->next)
+		filter->mix = a;
+}
+
+static void cd_apply_echo_feedback(cd_echo_t* filter, float b)
+{
+	for (; filter; filter = filter->next)
+		filter->feedback = b;
+}
+
+void cd_set_echo_parameters(cd_echo_t* filter, float t, float a, float b)
+{
+	CUTE_DSP_ASSERT(filter);
+	if (t * filter->sampling_rate <= filter->max_samples)
+		for (cd_echo_t* echo = filter; echo; echo = echo->next)
+			echo->offset = t * echo->sampling_rate;
+	cd_apply_echo_mix(filter, a);
+	cd_apply_echo_feedback(filter, b);
+}
+
+void cd_set_echo_delay(cs_playing_sound_t* playing_sound, float t)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
+	cd_apply_echo_delay(ctx, filter, t);
+	cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_ECHO_DELAY, t);
+}
+
+void cd_set_echo_mix(cs_playing_sound_t* playing_sound, float a)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
+	cd_apply_echo_mix(filter, a);
+	cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_ECHO_MIX, a);
+}
+
+void cd_set_echo_feedback(cs_playing_sound_t* playing_sound, float b)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
+	cd_apply_echo_feedback(filter, b);
+	cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_ECHO_FEEDBACK, b);
+}
+
+float cd_get_echo_delay(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	const cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
+	return filter->offset / filter->sampling_rate;
+}
+
+float cd_get_echo_mix(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	const cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
+	return filter->mix;
+}
+
+float cd_get_echo_feedback(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	const cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
+	return filter->feedback;
+}
+
+float cd_get_echo_max_delay(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	(void)playing_sound; /* unused parameter */
+	return ctx->echo_max_delay_s;
+}
+
+// the mix and feedback reached by the last block, and their steps per sample to the current ones
+static void cd_ramp_echo(cd_echo_t* filter, unsigned num_samples, float* mix, float* feedback, float* mix_step, float* feedback_step)
+{
+	float ramp = num_samples ? 1.f / (float)num_samples : 0.f;
+	if (!filter->running)
+	{
+		filter->smoothed_mix = filter->mix;
+		filter->smoothed_feedback = filter->feedback;
+		filter->running = 1;
+	}
+	*mix = filter->smoothed_mix;
+	*feedback = filter->smoothed_feedback;
+	*mix_step = (filter->mix - *mix) * ramp;
+	*feedback_step = (filter->feedback - *feedback) * ramp;
+	filter->smoothed_mix = filter->mix;
+	filter->smoothed_feedback = filter->feedback;
+}
+
+void cd_sample_echo(cd_context_t* context, cd_echo_t* filter, const float* input, float** output, unsigned num_samples)
+{
+	int i = 0; 
+	float* samples = context->current_output;
+	float out;
+	float startInd, endInd, factor;
+	float ystart, yend, yresult;
+	float xstart, xend, xresult;
+	float mix, feedback, mix_step, feedback_step;
+	cd_ramp_echo(filter, num_samples, &mix, &feedback, &mix_step, &feedback_step);
+
+	for (; i < (int)num_samples; ++i)
+	{
+		mix += mix_step;
+		feedback += feedback_step;
+		out = *input;
+		startInd = (float)(int)filter->offset; // floor
+		endInd = startInd + 1;
+		factor = filter->offset - startInd;
+
+		ystart = cd_ring_buffer_get(&filter->yvalues, (int)startInd);
+		yend = cd_ring_buffer_get(&filter->yvalues, (int)endInd);
+		yresult = CUTE_DSP_LERP_FLOAT(ystart, yend, (int)factor);
+
+		xstart = cd_ring_buffer_get(&filter->xvalues, (int)startInd);
+		xend = cd_ring_buffer_get(&filter->xvalues, (int)endInd);
+		xresult = CUTE_DSP_LERP_FLOAT(xstart, xend, factor);
+
+		out += (mix - feedback) * xresult + feedback * yresult;
+
+		cd_ring_buffer_put(&filter->yvalues, out);
+		cd_ring_buffer_put(&filter->xvalues, *input++);
+
+		*samples++ = out;
+	}
+	
+	*output = context->current_output;
+	cd_context_swap_buffers(context);
+}
+/* END ECHO IMPLEMENTATION */
+
+/* BEGIN CHORUS IMPLEMENTATION */
+/*
+	The taps are the lanes of an SSE register. Every block, the sine and cosine of the LFO phase
+	of each tap are computed once, and rotated by the phase step of a sample from there, so the
+	delays of all the taps come out of two multiplies and adds per sample. Each tap reads the two
+	samples around its delay from the ring buffer, and is interpolated and weighted in its lane.
+	Lanes past the tap count are read but weighted by 0. The reduced tier keeps only the first tap,
+	the minimal one only feeds the ring buffer, and changes of tier fade the weights over a block.
+*/
+
+// the longest delay plus the sample after it, in floats that keep the next pool object aligned
+static int cd_chorus_line_length(float sampling_rate)
+{
+	int length = (int)(CUTE_DSP_CHORUS_MAX_DELAY * sampling_rate) + 2;
+	return (length + 3) & ~3;
+}
+
+cd_chorus_t* cd_make_chorus(cd_context_t* context)
+{
+	cd_chorus_t* filter = NULL;
+	CUTE_DSP_ASSERT(context);
+
+	filter = (cd_chorus_t*)cd_memory_pool_alloc(&context->choruses);
+	CUTE_DSP_ASSERT(filter);
+
+	filter->next = NULL;
+	filter->line.buffer = (float*)(filter + 1);
+	filter->line.current_index = 0;
+	filter->line.max_elements = cd_chorus_line_length(context->sampling_rate);
+	memset(filter->line.buffer, 0, sizeof(float) * filter->line.max_elements);
+	filter->sampling_rate = context->sampling_rate;
+	filter->max_samples = CUTE_DSP_CHORUS_MAX_DELAY * filter->sampling_rate;
+	filter->delay = 0.f;
+	filter->depth = 0.f;
+	filter->rate = 0.f;
+	filter->phase = 0.f;
+	filter->mix = 0.f;
+	filter->feedback = 0.f;
+	filter->taps = 1;
+
+	return filter;
+}
+
+void cd_release_chorus(cd_context_t* context, cd_chorus_t** filter)
+{
+	CUTE_DSP_ASSERT(context && filter && *filter);
+	cd_memory_pool_free(&context->choruses, *filter);
+	*filter = NULL;
+}
+
+// chorus parameters are applied to every channel of the playing sound, except the phase of the LFO
+static void cd_apply_chorus_delay(cd_chorus_t* filter, float t)
+{
+	if (t * filter->sampling_rate + filter->depth > filter->max_samples) return;
+	for (; filter; filter = filter->next)
+		filter->delay = t * filter->sampling_rate;
+}
+
+static void cd_apply_chorus_depth(cd_chorus_t* filter, float t)
+{
+	if (filter->delay + t * filter->sampling_rate > filter->max_samples) return;
+	for (; filter; filter = filter->next)
+		filter->depth = t * filter->sampling_rate;
+}
+
+static void cd_apply_chorus_rate(cd_chorus_t* filter, float hz)
+{
+	for (; filter; filter = filter->next)
+		filter->rate = hz;
+}
+
+static void cd_apply_chorus_mix(cd_chorus_t* filter, float a)
+{
+	for (; filter; filter = filter->next)
+		filter->mix = a;
+}
+
+static void cd_apply_chorus_feedback(cd_chorus_t* filter, float b)
+{
+	for (; filter; filter = filter->next)
+		filter->feedback = b;
+}
+
+static void cd_apply_chorus_taps(cd_chorus_t* filter, unsigned taps)
+{
+	CUTE_DSP_ASSERT(taps >= 1 && taps <= CUTE_DSP_CHORUS_MAX_TAPS);
+	for (; filter; filter = filter->next)
+		filter->taps = taps;
+}
+
+void cd_set_chorus_parameters(cd_chorus_t* filter, float t, float depth, float hz, float a, float b, unsigned taps)
+{
+	CUTE_DSP_ASSERT(filter);
+	if ((t + depth) * filter->sampling_rate <= filter->max_samples)
+	{
+		for (cd_chorus_t* chorus = filter; chorus; chorus = chorus->next)
+		{
+			chorus->delay = t * chorus->sampling_rate;
+			chorus->depth = depth * chorus->sampling_rate;
+		}
+	}
+	cd_apply_chorus_rate(filter, hz);
+	cd_apply_chorus_mix(filter, a);
+	cd_apply_chorus_feedback(filter, b);
+	cd_apply_chorus_taps(filter, taps);
+}
+
+static cd_chorus_t* cd_get_chorus(cd_context_t* ctx, const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	CUTE_DSP_ASSERT(ctx->chorus_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	return (cd_chorus_t*)playing_sound->plugin_udata[ctx->chorus_id];
+}
+
+void cd_set_chorus_delay(cs_playing_sound_t* playing_sound, float t)
+{
+	cd_context_t* ctx = cd_get_context();
+	cd_apply_chorus_delay(cd_get_chorus(ctx, playing_sound), t);
+	cd_capture_parameter(ctx, playing_sound, CD_CAPTURE_CHORUS_DELAY, t);
+}
+
+void cd_set_chorus_depth(cs_playing_sound_t* playing_sound, float t)
+{
+	cd_context_t* ctx = cd_get_context();
+	cd_apply_chorus_depth(cd_get_chorus(ctx, playing_sound), t);
+	cd_capture_parameter(ctx, playing_sound, CD_CAPTURE_CHORUS_DEPTH, t);
+}
+
+void cd_set_chorus_rate(cs_playing_sound_t* playing_sound, float hz)
+{
+	cd_context_t* ctx = cd_get_context();
+	cd_apply_chorus_rate(cd_get_chorus(ctx, playing_sound), hz);
+	cd_capture_parameter(ctx, playing_sound, CD_CAPTURE_CHORUS_RATE, hz);
+}
+
+void cd_set_chorus_mix(cs_playing_sound_t* playing_sound, float a)
+{
+	cd_context_t* ctx = cd_get_context();
+	cd_apply_chorus_mix(cd_get_chorus(ctx, playing_sound), a);
+	cd_capture_parameter(ctx, playing_sound, CD_CAPTURE_CHORUS_MIX, a);
+}
+
+void cd_set_chorus_feedback(cs_playing_sound_t* playing_sound, float b)
+{
+	cd_context_t* ctx = cd_get_context();
+	cd_apply_chorus_feedback(cd_get_chorus(ctx, playing_sound), b);
+	cd_capture_parameter(ctx, playing_sound, CD_CAPTURE_CHORUS_FEEDBACK, b);
+}
+
+void cd_set_chorus_taps(cs_playing_sound_t* playing_sound, unsigned taps)
+{
+	cd_context_t* ctx = cd_get_context();
+	cd_apply_chorus_taps(cd_get_chorus(ctx, playing_sound), taps);
+	cd_capture_parameter(ctx, playing_sound, CD_CAPTURE_CHORUS_TAPS, (float)taps);
+}
+
+float cd_get_chorus_max_delay(const cs_playing_sound_t* playing_sound)
+{
+	(void)playing_sound;
+	return CUTE_DSP_CHORUS_MAX_DELAY;
+}
+
+float cd_get_chorus_delay(const cs_playing_sound_t* playing_sound)
+{
+	const cd_chorus_t* filter = cd_get_chorus(cd_get_context(), playing_sound);
+	return filter->delay / filter->sampling_rate;
+}
+
+float cd_get_chorus_depth(const cs_playing_sound_t* playing_sound)
+{
+	const cd_chorus_t* filter = cd_get_chorus(cd_get_context(), playing_sound);
+	return filter->depth / filter->sampling_rate;
+}
+
+float cd_get_chorus_rate(const cs_playing_sound_t* playing_sound)
+{
+	return cd_get_chorus(cd_get_context(), playing_sound)->rate;
+}
+
+float cd_get_chorus_mix(const cs_playing_sound_t* playing_sound)
+{
+	return cd_get_chorus(cd_get_context(), playing_sound)->mix;
+}
+
+float cd_get_chorus_feedback(const cs_playing_sound_t* playing_sound)
+{
+	return cd_get_chorus(cd_get_context(), playing_sound)->feedback;
+}
+
+unsigned cd_get_chorus_taps(const cs_playing_sound_t* playing_sound)
+{
+	return cd_get_chorus(cd_get_context(), playing_sound)->taps;
+}
+
+static void cd_advance_chorus(cd_chorus_t* filter, unsigned sample_count)
+{
+	filter->phase += filter->rate * (float)sample_count / filter->sampling_rate;
+	filter->phase -= (float)(int)filter->phase;
+}
+
+// the minimal tier and silent choruses only keep the ring buffer fed, so the taps are there to fade in
+static void cd_feed_chorus(cd_chorus_t* filter, const float* input, unsigned sample_count)
+{
+	float* line = filter->line.buffer;
+	int size = filter->line.max_elements;
+	int write = filter->line.current_index;
+	unsigned i = 0;
+	for (; i < sample_count; ++i)
+	{
+		line[write] = input[i];
+		if (++write == size) write = 0;
+	}
+	filter->line.current_index = write;
+	cd_advance_chorus(filter, sample_count);
+}
+
+static __m128 cd_chorus_weights(const cd_chorus_t* filter, cd_quality_tier_t tier)
+{
+	float weight = 1.f / (float)filter->taps;
+	if (tier == CD_TIER_MINIMAL)
+		return _mm_setzero_ps();
+	if (tier == CD_TIER_REDUCED)
+		return _mm_setr_ps(1.f, 0.f, 0.f, 0.f);
+	return _mm_setr_ps(weight, filter->taps > 1 ? weight : 0.f, filter->taps > 2 ? weight : 0.f, filter->taps > 3 ? weight : 0.f);
+}
+
+static void cd_run_chorus(cd_chorus_t* filter, const float* input, float* samples, unsigned sample_count, cd_quality_tier_t from, cd_quality_tier_t to)
+{
+	float* line = filter->line.buffer;
+	int size = filter->line.max_elements;
+	int write = filter->line.current_index;
+	float spread = 1.f / (float)filter->taps;
+	float step = 2.f * CUTE_DSP_PI * filter->rate / filter->sampling_rate;
+	const __m128 cos_step = _mm_set1_ps(CUTE_DSP_COS(step));
+	const __m128 sin_step = _mm_set1_ps(CUTE_DSP_SIN(step));
+	const __m128 center = _mm_set1_ps(filter->delay);
+	const __m128 depth = _mm_set1_ps(filter->depth);
+	const __m128 shortest = _mm_set1_ps(1.f);
+	const __m128 longest = _mm_set1_ps(filter->max_samples);
+	const __m128 from_weights = cd_chorus_weights(filter, from);
+	const __m128 weight_step = _mm_mul_ps(_mm_sub_ps(cd_chorus_weights(filter, to), from_weights), _mm_set1_ps(1.f / (float)sample_count));
+	__m128 lfo_sin, lfo_cos;
+	float angles[CUTE_DSP_CHORUS_MAX_TAPS];
+	unsigned i = 0, k = 0;
+
+	// the LFO of every tap for the start of the block, rotated a sample at a time from there
+	for (; k < CUTE_DSP_CHORUS_MAX_TAPS; ++k)
+		angles[k] = 2.f * CUTE_DSP_PI * (filter->phase + (float)k * spread);
+	lfo_sin = _mm_setr_ps(CUTE_DSP_SIN(angles[0]), CUTE_DSP_SIN(angles[1]), CUTE_DSP_SIN(angles[2]), CUTE_DSP_SIN(angles[3]));
+	lfo_cos = _mm_setr_ps(CUTE_DSP_COS(angles[0]), CUTE_DSP_COS(angles[1]), CUTE_DSP_COS(angles[2]), CUTE_DSP_COS(angles[3]));
+
+	for (; i < sample_count; ++i)
+	{
+		int delays[CUTE_DSP_CHORUS_MAX_TAPS], newer[CUTE_DSP_CHORUS_MAX_TAPS], older[CUTE_DSP_CHORUS_MAX_TAPS];
+		__m128 delay = _mm_min_ps(_mm_max_ps(_mm_add_ps(center, _mm_mul_ps(depth, lfo_sin)), shortest), longest);
+		__m128i whole = _mm_cvttps_epi32(delay);
+		__m128 fraction = _mm_sub_ps(delay, _mm_cvtepi32_ps(whole));
+		__m128 taps, weighted, rotated;
+		float x = input[i], wet;
+
+		_mm_storeu_si128((__m128i*)delays, whole);
+		for (k = 0; k < CUTE_DSP_CHORUS_MAX_TAPS; ++k)
+		{
+			int index = write - delays[k];
+			if (index < 0) index += size;
+			newer[k] = index;
+			older[k] = index ? index - 1 : size - 1;
+		}
+		taps = _mm_setr_ps(line[newer[0]], line[newer[1]], line[newer[2]], line[newer[3]]);
+		taps = _mm_add_ps(taps, _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(line[older[0]], line[older[1]], line[older[2]], line[older[3]]), taps), fraction));
+
+		weighted = _mm_mul_ps(taps, _mm_add_ps(from_weights, _mm_mul_ps(weight_step, _mm_set1_ps((float)(i + 1)))));
+		weighted = _mm_add_ps(weighted, _mm_movehl_ps(weighted, weighted));
+		wet = _mm_cvtss_f32(_mm_add_ss(weighted, _mm_shuffle_ps(weighted, weighted, 1)));
+
+		line[write] = x + filter->feedback * wet;
+		if (++write == size) write = 0;
+		samples[i] = x + filter->mix * wet;
+
+		rotated = _mm_add_ps(_mm_mul_ps(lfo_sin, cos_step), _mm_mul_ps(lfo_cos, sin_step));
+		lfo_cos = _mm_sub_ps(_mm_mul_ps(lfo_cos, cos_step), _mm_mul_ps(lfo_sin, sin_step));
+		lfo_sin = rotated;
+	}
+
+	filter->line.current_index = write;
+	cd_advance_chorus(filter, sample_count);
+}
+
+static void cd_sample_chorus_tiers(cd_context_t* context, cd_chorus_t* filter, const float* input, float** output, unsigned sample_count, const cd_quality_t* quality)
+{
+	cd_quality_tier_t from = quality->previous_tier;
+	cd_quality_tier_t to = quality->tier;
+	if (from == to && (to == CD_TIER_MINIMAL || (filter->mix == 0.f && filter->feedback == 0.f)))
+	{
+		cd_feed_chorus(filter, input, sample_count);
+		*output = (float*)input;
+		return;
+	}
+
+	cd_run_chorus(filter, input, context->current_output, sample_count, from, to);
+	*output = context->current_output;
+	cd_context_swap_buffers(context);
+}
+
+void cd_sample_chorus(cd_context_t* context, cd_chorus_t* filter, const float* input, float** output, unsigned num_samples)
+{
+	cd_run_chorus(filter, input, context->current_output, num_samples, CD_TIER_FULL, CD_TIER_FULL);
+	*output = context->current_output;
+	cd_context_swap_buffers(context);
+}
+/* END CHORUS IMPLEMENTATION */
+
+/* BEGIN CONVOLUTION IMPLEMENTATION */
+/*
+	Uniformly partitioned overlap-save within each level, with levels of growing partition size:
+	4 partitions of CUTE_DSP_CONVOLUTION_BLOCK frames, then 3 of 4x that size, 3 of 16x, and the
+	rest of the impulse response in partitions of 64x. A level is convolved whenever a whole
+	partition of input has arrived, and its first partition starts late enough in the response
+	that the result is always ready before it is heard, so the latency is one block at every level.
+
+	Spectra of 2n real samples are computed with a complex FFT of length n, packed as n real parts
+	followed by n imaginary parts. The DC and Nyquist bins are both real and share the first slot.
+*/
+
+// radix 2 decimation in time over bit reversed input, the stages of 4 butterflies or more use SSE
+static void cd_fft(const cd_impulse_response_t* ir, float* re, float* im, unsigned n)
+{
+	unsigned k, j, m;
+	for (k = 0; k < n; k += 4)
+	{
+		// first two stages at once, their twiddles are 1 and -i
+		float ar = re[k] + re[k + 1], ai = im[k] + im[k + 1];
+		float br = re[k] - re[k + 1], bi = im[k] - im[k + 1];
+		float cr = re[k + 2] + re[k + 3], ci = im[k + 2] + im[k + 3];
+		float dr = re[k + 2] - re[k + 3], di = im[k + 2] - im[k + 3];
+		re[k] = ar + cr; im[k] = ai + ci;
+		re[k + 2] = ar - cr; im[k + 2] = ai - ci;
+		re[k + 1] = br + di; im[k + 1] = bi - dr;
+		re[k + 3] = br - di; im[k + 3] = bi + dr;
+	}
+
+	for (m = 4; m < n; m <<= 1)
+	{
+		const float* twiddles_re = ir->twiddles_re + m;
+		const float* twiddles_im = ir->twiddles_im + m;
+		for (k = 0; k < n; k += 2 * m)
+		{
+			float* top_re = re + k;
+			float* top_im = im + k;
+			float* bottom_re = top_re + m;
+			float* bottom_im = top_im + m;
+			for (j = 0; j < m; j += 4)
+			{
+				__m128 wr = _mm_loadu_ps(twiddles_re + j);
+				__m128 wi = _mm_loadu_ps(twiddles_im + j);
+				__m128 br = _mm_loadu_ps(bottom_re + j);
+				__m128 bi = _mm_loadu_ps(bottom_im + j);
+				__m128 ar = _mm_loadu_ps(top_re + j);
+				__m128 ai = _mm_loadu_ps(top_im + j);
+				__m128 tr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+				__m128 ti = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+				_mm_storeu_ps(top_re + j, _mm_add_ps(ar, tr));
+				_mm_storeu_ps(top_im + j, _mm_add_ps(ai, ti));
+				_mm_storeu_ps(bottom_re + j, _mm_sub_ps(ar, tr));
+				_mm_storeu_ps(bottom_im + j, _mm_sub_ps(ai, ti));
+			}
+		}
+	}
+}
+
+static unsigned cd_fft_shift(const cd_impulse_response_t* ir, unsigned n)
+{
+	unsigned shift = 0;
+	while ((n << shift) < ir->fft_size)
+		++shift;
+	return shift;
+}
+
+// spectrum of the 2n samples of a ring buffer starting at start, scaled by 2
+static void cd_real_fft(const cd_impulse_response_t* ir, const float* samples, unsigned start, unsigned mask, unsigned n, float* work_re, float* work_im, float* spectrum)
+{
+	unsigned k, shift = cd_fft_shift(ir, n);
+	const float* twiddles_re = ir->twiddles_re + n;
+	const float* twiddles_im = ir->twiddles_im + n;
+	float* out_re = spectrum;
+	float* out_im = spectrum + n;
+
+	// even samples are the real parts, odd samples the imaginary parts
+	for (k = 0; k < n; ++k)
+	{
+		unsigned j = ir->bit_reverse[k] >> shift;
+		work_re[j] = samples[(start + 2 * k) & mask];
+		work_im[j] = samples[(start + 2 * k + 1) & mask];
+	}
+	cd_fft(ir, work_re, work_im, n);
+
+	out_re[0] = 2.f * (work_re[0] + work_im[0]);
+	out_im[0] = 2.f * (work_re[0] - work_im[0]);
+	for (k = 1; k < n; ++k)
+	{
+		float ar = work_re[k], ai = work_im[k];
+		float br = work_re[n - k], bi = -work_im[n - k];
+		float odd_re = ai - bi, odd_im = br - ar;
+		float c = twiddles_re[k], s = twiddles_im[k];
+		out_re[k] = ar + br + c * odd_re - s * odd_im;
+		out_im[k] = ai + bi + c * odd_im + s * odd_re;
+	}
+}
+
+// inverse of cd_real_fft, scaled by 2n, leaves z[k] = x[2k] + i x[2k + 1] in work_re and work_im
+static void cd_inverse_real_fft(const cd_impulse_response_t* ir, const float* spectrum, unsigned n, float* work_re, float* work_im)
+{
+	unsigned k, shift = cd_fft_shift(ir, n);
+	const float* twiddles_re = ir->twiddles_re + n;
+	const float* twiddles_im = ir->twiddles_im + n;
+	const float* in_re = spectrum;
+	const float* in_im = spectrum + n;
+
+	work_re[0] = in_re[0] + in_im[0];
+	work_im[0] = in_re[0] - in_im[0];
+	for (k = 1; k < n; ++k)
+	{
+		unsigned j = ir->bit_reverse[k] >> shift;
+		float ar = in_re[k], ai = in_im[k];
+		float br = in_re[n - k], bi = -in_im[n - k];
+		float dr = ar - br, di = ai - bi;
+		float c = twiddles_re[k], s = twiddles_im[k];
+		float odd_re = c * dr + s * di, odd_im = c * di - s * dr;
+		work_re[j] = ar + br - odd_im;
+		work_im[j] = ai + bi + odd_re;
+	}
+
+	// an inverse FFT is a forward FFT with the real and imaginary parts swapped
+	cd_fft(ir, work_im, work_re, n);
+}
+
+// accumulator += x * h for packed spectra
+static void cd_convolution_accumulate(float* accumulator, const float* x, const float* h, unsigned n)
+{
+	unsigned i = 0;
+	float dc = accumulator[0] + x[0] * h[0];
+	float nyquist = accumulator[n] + x[n] * h[n];
+	for (; i < n; i += 4)
+	{
+		__m128 xr = _mm_loadu_ps(x + i);
+		__m128 xi = _mm_loadu_ps(x + n + i);
+		__m128 hr = _mm_loadu_ps(h + i);
+		__m128 hi = _mm_loadu_ps(h + n + i);
+		__m128 ar = _mm_loadu_ps(accumulator + i);
+		__m128 ai = _mm_loadu_ps(accumulator + n + i);
+		_mm_storeu_ps(accumulator + i, _mm_add_ps(ar, _mm_sub_ps(_mm_mul_ps(xr, hr), _mm_mul_ps(xi, hi))));
+		_mm_storeu_ps(accumulator + n + i, _mm_add_ps(ai, _mm_add_ps(_mm_mul_ps(xr, hi), _mm_mul_ps(xi, hr))));
+	}
+	accumulator[0] = dc;
+	accumulator[n] = nyquist;
+}
+
+cd_impulse_response_t* cd_make_impulse_response(cd_context_t* context, const float* const* channels, int channel_count, unsigned frame_count)
+{
+	cd_impulse_response_t* ir = NULL;
+	unsigned start = 0, size = CUTE_DSP_CONVOLUTION_BLOCK, spectra_size = 0, bits = 0, k;
+	float* memory;
+	float* padded;
+	float scale;
+	int l, c;
+	CUTE_DSP_ASSERT(context && channels && frame_count);
+	CUTE_DSP_ASSERT(channel_count == CUTE_DSP_MONO || channel_count == CUTE_DSP_STEREO);
+
+	ir = (cd_impulse_response_t*)CUTE_DSP_ALLOC(sizeof(cd_impulse_response_t), 0);
+	CUTE_DSP_ASSERT(ir);
+	memset(ir, 0, sizeof(cd_impulse_response_t));
+	ir->channel_count = channel_count;
+	ir->frame_count = frame_count;
+	ir->sampling_rate = context->sampling_rate;
+
+	// level l must start at least one of its partitions, less a block, into the response
+	for (l = 0; l < CUTE_DSP_CONVOLUTION_LEVELS && start < frame_count; ++l, size *= 4)
+	{
+		cd_convolution_level_t* level = ir->levels + l;
+		unsigned remaining = (frame_count - start + size - 1) / size;
+		level->size = size;
+		level->start = start;
+		level->count = l == 0 ? 4 : 3;
+		if (l == CUTE_DSP_CONVOLUTION_LEVELS - 1 || remaining < level->count)
+			level->count = remaining;
+		start += level->count * size;
+		spectra_size += level->count * 2 * size;
+		ir->fft_size = size;
+		ir->level_count = l + 1;
+	}
+	ir->history = 1;
+	while (ir->history < 2 * ir->fft_size || ir->history < ir->levels[ir->level_count - 1].start + CUTE_DSP_CONVOLUTION_BLOCK)
+		ir->history *= 2;
+
+	memory = (float*)CUTE_DSP_ALLOC(sizeof(float) * (spectra_size * channel_count + 4 * ir->fft_size) + sizeof(unsigned) * ir->fft_size, 0);
+	CUTE_DSP_ASSERT(memory);
+	ir->memory = memory;
+	for (c = 0; c < channel_count; ++c)
+		for (l = 0; l < ir->level_count; memory += ir->levels[l].count * 2 * ir->levels[l].size, ++l)
+			ir->spectra[c][l] = memory;
+	ir->twiddles_re = memory;
+	ir->twiddles_im = memory + 2 * ir->fft_size;
+	ir->bit_reverse = (unsigned*)(memory + 4 * ir->fft_size);
+
+	for (k = 1; k < 2 * ir->fft_size; ++k)
+	{
+		unsigned m = 1;
+		while (m * 2 <= k)
+			m *= 2;
+		ir->twiddles_re[k] = cosf(CUTE_DSP_PI * (float)(k - m) / (float)m);
+		ir->twiddles_im[k] = -sinf(CUTE_DSP_PI * (float)(k - m) / (float)m);
+	}
+	ir->twiddles_re[0] = 1.f;
+	ir->twiddles_im[0] = 0.f;
+	while ((1u << bits) < ir->fft_size)
+		++bits;
+	for (k = 0; k < ir->fft_size; ++k)
+	{
+		unsigned b, reversed = 0;
+		for (b = 0; b < bits; ++b)
+			reversed |= ((k >> b) & 1) << (bits - 1 - b);
+		ir->bit_reverse[k] = reversed;
+	}
+
+	// every partition zero padded to twice its size, scaled so a forward and inverse transform cancel out
+	padded = (float*)CUTE_DSP_ALLOC(sizeof(float) * 4 * ir->fft_size, 0);
+	CUTE_DSP_ASSERT(padded);
+	for (c = 0; c < channel_count; ++c)
+	{
+		for (l = 0; l < ir->level_count; ++l)
+		{
+			const cd_convolution_level_t* level = ir->levels + l;
+			scale = 1.f / (8.f * (float)level->size);
+			for (k = 0; k < level->count; ++k)
+			{
+				unsigned i, offset = level->start + k * level->size;
+				float* spectrum = ir->spectra[c][l] + k * 2 * level->size;
+				memset(padded, 0, sizeof(float) * 2 * level->size);
+				for (i = 0; i < level->size && offset + i < frame_count; ++i)
+					padded[i] = channels[c][offset + i] * scale;
+				cd_real_fft(ir, padded, 0, 2 * level->size - 1, level->size, padded + 2 * ir->fft_size, padded + 3 * ir->fft_size, spectrum);
+			}
+		}
+	}
+	CUTE_DSP_FREE(padded, 0);
+	return ir;
+}
+
+void cd_release_impulse_response(cd_context_t* context, cd_impulse_response_t** impulse_response)
+{
+	CUTE_DSP_ASSERT(context && impulse_response && *impulse_response);
+	CUTE_DSP_FREE((*impulse_response)->memory, 0);
+	CUTE_DSP_FREE(*impulse_response, 0);
+	*impulse_response = NULL;
+	(void)context; /* unused parameter */
+}
+
+float cd_get_impulse_response_length(const cd_impulse_response_t* impulse_response)
+{
+	CUTE_DSP_ASSERT(impulse_response);
+	return (float)impulse_response->frame_count / impulse_response->sampling_rate;
+}
+
+cd_convolver_t* cd_make_convolver(cd_context_t* context, const cd_impulse_response_t* impulse_response, int channel_index)
+{
+	cd_convolver_t* filter = NULL;
+	const cd_impulse_response_t* ir = impulse_response;
+	size_t total = 2 * ir->history + 4 * ir->fft_size;
+	float* memory;
+	int l;
+	CUTE_DSP_ASSERT(context && ir && channel_index >= 0 && channel_index < CUTE_DSP_STEREO);
+
+	filter = (cd_convolver_t*)CUTE_DSP_ALLOC(sizeof(cd_convolver_t), 0);
+	CUTE_DSP_ASSERT(filter);
+	memset(filter, 0, sizeof(cd_convolver_t));
+	filter->impulse_response = ir;
+	filter->channel_index = channel_index < ir->channel_count ? channel_index : 0;
+
+	for (l = 0; l < ir->level_count; ++l)
+		total += ir->levels[l].count * 2 * ir->levels[l].size;
+	memory = (float*)CUTE_DSP_ALLOC(sizeof(float) * total, 0);
+	CUTE_DSP_ASSERT(memory);
+	memset(memory, 0, sizeof(float) * total);
+	filter->memory = memory;
+
+	filter->input = memory;
+	filter->output = memory + ir->history;
+	filter->work_re = memory + 2 * ir->history;
+	filter->work_im = filter->work_re + ir->fft_size;
+	filter->accumulator = filter->work_im + ir->fft_size;
+	memory = filter->accumulator + 2 * ir->fft_size;
+	for (l = 0; l < ir->level_count; memory += ir->levels[l].count * 2 * ir->levels[l].size, ++l)
+		filter->delay_lines[l] = memory;
+	return filter;
+}
+
+static cd_convolver_t* cd_make_convolver_channels(cd_context_t* context, const cd_impulse_response_t* impulse_response, int channel_count)
+{
+	cd_convolver_t* convolver = cd_make_convolver(context, impulse_response, 0);
+	if (channel_count == 2)
+		convolver->next = cd_make_convolver(context, impulse_response, 1);
+	return convolver;
+}
+
+void cd_release_convolver(cd_context_t* context, cd_convolver_t** filter)
+{
+	CUTE_DSP_ASSERT(context && filter && *filter);
+	CUTE_DSP_FREE((*filter)->memory, 0);
+	CUTE_DSP_FREE(*filter, 0);
+	*filter = NULL;
+	(void)context; /* unused parameter */
+}
+
+// convolves the last partition of input with every partition of a level, adds the result to the output ring
+static void cd_convolve_level(cd_convolver_t* filter, int l)
+{
+	const cd_impulse_response_t* ir = filter->impulse_response;
+	const cd_convolution_level_t* level = ir->levels + l;
+	unsigned n = level->size, spectrum_size = 2 * n, mask = ir->history - 1, k, p;
+	unsigned head = filter->heads[l];
+	const float* spectra = ir->spectra[filter->channel_index][l];
+	float* delay_line = filter->delay_lines[l];
+	float* output = filter->output;
+	unsigned first = filter->position - n + level->start + CUTE_DSP_CONVOLUTION_BLOCK;
+
+	// overlap-save, the FFT covers the last two partitions of input
+	cd_real_fft(ir, filter->input, filter->position - 2 * n, mask, n, filter->work_re, filter->work_im, delay_line + head * spectrum_size);
+	memset(filter->accumulator, 0, sizeof(float) * spectrum_size);
+	for (p = 0; p < level->count; ++p)
+	{
+		unsigned slot = (head + level->count - p) % level->count;
+		cd_convolution_accumulate(filter->accumulator, delay_line + slot * spectrum_size, spectra + p * spectrum_size, n);
+	}
+	filter->heads[l] = (head + 1) % level->count;
+
+	// only the second half of the inverse is free of circular wrap around
+	cd_inverse_real_fft(ir, filter->accumulator, n, filter->work_re, filter->work_im);
+	for (k = n / 2; k < n; ++k)
+	{
+		output[(first + 2 * k - n) & mask] += filter->work_re[k];
+		output[(first + 2 * k + 1 - n) & mask] += filter->work_im[k];
+	}
+}
+
+void cd_sample_convolver(cd_context_t* context, cd_convolver_t* filter, const float* input, float** output, unsigned num_samples)
+{
+	const cd_impulse_response_t* ir = filter->impulse_response;
+	unsigned mask = ir->history - 1, i = 0, j;
+	float* samples = context->current_output;
+	int l;
+
+	while (i < num_samples)
+	{
+		unsigned count = CUTE_DSP_CONVOLUTION_BLOCK - (filter->position & (CUTE_DSP_CONVOLUTION_BLOCK - 1));
+		if (count > num_samples - i)
+			count = num_samples - i;
+		for (j = 0; j < count; ++j)
+		{
+			unsigned at = (filter->position + j) & mask;
+			filter->input[at] = input[i + j];
+			samples[i + j] = filter->output[at];
+			filter->output[at] = 0.f;
+		}
+		filter->position += count;
+		i += count;
+
+		for (l = 0; l < ir->level_count; ++l)
+			if (!(filter->position & (ir->levels[l].size - 1)))
+				cd_convolve_level(filter, l);
+	}
+
+	*output = samples;
+	cd_context_swap_buffers(context);
+}
+/* END CONVOLUTION IMPLEMENTATION */
+
+/* BEGIN MULTI-TAP DELAY IMPLEMENTATION */
+/*
+	Taps are run in groups of 4, 4 samples at a time. Each tap of a group loads its 4 samples and the
+	ones before them at once, and is interpolated with the samples in the lanes. Transposed, the lanes
+	become the taps, for the damping filters that run from sample to sample, then transposed back and
+	summed into the output. The delay line is linear: the block is appended after the history so every
+	read of the block is a plain index, and the history is moved back to the start of the line only once
+	the line is full, about once every history samples. A sample costs the same for every tap whatever
+	its delay, and one write of the input feeds all of them.
+*/
+cd_tap_set_t* cd_make_tap_set(cd_context_t* context, const cd_tap_def_t* taps, int tap_count)
+{
+	cd_tap_set_t* tap_set = NULL;
+	int lanes, t;
+	char* memory;
+	CUTE_DSP_ASSERT(context && taps && tap_count > 0);
+
+	tap_set = (cd_tap_set_t*)CUTE_DSP_ALLOC(sizeof(cd_tap_set_t), 0);
+	CUTE_DSP_ASSERT(tap_set);
+	memset(tap_set, 0, sizeof(cd_tap_set_t));
+	tap_set->tap_count = tap_count;
+	tap_set->group_count = (tap_count + 3) / 4;
+	tap_set->sampling_rate = context->sampling_rate;
+	lanes = tap_set->group_count * 4;
+
+	memory = (char*)CUTE_DSP_ALLOC((sizeof(int) + 4 * sizeof(float)) * lanes, 0);
+	CUTE_DSP_ASSERT(memory);
+	memset(memory, 0, (sizeof(int) + 4 * sizeof(float)) * lanes);
+	tap_set->memory = memory;
+	tap_set->offsets = (int*)memory;
+	tap_set->fractions = (float*)(tap_set->offsets + lanes);
+	tap_set->gains[0] = tap_set->fractions + lanes;
+	tap_set->gains[1] = tap_set->gains[0] + lanes;
+	tap_set->damping = tap_set->gains[1] + lanes;
+
+	for (t = 0; t < lanes; ++t)
+	{
+		const cd_tap_def_t* def;
+		float delay, cutoff;
+		if (t >= tap_count)
+		{
+			tap_set->damping[t] = 1.f;
+			continue;
+		}
+
+		def = taps + t;
+		CUTE_DSP_ASSERT(def->delay >= 0.f);
+		delay = def->delay * tap_set->sampling_rate;
+		tap_set->offsets[t] = (int)delay;
+		tap_set->fractions[t] = delay - (float)tap_set->offsets[t];
+		tap_set->gains[0][t] = def->gains[0];
+		tap_set->gains[1][t] = def->gains[1];
+		cutoff = CUTE_DSP_CLAMP(def->damping_hz, 0.f, tap_set->sampling_rate * 0.5f);
+		tap_set->damping[t] = cutoff > 0.f ? 1.f - expf(-2.f * CUTE_DSP_PI * cutoff / tap_set->sampling_rate) : 1.f;
+		if (tap_set->offsets[t] + 1 > tap_set->history)
+			tap_set->history = tap_set->offsets[t] + 1;
+		if (def->delay > tap_set->length)
+			tap_set->length = def->delay;
+	}
+
+	return tap_set;
+}
+
+void cd_release_tap_set(cd_context_t* context, cd_tap_set_t** tap_set)
+{
+	CUTE_DSP_ASSERT(context && tap_set && *tap_set);
+	CUTE_DSP_FREE((*tap_set)->memory, 0);
+	CUTE_DSP_FREE(*tap_set, 0);
+	*tap_set = NULL;
+	(void)context; /* unused parameter */
+}
+
+float cd_get_tap_set_length(const cd_tap_set_t* tap_set)
+{
+	CUTE_DSP_ASSERT(tap_set);
+	return tap_set->length;
+}
+
+cd_multitap_t* cd_make_multitap(cd_context_t* context, const cd_tap_set_t* tap_set, int channel_index)
+{
+	cd_multitap_t* filter = NULL;
+	size_t total;
+	float* memory;
+	CUTE_DSP_ASSERT(context && tap_set && channel_index >= 0 && channel_index < CUTE_DSP_STEREO);
+
+	filter = (cd_multitap_t*)CUTE_DSP_ALLOC(sizeof(cd_multitap_t), 0);
+	CUTE_DSP_ASSERT(filter);
+	memset(filter, 0, sizeof(cd_multitap_t));
+	filter->tap_set = tap_set;
+	filter->channel_index = channel_index;
+	filter->capacity = 2 * tap_set->history + CUTE_DSP_MAX_FRAME_LENGTH;
+	filter->position = tap_set->history;
+
+	total = filter->capacity + tap_set->group_count * 4;
+	memory = (float*)CUTE_DSP_ALLOC(sizeof(float) * total, 0);
+	CUTE_DSP_ASSERT(memory);
+	memset(memory, 0, sizeof(float) * total);
+	filter->memory = memory;
+	filter->line = memory;
+	filter->states = memory + filter->capacity;
+	return filter;
+}
+
+static cd_multitap_t* cd_make_multitap_channels(cd_context_t* context, const cd_tap_set_t* tap_set, int channel_count)
+{
+	cd_multitap_t* multitap = cd_make_multitap(context, tap_set, 0);
+	if (channel_count == 2)
+		multitap->next = cd_make_multitap(context, tap_set, 1);
+	return multitap;
+}
+
+void cd_release_multitap(cd_context_t* context, cd_multitap_t** filter)
+{
+	CUTE_DSP_ASSERT(context && filter && *filter);
+	CUTE_DSP_FREE((*filter)->memory, 0);
+	CUTE_DSP_FREE(*filter, 0);
+	*filter = NULL;
+	(void)context; /* unused parameter */
+}
+
+// 4 samples of one tap from sample n of the line, interpolated, with the samples in the lanes
+#define cd_multitap_span(n, k) \
+	(newer = _mm_loadu_ps(line + (n) - offsets[k]), \
+	older = _mm_loadu_ps(line + (n) - offsets[k] - 1), \
+	_mm_add_ps(newer, _mm_mul_ps(fractions[k], _mm_sub_ps(older, newer))))
+
+// damps and weights the taps of the next sample, with the taps in the lanes
+#define cd_multitap_damp(x) \
+	(state = _mm_add_ps(_mm_mul_ps(state, keep), _mm_add_ps(_mm_mul_ps(damping, (x)), guard)), \
+	_mm_mul_ps(state, gain))
+
+// one group of taps at sample n of the line, for the samples left after the groups of 4
+#define cd_multitap_lanes(n) \
+	(newer = _mm_setr_ps(line[(n) - offsets[0]], line[(n) - offsets[1]], line[(n) - offsets[2]], line[(n) - offsets[3]]), \
+	older = _mm_setr_ps(line[(n) - offsets[0] - 1], line[(n) - offsets[1] - 1], line[(n) - offsets[2] - 1], line[(n) - offsets[3] - 1]), \
+	cd_multitap_damp(_mm_add_ps(newer, _mm_mul_ps(fraction, _mm_sub_ps(older, newer)))))
+
+void cd_sample_multitap(cd_context_t* context, cd_multitap_t* filter, const float* input, float** output, unsigned num_samples)
+{
+	const cd_tap_set_t* tap_set = filter->tap_set;
+	float* samples = context->current_output;
+	const float* line;
+	int count = (int)num_samples, i, g;
+	CUTE_DSP_ASSERT(num_samples <= CUTE_DSP_MAX_FRAME_LENGTH);
+
+	if (filter->position + count > filter->capacity)
+	{
+		memmove(filter->line, filter->line + filter->position - tap_set->history, sizeof(float) * tap_set->history);
+		filter->position = tap_set->history;
+	}
+	memcpy(filter->line + filter->position, input, sizeof(float) * num_samples);
+	memset(samples, 0, sizeof(float) * num_samples);
+	line = filter->line + filter->position;
+
+	for (g = 0; g < tap_set->group_count; ++g)
+	{
+		const int* offsets = tap_set->offsets + 4 * g;
+		const __m128 fraction = _mm_loadu_ps(tap_set->fractions + 4 * g);
+		const __m128 fractions[4] = { _mm_set1_ps(tap_set->fractions[4 * g]), _mm_set1_ps(tap_set->fractions[4 * g + 1]), _mm_set1_ps(tap_set->fractions[4 * g + 2]), _mm_set1_ps(tap_set->fractions[4 * g + 3]) };
+		const __m128 gain = _mm_loadu_ps(tap_set->gains[filter->channel_index] + 4 * g);
+		const __m128 damping = _mm_loadu_ps(tap_set->damping + 4 * g);
+		const __m128 keep = _mm_sub_ps(_mm_set1_ps(1.f), damping);
+		const __m128 guard = _mm_set1_ps(CUTE_DSP_MULTITAP_DENORMAL_GUARD);
+		__m128 state = _mm_loadu_ps(filter->states + 4 * g);
+		__m128 newer, older;
+
+		// consecutive samples of each tap are loaded at once, then transposed to run the damping across the taps
+		for (i = 0; i + 4 <= count; i += 4)
+		{
+			__m128 a = cd_multitap_span(i, 0);
+			__m128 b = cd_multitap_span(i, 1);
+			__m128 c = cd_multitap_span(i, 2);
+			__m128 d = cd_multitap_span(i, 3);
+			_MM_TRANSPOSE4_PS(a, b, c, d);
+			a = cd_multitap_damp(a);
+			b = cd_multitap_damp(b);
+			c = cd_multitap_damp(c);
+			d = cd_multitap_damp(d);
+			_MM_TRANSPOSE4_PS(a, b, c, d);
+			_mm_storeu_ps(samples + i, _mm_add_ps(_mm_loadu_ps(samples + i), _mm_add_ps(_mm_add_ps(a, b), _mm_add_ps(c, d))));
+		}
+		for (; i < count; ++i)
+		{
+			float lanes[4];
+			_mm_storeu_ps(lanes, cd_multitap_lanes(i));
+			samples[i] += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+		}
+		_mm_storeu_ps(filter->states + 4 * g, state);
+	}
+	filter->position += count;
+
+	*output = samples;
+	cd_context_swap_buffers(context);
+}
+
+#undef cd_multitap_lanes
+#undef cd_multitap_span
+#undef cd_multitap_damp
+/* END MULTI-TAP DELAY IMPLEMENTATION */
+
+/* BEGIN NOISE IMPLEMENTATION */
+cd_noise_t* cd_make_noise_generator(cd_context_t* context)
+{
+	cd_noise_t* filter = NULL;
+	CUTE_DSP_ASSERT(context);
+
+	filter = (cd_noise_t*)cd_memory_pool_alloc(&context->noise_generators);
+	CUTE_DSP_ASSERT(filter);
+
+	memset(filter, 0, sizeof(cd_noise_t));
+	filter->amplitude_db = CUTE_DSP_NOISE_INAUDIBLE;
+	filter->amplitude_gain = CUTE_DSP_DB_TO_GAIN(filter->amplitude_db);
+	filter->color = CD_NOISE_WHITE;
+	filter->key = cd_random_key(context->def.rand_seed, 0, context->noise_generator_counter++);
+
+	// leak of the brown noise integrator, and the spacing of the velvet noise impulses
+	filter->brown_leak = expf(-2.f * CUTE_DSP_PI * CUTE_DSP_BROWN_NOISE_CUTOFF / context->sampling_rate);
+	filter->velvet_spacing = (int)(context->sampling_rate / CUTE_DSP_VELVET_NOISE_DENSITY + 0.5f);
+	filter->velvet_spacing = filter->velvet_spacing > 0 ? filter->velvet_spacing : 1;
+	filter->next = 0;
+	return filter;
+}
+
+void cd_release_noise(cd_context_t* context, cd_noise_t** filter)
+{
+	CUTE_DSP_ASSERT(context && filter && *filter);
+	cd_memory_pool_free(&context->noise_generators, *filter);
+	*filter = NULL;
+}
+
+static void cd_apply_noise_db(cd_noise_t* filter, float db)
+{
+	for (; filter; filter = filter->next)
+	{
+		filter->amplitude_db = db;
+		filter->amplitude_gain = CUTE_DSP_DB_TO_GAIN(db);
+	}
+}
+
+static void cd_apply_noise_gain(cd_noise_t* filter, float gain)
+{
+	for (; filter; filter = filter->next)
+	{
+		filter->amplitude_gain = gain;
+		filter->amplitude_db = CUTE_DSP_GAIN_TO_DB(gain);
+	}
+}
+
+void cd_set_noise_generator_amplitude_db(cd_noise_t* filter, float db)
+{
+	CUTE_DSP_ASSERT(filter);
+	cd_apply_noise_db(filter, db);
+}
+
+// the groups already made are of the previous color
+static void cd_apply_noise_color(cd_noise_t* filter, cd_noise_color_t color)
+{
+	for (; filter; filter = filter->next)
+	{
+		filter->color = color;
+		filter->pending_count = 0;
+	}
+}
+
+void cd_set_noise_generator_color(cd_noise_t* filter, cd_noise_color_t color)
+{
+	CUTE_DSP_ASSERT(filter);
+	cd_apply_noise_color(filter, color);
+}
+
+void cd_set_noise_generator_stream(cd_context_t* context, cd_noise_t* filter, unsigned stream, unsigned channel)
+{
+	CUTE_DSP_ASSERT(context && filter);
+	for (; filter; filter = filter->next)
+	{
+		filter->key = cd_random_key(context->def.rand_seed, stream, channel++);
+		filter->position = 0;
+		filter->pending_count = 0;
+	}
+}
+
+void cd_seek_noise_generator(cd_noise_t* filter, unsigned position)
+{
+	CUTE_DSP_ASSERT(filter);
+	for (; filter; filter = filter->next)
+	{
+		filter->position = position;
+		filter->pending_count = 0;
+	}
+}
+
+void cd_set_noise_color(cs_playing_sound_t* playing_sound, cd_noise_color_t color)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_noise_t* filter = (cd_noise_t*)playing_sound->plugin_udata[ctx->noise_id];
+	cd_apply_noise_color(filter, color);
+	cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_NOISE_COLOR, (float)color);
+}
+
+cd_noise_color_t cd_get_noise_color(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_noise_t* filter = (cd_noise_t*)playing_sound->plugin_udata[ctx->noise_id];
+	return filter->color;
+}
+
+void cd_set_noise_amplitude_db(cs_playing_sound_t* playing_sound, float db)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_noise_t* filter = (cd_noise_t*)playing_sound->plugin_udata[ctx->noise_id];
+	cd_apply_noise_db(filter, db);
+	cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_NOISE_DB, db);
+}
+
+void cd_set_noise_amplitude_gain(cs_playing_sound_t* playing_sound, float gain)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_noise_t* filter = (cd_noise_t*)playing_sound->plugin_udata[ctx->noise_id];
+	cd_apply_noise_gain(filter, gain);
+	cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_NOISE_GAIN, gain);
+}
+
+float cd_get_noise_amplitude_db(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_noise_t* filter = (cd_noise_t*)playing_sound->plugin_udata[ctx->noise_id];
+	return filter->amplitude_db;
+}
+
+float cd_get_noise_amplitude_gain(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_noise_t* filter = (cd_noise_t*)playing_sound->plugin_udata[ctx->noise_id];
+	return filter->amplitude_gain;
+}
+
+/*
+	Colored noise is made 4 samples at a time, from the 4 white noise samples of the group, each scaled
+	to the rms of the white noise:
+	- pink sums 16 rows of white noise, row k changing every 2^k samples (Voss-McCartney), with one more
+	  white sample. In a group of 4, rows 0 and 1 change at fixed lanes, and one of the rows above changes
+	  on the first lane, so every lane is a sum of 4 vectors with a single running sum for the rows above.
+	- brown is a leaky integrator, solved for the 4 lanes at once with two shifts of a prefix sum.
+	- velvet places one impulse of random sign at a random place in every period of velvet_spacing samples.
+*/
+static __m128 cd_next_colored_noise(cd_noise_t* filter, __m128i key, __m128i weyl)
+{
+	__m128i bits = cd_random_hash4(key, weyl);
+	__m128 white = cd_random_to_float4(bits);
+
+	switch (filter->color)
+	{
+	case CD_NOISE_PINK:
+	{
+		float r[4];
+		unsigned group = filter->group_counter++;
+		unsigned row = 2, k;
+		__m128 rows01;
+		_mm_storeu_ps(r, cd_random_to_float4(cd_random_hash4(_mm_xor_si128(key, _mm_set1_epi32(0x5bd1e995)), weyl)));
+
+		// row 0 changes on lanes 1 and 3, row 1 on lane 2, a row above on lane 0
+		for (; row < CUTE_DSP_PINK_NOISE_ROWS - 1 && group && !(group & (1u << (row - 2))); ++row);
+		filter->high_rows += r[3] - filter->rows[row];
+		filter->rows[row] = r[3];
+		rows01 = _mm_add_ps(_mm_set_ps(r[1], r[0], r[0], filter->rows[0]), _mm_set_ps(r[2], r[2], filter->rows[1], filter->rows[1]));
+		filter->rows[0] = r[1];
+		filter->rows[1] = r[2];
+
+		// the running sum drifts, so it is summed again whenever the lowest row changes
+		if (row == CUTE_DSP_PINK_NOISE_ROWS - 1)
+		{
+			filter->high_rows = 0.f;
+			for (k = 2; k < CUTE_DSP_PINK_NOISE_ROWS; ++k)
+				filter->high_rows += filter->rows[k];
+		}
+		return _mm_mul_ps(_mm_add_ps(_mm_add_ps(white, rows01), _mm_set1_ps(filter->high_rows)), _mm_set1_ps(1.f / 4.1231056f));
+	}
+
+	case CD_NOISE_BROWN:
+	{
+		// y[n] = a * y[n - 1] + g * x[n], g = sqrt(1 - a^2) keeps the rms of x
+		float a = filter->brown_leak, a2 = a * a;
+		__m128 y = _mm_mul_ps(white, _mm_set1_ps(sqrtf(1.f - a2)));
+		y = _mm_add_ps(y, _mm_mul_ps(_mm_set1_ps(a), _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 4))));
+		y = _mm_add_ps(y, _mm_mul_ps(_mm_set1_ps(a2), _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 8))));
+		y = _mm_add_ps(y, _mm_mul_ps(_mm_set_ps(a2 * a2, a2 * a, a2, a), _mm_set1_ps(filter->brown)));
+		_mm_store_ss(&filter->brown, _mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 3, 3)));
+		return y;
+	}
+
+	case CD_NOISE_VELVET:
+	{
+		// impulses of the same power as the white noise over a period, which has a power of 1/3
+		float impulses[4] = { 0.f, 0.f, 0.f, 0.f };
+		float height = sqrtf((float)filter->velvet_spacing / 3.f);
+		uint32_t r[4];
+		int k = 0;
+		_mm_storeu_si128((__m128i*)r, bits);
+		while (filter->velvet_impulse < 4)
+		{
+			impulses[filter->velvet_impulse] = (r[k] & 1) ? height : -height;
+			filter->velvet_period += filter->velvet_spacing;
+			filter->velvet_impulse = filter->velvet_period + (int)((r[k] >> 1) % (uint32_t)filter->velvet_spacing);
+			k = (k + 1) & 3;
+		}
+		filter->velvet_period -= 4;
+		filter->velvet_impulse -= 4;
+		return _mm_loadu_ps(impulses);
+	}
+
+	default:
+		return white;
+	}
+}
+
+// gain of sample i of a block ramped by step per sample from amplitude, and of 4 samples from i
+#define cd_noise_gain(i) (amplitude + step * (float)((i) + 1))
+#define cd_noise_gain4(i) _mm_add_ps(_mm_set1_ps(amplitude), _mm_mul_ps(_mm_set1_ps(step), _mm_add_ps(_mm_set1_ps((float)((i) + 1)), _mm_setr_ps(0.f, 1.f, 2.f, 3.f))))
+
+// a group is made from the index of its first sample, the samples of a pending group were made with it
+static void cd_sample_colored_noise(cd_noise_t* filter, const float* input, float* samples, unsigned num_samples, float amplitude, float step)
+{
+	unsigned i = 0;
+	const __m128i key = _mm_set1_epi32((int)filter->key);
+	const __m128 step4 = _mm_set1_ps(4.f * step);
+	__m128i weyl;
+	__m128 gain;
+
+	for (; i < num_samples && filter->pending_count; ++i, --filter->pending_count)
+		samples[i] = cd_noise_gain(i) * filter->pending[4 - filter->pending_count] + input[i];
+
+	weyl = cd_random_weyl4(filter->position + i);
+	gain = cd_noise_gain4(i);
+	for (; i + 4 <= num_samples; i += 4, weyl = _mm_add_epi32(weyl, CUTE_DSP_WEYL_STEP4), gain = _mm_add_ps(gain, step4))
+	{
+		__m128 noise = cd_next_colored_noise(filter, key, weyl);
+		_mm_storeu_ps(samples + i, _mm_add_ps(_mm_mul_ps(gain, noise), _mm_loadu_ps(input + i)));
+	}
+
+	if (i < num_samples)
+	{
+		_mm_storeu_ps(filter->pending, cd_next_colored_noise(filter, key, weyl));
+		for (filter->pending_count = 4; i < num_samples; ++i, --filter->pending_count)
+			samples[i] = cd_noise_gain(i) * filter->pending[4 - filter->pending_count] + input[i];
+	}
+}
+
+// the gain ramps from the one reached by the last block, a static gain adds steps of 0
+void cd_sample_noise(cd_context_t* context, cd_noise_t* filter, const float* input, float** output, unsigned num_samples)
+{
+	unsigned i = 0;
+	float* samples = context->current_output;
+	float amplitude, step;
+	if (!filter->running)
+	{
+		filter->smoothed_gain = filter->amplitude_gain;
+		filter->running = 1;
+	}
+	amplitude = filter->smoothed_gain;
+	step = num_samples ? (filter->amplitude_gain - amplitude) / (float)num_samples : 0.f;
+	filter->smoothed_gain = filter->amplitude_gain;
+
+	if (filter->color != CD_NOISE_WHITE)
+		cd_sample_colored_noise(filter, input, samples, num_samples, amplitude, step);
+	else
+	{
+		const __m128i key = _mm_set1_epi32((int)filter->key);
+		const __m128 step4 = _mm_set1_ps(4.f * step);
+		__m128i weyl = cd_random_weyl4(filter->position);
+		__m128 gain = cd_noise_gain4(0);
+		for (; i + 4 <= num_samples; i += 4, weyl = _mm_add_epi32(weyl, CUTE_DSP_WEYL_STEP4), gain = _mm_add_ps(gain, step4))
+		{
+			__m128 noise = cd_random_to_float4(cd_random_hash4(key, weyl));
+			_mm_storeu_ps(samples + i, _mm_add_ps(_mm_mul_ps(gain, noise), _mm_loadu_ps(input + i)));
+		}
+		for (; i < num_samples; ++i)
+			samples[i] = cd_noise_gain(i) * cd_random_to_float(cd_random_hash(filter->key, filter->position + i)) + input[i];
+	}
+	filter->position += num_samples;
+
+	*output = context->current_output;
+	cd_context_swap_buffers(context);
+}
+
+#undef cd_noise_gain
+#undef cd_noise_gain4
+/* END NOISE IMPLEMENTATION */
+
+/* BEGIN WIND IMPLEMENTATION */
+/*
+	Stacking a noise generator and a resonant lowpass on every emitter draws a random number and a
+	double division per sample, and runs a biquad per sample. Winds read a noise table made once per
+	context instead, 4 lanes at a time, and only update their filter coefficients and gust LFOs once
+	per block. The loudness of a gust is ramped across the block so it doesn't click.
+*/
+
+// samples of shared noise, a power of two, followed by a copy of its start so blocks can be read without wrapping
+#define CUTE_DSP_WIND_NOISE_LENGTH (65536)
+
+// ratio of the rates of the two gust LFOs, irrational so the gusts don't repeat
+#define CUTE_DSP_WIND_GUST_RATIO (2.37f)
+
+// highest resonance of the bandpasses, at 1 they stop damping and cd_wind_bandpass_gain divides by 0
+#define CUTE_DSP_WIND_MAX_RESONANCE (0.995f)
+
+/*
+	Gain of the bandpass output of a state variable filter for an rms of about 1 from the shared noise.
+	k times the bandpass output peaks at 1, with a noise bandwidth of pi / 2 * cutoff * k, while the
+	noise has a power of 1/3 spread up to half the sampling rate. angle is pi * cutoff / sampling rate.
+*/
+static float cd_wind_bandpass_gain(float angle, float k)
+{
+	return k * sqrtf(3.f / (angle * k));
+}
+
+cd_wind_def_t cd_get_wind_preset(cd_wind_preset_t preset)
+{
+	cd_wind_def_t def;
+	memset(&def, 0, sizeof(cd_wind_def_t));
+	switch (preset)
+	{
+	case CD_WIND_BREEZE:
+		def.amplitude_db = -30.f;
+		def.cutoff = 400.f;
+		def.resonance = 0.3f;
+		def.cutoff_depth = 1.f;
+		def.gust_depth = 0.5f;
+		def.gust_rate = 0.15f;
+		break;
+
+	case CD_WIND_GALE:
+		def.amplitude_db = -18.f;
+		def.cutoff = 800.f;
+		def.resonance = 0.5f;
+		def.cutoff_depth = 2.f;
+		def.gust_depth = 0.8f;
+		def.gust_rate = 0.4f;
+		def.whistle_gain = 0.3f;
+		def.whistle_cutoff = 1800.f;
+		def.whistle_resonance = 0.9f;
+		break;
+
+	case CD_WIND_HOWLING:
+		def.amplitude_db = -20.f;
+		def.cutoff = 500.f;
+		def.resonance = 0.6f;
+		def.cutoff_depth = 1.5f;
+		def.gust_depth = 0.7f;
+		def.gust_rate = 0.25f;
+		def.whistle_gain = 1.f;
+		def.whistle_cutoff = 1200.f;
+		def.whistle_resonance = 0.98f;
+		break;
+	}
+	return def;
+}
+
+// white noise in [-1, 1), from 4 xorshift32 generators in the lanes of an SSE register
+static void cd_make_wind_noise(cd_context_t* context)
+{
+	float* noise = (float*)CUTE_DSP_ALLOC(sizeof(float) * (CUTE_DSP_WIND_NOISE_LENGTH + CUTE_DSP_MAX_FRAME_LENGTH), 0);
+	__m128i x;
+	unsigned i = 0;
+	CUTE_DSP_ASSERT(noise);
+
+	x = cd_random_seed4(&context->random_generator);
+	for (; i < CUTE_DSP_WIND_NOISE_LENGTH; i += 4)
+	{
+		x = cd_random_rand4(x);
+		_mm_storeu_ps(noise + i, cd_random_to_float4(x));
+	}
+	memcpy(noise + CUTE_DSP_WIND_NOISE_LENGTH, noise, sizeof(float) * CUTE_DSP_MAX_FRAME_LENGTH);
+	context->wind_noise = noise;
+}
+
+cd_wind_t* cd_make_wind(cd_context_t* context, cd_wind_def_t def)
+{
+	cd_wind_t* wind = NULL;
+	CUTE_DSP_ASSERT(context);
+
+	if (!context->wind_noise)
+		cd_make_wind_noise(context);
+
+	wind = (cd_wind_t*)CUTE_DSP_ALLOC(sizeof(cd_wind_t), 0);
+	CUTE_DSP_ASSERT(wind);
+	memset(wind, 0, sizeof(cd_wind_t));
+
+	wind->radians_per_hz = CUTE_DSP_PI / context->sampling_rate;
+	wind->position = (unsigned)cd_random_rand(&context->random_generator) & (CUTE_DSP_WIND_NOISE_LENGTH - 1);
+	wind->phases[0] = cd_random_rand_between(&context->random_generator, 0.f, 2.f * CUTE_DSP_PI);
+	wind->phases[1] = cd_random_rand_between(&context->random_generator, 0.f, 2.f * CUTE_DSP_PI);
+	cd_set_wind_parameters(wind, def);
+	return wind;
+}
+
+void cd_release_wind(cd_context_t* context, cd_wind_t** wind)
+{
+	CUTE_DSP_ASSERT(context && wind && *wind);
+	CUTE_DSP_FREE(*wind, 0);
+	*wind = NULL;
+	(void)context; /* unused parameter */
+}
+
+void cd_set_wind_parameters(cd_wind_t* wind, cd_wind_def_t def)
+{
+	CUTE_DSP_ASSERT(wind);
+	def.cutoff = CUTE_DSP_CLAMP(def.cutoff, CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF, CUTE_DSP_DEFAULT_LOWPASS_CUTOFF);
+	def.whistle_cutoff = CUTE_DSP_CLAMP(def.whistle_cutoff, CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF, CUTE_DSP_DEFAULT_LOWPASS_CUTOFF);
+	def.resonance = CUTE_DSP_CLAMP(def.resonance, 0.f, CUTE_DSP_WIND_MAX_RESONANCE);
+	def.whistle_resonance = CUTE_DSP_CLAMP(def.whistle_resonance, 0.f, CUTE_DSP_WIND_MAX_RESONANCE);
+	def.gust_depth = CUTE_DSP_CLAMP(def.gust_depth, 0.f, 1.f);
+	wind->def = def;
+
+	// same pole angles as cd_set_svf_parameters
+	wind->body_k = 2.f * CUTE_DSP_SIN(CUTE_DSP_PI / 4.f * (1.f - def.resonance));
+	wind->whistle_k = 2.f * CUTE_DSP_SIN(CUTE_DSP_PI / 4.f * (1.f - def.whistle_resonance));
+}
+
+cd_wind_def_t cd_get_wind_parameters(const cd_wind_t* wind)
+{
+	return wind->def;
+}
+
+void cd_sample_wind(cd_context_t* context, cd_wind_t* wind, const float* input, float** output, unsigned num_samples)
+{
+	unsigned i = 0;
+	float* samples = context->current_output;
+	const float* noise = context->wind_noise + wind->position;
+	const cd_wind_def_t* def = &wind->def;
+	float step = 2.f * CUTE_DSP_PI * def->gust_rate * (float)num_samples / context->sampling_rate;
+	float lfo, gust, octaves, angle, target, gain, gain_step, body_gain, whistle_gain;
+	float b1, b2, b3, w1, w2, w3;
+	float body_ic1eq = wind->body_ic1eq, body_ic2eq = wind->body_ic2eq;
+	float whistle_ic1eq = wind->whistle_ic1eq, whistle_ic2eq = wind->whistle_ic2eq;
+	CUTE_DSP_ASSERT(num_samples <= CUTE_DSP_MAX_FRAME_LENGTH);
+
+	// gusts peak sharply and linger between, the square of the sum of two LFOs in [0, 1]
+	wind->phases[0] = fmodf(wind->phases[0] + step, 2.f * CUTE_DSP_PI);
+	wind->phases[1] = fmodf(wind->phases[1] + step * CUTE_DSP_WIND_GUST_RATIO, 2.f * CUTE_DSP_PI);
+	lfo = 0.5f + 0.3f * CUTE_DSP_SIN(wind->phases[0]) + 0.2f * CUTE_DSP_SIN(wind->phases[1]);
+	gust = lfo * lfo;
+	target = CUTE_DSP_DB_TO_GAIN(def->amplitude_db) * (1.f - def->gust_depth + def->gust_depth * gust);
+	gain_step = (target - wind->gain) / (float)(num_samples ? num_samples : 1);
+	gain = wind->gain;
+
+	octaves = powf(2.f, def->cutoff_depth * (gust - 0.5f));
+	angle = CUTE_DSP_CLAMP(def->cutoff * octaves * wind->radians_per_hz, 0.f, CUTE_DSP_SVF_MAX_ANGLE);
+	cd_svf_coefficients(angle, wind->body_k, b1, b2, b3);
+	body_gain = cd_wind_bandpass_gain(angle, wind->body_k);
+	angle = CUTE_DSP_CLAMP(def->whistle_cutoff * octaves * wind->radians_per_hz, 0.f, CUTE_DSP_SVF_MAX_ANGLE);
+	cd_svf_coefficients(angle, wind->whistle_k, w1, w2, w3);
+	whistle_gain = def->whistle_gain * cd_wind_bandpass_gain(angle, wind->whistle_k);
+
+#define cd_wind_bandpass(v0, a1, a2, a3, ic1eq, ic2eq, band)	\
+	{	\
+		float v3 = v0 - ic2eq;	\
+		band = a1 * ic1eq + a2 * v3;	\
+		ic2eq = 2.f * (ic2eq + a2 * ic1eq + a3 * v3) - ic2eq;	\
+		ic1eq = 2.f * band - ic1eq;	\
+	}
+
+	if (def->whistle_gain == 0.f)
+	{
+		for (; i < num_samples; ++i, gain += gain_step)
+		{
+			float body;
+			cd_wind_bandpass(noise[i], b1, b2, b3, body_ic1eq, body_ic2eq, body);
+			samples[i] = gain * body_gain * body + (input ? input[i] : 0.f);
+		}
+	}
+	else
+	{
+		for (; i < num_samples; ++i, gain += gain_step)
+		{
+			float body, whistle;
+			cd_wind_bandpass(noise[i], b1, b2, b3, body_ic1eq, body_ic2eq, body);
+			cd_wind_bandpass(noise[i], w1, w2, w3, whistle_ic1eq, whistle_ic2eq, whistle);
+			samples[i] = gain * (body_gain * body + whistle_gain * whistle) + (input ? input[i] : 0.f);
+		}
+	}
+
+#undef cd_wind_bandpass
+
+	wind->gain = target;
+	wind->position = (wind->position + num_samples) & (CUTE_DSP_WIND_NOISE_LENGTH - 1);
+	wind->body_ic1eq = body_ic1eq;
+	wind->body_ic2eq = body_ic2eq;
+	wind->whistle_ic1eq = whistle_ic1eq;
+	wind->whistle_ic2eq = whistle_ic2eq;
+	*output = context->current_output;
+	cd_context_swap_buffers(context);
+}
+/* END WIND IMPLEMENTATION */
+
+/* BEGIN REVERB IMPLEMENTATION */
+/*
+	Feedback delay network: every frame the 8 delay lines are read, damped by a one pole lowpass,
+	scaled by their decay gain and mixed by an orthogonal 8x8 Hadamard matrix before being written
+	back together with the input. Lines 0-3 and 4-7 are one SSE register each, the left input feeds
+	and the left output taps the first half, the right side the second half.
+*/
+
+// mutually prime line lengths at 44.1kHz, scaled with the sampling rate so the room sounds the same
+static const int cd_reverb_base_lengths[CUTE_DSP_REVERB_LINES] = { 1031, 1327, 1523, 1871, 2053, 2311, 2557, 2903 };
+
+#define CUTE_DSP_REVERB_INPUT_GAIN (0.25f)
+#define CUTE_DSP_REVERB_OUTPUT_GAIN (0.5f)
+#define CUTE_DSP_REVERB_MAX_DAMPING (0.9f)
+
+static void cd_update_reverb_gains(cd_reverb_t* reverb)
+{
+	int i;
+	reverb->dirty = 0;
+	for (i = 0; i < CUTE_DSP_REVERB_LINES; ++i)
+		reverb->gains[i] = powf(10.f, -3.f * (float)reverb->lengths[i] / (reverb->decay * reverb->sampling_rate));
+	reverb->damping_coeff = reverb->damping * CUTE_DSP_REVERB_MAX_DAMPING;
+}
+
+cd_reverb_t* cd_make_reverb(cd_context_t* context)
+{
+	cd_reverb_t* reverb = NULL;
+	float* line;
+	int i, total = 0;
+	CUTE_DSP_ASSERT(context);
+
+	reverb = (cd_reverb_t*)CUTE_DSP_ALLOC(sizeof(cd_reverb_t), 0);
+	CUTE_DSP_ASSERT(reverb);
+	memset(reverb, 0, sizeof(cd_reverb_t));
+	reverb->sampling_rate = context->sampling_rate;
+
+	for (i = 0; i < CUTE_DSP_REVERB_LINES; ++i)
+	{
+		reverb->lengths[i] = (int)((float)cd_reverb_base_lengths[i] * reverb->sampling_rate / CUTE_DSP_REVERB_BASE_RATE + 0.5f);
+		if (reverb->lengths[i] < 1)
+			reverb->lengths[i] = 1;
+		total += reverb->lengths[i];
+	}
+
+	reverb->memory = (float*)CUTE_DSP_ALLOC(sizeof(float) * total, 0);
+	CUTE_DSP_ASSERT(reverb->memory);
+	memset(reverb->memory, 0, sizeof(float) * total);
+	for (i = 0, line = reverb->memory; i < CUTE_DSP_REVERB_LINES; line += reverb->lengths[i++])
+		reverb->lines[i] = line;
+
+	reverb->decay = CUTE_DSP_DEFAULT_REVERB_DECAY;
+	reverb->damping = CUTE_DSP_DEFAULT_REVERB_DAMPING;
+	cd_update_reverb_gains(reverb);
+	return reverb;
+}
+
+void cd_release_reverb(cd_context_t* context, cd_reverb_t** reverb)
+{
+	CUTE_DSP_ASSERT(context && reverb && *reverb);
+	CUTE_DSP_FREE((*reverb)->memory, 0);
+	CUTE_DSP_FREE(*reverb, 0);
+	*reverb = NULL;
+	(void)context; /* unused parameter */
+}
+
+void cd_set_reverb_parameters(cd_reverb_t* reverb, float decay_s, float damping)
+{
+	CUTE_DSP_ASSERT(reverb);
+	reverb->decay = CUTE_DSP_CLAMP(decay_s, 0.1f, 30.f);
+	reverb->damping = CUTE_DSP_CLAMP(damping, 0.f, 1.f);
+	reverb->dirty = 1;
+}
+
+float cd_get_reverb_decay(const cd_reverb_t* reverb)
+{
+	CUTE_DSP_ASSERT(reverb);
+	return reverb->decay;
+}
+
+float cd_get_reverb_damping(const cd_reverb_t* reverb)
+{
+	CUTE_DSP_ASSERT(reverb);
+	return reverb->damping;
+}
+
+// 4 point Hadamard transform in two butterfly stages
+static inline __m128 cd_hadamard4(__m128 v)
+{
+	const __m128 signs1 = _mm_setr_ps(1.f, -1.f, 1.f, -1.f);
+	const __m128 signs2 = _mm_setr_ps(1.f, 1.f, -1.f, -1.f);
+	v = _mm_add_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)), _mm_mul_ps(v, signs1));
+	return _mm_add_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)), _mm_mul_ps(v, signs2));
+}
+
+void cd_sample_reverb(cd_context_t* context, cd_reverb_t* reverb, const float* left, const float* right, float** out_left, float** out_right, unsigned num_samples)
+{
+	unsigned i = 0;
+	int l;
+	float taps[CUTE_DSP_REVERB_LINES];
+	float* samples_left = context->current_output;
+	float* samples_right = context->current_output + CUTE_DSP_MAX_FRAME_LENGTH;
+	const __m128 normalize = _mm_set1_ps(0.35355339f); // 1 / sqrt(8) keeps the matrix lossless
+	__m128 lows, highs, gains_low, gains_high, damping, states_low, states_high;
+	CUTE_DSP_ASSERT(num_samples <= CUTE_DSP_MAX_FRAME_LENGTH);
+
+	if (reverb->dirty)
+		cd_update_reverb_gains(reverb);
+	gains_low = _mm_loadu_ps(reverb->gains);
+	gains_high = _mm_loadu_ps(reverb->gains + 4);
+	states_low = _mm_loadu_ps(reverb->damping_states);
+	states_high = _mm_loadu_ps(reverb->damping_states + 4);
+	damping = _mm_set1_ps(reverb->damping_coeff);
+
+	for (; i < num_samples; ++i)
+	{
+		for (l = 0; l < CUTE_DSP_REVERB_LINES; ++l)
+			taps[l] = reverb->lines[l][reverb->positions[l]];
+		samples_left[i] = (taps[0] + taps[1] + taps[2] + taps[3]) * CUTE_DSP_REVERB_OUTPUT_GAIN;
+		samples_right[i] = (taps[4] + taps[5] + taps[6] + taps[7]) * CUTE_DSP_REVERB_OUTPUT_GAIN;
+
+		// damp and decay every line
+		lows = _mm_loadu_ps(taps);
+		highs = _mm_loadu_ps(taps + 4);
+		states_low = _mm_add_ps(lows, _mm_mul_ps(damping, _mm_sub_ps(states_low, lows)));
+		states_high = _mm_add_ps(highs, _mm_mul_ps(damping, _mm_sub_ps(states_high, highs)));
+		lows = cd_hadamard4(_mm_mul_ps(states_low, gains_low));
+		highs = cd_hadamard4(_mm_mul_ps(states_high, gains_high));
+
+		// last butterfly stage of the 8 point Hadamard across the two registers, then feed the input
+		_mm_storeu_ps(taps, _mm_add_ps(_mm_mul_ps(_mm_add_ps(lows, highs), normalize), _mm_set1_ps(left[i] * CUTE_DSP_REVERB_INPUT_GAIN + CUTE_DSP_REVERB_DENORMAL_GUARD)));
+		_mm_storeu_ps(taps + 4, _mm_add_ps(_mm_mul_ps(_mm_sub_ps(lows, highs), normalize), _mm_set1_ps(right[i] * CUTE_DSP_REVERB_INPUT_GAIN + CUTE_DSP_REVERB_DENORMAL_GUARD)));
+		for (l = 0; l < CUTE_DSP_REVERB_LINES; ++l)
+		{
+			reverb->lines[l][reverb->positions[l]] = taps[l];
+			if (++reverb->positions[l] == reverb->lengths[l])
+				reverb->positions[l] = 0;
+		}
+	}
+
+	_mm_storeu_ps(reverb->damping_states, states_low);
+	_mm_storeu_ps(reverb->damping_states + 4, states_high);
+	*out_left = samples_left;
+	*out_right = samples_right;
+	cd_context_swap_buffers(context);
+}
+
+void cd_set_reverb_send(cs_playing_sound_t* playing_sound, float send)
+{
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->reverb_bus);
+	cd_set_bus_send(playing_sound, ctx->reverb_bus, send);
+}
+
+float cd_get_reverb_send(const cs_playing_sound_t* playing_sound)
+{
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->reverb_bus);
+	return cd_get_bus_send(playing_sound, ctx->reverb_bus);
+}
+
+cd_reverb_t* cd_get_shared_reverb(cd_context_t* context)
+{
+	CUTE_DSP_ASSERT(context);
+	return context->reverb_bus ? context->reverb_bus->reverb : NULL;
+}
+
+cs_loaded_sound_t* cd_get_reverb_return(cd_context_t* context)
 {
-	struct cd_memory_pool_object_t* next;
-} cd_memory_pool_object_t;
+	CUTE_DSP_ASSERT(context);
+	return context->reverb_bus ? &context->reverb_bus->return_sound : NULL;
+}
 
-typedef struct cd_memory_pool_t
+/* END REVERB IMPLEMENTATION */
+
+/* BEGIN BUS IMPLEMENTATION */
+/*
+	The send plugin sums every voice, after its own filters, into the send buffers of the buses it is sent to.
+	When cute_sound mixes the return voice of a bus, the bus effects run once over the summed block and the
+	send buffers are cleared. Every voice is mixed once between two blocks of the return voice, so a bus costs
+	the same however many voices feed it, and its output runs one mix block behind the voices.
+*/
+cd_bus_t* cd_make_bus(cd_context_t* context, cd_bus_def_t def)
 {
-	unsigned size_per_object;
-	unsigned max_objects;
-	unsigned pool_size;
-	unsigned num_objects;
-	char* pool;
-	cd_memory_pool_object_t* free_list;
-} cd_memory_pool_t;
+	cd_bus_t* bus = NULL;
+	size_t size = sizeof(float) * CUTE_DSP_MAX_FRAME_LENGTH;
+	CUTE_DSP_ASSERT(context && def.name && context->bus_count < CUTE_DSP_MAX_BUSES);
+	bus = (cd_bus_t*)CUTE_DSP_ALLOC(sizeof(cd_bus_t), 0);
+	CUTE_DSP_ASSERT(bus);
+	memset(bus, 0, sizeof(cd_bus_t));
+
+	strncpy(bus->name, def.name, CUTE_DSP_MAX_BUS_NAME - 1);
+	bus->index = context->bus_count;
+	if (def.use_lowpass)
+		bus->lowpass = cd_make_lowpass_channels(context, CUTE_DSP_STEREO);
+	if (def.use_highpass)
+		bus->highpass = cd_make_highpass_channels(context, CUTE_DSP_STEREO);
+	if (def.use_echo)
+		bus->echo = cd_make_echo_channels(context, CUTE_DSP_STEREO);
+	if (def.reflections)
+		bus->reflections = cd_make_multitap_channels(context, def.reflections, CUTE_DSP_STEREO);
+	if (def.impulse_response)
+		bus->convolver = cd_make_convolver_channels(context, def.impulse_response, CUTE_DSP_STEREO);
+	if (def.use_reverb)
+		bus->reverb = cd_make_reverb(context);
+
+	// one block of silence shared by every return sound, cute_sound reads loaded sounds 4 samples at a time
+	if (!context->silence)
+	{
+		char* memory = (char*)CUTE_DSP_ALLOC(size + 15, 0);
+		CUTE_DSP_ASSERT(memory);
+		context->silence_memory = memory;
+		memory += (16 - ((size_t)memory & 15)) & 15;
+		memset(memory, 0, size);
+		context->silence = (float*)memory;
+	}
+	bus->return_sound.sample_rate = (int)context->sampling_rate;
+	bus->return_sound.sample_count = CUTE_DSP_MAX_FRAME_LENGTH;
+	bus->return_sound.channel_count = CUTE_DSP_STEREO;
+	bus->return_sound.channels[0] = (__m128*)context->silence;
+	bus->return_sound.channels[1] = (__m128*)context->silence;
+
+	// published last, the send plugin reads the buses on the mix thread
+	context->buses[bus->index] = bus;
+	context->bus_count = bus->index + 1;
+	return bus;
+}
 
-typedef struct cd_memory_pool_def_t
+static void cd_release_buses(cd_context_t* context)
 {
-	unsigned size_per_object;
-	unsigned max_objects;
-} cd_memory_pool_def_t;
+	unsigned i = 0;
+	for (; i < context->bus_count; ++i)
+	{
+		cd_bus_t* bus = context->buses[i];
+		if (bus->lowpass)
+		{
+			cd_release_lowpass(context, &bus->lowpass->next);
+			cd_release_lowpass(context, &bus->lowpass);
+		}
+		if (bus->highpass)
+		{
+			cd_release_highpass(context, &bus->highpass->next);
+			cd_release_highpass(context, &bus->highpass);
+		}
+		if (bus->echo)
+		{
+			cd_release_echo_filter(context, &bus->echo->next);
+			cd_release_echo_filter(context, &bus->echo);
+		}
+		if (bus->reflections)
+		{
+			cd_release_multitap(context, &bus->reflections->next);
+			cd_release_multitap(context, &bus->reflections);
+		}
+		if (bus->convolver)
+		{
+			cd_release_convolver(context, &bus->convolver->next);
+			cd_release_convolver(context, &bus->convolver);
+		}
+		if (bus->reverb)
+			cd_release_reverb(context, &bus->reverb);
+		CUTE_DSP_FREE(bus, 0);
+		context->buses[i] = 0;
+	}
+	context->bus_count = 0;
+	context->reverb_bus = 0;
+	if (context->silence_memory)
+		CUTE_DSP_FREE(context->silence_memory, 0);
+	context->silence_memory = 0;
+	context->silence = 0;
+}
 
-typedef struct cd_ring_buffer_t
+cd_bus_t* cd_find_bus(cd_context_t* context, const char* name)
 {
-	float* buffer;
-	int current_index;
-	int max_elements;
-} cd_ring_buffer_t;
+	unsigned i = 0;
+	CUTE_DSP_ASSERT(context && name);
+	for (; i < context->bus_count; ++i)
+		if (!strcmp(context->buses[i]->name, name))
+			return context->buses[i];
+	return NULL;
+}
 
-// xorshift PRNG
-typedef size_t uint64_t;
-typedef struct cd_random_t
+cs_loaded_sound_t* cd_get_bus_return(cd_bus_t* bus)
 {
-	uint64_t a;
-	uint64_t b;
-} cd_random_t;
+	CUTE_DSP_ASSERT(bus);
+	return &bus->return_sound;
+}
 
-typedef struct cd_context_t
+void cd_set_bus_send(cs_playing_sound_t* playing_sound, const cd_bus_t* bus, float send)
 {
-	float sampling_rate;
-	unsigned channel_count;
-	cd_memory_pool_t lowpass_filters;
-	cd_memory_pool_t highpass_filters;
-	cd_memory_pool_t echo_filters;
-	cd_memory_pool_t noise_generators;
-	unsigned pool_size;
-	cs_plugin_id_t lowpass_id;
-	cs_plugin_id_t highpass_id;
-	cs_plugin_id_t echo_id;
-	cs_plugin_id_t noise_id;
-	float* current_output;
-	float output1[CUTE_DSP_MAX_FRAME_LENGTH * CUTE_DSP_STEREO]; // number of samples is frames * channels
-	float output2[CUTE_DSP_MAX_FRAME_LENGTH * CUTE_DSP_STEREO];
+	CUTE_DSP_ASSERT(playing_sound && bus);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->bus_send_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_voice_t* voice = (cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	voice->sends[bus->index] = send;
+
+	// sends come after the filters, so cached renders stay valid
+	cd_capture_parameter(ctx, playing_sound, CD_CAPTURE_BUS_SEND + (int)bus->index, send);
+}
+
+float cd_get_bus_send(const cs_playing_sound_t* playing_sound, const cd_bus_t* bus)
+{
+	CUTE_DSP_ASSERT(playing_sound && bus);
+	cd_context_t* ctx = cd_get_context();
+	const cd_voice_t* voice = (const cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	return voice->sends[bus->index];
+}
+
+void cd_set_dry_gain(cs_playing_sound_t* playing_sound, float gain)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->bus_send_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_voice_t* voice = (cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	voice->dry_gain = gain;
+	cd_capture_parameter(ctx, playing_sound, CD_CAPTURE_DRY_GAIN, gain);
+}
+
+float cd_get_dry_gain(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	const cd_voice_t* voice = (const cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	return voice->dry_gain;
+}
+
+void cd_set_bus_lowpass(cd_bus_t* bus, float cutoff_freq_in_hz, float resonance)
+{
+	CUTE_DSP_ASSERT(bus && bus->lowpass);
+	cd_set_lowpass_channels(bus->lowpass, cutoff_freq_in_hz, resonance);
+}
+
+void cd_set_bus_highpass(cd_bus_t* bus, float cutoff_freq_in_hz)
+{
+	CUTE_DSP_ASSERT(bus && bus->highpass);
+	cd_set_highpass_cutoff_frequency(bus->highpass, cutoff_freq_in_hz);
+}
+
+void cd_set_bus_echo(cd_bus_t* bus, float t, float a, float b)
+{
+	CUTE_DSP_ASSERT(bus && bus->echo);
+	cd_set_echo_parameters(bus->echo, t, a, b);
+}
+
+cd_reverb_t* cd_get_bus_reverb(cd_bus_t* bus)
+{
+	CUTE_DSP_ASSERT(bus);
+	return bus->reverb;
+}
+
+// runs the filters of one channel, the context output buffers are reused by the other channel so the result is copied out
+static void cd_sample_bus_channel(cd_context_t* context, cd_bus_t* bus, int channel_index, const float* input, unsigned num_samples)
+{
+	float* samples = (float*)input;
+	if (bus->lowpass)
+		cd_sample_lowpass(context, channel_index ? bus->lowpass->next : bus->lowpass, samples, &samples, num_samples);
+	if (bus->highpass)
+		cd_sample_highpass(context, channel_index ? bus->highpass->next : bus->highpass, samples, &samples, num_samples);
+	if (bus->echo)
+		cd_sample_echo(context, channel_index ? bus->echo->next : bus->echo, samples, &samples, num_samples);
+	if (bus->reflections)
+		cd_sample_multitap(context, channel_index ? bus->reflections->next : bus->reflections, samples, &samples, num_samples);
+	if (bus->convolver)
+		cd_sample_convolver(context, channel_index ? bus->convolver->next : bus->convolver, samples, &samples, num_samples);
+	memcpy(bus->output[channel_index], samples, sizeof(float) * num_samples);
+}
+
+void cd_sample_bus(cd_context_t* context, cd_bus_t* bus, const float* left, const float* right, float** out_left, float** out_right, unsigned num_samples)
+{
+	CUTE_DSP_ASSERT(context && bus && num_samples <= CUTE_DSP_MAX_FRAME_LENGTH);
+	cd_sample_bus_channel(context, bus, 0, left, num_samples);
+	cd_sample_bus_channel(context, bus, 1, right, num_samples);
+	if (bus->reverb)
+	{
+		float* reverb_left;
+		float* reverb_right;
+		cd_sample_reverb(context, bus->reverb, bus->output[0], bus->output[1], &reverb_left, &reverb_right, num_samples);
+		memcpy(bus->output[0], reverb_left, sizeof(float) * num_samples);
+		memcpy(bus->output[1], reverb_right, sizeof(float) * num_samples);
+	}
+	*out_left = bus->output[0];
+	*out_right = bus->output[1];
+}
+
+static void cd_accumulate_bus_send(float* send, const float* samples, float gain, int sample_count)
+{
+	int i = 0;
+	const __m128 send_gain = _mm_set1_ps(gain);
+	for (; i + 4 <= sample_count; i += 4)
+		_mm_storeu_ps(send + i, _mm_add_ps(_mm_loadu_ps(send + i), _mm_mul_ps(_mm_loadu_ps(samples + i), send_gain)));
+	for (; i < sample_count; ++i)
+		send[i] += samples[i] * gain;
+}
+
+static void cd_apply_dry_gain(cd_context_t* context, const float* input, float** output, unsigned num_samples, float gain)
+{
+	unsigned i = 0;
+	float* samples = context->current_output;
+	const __m128 dry_gain = _mm_set1_ps(gain);
+	for (; i + 4 <= num_samples; i += 4)
+		_mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(input + i), dry_gain));
+	for (; i < num_samples; ++i)
+		samples[i] = input[i] * gain;
+	*output = samples;
+	cd_context_swap_buffers(context);
+}
+
+static void cd_mix_bus_return(cd_context_t* context, cd_bus_t* bus, int channel_index, int sample_count, float** samples_out)
+{
+	float* left;
+	float* right;
+	if (channel_index == 0)
+	{
+		cd_sample_bus(context, bus, bus->send[0], bus->send[1], &left, &right, (unsigned)sample_count);
+		memset(bus->send, 0, sizeof(bus->send));
+	}
+	*samples_out = bus->output[channel_index];
+}
+
+/* END BUS IMPLEMENTATION */
+
+/* BEGIN FILTER GROUP IMPLEMENTATION */
+/*
+	A group keeps a reference to the coefficients of its parameters, at the rate of the context and at the
+	reduced rates of multirate voices. A set looks them up once per rate, then points the filters of every
+	member to them on the game thread, the same as the setters of a single sound, so the mix thread never
+	touches the references or the parameters of a group.
+*/
+cd_filter_group_t* cd_make_filter_group(cd_context_t* context, const char* name)
+{
+	cd_filter_group_t* group = NULL;
+	CUTE_DSP_ASSERT(context && name && context->filter_group_count < CUTE_DSP_MAX_FILTER_GROUPS);
+	group = (cd_filter_group_t*)CUTE_DSP_ALLOC(sizeof(cd_filter_group_t), 0);
+	CUTE_DSP_ASSERT(group);
+	memset(group, 0, sizeof(cd_filter_group_t));
+
+	strncpy(group->name, name, CUTE_DSP_MAX_FILTER_GROUP_NAME - 1);
+	group->context = context;
+	group->lowpass_cutoff = CUTE_DSP_DEFAULT_LOWPASS_CUTOFF;
+	group->lowpass_resonance = 0.f;
+	group->highpass_cutoff = CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF;
+	group->lowpass = cd_acquire_coefficients(&context->coefficients, 0, context->sampling_rate, group->lowpass_cutoff, group->lowpass_resonance);
+	group->highpass = cd_acquire_coefficients(&context->coefficients, 1, context->sampling_rate, group->highpass_cutoff, 0.f);
+	cd_acquire_reduced_coefficients(&context->coefficients, group->lowpass_reduced, 4, 0, context->sampling_rate, group->lowpass_cutoff, group->lowpass_resonance);
+	cd_acquire_reduced_coefficients(&context->coefficients, group->highpass_reduced, 4, 1, context->sampling_rate, group->highpass_cutoff, 0.f);
+
+	context->filter_groups[context->filter_group_count++] = group;
+	return group;
+}
+
+static void cd_release_filter_groups(cd_context_t* context)
+{
+	unsigned i = 0;
+	for (; i < context->filter_group_count; ++i)
+	{
+		cd_filter_group_t* group = context->filter_groups[i];
+		cd_release_coefficients(group->lowpass);
+		cd_release_coefficients(group->highpass);
+		cd_release_reduced_coefficients(group->lowpass_reduced);
+		cd_release_reduced_coefficients(group->highpass_reduced);
+		CUTE_DSP_FREE(group, 0);
+		context->filter_groups[i] = 0;
+	}
+	context->filter_group_count = 0;
+}
+
+cd_filter_group_t* cd_find_filter_group(cd_context_t* context, const char* name)
+{
+	unsigned i = 0;
+	CUTE_DSP_ASSERT(context && name);
+	for (; i < context->filter_group_count; ++i)
+		if (!strcmp(context->filter_groups[i]->name, name))
+			return context->filter_groups[i];
+	return NULL;
+}
+
+// while the lock of the cache is held, points a channel to an entry of the group
+static void cd_take_group_coefficients(cd_coefficients_t** coefficients, cd_coefficients_t* shared)
+{
+	if (*coefficients == shared)
+		return;
+	++shared->refs;
+	cd_drop_coefficients(shared->cache, *coefficients);
+	*coefficients = shared;
+}
+
+// every channel of a member is pointed to the lowpass of the group under one lock of the cache, including
+// the reduced rates it holds, so nothing is designed here
+static void cd_take_group_lowpass(cd_context_t* context, const cd_filter_group_t* group, const cs_playing_sound_t* sound)
+{
+	cd_lowpass_t* filter;
+	unsigned stage;
+	if (context->lowpass_id == CUTE_DSP_INVALID_PLUGIN_ID)
+		return;
+
+	cd_lock(&context->coefficients.lock);
+	for (filter = (cd_lowpass_t*)sound->plugin_udata[context->lowpass_id]; filter; filter = filter->next)
+	{
+		filter->freq_cutoff = group->lowpass_cutoff;
+		filter->resonance = group->lowpass_resonance;
+		cd_take_group_coefficients(&filter->coefficients, group->lowpass);
+		for (stage = 0; stage < CUTE_DSP_MULTIRATE_STAGES && filter->reduced[stage]; ++stage)
+			cd_take_group_coefficients(filter->reduced + stage, group->lowpass_reduced[stage]);
+	}
+	cd_unlock(&context->coefficients.lock);
+	cd_parameter_changed(context, sound, CD_CAPTURE_LOWPASS_CUTOFF, group->lowpass_cutoff);
+	cd_parameter_changed(context, sound, CD_CAPTURE_LOWPASS_RESONANCE, group->lowpass_resonance);
+}
+
+static void cd_take_group_highpass(cd_context_t* context, const cd_filter_group_t* group, const cs_playing_sound_t* sound)
+{
+	cd_highpass_t* filter;
+	unsigned stage;
+	if (context->highpass_id == CUTE_DSP_INVALID_PLUGIN_ID)
+		return;
+
+	cd_lock(&context->coefficients.lock);
+	for (filter = (cd_highpass_t*)sound->plugin_udata[context->highpass_id]; filter; filter = filter->next)
+	{
+		filter->freq_cutoff = group->highpass_cutoff;
+		cd_take_group_coefficients(&filter->coefficients, group->highpass);
+		for (stage = 0; stage < CUTE_DSP_MULTIRATE_STAGES && filter->reduced[stage]; ++stage)
+			cd_take_group_coefficients(filter->reduced + stage, group->highpass_reduced[stage]);
+	}
+	cd_unlock(&context->coefficients.lock);
+	cd_parameter_changed(context, sound, CD_CAPTURE_HIGHPASS_CUTOFF, group->highpass_cutoff);
+}
+
+void cd_join_filter_group(cs_playing_sound_t* playing_sound, cd_filter_group_t* group)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->voice_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	cd_voice_t* voice = (cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	voice->filter_group = group;
+	if (!group || voice->bus_return)
+		return;
+
+	// a new member takes whatever the group has set right away
+	if (group->lowpass_set)
+		cd_take_group_lowpass(ctx, group, playing_sound);
+	if (group->highpass_set)
+		cd_take_group_highpass(ctx, group, playing_sound);
+}
+
+cd_filter_group_t* cd_get_filter_group(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->voice_id != CUTE_DSP_INVALID_PLUGIN_ID);
+
+	const cd_voice_t* voice = (const cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	return voice->filter_group;
+}
+
+void cd_set_filter_group_lowpass(cd_filter_group_t* group, float cutoff_freq_in_hz, float resonance)
+{
+	cd_context_t* context;
+	const cd_voice_t* voice;
+	CUTE_DSP_ASSERT(group);
+	if (resonance < 0.f || resonance > 1.f
+		|| cutoff_freq_in_hz < CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF
+		|| cutoff_freq_in_hz > CUTE_DSP_DEFAULT_LOWPASS_CUTOFF)
+		return;
+
+	context = group->context;
+	cd_use_coefficients(&group->lowpass, 0, context->sampling_rate, cutoff_freq_in_hz, resonance, NULL);
+	cd_use_reduced_coefficients(group->lowpass_reduced, 0, context->sampling_rate, cutoff_freq_in_hz, resonance);
+	group->lowpass_cutoff = cutoff_freq_in_hz;
+	group->lowpass_resonance = resonance;
+	group->lowpass_set = 1;
+
+	// members are released on the mix thread, holding the voices keeps their filters alive meanwhile
+	cd_lock(&context->voice_lock);
+	for (voice = context->active_voices; voice; voice = voice->next_active)
+		if (voice->filter_group == group && !voice->bus_return)
+			cd_take_group_lowpass(context, group, voice->sound);
+	cd_unlock(&context->voice_lock);
+}
+
+void cd_set_filter_group_highpass(cd_filter_group_t* group, float cutoff_freq_in_hz)
+{
+	cd_context_t* context;
+	const cd_voice_t* voice;
+	CUTE_DSP_ASSERT(group);
+	if (cutoff_freq_in_hz < CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF
+		|| cutoff_freq_in_hz > CUTE_DSP_DEFAULT_LOWPASS_CUTOFF)
+		return;
+
+	context = group->context;
+	cd_use_coefficients(&group->highpass, 1, context->sampling_rate, cutoff_freq_in_hz, 0.f, NULL);
+	cd_use_reduced_coefficients(group->highpass_reduced, 1, context->sampling_rate, cutoff_freq_in_hz, 0.f);
+	group->highpass_cutoff = cutoff_freq_in_hz;
+	group->highpass_set = 1;
+
+	cd_lock(&context->voice_lock);
+	for (voice = context->active_voices; voice; voice = voice->next_active)
+		if (voice->filter_group == group && !voice->bus_return)
+			cd_take_group_highpass(context, group, voice->sound);
+	cd_unlock(&context->voice_lock);
+}
+
+float cd_get_filter_group_lowpass_cutoff(const cd_filter_group_t* group)
+{
+	CUTE_DSP_ASSERT(group);
+	return group->lowpass_cutoff;
+}
+
+float cd_get_filter_group_lowpass_resonance(const cd_filter_group_t* group)
+{
+	CUTE_DSP_ASSERT(group);
+	return group->lowpass_resonance;
+}
+
+float cd_get_filter_group_highpass_cutoff(const cd_filter_group_t* group)
+{
+	CUTE_DSP_ASSERT(group);
+	return group->highpass_cutoff;
+}
+
+/* END FILTER GROUP IMPLEMENTATION */
+
+/* BEGIN BATCH PARAMETER IMPLEMENTATION */
+// while the lock of the cache is held, last is the entry taken by the channel before, reused when the keys match
+static cd_coefficients_t* cd_rekey_coefficients(cd_coefficient_cache_t* cache, cd_coefficients_t** coefficients, cd_coefficients_t* last, int highpass, float sampling_rate, int cutoff_key, int resonance_key)
+{
+	cd_coefficients_t* previous = *coefficients;
+	cd_coefficients_t* entry;
+	if (previous->cutoff_key == cutoff_key && previous->resonance_key == resonance_key && previous->sampling_rate == sampling_rate)
+		return previous;
+
+	if (last && last->cutoff_key == cutoff_key && last->resonance_key == resonance_key && last->sampling_rate == sampling_rate)
+		entry = last;
+	else
+		entry = cd_find_coefficients(cache, highpass, sampling_rate, cutoff_key, resonance_key, NULL);
+	++entry->refs;
+	cd_drop_coefficients(cache, previous);
+	*coefficients = entry;
+	return entry;
+}
+
+// the reduced rate designs a channel holds, while the lock of the cache is held
+static void cd_rekey_reduced_coefficients(cd_coefficient_cache_t* cache, cd_coefficients_t** reduced, int highpass, float sampling_rate, float freq_in_hz, int resonance_key)
+{
+	unsigned stage = 0;
+	for (; stage < CUTE_DSP_MULTIRATE_STAGES && reduced[stage]; ++stage)
+		cd_rekey_coefficients(cache, reduced + stage, NULL, highpass, sampling_rate / (float)(2u << stage), cd_coefficient_cutoff_key(cd_reduced_cutoff(sampling_rate, stage, freq_in_hz)), resonance_key);
+}
+
+// the part of cd_parameter_changed done while the sound is loaded, the values are captured afterwards in one go
+static void cd_detach_cached_voice(cd_context_t* context, const cs_playing_sound_t* playing_sound)
+{
+	cd_voice_t* voice = (cd_voice_t*)playing_sound->plugin_udata[context->voice_id];
+	if (voice->cache)
+		voice->cache_detach = 1;
+}
+
+// NULL cutoffs or resonances keep those of the filters, the lock is let go between chunks so the mix thread never waits long
+static void cd_set_lowpass_batch(cd_context_t* context, cs_playing_sound_t** playing_sounds, const float* cutoffs, const float* resonances, int count)
+{
+	cd_coefficient_cache_t* cache = &context->coefficients;
+	int start = 0, i, end;
+	for (; start < count; start = end)
+	{
+		cd_coefficients_t* last = NULL;
+		end = start + CUTE_DSP_BATCH_SIZE < count ? start + CUTE_DSP_BATCH_SIZE : count;
+		cd_lock(&cache->lock);
+		for (i = start; i < end; ++i)
+		{
+			cd_lowpass_t* filter = (cd_lowpass_t*)playing_sounds[i]->plugin_udata[context->lowpass_id];
+			float freq_in_hz = cutoffs ? cutoffs[i] : filter->freq_cutoff;
+			float resonance = resonances ? resonances[i] : filter->resonance;
+			int cutoff_key, resonance_key;
+			cd_detach_cached_voice(context, playing_sounds[i]);
+			if (resonance < 0.f || resonance > 1.f
+				|| freq_in_hz < CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF
+				|| freq_in_hz > CUTE_DSP_DEFAULT_LOWPASS_CUTOFF)
+				continue;
+
+			cutoff_key = cd_coefficient_cutoff_key(freq_in_hz);
+			resonance_key = cd_coefficient_resonance_key(resonance);
+			for (; filter; filter = filter->next)
+			{
+				filter->freq_cutoff = freq_in_hz;
+				filter->resonance = resonance;
+				last = cd_rekey_coefficients(cache, &filter->coefficients, last, 0, filter->sampling_rate, cutoff_key, resonance_key);
+				cd_rekey_reduced_coefficients(cache, filter->reduced, 0, filter->sampling_rate, freq_in_hz, resonance_key);
+			}
+		}
+		cd_unlock(&cache->lock);
+	}
+}
+
+void cd_set_lowpass_cutoffs(cs_playing_sound_t** playing_sounds, const float* cutoffs_in_hz, int count)
+{
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && cutoffs_in_hz));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_set_lowpass_batch(ctx, playing_sounds, cutoffs_in_hz, NULL, count);
+	if (ctx->capture.file)
+		cd_capture_parameters(ctx, playing_sounds, CD_CAPTURE_LOWPASS_CUTOFF, cutoffs_in_hz, count);
+}
+
+void cd_set_lowpass_resonances(cs_playing_sound_t** playing_sounds, const float* resonances, int count)
+{
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && resonances));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_set_lowpass_batch(ctx, playing_sounds, NULL, resonances, count);
+	if (ctx->capture.file)
+		cd_capture_parameters(ctx, playing_sounds, CD_CAPTURE_LOWPASS_RESONANCE, resonances, count);
+}
+
+void cd_set_highpass_cutoffs(cs_playing_sound_t** playing_sounds, const float* cutoffs_in_hz, int count)
+{
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && cutoffs_in_hz));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_coefficient_cache_t* cache = &ctx->coefficients;
+	int start = 0, i, end;
+	for (; start < count; start = end)
+	{
+		cd_coefficients_t* last = NULL;
+		end = start + CUTE_DSP_BATCH_SIZE < count ? start + CUTE_DSP_BATCH_SIZE : count;
+		cd_lock(&cache->lock);
+		for (i = start; i < end; ++i)
+		{
+			cd_highpass_t* filter = (cd_highpass_t*)playing_sounds[i]->plugin_udata[ctx->highpass_id];
+			int cutoff_key = cd_coefficient_cutoff_key(cutoffs_in_hz[i]);
+			cd_detach_cached_voice(ctx, playing_sounds[i]);
+			for (; filter; filter = filter->next)
+			{
+				filter->freq_cutoff = cutoffs_in_hz[i];
+				last = cd_rekey_coefficients(cache, &filter->coefficients, last, 1, filter->sampling_rate, cutoff_key, 0);
+				cd_rekey_reduced_coefficients(cache, filter->reduced, 1, filter->sampling_rate, cutoffs_in_hz[i], 0);
+			}
+		}
+		cd_unlock(&cache->lock);
+	}
+	if (ctx->capture.file)
+		cd_capture_parameters(ctx, playing_sounds, CD_CAPTURE_HIGHPASS_CUTOFF, cutoffs_in_hz, count);
+}
+
+void cd_set_echo_delays(cs_playing_sound_t** playing_sounds, const float* delays, int count)
+{
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && delays));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	int i = 0;
+	for (; i < count; ++i)
+	{
+		cd_apply_echo_delay(ctx, (cd_echo_t*)playing_sounds[i]->plugin_udata[ctx->echo_id], delays[i]);
+		cd_detach_cached_voice(ctx, playing_sounds[i]);
+	}
+	if (ctx->capture.file)
+		cd_capture_parameters(ctx, playing_sounds, CD_CAPTURE_ECHO_DELAY, delays, count);
+}
+
+void cd_set_echo_mixes(cs_playing_sound_t** playing_sounds, const float* mixes, int count)
+{
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && mixes));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	int i = 0;
+	for (; i < count; ++i)
+	{
+		cd_apply_echo_mix((cd_echo_t*)playing_sounds[i]->plugin_udata[ctx->echo_id], mixes[i]);
+		cd_detach_cached_voice(ctx, playing_sounds[i]);
+	}
+	if (ctx->capture.file)
+		cd_capture_parameters(ctx, playing_sounds, CD_CAPTURE_ECHO_MIX, mixes, count);
+}
+
+void cd_set_echo_feedbacks(cs_playing_sound_t** playing_sounds, const float* feedbacks, int count)
+{
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && feedbacks));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	int i = 0;
+	for (; i < count; ++i)
+	{
+		cd_apply_echo_feedback((cd_echo_t*)playing_sounds[i]->plugin_udata[ctx->echo_id], feedbacks[i]);
+		cd_detach_cached_voice(ctx, playing_sounds[i]);
+	}
+	if (ctx->capture.file)
+		cd_capture_parameters(ctx, playing_sounds, CD_CAPTURE_ECHO_FEEDBACK, feedbacks, count);
+}
+
+// the gains of a chunk are converted in a loop of their own, free of the loads of the voices
+void cd_set_noise_amplitudes_db(cs_playing_sound_t** playing_sounds, const float* dbs, int count)
+{
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && dbs));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	float gains[CUTE_DSP_BATCH_SIZE];
+	int start = 0, i, end;
+	for (; start < count; start = end)
+	{
+		end = start + CUTE_DSP_BATCH_SIZE < count ? start + CUTE_DSP_BATCH_SIZE : count;
+		i = start;
+#if defined(CUTE_DSP_DB_TO_GAIN_PS)
+		for (; i + 4 <= end; i += 4)
+			_mm_storeu_ps(gains + i - start, CUTE_DSP_DB_TO_GAIN_PS(_mm_loadu_ps(dbs + i)));
+#endif
+		for (; i < end; ++i)
+			gains[i - start] = CUTE_DSP_DB_TO_GAIN(dbs[i]);
+		for (i = start; i < end; ++i)
+		{
+			cd_noise_t* filter = (cd_noise_t*)playing_sounds[i]->plugin_udata[ctx->noise_id];
+			for (; filter; filter = filter->next)
+			{
+				filter->amplitude_db = dbs[i];
+				filter->amplitude_gain = gains[i - start];
+			}
+			cd_detach_cached_voice(ctx, playing_sounds[i]);
+		}
+	}
+	if (ctx->capture.file)
+		cd_capture_parameters(ctx, playing_sounds, CD_CAPTURE_NOISE_DB, dbs, count);
+}
 
-	// optional filter default parameters
-	float echo_max_delay_s;
-	cd_random_t random_generator;
+void cd_get_lowpass_cutoffs(cs_playing_sound_t** playing_sounds, float* cutoffs_in_hz, int count)
+{
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && cutoffs_in_hz));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	int i = 0;
+	for (; i < count; ++i)
+		cutoffs_in_hz[i] = ((const cd_lowpass_t*)playing_sounds[i]->plugin_udata[ctx->lowpass_id])->freq_cutoff;
+}
 
-} cd_context_t;
+void cd_get_lowpass_resonances(cs_playing_sound_t** playing_sounds, float* resonances, int count)
+{
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && resonances));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	int i = 0;
+	for (; i < count; ++i)
+		resonances[i] = ((const cd_lowpass_t*)playing_sounds[i]->plugin_udata[ctx->lowpass_id])->resonance;
+}
 
-static cd_context_t* g_dsp_context = 0;
+void cd_get_highpass_cutoffs(cs_playing_sound_t** playing_sounds, float* cutoffs_in_hz, int count)
+{
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && cutoffs_in_hz));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	int i = 0;
+	for (; i < count; ++i)
+		cutoffs_in_hz[i] = ((const cd_highpass_t*)playing_sounds[i]->plugin_udata[ctx->highpass_id])->freq_cutoff;
+}
 
-typedef struct cd_lowpass_t
+void cd_get_echo_delays(cs_playing_sound_t** playing_sounds, float* delays, int count)
 {
-	struct cd_lowpass_t* next;
-	float freq_cutoff;
-	float sampling_rate;
-	float resonance;
-	float y1;
-	float y2;
-	float x_coeff;
-	float y1_coeff;
-	float y2_coeff;
-} cd_lowpass_t;
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && delays));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	int i = 0;
+	for (; i < count; ++i)
+	{
+		const cd_echo_t* filter = (const cd_echo_t*)playing_sounds[i]->plugin_udata[ctx->echo_id];
+		delays[i] = filter->offset / filter->sampling_rate;
+	}
+}
 
-typedef struct cd_highpass_t
+void cd_get_echo_mixes(cs_playing_sound_t** playing_sounds, float* mixes, int count)
 {
-	struct cd_highpass_t* next;
-	float freq_cutoff;
-	float sampling_rate;
-	float y1;
-	float y2;
-	float x1;
-	float x2;
-	float x_coeff;
-	float x1_coeff;
-	float y1_coeff;
-	float y2_coeff;
-} cd_highpass_t;
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && mixes));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	int i = 0;
+	for (; i < count; ++i)
+		mixes[i] = ((const cd_echo_t*)playing_sounds[i]->plugin_udata[ctx->echo_id])->mix;
+}
 
-typedef struct cd_echo_t
+void cd_get_echo_feedbacks(cs_playing_sound_t** playing_sounds, float* feedbacks, int count)
 {
-	struct cd_echo_t* next;
-	cd_ring_buffer_t xvalues;
-	cd_ring_buffer_t yvalues;
-	float mix;
-	float feedback;
-	float offset;
-	float sampling_rate;
-	float max_samples;
-} cd_echo_t;
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && feedbacks));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	int i = 0;
+	for (; i < count; ++i)
+		feedbacks[i] = ((const cd_echo_t*)playing_sounds[i]->plugin_udata[ctx->echo_id])->feedback;
+}
 
-typedef struct cd_noise_t
+void cd_get_noise_amplitudes_db(cs_playing_sound_t** playing_sounds, float* dbs, int count)
 {
-	struct cd_noise_t* next;
-	float amplitude_db;
-	float amplitude_gain;
-} cd_noise_t;
+	CUTE_DSP_ASSERT(count <= 0 || (playing_sounds && dbs));
+	cd_context_t* ctx = cd_get_context();
+	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	int i = 0;
+	for (; i < count; ++i)
+		dbs[i] = ((const cd_noise_t*)playing_sounds[i]->plugin_udata[ctx->noise_id])->amplitude_db;
+}
+/* END BATCH PARAMETER IMPLEMENTATION */
 
-/* END OPAQUE STRUCT IMPLEMENTATION */
-/* BEGIN FUNCTION IMPLEMENTATION */
+/* BEGIN RANDOMIZATION IMPLEMENTATION */
+enum
+{
+	CD_PICK_LOWPASS_CUTOFF,
+	CD_PICK_LOWPASS_RESONANCE,
+	CD_PICK_HIGHPASS_CUTOFF,
+	CD_PICK_ECHO_DELAY,
+	CD_PICK_NOISE_DB,
+};
+
+// value k of steps evenly spaced values of a range
+#define cd_randomization_step(range, k, steps) ((steps) > 1 ? (range)[0] + ((range)[1] - (range)[0]) * (float)(k) / (float)((steps) - 1) : (range)[0])
+#define cd_randomization_octave_step(range, k, steps) ((steps) > 1 ? (range)[0] * powf((range)[1] / (range)[0], (float)(k) / (float)((steps) - 1)) : (range)[0])
+
+// the filter and the filters chained after it, a design of another rate is made again at the rate of the filter
+static void cd_load_lowpass_design(cd_lowpass_t* filter, const cd_filter_design_t* design, float sampling_rate)
+{
+	for (; filter; filter = filter->next)
+	{
+		filter->freq_cutoff = design->freq_cutoff;
+		filter->resonance = design->resonance;
+		cd_use_coefficients(&filter->coefficients, 0, filter->sampling_rate, design->freq_cutoff, design->resonance, filter->sampling_rate == sampling_rate ? design : NULL);
+		cd_use_reduced_coefficients(filter->reduced, 0, filter->sampling_rate, design->freq_cutoff, design->resonance);
+	}
+}
 
-/* BEGIN PLUGIN INTERFACE IMPLEMENTATION */
-static cd_context_t* cd_get_context(void);
+static void cd_load_highpass_design(cd_highpass_t* filter, const cd_filter_design_t* design, float sampling_rate)
+{
+	for (; filter; filter = filter->next)
+	{
+		filter->freq_cutoff = design->freq_cutoff;
+		cd_use_coefficients(&filter->coefficients, 1, filter->sampling_rate, design->freq_cutoff, 0.f, filter->sampling_rate == sampling_rate ? design : NULL);
+		cd_use_reduced_coefficients(filter->reduced, 1, filter->sampling_rate, design->freq_cutoff, 0.f);
+	}
+}
 
-static void cd_lowpass_on_make_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void** playing_sound_udata, const cs_playing_sound_t* sound)
+static void cd_make_lowpass_designs(cd_context_t* context, cd_randomization_table_t* table)
 {
-	cd_context_t* ctx = (cd_context_t*)plugin_instance;
-	switch(sound->loaded_sound->channel_count)
+	const cd_randomization_t* def = &table->def;
+	float cutoffs[2] = { CUTE_DSP_DEFAULT_LOWPASS_CUTOFF, CUTE_DSP_DEFAULT_LOWPASS_CUTOFF };
+	float resonances[2] = { 0.f, 0.f };
+	const cd_coefficient_cache_t* cache = &context->coefficients;
+	unsigned c, r;
+
+	// designed as the coefficient cache would, so a voice loading a step finds or makes the same entry
+	table->cutoff_steps = (def->flags & CD_RANDOMIZE_LOWPASS_CUTOFF) ? CUTE_DSP_RANDOMIZATION_STEPS : 1;
+	table->resonance_steps = (def->flags & CD_RANDOMIZE_LOWPASS_RESONANCE) ? CUTE_DSP_RESONANCE_STEPS : 1;
+	if (def->flags & CD_RANDOMIZE_LOWPASS_CUTOFF)
+		memcpy(cutoffs, def->lowpass_cutoff, sizeof(cutoffs));
+	if (def->flags & CD_RANDOMIZE_LOWPASS_RESONANCE)
+		memcpy(resonances, def->lowpass_resonance, sizeof(resonances));
+	table->lowpass = (cd_filter_design_t*)CUTE_DSP_ALLOC(sizeof(cd_filter_design_t) * table->cutoff_steps * table->resonance_steps, 0);
+	CUTE_DSP_ASSERT(table->lowpass);
+
+	for (r = 0; r < table->resonance_steps; ++r)
 	{
-		case 1:
-		{
-			cd_lowpass_t* lowpass = cd_make_lowpass_filter(ctx);
-			*playing_sound_udata = lowpass;
-			break;
-		}
-		case 2:
+		for (c = 0; c < table->cutoff_steps; ++c)
 		{
-			cd_lowpass_t* lowpass = cd_make_lowpass_filter(ctx);
-			*playing_sound_udata = lowpass;
-			lowpass->next = cd_make_lowpass_filter(ctx);
-			break;
+			int cutoff_key = cd_coefficient_cutoff_key(cd_randomization_octave_step(cutoffs, c, table->cutoff_steps));
+			int resonance_key = cd_coefficient_resonance_key(cd_randomization_step(resonances, r, table->resonance_steps));
+			cd_design_filter(table->lowpass + r * table->cutoff_steps + c, 0, cache->order, cache->alignment, context->sampling_rate, cutoff_key, resonance_key);
 		}
 	}
-
-	// unused parameters
-	(void)cs_ctx;
-	(void)sound;
 }
 
-static void cd_lowpass_on_free_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void* playing_sound_udata, const cs_playing_sound_t* sound)
+static void cd_make_highpass_designs(cd_context_t* context, cd_randomization_table_t* table)
 {
-	cd_context_t* ctx = (cd_context_t*)plugin_instance;
-	cd_lowpass_t* filter = (cd_lowpass_t*)playing_sound_udata;
-	if(filter->next)
+	const cd_coefficient_cache_t* cache = &context->coefficients;
+	unsigned c;
+
+	table->highpass = (cd_filter_design_t*)CUTE_DSP_ALLOC(sizeof(cd_filter_design_t) * CUTE_DSP_RANDOMIZATION_STEPS, 0);
+	CUTE_DSP_ASSERT(table->highpass);
+
+	for (c = 0; c < CUTE_DSP_RANDOMIZATION_STEPS; ++c)
 	{
-		cd_release_lowpass(ctx, &(filter->next));
+		int cutoff_key = cd_coefficient_cutoff_key(cd_randomization_octave_step(table->def.highpass_cutoff, c, CUTE_DSP_RANDOMIZATION_STEPS));
+		cd_design_filter(table->highpass + c, 1, cache->order, cache->alignment, context->sampling_rate, cutoff_key, 0);
 	}
-	cd_release_lowpass(ctx, &filter);
+}
 
-	// unused parameters
-	(void)cs_ctx;
-	(void)sound;
+static void cd_release_randomization_table(cd_randomization_table_t* table)
+{
+	if (table->lowpass)
+		CUTE_DSP_FREE(table->lowpass, 0);
+	if (table->highpass)
+		CUTE_DSP_FREE(table->highpass, 0);
+	CUTE_DSP_FREE(table, 0);
 }
 
-static void cd_lowpass_on_mix(cs_context_t* cs_ctx, void* plugin_instance, int channel_index, const float* samples_in, int sample_count, float** samples_out, void* playing_sound_udata, const cs_playing_sound_t* sound)
+static unsigned cd_find_randomization_index(const cd_context_t* context, const cs_loaded_sound_t* sound)
 {
-	cd_lowpass_t* filter = 0;
-	cd_context_t* context = (cd_context_t*)plugin_instance;
-	switch(channel_index)
-	{
-	case 0:
-		filter = (cd_lowpass_t*)playing_sound_udata;
-		break;
-	case 1:
-		filter = (cd_lowpass_t*)playing_sound_udata;
-		filter = filter->next;
-		break;
-	}
-	cd_sample_lowpass(context, filter, samples_in, samples_out, (unsigned)sample_count);
+	unsigned i = 0;
+	for (; i < context->randomization_count; ++i)
+		if (context->randomizations[i]->sound == sound)
+			break;
+	return i;
+}
 
-	// unused parameters
-	(void)cs_ctx;
-	(void)sound;
+int cd_set_randomization(cd_context_t* context, const cs_loaded_sound_t* sound, const cd_randomization_t* randomization)
+{
+	cd_randomization_table_t* table;
+	unsigned i, k;
+	CUTE_DSP_ASSERT(context && randomization);
+	CUTE_DSP_ASSERT(!(randomization->flags & CD_RANDOMIZE_LOWPASS_CUTOFF) || (randomization->lowpass_cutoff[0] >= CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF && randomization->lowpass_cutoff[1] <= CUTE_DSP_DEFAULT_LOWPASS_CUTOFF));
+	CUTE_DSP_ASSERT(!(randomization->flags & CD_RANDOMIZE_LOWPASS_RESONANCE) || (randomization->lowpass_resonance[0] >= 0.f && randomization->lowpass_resonance[1] <= 1.f));
+	CUTE_DSP_ASSERT(!(randomization->flags & CD_RANDOMIZE_HIGHPASS_CUTOFF) || (randomization->highpass_cutoff[0] >= CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF && randomization->highpass_cutoff[1] <= CUTE_DSP_DEFAULT_LOWPASS_CUTOFF));
+	CUTE_DSP_ASSERT(!(randomization->flags & CD_RANDOMIZE_ECHO_DELAY) || (randomization->echo_delay[0] >= 0.f && randomization->echo_delay[1] <= context->echo_max_delay_s));
+
+	i = cd_find_randomization_index(context, sound);
+	if (i == context->randomization_count && i == CUTE_DSP_MAX_RANDOMIZATIONS)
+		return 0;
+
+	table = (cd_randomization_table_t*)CUTE_DSP_ALLOC(sizeof(cd_randomization_table_t), 0);
+	CUTE_DSP_ASSERT(table);
+	memset(table, 0, sizeof(cd_randomization_table_t));
+	table->sound = sound;
+	table->def = *randomization;
+	if (context->def.use_lowpass && (randomization->flags & (CD_RANDOMIZE_LOWPASS_CUTOFF | CD_RANDOMIZE_LOWPASS_RESONANCE)))
+		cd_make_lowpass_designs(context, table);
+	if (context->def.use_highpass && (randomization->flags & CD_RANDOMIZE_HIGHPASS_CUTOFF))
+		cd_make_highpass_designs(context, table);
+	if (randomization->flags & CD_RANDOMIZE_NOISE_DB)
+		for (k = 0; k < CUTE_DSP_RANDOMIZATION_STEPS; ++k)
+			table->noise_gains[k] = CUTE_DSP_DB_TO_GAIN(cd_randomization_step(randomization->noise_db, k, CUTE_DSP_RANDOMIZATION_STEPS));
+
+	if (i < context->randomization_count)
+		cd_release_randomization_table(context->randomizations[i]);
+	else
+		++context->randomization_count;
+	context->randomizations[i] = table;
+	return 1;
 }
 
-cs_plugin_interface_t cd_make_lowpass_plugin(void)
+void cd_clear_randomization(cd_context_t* context, const cs_loaded_sound_t* sound)
 {
-	cs_plugin_interface_t plugin;
-	plugin.plugin_instance = cd_get_context();
-	plugin.on_make_playing_sound_fn = cd_lowpass_on_make_playing_sound;
-	plugin.on_free_playing_sound_fn = cd_lowpass_on_free_playing_sound;
-	plugin.on_mix_fn = cd_lowpass_on_mix;
+	unsigned i;
+	CUTE_DSP_ASSERT(context);
+	i = cd_find_randomization_index(context, sound);
+	if (i == context->randomization_count)
+		return;
+	cd_release_randomization_table(context->randomizations[i]);
+	context->randomizations[i] = context->randomizations[--context->randomization_count];
+}
 
-	return plugin;
+static void cd_release_randomizations(cd_context_t* context)
+{
+	unsigned i = 0;
+	for (; i < context->randomization_count; ++i)
+		cd_release_randomization_table(context->randomizations[i]);
+	context->randomization_count = 0;
 }
 
-static void cd_highpass_on_make_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void** playing_sound_udata, const cs_playing_sound_t* sound)
+static const cd_randomization_table_t* cd_find_randomization(const cd_context_t* context, const cs_loaded_sound_t* sound)
 {
-	cd_context_t* ctx = (cd_context_t*)plugin_instance;
-	switch(sound->loaded_sound->channel_count)
-	{
-		case 1:
-		{
-			cd_highpass_t* filter = cd_make_highpass_filter(ctx);
-			*playing_sound_udata = filter;
-			break;
-		}
-		case 2:
-		{
-			cd_highpass_t* filter = cd_make_highpass_filter(ctx);
-			*playing_sound_udata = filter;
-			filter->next = cd_make_highpass_filter(ctx);
-			break;
-		}
-	}
+	unsigned i = cd_find_randomization_index(context, sound);
+	if (i == context->randomization_count)
+		i = cd_find_randomization_index(context, NULL);
+	return i < context->randomization_count ? context->randomizations[i] : NULL;
 }
 
-static void cd_highpass_on_free_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void* playing_sound_udata, const cs_playing_sound_t* sound)
+// the voice plugin runs first, so the voice already knows its ranges when the filters are made
+static const cd_voice_t* cd_randomized_voice(const cd_context_t* context, const cs_playing_sound_t* sound)
 {
-	cd_context_t* ctx = (cd_context_t*)plugin_instance;
-	cd_highpass_t* filter = (cd_highpass_t*)playing_sound_udata;
-	if(filter->next)
-	{
-		cd_release_highpass(ctx, &(filter->next));
-	}
-	cd_release_highpass(ctx, &filter);
+	const cd_voice_t* voice = (const cd_voice_t*)sound->plugin_udata[context->voice_id];
+	return voice->randomization ? voice : NULL;
 }
 
-static void cd_highpass_on_mix(cs_context_t* cs_ctx, void* plugin_instance, int channel_index, const float* samples_in, int sample_count, float** samples_out, void* playing_sound_udata, const cs_playing_sound_t* sound)
+static void cd_randomize_lowpass(cd_context_t* context, const cs_playing_sound_t* sound, cd_lowpass_t* filter)
 {
-	cd_highpass_t* filter = 0;
-	cd_context_t* context = (cd_context_t*)plugin_instance;
+	const cd_voice_t* voice = cd_randomized_voice(context, sound);
+	const cd_randomization_table_t* table = voice ? voice->randomization : NULL;
+	const cd_filter_design_t* design;
+	if (!table || !table->lowpass)
+		return;
 
-	switch(channel_index)
+	design = table->lowpass + cd_random_pick(voice->random_key, CD_PICK_LOWPASS_RESONANCE, table->resonance_steps) * table->cutoff_steps
+		+ cd_random_pick(voice->random_key, CD_PICK_LOWPASS_CUTOFF, table->cutoff_steps);
+	cd_load_lowpass_design(filter, design, context->sampling_rate);
+	cd_capture_parameter(context, sound, CD_CAPTURE_LOWPASS_CUTOFF, design->freq_cutoff);
+	cd_capture_parameter(context, sound, CD_CAPTURE_LOWPASS_RESONANCE, design->resonance);
+}
+
+static void cd_randomize_highpass(cd_context_t* context, const cs_playing_sound_t* sound, cd_highpass_t* filter)
+{
+	const cd_voice_t* voice = cd_randomized_voice(context, sound);
+	const cd_randomization_table_t* table = voice ? voice->randomization : NULL;
+	const cd_filter_design_t* design;
+	if (!table || !table->highpass)
+		return;
+
+	design = table->highpass + cd_random_pick(voice->random_key, CD_PICK_HIGHPASS_CUTOFF, CUTE_DSP_RANDOMIZATION_STEPS);
+	cd_load_highpass_design(filter, design, context->sampling_rate);
+	cd_capture_parameter(context, sound, CD_CAPTURE_HIGHPASS_CUTOFF, design->freq_cutoff);
+}
+
+static void cd_randomize_echo(cd_context_t* context, const cs_playing_sound_t* sound, cd_echo_t* filter)
+{
+	const cd_voice_t* voice = cd_randomized_voice(context, sound);
+	const float* range;
+	float t;
+	if (!voice || !(voice->randomization->def.flags & CD_RANDOMIZE_ECHO_DELAY))
+		return;
+
+	// the delay costs no trig, so it is picked from the whole range
+	range = voice->randomization->def.echo_delay;
+	t = range[0] + (range[1] - range[0]) * (float)(cd_random_hash(voice->random_key, CD_PICK_ECHO_DELAY) >> 8) * (1.f / 16777216.f);
+	cd_apply_echo_delay(context, filter, t);
+	cd_capture_parameter(context, sound, CD_CAPTURE_ECHO_DELAY, t);
+}
+
+static void cd_randomize_noise(cd_context_t* context, const cs_playing_sound_t* sound, cd_noise_t* filter)
+{
+	const cd_voice_t* voice = cd_randomized_voice(context, sound);
+	unsigned k;
+	float db;
+	if (!voice || !(voice->randomization->def.flags & CD_RANDOMIZE_NOISE_DB))
+		return;
+
+	k = cd_random_pick(voice->random_key, CD_PICK_NOISE_DB, CUTE_DSP_RANDOMIZATION_STEPS);
+	db = cd_randomization_step(voice->randomization->def.noise_db, k, CUTE_DSP_RANDOMIZATION_STEPS);
+	for (; filter; filter = filter->next)
 	{
-	case 0:
-		filter = (cd_highpass_t*)playing_sound_udata;
-		break;
-	case 1:
-		filter = (cd_highpass_t*)playing_sound_udata;
-		filter = filter->next;
-		break;
+		filter->amplitude_db = db;
+		filter->amplitude_gain = voice->randomization->noise_gains[k];
 	}
-	cd_sample_highpass(context, filter, samples_in, samples_out, (unsigned)sample_count);
+	cd_capture_parameter(context, sound, CD_CAPTURE_NOISE_DB, db);
 }
+/* END RANDOMIZATION IMPLEMENTATION */
 
-cs_plugin_interface_t cd_make_highpass_plugin()
-{
-	cs_plugin_interface_t plugin;
-	plugin.plugin_instance = cd_get_context();
-	plugin.on_make_playing_sound_fn = cd_highpass_on_make_playing_sound;
-	plugin.on_free_playing_sound_fn = cd_highpass_on_free_playing_sound;
-	plugin.on_mix_fn = cd_highpass_on_mix;
+/* BEGIN PRESET BANK IMPLEMENTATION */
+/*
+	Preset bank files are native endian, like captures, and are laid out so every part can be used in place:
+		header		"CDPB", then as u32: version, preset count, sampling rate count, cascade order,
+				filter alignment, sizeof(cd_filter_design_t), CUTE_DSP_MAX_PRESET_NAME
+		rates		f32 per sampling rate
+		presets		cd_preset_record_t per preset, sorted by name
+		designs		cd_filter_design_t per rate, per preset, lowpass then highpass
+	The cascade order is 0 for the single section Butterworth filters, see cd_biquad_cascade_order.
+*/
+#define CUTE_DSP_PRESET_BANK_VERSION (1)
+#define CUTE_DSP_PRESET_BANK_HEADER_SIZE (32)
 
-	return plugin;
+static int cd_compare_preset_names(const cd_preset_t* a, const cd_preset_t* b)
+{
+	return strcmp(a->name, b->name);
 }
 
-static void cd_echo_on_make_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void** playing_sound_udata, const cs_playing_sound_t* sound)
+int cd_write_preset_bank(const char* path, cd_preset_bank_def_t def)
 {
-	cd_context_t* ctx = (cd_context_t*)plugin_instance;
-	switch (sound->loaded_sound->channel_count)
+	unsigned header[CUTE_DSP_PRESET_BANK_HEADER_SIZE / 4];
+	const cd_preset_t** sorted;
+	cd_filter_design_t designs[2];
+	FILE* file;
+	unsigned i, j, r;
+	int order = cd_biquad_cascade_order(def.filter_order, def.filter_alignment);
+
+	CUTE_DSP_ASSERT(path && def.presets && def.sampling_rates && def.sampling_rate_count);
+	sorted = (const cd_preset_t**)CUTE_DSP_ALLOC(sizeof(cd_preset_t*) * (def.preset_count + 1), 0);
+	CUTE_DSP_ASSERT(sorted);
+
+	// insertion sort, banks are baked offline and hold hundreds of presets at most
+	for (i = 0; i < def.preset_count; ++i)
 	{
-	case 1:
+		const cd_preset_t* preset = def.presets + i;
+		CUTE_DSP_ASSERT(preset->name && strlen(preset->name) < CUTE_DSP_MAX_PRESET_NAME);
+		CUTE_DSP_ASSERT(preset->lowpass_resonance >= 0.f && preset->lowpass_resonance <= 1.f);
+		CUTE_DSP_ASSERT(preset->lowpass_cutoff >= CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF && preset->lowpass_cutoff <= CUTE_DSP_DEFAULT_LOWPASS_CUTOFF);
+		for (j = i; j > 0 && cd_compare_preset_names(sorted[j - 1], preset) > 0; --j)
+			sorted[j] = sorted[j - 1];
+		sorted[j] = preset;
+	}
+	for (i = 1; i < def.preset_count; ++i)
 	{
-		cd_echo_t* echo = cd_make_echo_filter(ctx);
-		*playing_sound_udata = echo;
-		break;
+		if (!cd_compare_preset_names(sorted[i - 1], sorted[i]))
+		{
+			CUTE_DSP_FREE(sorted, 0);
+			return 0;
+		}
 	}
-	case 2:
+
+	file = fopen(path, "wb");
+	if (!file)
 	{
-		cd_echo_t* echo = cd_make_echo_filter(ctx);
-		*playing_sound_udata = echo;
-		echo->next = cd_make_echo_filter(ctx);
-		break;
+		CUTE_DSP_FREE(sorted, 0);
+		return 0;
+	}
+
+	memcpy(header, "CDPB", 4);
+	header[1] = CUTE_DSP_PRESET_BANK_VERSION;
+	header[2] = def.preset_count;
+	header[3] = def.sampling_rate_count;
+	header[4] = (unsigned)order;
+	header[5] = (unsigned)def.filter_alignment;
+	header[6] = (unsigned)sizeof(cd_filter_design_t);
+	header[7] = CUTE_DSP_MAX_PRESET_NAME;
+	fwrite(header, 1, sizeof(header), file);
+	fwrite(def.sampling_rates, sizeof(float), def.sampling_rate_count, file);
+
+	for (i = 0; i < def.preset_count; ++i)
+	{
+		const cd_preset_t* preset = sorted[i];
+		cd_preset_record_t record;
+		memset(&record, 0, sizeof(record));
+		memcpy(record.name, preset->name, strlen(preset->name));
+		record.lowpass_cutoff = preset->lowpass_cutoff;
+		record.lowpass_resonance = preset->lowpass_resonance;
+		record.highpass_cutoff = preset->highpass_cutoff;
+		record.echo_delay = preset->echo_delay;
+		record.echo_mix = preset->echo_mix;
+		record.echo_feedback = preset->echo_feedback;
+		record.noise_db = preset->noise_db;
+		record.noise_gain = CUTE_DSP_DB_TO_GAIN(preset->noise_db);
+		fwrite(&record, 1, sizeof(record), file);
 	}
+
+	// designed as the coefficient cache would, so applying a preset matches setting its parameters
+	for (r = 0; r < def.sampling_rate_count; ++r)
+	{
+		for (i = 0; i < def.preset_count; ++i)
+		{
+			cd_design_filter(designs + 0, 0, order, def.filter_alignment, def.sampling_rates[r],
+				cd_coefficient_cutoff_key(sorted[i]->lowpass_cutoff), cd_coefficient_resonance_key(sorted[i]->lowpass_resonance));
+			cd_design_filter(designs + 1, 1, order, def.filter_alignment, def.sampling_rates[r], cd_coefficient_cutoff_key(sorted[i]->highpass_cutoff), 0);
+			fwrite(designs, 1, sizeof(designs), file);
+		}
 	}
 
-	// unused parameters
-	(void)cs_ctx;
-	(void)sound;
+	CUTE_DSP_FREE(sorted, 0);
+	return !fclose(file);
 }
 
-static void cd_echo_on_free_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void* playing_sound_udata, const cs_playing_sound_t* sound)
+cd_preset_bank_t* cd_open_preset_bank(const cd_context_t* context, const void* data, size_t size)
 {
-	cd_context_t* ctx = (cd_context_t*)plugin_instance;
-	cd_echo_t* filter = (cd_echo_t*)playing_sound_udata;
-	if (filter->next)
-	{
-		cd_release_echo_filter(ctx, &(filter->next));
-	}
-	cd_release_echo_filter(ctx, &filter);
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned header[CUTE_DSP_PRESET_BANK_HEADER_SIZE / 4];
+	const float* rates;
+	cd_preset_bank_t* bank;
+	size_t designs_offset, rate_size;
+	unsigned r;
+
+	CUTE_DSP_ASSERT(context && data);
+	if (size < CUTE_DSP_PRESET_BANK_HEADER_SIZE)
+		return NULL;
+	memcpy(header, bytes, sizeof(header));
+	if (memcmp(header, "CDPB", 4) || header[1] != CUTE_DSP_PRESET_BANK_VERSION
+		|| header[6] != sizeof(cd_filter_design_t) || header[7] != CUTE_DSP_MAX_PRESET_NAME)
+		return NULL;
+	if (header[4] != (unsigned)cd_biquad_cascade_order(context->def.filter_order, context->def.filter_alignment)
+		|| header[5] != (unsigned)context->def.filter_alignment)
+		return NULL;
+
+	rate_size = sizeof(cd_filter_design_t) * 2 * header[2];
+	designs_offset = CUTE_DSP_PRESET_BANK_HEADER_SIZE + sizeof(float) * header[3] + sizeof(cd_preset_record_t) * header[2];
+	if (size < designs_offset + rate_size * header[3])
+		return NULL;
+
+	rates = (const float*)(bytes + CUTE_DSP_PRESET_BANK_HEADER_SIZE);
+	for (r = 0; r < header[3]; ++r)
+		if (rates[r] == context->sampling_rate)
+			break;
+	if (r == header[3])
+		return NULL;
+
+	bank = (cd_preset_bank_t*)CUTE_DSP_ALLOC(sizeof(cd_preset_bank_t), 0);
+	CUTE_DSP_ASSERT(bank);
+	bank->presets = (const cd_preset_record_t*)(rates + header[3]);
+	bank->designs = (const cd_filter_design_t*)(bytes + designs_offset + rate_size * r);
+	bank->preset_count = header[2];
+	bank->sampling_rate = context->sampling_rate;
+	return bank;
+}
 
-	// unused parameters
-	(void)cs_ctx;
-	(void)sound;
+void cd_close_preset_bank(cd_preset_bank_t** bank)
+{
+	CUTE_DSP_ASSERT(bank && *bank);
+	CUTE_DSP_FREE(*bank, 0);
+	*bank = NULL;
 }
 
-static void cd_echo_on_mix(cs_context_t* cs_ctx, void* plugin_instance, int channel_index, const float* samples_in, int sample_count, float** samples_out, void* playing_sound_udata, const cs_playing_sound_t* sound)
+unsigned cd_get_preset_count(const cd_preset_bank_t* bank)
 {
-	cd_echo_t* filter = 0;
-	cd_context_t* context = (cd_context_t*)plugin_instance;
-	switch (channel_index)
+	CUTE_DSP_ASSERT(bank);
+	return bank->preset_count;
+}
+
+int cd_find_preset(const cd_preset_bank_t* bank, const char* name)
+{
+	int low = 0;
+	int high;
+	CUTE_DSP_ASSERT(bank && name);
+	high = (int)bank->preset_count - 1;
+	while (low <= high)
 	{
-	case 0:
-		filter = (cd_echo_t*)playing_sound_udata;
-		break;
-	case 1:
-		filter = (cd_echo_t*)playing_sound_udata;
-		filter = filter->next;
-		break;
+		int middle = low + (high - low) / 2;
+		int order = strncmp(name, bank->presets[middle].name, CUTE_DSP_MAX_PRESET_NAME);
+		if (!order)
+			return middle;
+		if (order < 0)
+			high = middle - 1;
+		else
+			low = middle + 1;
 	}
-	cd_sample_echo(context, filter, samples_in, samples_out, (unsigned)sample_count);
-
-	// unused parameters
-	(void)cs_ctx;
-	(void)sound;
+	return -1;
 }
 
-cs_plugin_interface_t cd_make_echo_plugin(void)
+cd_preset_t cd_get_preset(const cd_preset_bank_t* bank, int index)
 {
-	cs_plugin_interface_t plugin;
-	plugin.plugin_instance = cd_get_context();
-	plugin.on_make_playing_sound_fn = cd_echo_on_make_playing_sound;
-	plugin.on_free_playing_sound_fn = cd_echo_on_free_playing_sound;
-	plugin.on_mix_fn = cd_echo_on_mix;
+	const cd_preset_record_t* record;
+	cd_preset_t preset;
+	CUTE_DSP_ASSERT(bank && index >= 0 && (unsigned)index < bank->preset_count);
+	record = bank->presets + index;
+	preset.name = record->name;
+	preset.lowpass_cutoff = record->lowpass_cutoff;
+	preset.lowpass_resonance = record->lowpass_resonance;
+	preset.highpass_cutoff = record->highpass_cutoff;
+	preset.echo_delay = record->echo_delay;
+	preset.echo_mix = record->echo_mix;
+	preset.echo_feedback = record->echo_feedback;
+	preset.noise_db = record->noise_db;
+	return preset;
+}
 
-	return plugin;
+void cd_apply_preset_to_filters(const cd_preset_bank_t* bank, int index, cd_lowpass_t* lowpass, cd_highpass_t* highpass, cd_echo_t* echo, cd_noise_t* noise)
+{
+	const cd_preset_record_t* record;
+	CUTE_DSP_ASSERT(bank && index >= 0 && (unsigned)index < bank->preset_count);
+	record = bank->presets + index;
+
+	// filters of multirate voices look up their reduced rate designs as well
+	if (lowpass)
+		cd_load_lowpass_design(lowpass, bank->designs + 2 * index, bank->sampling_rate);
+	if (highpass)
+		cd_load_highpass_design(highpass, bank->designs + 2 * index + 1, bank->sampling_rate);
+	for (; echo; echo = echo->next)
+	{
+		if (record->echo_delay * echo->sampling_rate <= echo->max_samples)
+			echo->offset = record->echo_delay * echo->sampling_rate;
+		echo->mix = record->echo_mix;
+		echo->feedback = record->echo_feedback;
+	}
+	for (; noise; noise = noise->next)
+	{
+		noise->amplitude_db = record->noise_db;
+		noise->amplitude_gain = record->noise_gain;
+	}
 }
 
-static void cd_noise_on_make_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void** playing_sound_udata, const cs_playing_sound_t* sound)
+void cd_apply_preset(cs_playing_sound_t* playing_sound, const cd_preset_bank_t* bank, int index)
 {
-	cd_context_t* ctx = (cd_context_t*)plugin_instance;
-	switch (sound->loaded_sound->channel_count)
+	cd_context_t* ctx = cd_get_context();
+	const cd_preset_record_t* record;
+	cd_lowpass_t* lowpass = NULL;
+	cd_highpass_t* highpass = NULL;
+	cd_echo_t* echo = NULL;
+	cd_noise_t* noise = NULL;
+
+	CUTE_DSP_ASSERT(playing_sound && bank && index >= 0 && (unsigned)index < bank->preset_count);
+	record = bank->presets + index;
+	if (ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		lowpass = (cd_lowpass_t*)playing_sound->plugin_udata[ctx->lowpass_id];
+	if (ctx->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		highpass = (cd_highpass_t*)playing_sound->plugin_udata[ctx->highpass_id];
+	if (ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		echo = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
+	if (ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		noise = (cd_noise_t*)playing_sound->plugin_udata[ctx->noise_id];
+	cd_apply_preset_to_filters(bank, index, lowpass, highpass, echo, noise);
+
+	// recorded as the setters would be, replaying them designs the same coefficients
+	if (lowpass)
 	{
-	case 1:
+		cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_LOWPASS_CUTOFF, record->lowpass_cutoff);
+		cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_LOWPASS_RESONANCE, record->lowpass_resonance);
+	}
+	if (highpass)
+		cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_HIGHPASS_CUTOFF, record->highpass_cutoff);
+	if (echo)
 	{
-		cd_noise_t* noise = cd_make_noise_generator(ctx);
-		*playing_sound_udata = noise;
-		break;
+		cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_ECHO_DELAY, record->echo_delay);
+		cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_ECHO_MIX, record->echo_mix);
+		cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_ECHO_FEEDBACK, record->echo_feedback);
 	}
-	case 2:
+	if (noise)
+		cd_parameter_changed(ctx, playing_sound, CD_CAPTURE_NOISE_DB, record->noise_db);
+}
+/* END PRESET BANK IMPLEMENTATION */
+
+/* BEGIN QUALITY TIER IMPLEMENTATION */
+/*
+	The tier of a voice is resolved once per mix block, on its first channel. When it changes, every
+	filter runs at both the old and the new tier for that block and fades linearly from one to the other.
+	The state used by the new tier is cleared first, as it is stale, and the fade hides it settling.
+	Echoes fade their delayed taps instead, since both tiers share the ring buffers.
+*/
+
+// 20 * log10(32768), the samples keep the 16 bit range
+#define CUTE_DSP_QUALITY_FULL_SCALE_DB (90.309f)
+// keeps silence finite, far below CUTE_DSP_QUALITY_MINIMAL_DB
+#define CUTE_DSP_QUALITY_SILENCE (1e-3f)
+
+// @return 1 when the governor kept the voice below the tier it would have been at
+static int cd_update_quality(cd_quality_t* quality, const float* samples, unsigned sample_count)
+{
+	__m128 sum = _mm_setzero_ps();
+	float lanes[4], mean_square = 0.f, loudness_db, score;
+	cd_quality_tier_t tier = quality->requested;
+	unsigned i = 0;
+
+	// measured at every tier, the governor ranks voices by it too
+	for (; i + 4 <= sample_count; i += 4)
 	{
-		cd_noise_t* noise = cd_make_noise_generator(ctx);
-		*playing_sound_udata = noise;
-		noise->next = cd_make_noise_generator(ctx);
-		break;
+		__m128 x = _mm_loadu_ps(samples + i);
+		sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
 	}
+	_mm_storeu_ps(lanes, sum);
+	mean_square = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	for (; i < sample_count; ++i)
+		mean_square += samples[i] * samples[i];
+	if (sample_count)
+		mean_square /= (float)sample_count;
+
+	// rises at once, and falls slowly so the tails of the filters aren't cut when the sound goes quiet
+	loudness_db = 10.f * log10f(mean_square + CUTE_DSP_QUALITY_SILENCE) - CUTE_DSP_QUALITY_FULL_SCALE_DB;
+	if (loudness_db < quality->loudness_db - CUTE_DSP_QUALITY_RELEASE_DB)
+		loudness_db = quality->loudness_db - CUTE_DSP_QUALITY_RELEASE_DB;
+	quality->loudness_db = loudness_db;
+
+	if (tier == CD_TIER_AUTO)
+	{
+		score = loudness_db + quality->priority_db;
+		if (score >= CUTE_DSP_QUALITY_REDUCED_DB + (quality->tier == CD_TIER_FULL ? 0.f : CUTE_DSP_QUALITY_HYSTERESIS_DB))
+			tier = CD_TIER_FULL;
+		else if (score >= CUTE_DSP_QUALITY_MINIMAL_DB + (quality->tier == CD_TIER_MINIMAL ? CUTE_DSP_QUALITY_HYSTERESIS_DB : 0.f))
+			tier = CD_TIER_REDUCED;
+		else
+			tier = CD_TIER_MINIMAL;
 	}
 
-	// unused parameters
-	(void)cs_ctx;
-	(void)sound;
+	quality->previous_tier = quality->tier;
+	quality->tier = tier < quality->cap ? quality->cap : tier;
+	return quality->tier != tier;
 }
 
-static void cd_noise_on_free_playing_sound(cs_context_t* cs_ctx, void* plugin_instance, void* playing_sound_udata, const cs_playing_sound_t* sound)
+typedef void (*cd_tier_sample_fn)(cd_context_t* context, void* filter, const float* input, float** output, unsigned sample_count, cd_quality_tier_t tier);
+
+// the minimal tier passes the input through
+static void cd_fade_tiers(cd_context_t* context, cd_tier_sample_fn sample, void* filter, const float* input, float** output, unsigned sample_count, cd_quality_tier_t from, cd_quality_tier_t to)
 {
-	cd_context_t* ctx = (cd_context_t*)plugin_instance;
-	cd_noise_t* filter = (cd_noise_t*)playing_sound_udata;
-	if (filter->next)
+	const float* faded_in = input;
+	float* faded_out;
+	float step = 1.f / (float)sample_count;
+	unsigned i = 0;
+
+	// the input is the other output buffer, so the new tier is kept aside and its buffer reused
+	if (to != CD_TIER_MINIMAL)
 	{
-		cd_release_noise(ctx, &(filter->next));
+		float* samples;
+		sample(context, filter, input, &samples, sample_count, to);
+		memcpy(context->tier_fade, samples, sizeof(float) * sample_count);
+		cd_context_swap_buffers(context);
+		faded_in = context->tier_fade;
+	}
+	if (from != CD_TIER_MINIMAL)
+		sample(context, filter, input, &faded_out, sample_count, from);
+	else
+	{
+		faded_out = context->current_output;
+		memcpy(faded_out, input, sizeof(float) * sample_count);
+		cd_context_swap_buffers(context);
 	}
 
-	cd_release_noise(ctx, &filter);
-
-	// unused parameters
-	(void)cs_ctx;
-	(void)sound;
+	for (; i < sample_count; ++i)
+		faded_out[i] += (faded_in[i] - faded_out[i]) * (float)(i + 1) * step;
+	*output = faded_out;
 }
 
-static void cd_noise_on_mix(cs_context_t* cs_ctx, void* plugin_instance, int channel_index, const float* samples_in, int sample_count, float** samples_out, void* playing_sound_udata, const cs_playing_sound_t* sound)
+static void cd_sample_lowpass_tier(cd_context_t* context, void* filter, const float* input, float** output, unsigned sample_count, cd_quality_tier_t tier)
 {
-	cd_noise_t* filter = 0;
-	cd_context_t* context = (cd_context_t*)plugin_instance;
-	switch (channel_index)
+	cd_lowpass_t* lowpass = (cd_lowpass_t*)filter;
+	if (tier == CD_TIER_FULL)
 	{
-	case 0:
-		filter = (cd_noise_t*)playing_sound_udata;
-		break;
-	case 1:
-		filter = (cd_noise_t*)playing_sound_udata;
-		filter = filter->next;
-		break;
+		cd_sample_lowpass(context, lowpass, input, output, sample_count);
+		return;
 	}
-	cd_sample_noise(context, filter, samples_in, samples_out, (unsigned)sample_count);
-
-	// unused parameters
-	(void)cs_ctx;
-	(void)sound;
+	cd_sample_lowpass_section(lowpass, input, context->current_output, sample_count);
+	*output = context->current_output;
+	cd_context_swap_buffers(context);
 }
 
-cs_plugin_interface_t cd_make_noise_plugin(void)
+static void cd_sample_lowpass_tiers(cd_context_t* context, cd_lowpass_t* filter, const float* input, float** output, unsigned sample_count, const cd_quality_t* quality)
 {
-	cs_plugin_interface_t plugin;
-	plugin.plugin_instance = cd_get_context();
-	plugin.on_make_playing_sound_fn = cd_noise_on_make_playing_sound;
-	plugin.on_free_playing_sound_fn = cd_noise_on_free_playing_sound;
-	plugin.on_mix_fn = cd_noise_on_mix;
+	// the single section filters are already the reduced ones
+	cd_quality_tier_t from = quality->previous_tier == CD_TIER_REDUCED && !filter->cascade.order ? CD_TIER_FULL : quality->previous_tier;
+	cd_quality_tier_t to = quality->tier == CD_TIER_REDUCED && !filter->cascade.order ? CD_TIER_FULL : quality->tier;
+	if (from == to)
+	{
+		if (to == CD_TIER_MINIMAL)
+			*output = (float*)input;
+		else
+			cd_sample_lowpass_tier(context, filter, input, output, sample_count, to);
+		return;
+	}
 
-	return plugin;
+	if (to == CD_TIER_FULL && filter->cascade.order)
+		cd_reset_biquad_cascade(&filter->cascade);
+	else if (to == CD_TIER_REDUCED)
+	{
+		filter->y1 = filter->y2 = 0.f;
+		filter->running = 0;
+	}
+	cd_fade_tiers(context, cd_sample_lowpass_tier, filter, input, output, sample_count, from, to);
 }
 
-/* END PLUGIN INTERFACE IMPLEMENTATION */
-
-/* BEGIN MEMORY POOL IMPLEMENTATION */
-void cd_make_memory_pool(cd_memory_pool_t* mem_pool, cd_memory_pool_def_t def)
+static void cd_sample_highpass_tier(cd_context_t* context, void* filter, const float* input, float** output, unsigned sample_count, cd_quality_tier_t tier)
 {
-	char* pool = NULL;
-	unsigned i = 0;
+	cd_highpass_t* highpass = (cd_highpass_t*)filter;
+	if (tier == CD_TIER_FULL)
+	{
+		cd_sample_highpass(context, highpass, input, output, sample_count);
+		return;
+	}
+	cd_sample_highpass_section(highpass, input, context->current_output, sample_count);
+	*output = context->current_output;
+	cd_context_swap_buffers(context);
+}
 
-	CUTE_DSP_ASSERT(mem_pool);
-	mem_pool->size_per_object = def.size_per_object;
-	mem_pool->max_objects = def.max_objects;
-	mem_pool->pool_size = def.max_objects * def.size_per_object;
-	mem_pool->num_objects = 0;
-	
-	pool = CUTE_DSP_ALLOC(mem_pool->pool_size, 0);
-	mem_pool->pool = pool;
-	CUTE_DSP_ASSERT(pool);
+static void cd_sample_highpass_tiers(cd_context_t* context, cd_highpass_t* filter, const float* input, float** output, unsigned sample_count, const cd_quality_t* quality)
+{
+	cd_quality_tier_t from = quality->previous_tier == CD_TIER_REDUCED && !filter->cascade.order ? CD_TIER_FULL : quality->previous_tier;
+	cd_quality_tier_t to = quality->tier == CD_TIER_REDUCED && !filter->cascade.order ? CD_TIER_FULL : quality->tier;
+	if (from == to)
+	{
+		if (to == CD_TIER_MINIMAL)
+			*output = (float*)input;
+		else
+			cd_sample_highpass_tier(context, filter, input, output, sample_count, to);
+		return;
+	}
 
-	// initialize free list
-	for(i = 0; i < def.max_objects; ++i)
+	if (to == CD_TIER_FULL && filter->cascade.order)
+		cd_reset_biquad_cascade(&filter->cascade);
+	else if (to == CD_TIER_REDUCED)
 	{
-		cd_memory_pool_object_t* obj = (cd_memory_pool_object_t *)(mem_pool->pool + i * def.size_per_object);
-		obj->next = mem_pool->free_list;
-		mem_pool->free_list = obj;
+		filter->x1 = filter->x2 = filter->y1 = filter->y2 = 0.f;
+		filter->running = 0;
 	}
+	cd_fade_tiers(context, cd_sample_highpass_tier, filter, input, output, sample_count, from, to);
 }
 
-void cd_release_memory_pool(cd_memory_pool_t* mem_pool)
+// the delayed taps added to the input, as cd_sample_echo reads them at the full tier
+static float cd_echo_taps(cd_echo_t* filter, cd_quality_tier_t tier)
 {
-	CUTE_DSP_ASSERT(mem_pool);
-	if(mem_pool->pool)
+	float x, y;
+	if (tier == CD_TIER_MINIMAL)
+		return 0.f;
+	if (tier == CD_TIER_REDUCED)
 	{
-		CUTE_DSP_FREE(mem_pool->pool, 0);
-		mem_pool->pool = NULL;
+		int delay = (int)(filter->offset + 0.5f);
+		x = cd_ring_buffer_get(&filter->xvalues, delay);
+		y = cd_ring_buffer_get(&filter->yvalues, delay);
+	}
+	else
+	{
+		float start = (float)(int)filter->offset;
+		float factor = filter->offset - start;
+		y = CUTE_DSP_LERP_FLOAT(cd_ring_buffer_get(&filter->yvalues, (int)start), cd_ring_buffer_get(&filter->yvalues, (int)start + 1), (int)factor);
+		x = CUTE_DSP_LERP_FLOAT(cd_ring_buffer_get(&filter->xvalues, (int)start), cd_ring_buffer_get(&filter->xvalues, (int)start + 1), factor);
 	}
+	return (filter->mix - filter->feedback) * x + filter->feedback * y;
 }
 
-void* cd_memory_pool_alloc(cd_memory_pool_t* mem_pool)
+// the minimal tier keeps the rings fed with the dry input, so the taps are there to fade back in
+static void cd_feed_echo(cd_echo_t* filter, const float* input, unsigned sample_count)
 {
-	CUTE_DSP_ASSERT(mem_pool);
-
-	// case the pool is empty
-	if(mem_pool->free_list == NULL)
+	int size = filter->xvalues.max_elements;
+	int write = filter->xvalues.current_index;
+	unsigned first = sample_count;
+	if (sample_count > (unsigned)size)
 	{
-		// allocate from the heap normally
-		void* object = CUTE_DSP_ALLOC(mem_pool->size_per_object, 0);
-		CUTE_DSP_ASSERT(object);
-		++mem_pool->num_objects;
-		return object;
+		input += sample_count - size;
+		sample_count = first = size;
 	}
-	else
+	if (first > (unsigned)(size - write))
+		first = size - write;
+	memcpy(filter->xvalues.buffer + write, input, sizeof(float) * first);
+	memcpy(filter->yvalues.buffer + write, input, sizeof(float) * first);
+	memcpy(filter->xvalues.buffer, input + first, sizeof(float) * (sample_count - first));
+	memcpy(filter->yvalues.buffer, input + first, sizeof(float) * (sample_count - first));
+	filter->xvalues.current_index = filter->yvalues.current_index = (write + sample_count) % size;
+}
+
+// whole sample delay, the rings share their write position so the indices wrap without a modulo
+static void cd_sample_echo_reduced(cd_echo_t* filter, const float* input, float* samples, unsigned sample_count)
+{
+	float* xs = filter->xvalues.buffer;
+	float* ys = filter->yvalues.buffer;
+	int size = filter->xvalues.max_elements;
+	int write = filter->xvalues.current_index;
+	int read = (write - (int)(filter->offset + 0.5f) - 1) % size;
+	float mix, feedback, mix_step, feedback_step;
+	unsigned i = 0;
+	if (read < 0)
+		read += size;
+	cd_ramp_echo(filter, sample_count, &mix, &feedback, &mix_step, &feedback_step);
+
+	for (; i < sample_count; ++i)
 	{
-		// pull another object from the free list
-		cd_memory_pool_object_t* object = mem_pool->free_list;
-		mem_pool->free_list = mem_pool->free_list->next;
-		++mem_pool->num_objects;
-		return object;
+		float x = input[i];
+		float out;
+		mix += mix_step;
+		feedback += feedback_step;
+		out = x + ((mix - feedback) * xs[read] + feedback * ys[read]);
+		ys[write] = out;
+		xs[write] = x;
+		samples[i] = out;
+		if (++write == size) write = 0;
+		if (++read == size) read = 0;
 	}
+	filter->xvalues.current_index = filter->yvalues.current_index = write;
 }
 
-void cd_memory_pool_free(cd_memory_pool_t* mem_pool, void* object)
+static void cd_sample_echo_tiers(cd_context_t* context, cd_echo_t* filter, const float* input, float** output, unsigned sample_count, const cd_quality_t* quality)
 {
-	char* obj = (char *)object;
-	size_t obj_distance, pool_distance;
-	CUTE_DSP_ASSERT(object && mem_pool);
+	cd_quality_tier_t from = quality->previous_tier;
+	cd_quality_tier_t to = quality->tier;
+	float* samples = context->current_output;
+	float step = 1.f / (float)sample_count;
+	float mix, feedback, mix_step, feedback_step;
+	unsigned i = 0;
 
-	obj_distance = obj - mem_pool->pool;
-	pool_distance = (mem_pool->pool + mem_pool->pool_size) - mem_pool->pool;
+	if (from == to && to == CD_TIER_FULL)
+	{
+		cd_sample_echo(context, filter, input, output, sample_count);
+		return;
+	}
 
-	// case object isn't in the pool
-	if(pool_distance < obj_distance && obj_distance >= 0)
+	// the minimal tier and the fades between tiers take new parameters at once
+	if (from == to && to == CD_TIER_MINIMAL)
 	{
-		CUTE_DSP_FREE(object, 0);
+		cd_ramp_echo(filter, sample_count, &mix, &feedback, &mix_step, &feedback_step);
+		cd_feed_echo(filter, input, sample_count);
+		*output = (float*)input;
+		return;
 	}
-	// case object is in the pool
+
+	if (from == to)
+		cd_sample_echo_reduced(filter, input, samples, sample_count);
 	else
 	{
-		// put it back on the free list
-		cd_memory_pool_object_t* mem_obj = (cd_memory_pool_object_t*)(object);
-		mem_obj->next = mem_pool->free_list;
-		mem_pool->free_list = mem_obj;
+		cd_ramp_echo(filter, sample_count, &mix, &feedback, &mix_step, &feedback_step);
+		for (; i < sample_count; ++i)
+		{
+			float faded_out = cd_echo_taps(filter, from);
+			float out = input[i] + (faded_out + (cd_echo_taps(filter, to) - faded_out) * (float)(i + 1) * step);
+			cd_ring_buffer_put(&filter->yvalues, out);
+			cd_ring_buffer_put(&filter->xvalues, input[i]);
+			samples[i] = out;
+		}
 	}
-	
-	--mem_pool->num_objects;
+	*output = samples;
+	cd_context_swap_buffers(context);
 }
-/* END MEMORY POOL IMPLEMENTATION */
 
-/* BEGIN RING BUFFER IMPLEMENTATION */
+static void cd_sample_noise_tier(cd_context_t* context, void* filter, const float* input, float** output, unsigned sample_count, cd_quality_tier_t tier)
+{
+	cd_sample_noise(context, (cd_noise_t*)filter, input, output, sample_count);
+	(void)tier;
+}
 
-void cd_ring_buffer_init(cd_ring_buffer_t* buff, int num_elements)
+// the noise is already as cheap as it gets, so it only stops at the minimal tier
+static void cd_sample_noise_tiers(cd_context_t* context, cd_noise_t* filter, const float* input, float** output, unsigned sample_count, const cd_quality_t* quality)
 {
-	if (num_elements)
+	cd_quality_tier_t from = quality->previous_tier == CD_TIER_MINIMAL ? CD_TIER_MINIMAL : CD_TIER_FULL;
+	cd_quality_tier_t to = quality->tier == CD_TIER_MINIMAL ? CD_TIER_MINIMAL : CD_TIER_FULL;
+	if (from != to)
+		cd_fade_tiers(context, cd_sample_noise_tier, filter, input, output, sample_count, from, to);
+	else if (to == CD_TIER_MINIMAL)
+		*output = (float*)input;
+	else
+		cd_sample_noise(context, filter, input, output, sample_count);
+}
+
+void cd_set_quality_tier(cs_playing_sound_t* playing_sound, cd_quality_tier_t tier)
+{
+	CUTE_DSP_ASSERT(playing_sound && tier <= CD_TIER_AUTO);
+	cd_context_t* ctx = cd_get_context();
+	cd_voice_t* voice = (cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	voice->quality.requested = tier;
+
+	// the render cache is rendered at the full tier and skips the filters either way
+	cd_capture_parameter(ctx, playing_sound, CD_CAPTURE_QUALITY_TIER, (float)tier);
+}
+
+cd_quality_tier_t cd_get_quality_tier(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	const cd_voice_t* voice = (const cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	return voice->quality.tier;
+}
+
+void cd_set_voice_priority(cs_playing_sound_t* playing_sound, float priority_db)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	cd_voice_t* voice = (cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	voice->quality.priority_db = priority_db;
+	cd_capture_parameter(ctx, playing_sound, CD_CAPTURE_PRIORITY, priority_db);
+}
+
+float cd_get_voice_priority(const cs_playing_sound_t* playing_sound)
+{
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	const cd_voice_t* voice = (const cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	return voice->quality.priority_db;
+}
+
+cd_quality_stats_t cd_get_quality_stats(cd_context_t* context)
+{
+	cd_quality_stats_t stats;
+	const cd_voice_t* voice;
+	CUTE_DSP_ASSERT(context);
+	memset(&stats, 0, sizeof(stats));
+	memcpy(stats.samples, context->tier_samples, sizeof(stats.samples));
+	stats.transitions = context->tier_transitions;
+
+	cd_lock(&context->voice_lock);
+	for (voice = context->active_voices; voice; voice = voice->next_active)
+		++stats.voices[voice->quality.tier];
+	cd_unlock(&context->voice_lock);
+	return stats;
+}
+/* END QUALITY TIER IMPLEMENTATION */
+
+/* BEGIN GOVERNOR IMPLEMENTATION */
+/*
+	Every voice is timed from the voice plugin, the first of its chain, to the bus send plugin, the last.
+	At the end of a block over budget the threshold rises by CUTE_DSP_GOVERNOR_STEP_DB, starting just
+	under the quietest voice, and falls slowly once the blocks fit with headroom. The tiers follow it
+	from the next block with the usual crossfade. The caps are captured like parameters, so replays
+	don't depend on the timing of the session.
+*/
+static void cd_end_governor_block(cd_context_t* context)
+{
+	cd_governor_t* governor = &context->governor;
+	cd_governor_stats_t* stats = &governor->stats;
+	float load = 0.f;
+
+	if (governor->block_frames && governor->budget > 0.f)
 	{
-		buff->buffer = (float*)CUTE_DSP_ALLOC((sizeof(float) * num_elements), 0);
-		buff->current_index = 0;
-		buff->max_elements = num_elements;
-		memset(buff->buffer, 0, sizeof(float) * num_elements);
+		load = (float)(governor->block_time * context->def.sampling_rate / governor->block_frames);
+		++stats->blocks;
+		stats->load = load;
+		if (load > stats->peak_load)
+			stats->peak_load = load;
 	}
-	else
+	stats->voices_degraded = governor->voices_degraded;
+	if (governor->voices_degraded > stats->peak_voices_degraded)
+		stats->peak_voices_degraded = governor->voices_degraded;
+
+	if (governor->budget > 0.f && load > governor->budget)
 	{
-		buff->buffer = 0;
-		buff->current_index = 0;
-		buff->max_elements = 0;
+		++stats->blocks_over_budget;
+		if (governor->threshold_db == CUTE_DSP_GOVERNOR_IDLE_DB)
+			governor->threshold_db = governor->min_score - CUTE_DSP_GOVERNOR_SPAN_DB + CUTE_DSP_GOVERNOR_STEP_DB;
+		else if (governor->threshold_db <= governor->max_score)
+			governor->threshold_db += CUTE_DSP_GOVERNOR_STEP_DB;
+		else
+			governor->threshold_db = governor->max_score + CUTE_DSP_GOVERNOR_STEP_DB;	// every voice is minimal already
+		++stats->interventions;
 	}
+	else if (governor->threshold_db != CUTE_DSP_GOVERNOR_IDLE_DB && (governor->budget <= 0.f || load < governor->budget * CUTE_DSP_GOVERNOR_HEADROOM))
+	{
+		governor->threshold_db -= CUTE_DSP_GOVERNOR_RELEASE_DB;
+		if (governor->budget <= 0.f || governor->threshold_db + CUTE_DSP_GOVERNOR_SPAN_DB < governor->min_score)
+			governor->threshold_db = CUTE_DSP_GOVERNOR_IDLE_DB;
+	}
+	stats->threshold_db = governor->threshold_db;
+
+	governor->block_time = 0.0;
+	governor->block_frames = 0;
+	governor->voices_degraded = 0;
+	governor->min_score = -CUTE_DSP_GOVERNOR_IDLE_DB;
+	governor->max_score = CUTE_DSP_GOVERNOR_IDLE_DB;
 }
 
-inline void cd_ring_buffer_put(cd_ring_buffer_t* buff, float value)
+// ranks the voice by the loudness of its last block, on its first channel
+static void cd_govern_voice(cd_context_t* context, cd_voice_t* voice)
 {
-	buff->buffer[buff->current_index] = value;
-	buff->current_index = (buff->current_index + 1) % buff->max_elements;
+	cd_governor_t* governor = &context->governor;
+	cd_quality_tier_t cap = CD_TIER_FULL;
+	float score = voice->quality.loudness_db + voice->quality.priority_db;
+
+	if (score < governor->min_score)
+		governor->min_score = score;
+	if (score > governor->max_score)
+		governor->max_score = score;
+	if (score < governor->threshold_db)
+		cap = CD_TIER_MINIMAL;
+	else if (score < governor->threshold_db + CUTE_DSP_GOVERNOR_SPAN_DB)
+		cap = CD_TIER_REDUCED;
+
+	if (cap != voice->quality.cap)
+	{
+		voice->quality.cap = cap;
+		if (context->capture.file)
+			cd_capture_voice_parameter(context, voice, CD_CAPTURE_GOVERNOR_CAP, (float)cap);
+	}
 }
 
-inline float cd_ring_buffer_get(cd_ring_buffer_t* buff, int delay)
+void cd_set_cpu_budget(cd_context_t* context, float budget)
 {
-	int index = buff->current_index - delay - 1;
-	index %= buff->max_elements;
-	if (index < 0) index += buff->max_elements;
-	return buff->buffer[index];
+	CUTE_DSP_ASSERT(context && budget >= 0.f && budget - budget == 0.f);	// finite
+	context->governor.budget = budget;
 }
 
-void cd_ring_buffer_release(cd_ring_buffer_t* buff)
+cd_governor_stats_t cd_get_governor_stats(cd_context_t* context)
 {
-	CUTE_DSP_ASSERT(buff);
-	if(buff->buffer)
-		CUTE_DSP_FREE(buff->buffer, 0);
-	buff->buffer = 0;
-	buff->current_index = 0;
-	buff->max_elements = 0;
+	CUTE_DSP_ASSERT(context);
+	return context->governor.stats;
 }
+/* END GOVERNOR IMPLEMENTATION */
 
-/* END RING BUFFER IMPLEMENTATION */
+/* BEGIN MULTIRATE IMPLEMENTATION */
+/*
+	Voices whose cutoffs fit the bandwidth of a reduced rate are decimated by halfband stages, run
+	through their lowpass and highpass at that rate, and interpolated back, all in the voice plugin so
+	the filter plugins skip them. Their filters hold designs of the reduced rates, looked up on the game
+	thread whenever the limit or the parameters are set, so the mix thread only picks one. When the factor
+	changes, the filters run at both factors for a block and fade from one to the other. The noise and
+	echo stay at the full rate, so the history of the echo never holds samples from both sides of the
+	halfband stages.
+*/
 
-/* BEGIN RANDOM IMPLEMENTATION */
+// windowed sinc, Kaiser beta of 6, the taps next to the center first, -60 dB above 0.39 of the rate
+static const float cd_halfband_taps[4] = { 0.300649115f, -0.062679686f, 0.012706253f, -0.000675681f };
 
-void cd_random_seed(cd_random_t* prng, uint64_t seed)
+static void cd_halfband_decimate(float* history, const float* input, unsigned sample_count, float* output, float* work)
 {
-	prng->a = seed / 2;
-	prng->b = seed;
-}
+	const float g0 = cd_halfband_taps[0], g1 = cd_halfband_taps[1], g2 = cd_halfband_taps[2], g3 = cd_halfband_taps[3];
+	unsigned i = 0;
+	memcpy(work, history, sizeof(float) * CUTE_DSP_HALFBAND_DECIMATOR_HISTORY);
+	memcpy(work + CUTE_DSP_HALFBAND_DECIMATOR_HISTORY, input, sizeof(float) * sample_count);
 
-uint64_t cd_random_rand(cd_random_t* prng)
-{
-	uint64_t t = prng->a;
-	uint64_t const s = prng->b;
-	prng->a = s;
-	t ^= t << 23;
-	t ^= t >> 17;
-	t ^= s ^ (s >> 26);
-	prng->b = t;
-	return t + s;
+	// only the odd taps around the center aren't 0, and every other output is skipped
+	for (; i < sample_count / 2; ++i)
+	{
+		const float* x = work + 2 * i + 8;
+		output[i] = 0.5f * x[0] + g0 * (x[-1] + x[1]) + g1 * (x[-3] + x[3]) + g2 * (x[-5] + x[5]) + g3 * (x[-7] + x[7]);
+	}
+	memcpy(history, work + sample_count, sizeof(float) * CUTE_DSP_HALFBAND_DECIMATOR_HISTORY);
 }
 
-float cd_random_rand_between(cd_random_t* prng, float min_val, float max_val)
+static void cd_halfband_interpolate(float* history, const float* input, unsigned sample_count, float* output, float* work)
 {
-	uint64_t raw = cd_random_rand(prng);
-	double scale = (double)raw / (double)CUTE_DSP_PRNG_MAX;
-	return (float)((double)min_val + scale * ((double)max_val - (double)min_val));
+	const float g0 = 2.f * cd_halfband_taps[0], g1 = 2.f * cd_halfband_taps[1], g2 = 2.f * cd_halfband_taps[2], g3 = 2.f * cd_halfband_taps[3];
+	unsigned i = 0;
+	memcpy(work, history, sizeof(float) * CUTE_DSP_HALFBAND_INTERPOLATOR_HISTORY);
+	memcpy(work + CUTE_DSP_HALFBAND_INTERPOLATOR_HISTORY, input, sizeof(float) * sample_count);
+
+	// the inserted zeros leave the odd taps for the new samples, and the center tap for the others
+	for (; i < sample_count; ++i)
+	{
+		const float* x = work + i + CUTE_DSP_HALFBAND_INTERPOLATOR_HISTORY;
+		output[2 * i] = g0 * (x[-3] + x[-4]) + g1 * (x[-2] + x[-5]) + g2 * (x[-1] + x[-6]) + g3 * (x[0] + x[-7]);
+		output[2 * i + 1] = x[-3];
+	}
+	memcpy(history, work + sample_count, sizeof(float) * CUTE_DSP_HALFBAND_INTERPOLATOR_HISTORY);
 }
 
-/* END RANDOM IMPLEMENTATION */
-
-/* BEGIN CONTEXT IMPLEMENTATION */
-static cd_context_t* cd_get_context(void)
+// looks up the designs of both channels at the reduced rates up to the limit, on the game thread
+static void cd_reduce_filters(cd_lowpass_t* lowpass, cd_highpass_t* highpass, unsigned limit)
 {
-	return g_dsp_context;
+	for (; lowpass; lowpass = lowpass->next)
+		cd_acquire_reduced_coefficients(lowpass->coefficients->cache, lowpass->reduced, limit, 0, lowpass->sampling_rate, lowpass->freq_cutoff, lowpass->resonance);
+	for (; highpass; highpass = highpass->next)
+		cd_acquire_reduced_coefficients(highpass->coefficients->cache, highpass->reduced, limit, 1, highpass->sampling_rate, highpass->freq_cutoff, 0.f);
 }
 
-#define cd_context_swap_buffers(context)	\
-{	\
-	if (context->current_output == context->output1)	\
-	{	\
-		context->current_output = context->output2;	\
-	}	\
-	else	\
-	{	\
-		context->current_output = context->output1;	\
-	}	\
+// points the filters of one channel to their designs at the sampling rate over the factor
+static void cd_design_multirate(cd_lowpass_t* lowpass, cd_highpass_t* highpass, unsigned factor)
+{
+	if (lowpass)
+		lowpass->factor = factor;
+	if (highpass)
+		highpass->factor = factor;
 }
 
-cd_context_t* cd_make_context(cs_context_t* sound_ctx, cd_context_def_t def)
+static void cd_reset_multirate_filters(cd_lowpass_t* lowpass, cd_highpass_t* highpass)
 {
-	cd_memory_pool_def_t lowpass_def;
-	cd_memory_pool_def_t highpass_def;
-	cd_memory_pool_def_t echo_def;
-	cd_memory_pool_def_t noise_def;
-
-	cd_context_t* context = (cd_context_t *)CUTE_DSP_ALLOC(sizeof(cd_context_t), 0);
-	CUTE_DSP_ASSERT(context && def.playing_pool_count);
-	g_dsp_context = context;
+	if (lowpass)
+	{
+		lowpass->y1 = lowpass->y2 = 0.f;
+		lowpass->running = 0;
+		cd_reset_biquad_cascade(&lowpass->cascade);
+	}
+	if (highpass)
+	{
+		highpass->x1 = highpass->x2 = highpass->y1 = highpass->y2 = 0.f;
+		highpass->running = 0;
+		cd_reset_biquad_cascade(&highpass->cascade);
+	}
+}
 
-	context->sampling_rate = def.sampling_rate;
-	context->pool_size = def.playing_pool_count * 2;
-	context->channel_count = CUTE_DSP_STEREO;
-	memset(context->output1, 0, sizeof(float) * CUTE_DSP_MAX_FRAME_LENGTH);
-	memset(context->output2, 0, sizeof(float) * CUTE_DSP_MAX_FRAME_LENGTH);
-	context->current_output = context->output1;
+// the filters of one channel at the sampling rate over the factor, writes sample_count samples to output
+static void cd_multirate_chain(cd_context_t* context, cd_multirate_t* multirate, int channel_index, unsigned factor, cd_lowpass_t* lowpass, cd_highpass_t* highpass, const cd_quality_t* quality, const float* input, unsigned sample_count, float* output)
+{
+	const float* samples = input;
+	float* out;
+	unsigned count = sample_count, stage = 0;
 
-	/* set up filters =========================================== */
-	/* noise filter */
-	if (def.use_noise)
+	for (; (2u << stage) <= factor; ++stage, count /= 2)
 	{
-		noise_def.max_objects = context->pool_size;
-		noise_def.size_per_object = sizeof(cd_noise_t);
-		cd_make_memory_pool(&context->noise_generators, noise_def);
+		cd_halfband_decimate(multirate->decimators[channel_index][stage], samples, count, context->multirate_stages[stage], context->multirate_work);
+		samples = context->multirate_stages[stage];
+	}
 
-		cs_plugin_interface_t noise_interface = cd_make_noise_plugin();
-		context->noise_id = cs_add_plugin(sound_ctx, &noise_interface);
+	if (lowpass) { cd_sample_lowpass_tiers(context, lowpass, samples, &out, count, quality); samples = out; }
+	if (highpass) { cd_sample_highpass_tiers(context, highpass, samples, &out, count, quality); samples = out; }
 
-		cd_random_seed(&context->random_generator, def.rand_seed);
-	}
-	else
+	if (!stage)
+		memcpy(output, samples, sizeof(float) * count);
+	while (stage--)
 	{
-		memset(&context->noise_generators, 0, sizeof(cd_memory_pool_t));
-		context->noise_id = CUTE_DSP_INVALID_PLUGIN_ID;
+		float* interpolated = stage ? context->multirate_stages[stage - 1] : output;
+		cd_halfband_interpolate(multirate->interpolators[channel_index][stage], samples, count, interpolated, context->multirate_work);
+		samples = interpolated;
+		count *= 2;
 	}
+}
 
-	/* lowpass filter */
-	if(def.use_lowpass)
-	{
-		lowpass_def.max_objects = context->pool_size;
-		lowpass_def.size_per_object = sizeof(cd_lowpass_t);
-		cd_make_memory_pool(&context->lowpass_filters, lowpass_def);
+// on the first channel of every block
+static void cd_update_multirate(cd_context_t* context, cd_multirate_t* multirate, const cd_lowpass_t* lowpass, const cd_highpass_t* highpass, const cd_quality_t* quality, unsigned sample_count)
+{
+	unsigned factor = multirate->limit >= 4 ? 4 : multirate->limit >= 2 ? 2 : 1;
+	multirate->previous_factor = multirate->factor;
 
-		cs_plugin_interface_t lowpass_interface = cd_make_lowpass_plugin();
-		context->lowpass_id = cs_add_plugin(sound_ctx, &lowpass_interface);
-	}
-	else
+	// the minimal tier skips the filters, and needn't lose what is above the bandwidth
+	for (; factor > 1; factor /= 2)
 	{
-		memset(&context->lowpass_filters, 0, sizeof(cd_memory_pool_t));
-		context->lowpass_id = CUTE_DSP_INVALID_PLUGIN_ID;
+		float bandwidth = CUTE_DSP_MULTIRATE_BANDWIDTH * 0.5f * context->sampling_rate / (float)factor;
+		if (factor > multirate->factor)
+			bandwidth *= CUTE_DSP_MULTIRATE_HYSTERESIS;
+		if (lowpass && quality->tier != CD_TIER_MINIMAL && sample_count % factor == 0
+			&& lowpass->freq_cutoff <= bandwidth && (!highpass || highpass->freq_cutoff <= bandwidth))
+			break;
 	}
 
-	/* highpass filter */
-	if(def.use_highpass)
-	{
-		highpass_def.max_objects = context->pool_size;
-		highpass_def.size_per_object = sizeof(cd_highpass_t);
-		cd_make_memory_pool(&context->highpass_filters, highpass_def);
+	multirate->factor = factor;
+	if (factor != multirate->previous_factor)
+		++context->multirate_transitions;
+}
 
-		cs_plugin_interface_t highpass_interface = cd_make_highpass_plugin();
-		context->highpass_id = cs_add_plugin(sound_ctx, &highpass_interface);
-	}
-	else
+// the noise, lowpass, highpass and echo of one channel, the filters are the ones of the first channel
+static void cd_mix_multirate(cd_context_t* context, cd_multirate_t* multirate, int channel_index, cd_noise_t* noise, cd_lowpass_t* lowpass, cd_highpass_t* highpass, cd_echo_t* echo, const cd_quality_t* quality, const float* input, unsigned sample_count, float** output)
+{
+	float decimators[CUTE_DSP_MULTIRATE_STAGES][CUTE_DSP_HALFBAND_DECIMATOR_HISTORY];
+	float interpolators[CUTE_DSP_MULTIRATE_STAGES][CUTE_DSP_HALFBAND_INTERPOLATOR_HISTORY];
+	unsigned from = multirate->previous_factor, to = multirate->factor, stage = 0, i = 0;
+	float* samples = context->multirate_output;
+	float* fade = context->multirate_fade;
+	float step = 1.f / (float)sample_count;
+
+	if (channel_index)
 	{
-		memset(&context->highpass_filters, 0, sizeof(cd_memory_pool_t));
-		context->highpass_id = CUTE_DSP_INVALID_PLUGIN_ID;
+		noise = noise ? noise->next : NULL;
+		lowpass = lowpass ? lowpass->next : NULL;
+		highpass = highpass ? highpass->next : NULL;
+		echo = echo ? echo->next : NULL;
 	}
+	context->multirate_samples[to >> 1] += sample_count;
 
-	/* echo filter */
-	if (def.use_echo)
+	if (noise)
 	{
-		echo_def.max_objects = context->pool_size;
-		echo_def.size_per_object = sizeof(cd_echo_t);
-		cd_make_memory_pool(&context->echo_filters, echo_def);
-		
-		cs_plugin_interface_t echo_interface = cd_make_echo_plugin();
-		context->echo_id = cs_add_plugin(sound_ctx, &echo_interface);
+		float* noisy;
+		cd_sample_noise_tiers(context, noise, input, &noisy, sample_count, quality);
+		input = noisy;
+	}
 
-		if (def.echo_max_delay_s == 0.f)
-			context->echo_max_delay_s = CUTE_DSP_DEFAULT_ECHO_MAX_DELAY;
-		else
-			context->echo_max_delay_s = def.echo_max_delay_s;
+	if (from == to)
+	{
+		cd_multirate_chain(context, multirate, channel_index, to, lowpass, highpass, quality, input, sample_count, samples);
+		if (echo)
+			cd_sample_echo_tiers(context, echo, samples, &samples, sample_count, quality);
+		*output = samples;
+		return;
 	}
-	else
+
+	// the input is in an output buffer of the context, which the filters reuse
+	memcpy(context->multirate_input, input, sizeof(float) * sample_count);
+	input = context->multirate_input;
+	memcpy(decimators, multirate->decimators[channel_index], sizeof(decimators));
+	memcpy(interpolators, multirate->interpolators[channel_index], sizeof(interpolators));
+	cd_design_multirate(lowpass, highpass, from);
+	cd_multirate_chain(context, multirate, channel_index, from, lowpass, highpass, quality, input, sample_count, fade);
+
+	// stages the old factor didn't use start empty, so do the filters at the new rate
+	memcpy(multirate->decimators[channel_index], decimators, sizeof(decimators));
+	memcpy(multirate->interpolators[channel_index], interpolators, sizeof(interpolators));
+	for (; stage < CUTE_DSP_MULTIRATE_STAGES; ++stage)
 	{
-		memset(&context->echo_filters, 0, sizeof(cd_memory_pool_t));
-		context->echo_id = CUTE_DSP_INVALID_PLUGIN_ID;
+		if ((2u << stage) <= from)
+			continue;
+		memset(multirate->decimators[channel_index][stage], 0, sizeof(decimators[stage]));
+		memset(multirate->interpolators[channel_index][stage], 0, sizeof(interpolators[stage]));
 	}
+	cd_reset_multirate_filters(lowpass, highpass);
+	cd_design_multirate(lowpass, highpass, to);
+	cd_multirate_chain(context, multirate, channel_index, to, lowpass, highpass, quality, input, sample_count, samples);
 
-	return context;
+	for (; i < sample_count; ++i)
+		samples[i] = fade[i] + (samples[i] - fade[i]) * (float)(i + 1) * step;
+
+	if (echo)
+		cd_sample_echo_tiers(context, echo, samples, &samples, sample_count, quality);
+	*output = samples;
 }
 
-void cd_release_context(cd_context_t** context)
+static void cd_update_voice_multirate(cd_context_t* context, cd_voice_t* voice, const cs_playing_sound_t* sound, unsigned sample_count)
 {
-	CUTE_DSP_ASSERT(context && *context);
+	const cd_lowpass_t* lowpass = NULL;
+	const cd_highpass_t* highpass = NULL;
+	if (voice->multirate.limit <= 1 && voice->multirate.factor == 1)
+	{
+		voice->multirate.previous_factor = 1;
+		return;
+	}
 
-	if((*context)->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
-		cd_release_memory_pool(&(*context)->lowpass_filters);
-	if ((*context)->highpass_id!= CUTE_DSP_INVALID_PLUGIN_ID)
-		cd_release_memory_pool(&(*context)->highpass_filters);
-	if ((*context)->echo_id != CUTE_DSP_INVALID_PLUGIN_ID)
-		cd_release_memory_pool(&(*context)->echo_filters);
-	if ((*context)->noise_id != CUTE_DSP_INVALID_PLUGIN_ID)
-		cd_release_memory_pool(&(*context)->noise_generators);
+	if (context->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		lowpass = (const cd_lowpass_t*)sound->plugin_udata[context->lowpass_id];
+	if (context->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		highpass = (const cd_highpass_t*)sound->plugin_udata[context->highpass_id];
+	cd_update_multirate(context, &voice->multirate, lowpass, highpass, &voice->quality, sample_count);
+}
 
-	CUTE_DSP_FREE(*context, 0);
-	*context = 0;
-	g_dsp_context = 0;
+static void cd_mix_voice_multirate(cd_context_t* context, cd_voice_t* voice, const cs_playing_sound_t* sound, int channel_index, const float* samples_in, unsigned sample_count, float** samples_out)
+{
+	cd_noise_t* noise = NULL;
+	cd_lowpass_t* lowpass = NULL;
+	cd_highpass_t* highpass = NULL;
+	cd_echo_t* echo = NULL;
+	if (context->noise_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		noise = (cd_noise_t*)sound->plugin_udata[context->noise_id];
+	if (context->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		lowpass = (cd_lowpass_t*)sound->plugin_udata[context->lowpass_id];
+	if (context->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		highpass = (cd_highpass_t*)sound->plugin_udata[context->highpass_id];
+	if (context->echo_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		echo = (cd_echo_t*)sound->plugin_udata[context->echo_id];
+	cd_mix_multirate(context, &voice->multirate, channel_index, noise, lowpass, highpass, echo, &voice->quality, samples_in, sample_count, samples_out);
 }
 
-/* END CONTEXT IMPLEMENTATION */
+void cd_set_multirate_limit(cs_playing_sound_t* playing_sound, unsigned factor)
+{
+	CUTE_DSP_ASSERT(playing_sound && (factor <= 2 || factor == 4));
+	cd_context_t* ctx = cd_get_context();
+	cd_voice_t* voice = (cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	cd_lowpass_t* lowpass = NULL;
+	cd_highpass_t* highpass = NULL;
+	if (ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		lowpass = (cd_lowpass_t*)playing_sound->plugin_udata[ctx->lowpass_id];
+	if (ctx->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+		highpass = (cd_highpass_t*)playing_sound->plugin_udata[ctx->highpass_id];
+	cd_reduce_filters(lowpass, highpass, factor);
+	voice->multirate.limit = factor;
+	cd_capture_parameter(ctx, playing_sound, CD_CAPTURE_MULTIRATE_LIMIT, (float)factor);
+}
 
-/* BEGIN LOWPASS IMPLEMENTATION */
-static void cd_set_lowpass_parameters(cd_lowpass_t* filter, float freq_in_hz, float resonance)
+unsigned cd_get_multirate_factor(const cs_playing_sound_t* playing_sound)
 {
-	if (resonance < 0.f || resonance > 1.f
-		|| freq_in_hz < CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF 
-		|| freq_in_hz > CUTE_DSP_DEFAULT_LOWPASS_CUTOFF)
-		return;
-	
-	filter->resonance = resonance;
-	filter->freq_cutoff = freq_in_hz;
-	float cutoff = 2.f * CUTE_DSP_PI * filter->freq_cutoff;
-	float theta = resonance * CUTE_DSP_PI / 4.f;
-	float R = filter->sampling_rate;
-	float R2 = R * R;
-	float g = 2.f * cutoff * CUTE_DSP_SIN(CUTE_DSP_PI / 4.f - theta) * R;
-	float d = 1.f / (R2 + g + cutoff * cutoff);
-	filter->x_coeff = (cutoff * cutoff) * d;
-	filter->y1_coeff = (2.f * R2 + g) * d;
-	filter->y2_coeff = -1.f * R2 * d;
+	CUTE_DSP_ASSERT(playing_sound);
+	cd_context_t* ctx = cd_get_context();
+	const cd_voice_t* voice = (const cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	return voice->multirate.factor;
 }
 
-cd_lowpass_t* cd_make_lowpass_filter(cd_context_t* context)
+cd_multirate_stats_t cd_get_multirate_stats(cd_context_t* context)
 {
-	cd_lowpass_t* filter = NULL;
+	cd_multirate_stats_t stats;
+	const cd_voice_t* voice;
 	CUTE_DSP_ASSERT(context);
+	memset(&stats, 0, sizeof(stats));
+	memcpy(stats.samples, context->multirate_samples, sizeof(stats.samples));
+	stats.transitions = context->multirate_transitions;
+
+	cd_lock(&context->voice_lock);
+	for (voice = context->active_voices; voice; voice = voice->next_active)
+		++stats.voices[voice->multirate.factor >> 1];
+	cd_unlock(&context->voice_lock);
+	return stats;
+}
+/* END MULTIRATE IMPLEMENTATION */
 
-	filter = (cd_lowpass_t*)cd_memory_pool_alloc(&context->lowpass_filters);
-	CUTE_DSP_ASSERT(filter);
+/* BEGIN RENDER CACHE IMPLEMENTATION */
+/*
+	Entries hold a loaded sound rendered through the lowpass, highpass and echo filters, followed by the
+	tail the filters ring out with afterwards. Voices play the sound part, and looped voices add the tails
+	of their previous passes on top, the same way the live filters carry them into the next pass.
+	cd_use_render_cache queues a miss, cd_update_render_cache renders it a slice at a time into a detached
+	context, and the entry becomes ready once the tail is rendered. Ready entries are never written again,
+	so the mix thread reads them without locking while a voice holds a reference.
+*/
+static int cd_render_cache_key(const cd_context_t* context, const cs_playing_sound_t* playing_sound, const cd_voice_t* voice, cd_render_key_t* key)
+{
+	const cs_loaded_sound_t* loaded = playing_sound->loaded_sound;
+	memset(key, 0, sizeof(cd_render_key_t));
 
-	filter->sampling_rate = context->sampling_rate;
-	cd_set_lowpass_parameters(filter, CUTE_DSP_DEFAULT_LOWPASS_CUTOFF, 0.f);
-	filter->y1 = filter->y2 = 0.f;
-	filter->next = 0;
-	return filter;
+	// the filters may already hold state once the voice is mixed, and noise should differ every playback
+	if (voice->mixed_block != CUTE_DSP_INVALID_BLOCK || playing_sound->pitch != 1.f || loaded->sample_count <= 0)
+		return 0;
+	if (context->noise_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		const cd_noise_t* noise = (const cd_noise_t*)playing_sound->plugin_udata[context->noise_id];
+		if (noise->amplitude_db > CUTE_DSP_NOISE_INAUDIBLE)
+			return 0;
+	}
+
+	key->sound = loaded;
+	if (context->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		const cd_lowpass_t* lowpass = (const cd_lowpass_t*)playing_sound->plugin_udata[context->lowpass_id];
+		key->lowpass_cutoff = lowpass->freq_cutoff;
+		key->lowpass_resonance = lowpass->resonance;
+	}
+	if (context->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		const cd_highpass_t* highpass = (const cd_highpass_t*)playing_sound->plugin_udata[context->highpass_id];
+		key->highpass_cutoff = highpass->freq_cutoff;
+	}
+	if (context->echo_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		const cd_echo_t* echo = (const cd_echo_t*)playing_sound->plugin_udata[context->echo_id];
+		key->echo_offset = echo->offset;
+		key->echo_mix = echo->mix;
+		key->echo_feedback = echo->feedback;
+	}
+	return 1;
 }
 
-void cd_release_lowpass(cd_context_t* context, cd_lowpass_t** filter)
+static unsigned cd_render_tail_frames(const cd_context_t* context, const cd_render_key_t* key)
 {
-	CUTE_DSP_ASSERT(filter && *filter);
-	cd_memory_pool_free(&context->lowpass_filters, *filter);
-	*filter = NULL;
+	float tail = CUTE_DSP_RENDER_CACHE_FILTER_TAIL_S * context->sampling_rate;
+	float max_tail = CUTE_DSP_RENDER_CACHE_MAX_TAIL_S * context->sampling_rate;
+	float feedback = CUTE_DSP_ABS(key->echo_feedback);
+
+	if (key->echo_mix != 0.f || key->echo_feedback != 0.f)
+	{
+		// each repeat is scaled by the feedback once more
+		float repeats = max_tail;
+		if (feedback < CUTE_DSP_RENDER_CACHE_ECHO_FLOOR)
+			repeats = 1.f;
+		else if (feedback < 1.f)
+			repeats = logf(CUTE_DSP_RENDER_CACHE_ECHO_FLOOR) / logf(feedback) + 1.f;
+		tail += (key->echo_offset + 1.f) * repeats;
+	}
+	return (unsigned)(tail < max_tail ? tail : max_tail);
 }
 
-void cd_set_lowpass_cutoff(cs_playing_sound_t* playing_sound, float cutoff_freq_in_hz)
+static cd_render_entry_t* cd_find_render_entry(cd_render_cache_t* cache, const cd_render_key_t* key)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
-
-	cd_lowpass_t* filter = (cd_lowpass_t*)playing_sound->plugin_udata[ctx->lowpass_id];
-	cd_set_lowpass_parameters(filter, cutoff_freq_in_hz, filter->resonance);
-	if (filter->next)
-		cd_set_lowpass_parameters(filter->next, cutoff_freq_in_hz, filter->resonance);
+	cd_render_entry_t* entry = cache->newest;
+	for (; entry; entry = entry->next)
+		if (!memcmp(&entry->key, key, sizeof(cd_render_key_t)))
+			return entry;
+	return 0;
 }
 
-float cd_get_lowpass_cutoff(const cs_playing_sound_t* playing_sound)
+static void cd_unlink_render_entry(cd_render_cache_t* cache, cd_render_entry_t* entry)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		cache->newest = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		cache->oldest = entry->prev;
+}
 
-	const cd_lowpass_t* filter = (const cd_lowpass_t*)playing_sound->plugin_udata[ctx->lowpass_id];
-	return filter->freq_cutoff;
+static void cd_push_render_entry(cd_render_cache_t* cache, cd_render_entry_t* entry)
+{
+	entry->prev = 0;
+	entry->next = cache->newest;
+	if (cache->newest)
+		cache->newest->prev = entry;
+	else
+		cache->oldest = entry;
+	cache->newest = entry;
 }
 
-void cd_set_lowpass_resonance(cs_playing_sound_t* playing_sound, float resonance)
+// unlinks unreferenced entries, oldest first, until the cache fits in size. returns them chained through next
+static cd_render_entry_t* cd_evict_render_entries(cd_render_cache_t* cache, size_t size)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_render_entry_t* evicted = 0;
+	cd_render_entry_t* entry = cache->oldest;
+	while (entry && cache->bytes > size)
+	{
+		cd_render_entry_t* prev = entry->prev;
+		if (!entry->refs && entry != cache->rendering)
+		{
+			cd_unlink_render_entry(cache, entry);
+			cache->bytes -= entry->bytes;
+			++cache->evictions;
+			entry->next = evicted;
+			evicted = entry;
+		}
+		entry = prev;
+	}
+	return evicted;
+}
 
-	cd_lowpass_t* filter = (cd_lowpass_t*)playing_sound->plugin_udata[ctx->lowpass_id];
-	cd_set_lowpass_parameters(filter, filter->freq_cutoff, resonance);
-	if (filter->next)
-		cd_set_lowpass_parameters(filter->next, filter->freq_cutoff, resonance);
+static void cd_free_render_entries(cd_render_entry_t* entry)
+{
+	while (entry)
+	{
+		cd_render_entry_t* next = entry->next;
+		CUTE_DSP_FREE(entry, 0);
+		entry = next;
+	}
 }
 
-float cd_get_lowpass_resonance(const cs_playing_sound_t* playing_sound)
+static void cd_queue_render_entry(cd_context_t* context, const cd_render_key_t* key)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_render_cache_t* cache = &context->render_cache;
+	cd_render_entry_t* entry;
+	cd_render_entry_t* evicted = 0;
+	unsigned channel_count = key->sound->channel_count == 2 ? 2 : 1;
+	unsigned frames = (unsigned)key->sound->sample_count;
+	unsigned tail_frames = cd_render_tail_frames(context, key);
+	size_t bytes = sizeof(cd_render_entry_t) + sizeof(float) * channel_count * (frames + tail_frames);
+	if (bytes > cache->budget)
+		return;
 
-	const cd_lowpass_t* filter = (const cd_lowpass_t*)playing_sound->plugin_udata[ctx->lowpass_id];
-	return filter->resonance;
+	// allocate outside the lock, the mix thread takes it to release references
+	entry = (cd_render_entry_t*)CUTE_DSP_ALLOC(bytes, 0);
+	if (!entry)
+		return;
+	entry->key = *key;
+	entry->samples = (float*)(entry + 1);
+	entry->channel_count = channel_count;
+	entry->frames = frames;
+	entry->tail_frames = tail_frames;
+	entry->rendered = 0;
+	entry->ready = 0;
+	entry->refs = 0;
+	entry->bytes = bytes;
+
+	cd_lock(&cache->lock);
+	if (!cd_find_render_entry(cache, key))
+	{
+		evicted = cd_evict_render_entries(cache, cache->budget - bytes);
+		if (cache->bytes + bytes <= cache->budget)
+		{
+			cd_push_render_entry(cache, entry);
+			cache->bytes += bytes;
+			entry = 0;
+		}
+	}
+	cd_unlock(&cache->lock);
+
+	cd_free_render_entries(evicted);
+	if (entry)
+		CUTE_DSP_FREE(entry, 0);
 }
 
-void cd_sample_lowpass(cd_context_t* context, cd_lowpass_t* filter, const float* input, float** output, unsigned num_samples)
+int cd_use_render_cache(cs_playing_sound_t* playing_sound)
 {
-	int i = 0; 
-	float* samples = context->current_output;
+	cd_context_t* ctx = cd_get_context();
+	cd_render_cache_t* cache;
+	cd_render_entry_t* entry;
+	cd_voice_t* voice;
+	cd_render_key_t key;
+	int hit = 0;
+	CUTE_DSP_ASSERT(playing_sound && ctx);
+
+	cache = &ctx->render_cache;
+	voice = (cd_voice_t*)playing_sound->plugin_udata[ctx->voice_id];
+	if (!cache->budget || voice->cache || !cd_render_cache_key(ctx, playing_sound, voice, &key))
+		return 0;
+
+	cd_lock(&cache->lock);
+	entry = cd_find_render_entry(cache, &key);
+	if (entry && entry->ready)
+	{
+		cd_unlink_render_entry(cache, entry);
+		cd_push_render_entry(cache, entry);
+		++entry->refs;
+		++cache->hits;
+		hit = 1;
+	}
+	else
+	{
+		++cache->misses;
+	}
+	cd_unlock(&cache->lock);
 
-	for(; i < (int)num_samples; ++i)
+	if (!hit)
 	{
-		*samples = filter->x_coeff * *input++ + 
-					filter->y1_coeff * filter->y1 + 
-					filter->y2_coeff * filter->y2;
-		filter->y2 = filter->y1;
-		filter->y1 = *samples++;
+		if (!entry)
+			cd_queue_render_entry(ctx, &key);
+		return 0;
 	}
 
-	*output = context->current_output;
-	cd_context_swap_buffers(context);
+	voice->cache_position = 0;
+	voice->cache_loops = 0;
+	voice->cache_detach = 0;
+	voice->cache = entry;
+	return 1;
 }
-/* END LOWPASS IMPLEMENTATION */
 
-/* BEGIN HIGHPASS IMPLEMENTATION */
-cd_highpass_t* cd_make_highpass_filter(cd_context_t* context)
+static void cd_begin_render(cd_context_t* context, cd_render_entry_t* entry)
 {
-	cd_highpass_t* filter = NULL;
-	CUTE_DSP_ASSERT(context);
+	cd_render_cache_t* cache = &context->render_cache;
+	const cd_render_key_t* key = &entry->key;
+	cd_context_t* render_context = cache->render_context;
 
-	filter = (cd_highpass_t*)cd_memory_pool_alloc(&context->highpass_filters);
-	CUTE_DSP_ASSERT(filter);
+	if (!render_context)
+	{
+		cd_context_def_t def = context->def;
+		def.playing_pool_count = 1;	// one stereo chain
+		def.echo_max_delay_s = context->echo_max_delay_s;
+		def.use_noise = 0;
+		def.use_reverb = 0;
+		def.render_cache_bytes = 0;
+		render_context = cache->render_context = cd_make_context(NULL, def);
+	}
 
-	filter->sampling_rate = context->sampling_rate;
-	cd_set_highpass_cutoff_frequency(filter, CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF);
-	filter->x1 = filter->x2 = filter->y1 = filter->y2 = 0;
-	filter->next = 0;
-	return filter;
+	// the same filter types the plugins run, set up with the parameters of the key
+	cache->lowpass = 0;
+	cache->highpass = 0;
+	cache->echo = 0;
+	if (context->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		cd_lowpass_t* lowpass = cache->lowpass = cd_make_lowpass_channels(render_context, entry->channel_count);
+		for (; lowpass; lowpass = lowpass->next)
+			cd_set_lowpass_parameters(lowpass, key->lowpass_cutoff, key->lowpass_resonance);
+	}
+	if (context->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		cache->highpass = cd_make_highpass_channels(render_context, entry->channel_count);
+		cd_set_highpass_cutoff_frequency(cache->highpass, key->highpass_cutoff);
+	}
+	if (context->echo_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		cd_echo_t* echo = cache->echo = cd_make_echo_channels(render_context, entry->channel_count);
+		for (; echo; echo = echo->next)
+			echo->offset = key->echo_offset;
+		cd_apply_echo_mix(cache->echo, key->echo_mix);
+		cd_apply_echo_feedback(cache->echo, key->echo_feedback);
+	}
 }
 
-void cd_release_highpass(cd_context_t* context, cd_highpass_t** filter)
+static void cd_end_render(cd_render_cache_t* cache)
 {
-	CUTE_DSP_ASSERT(context && filter && *filter);
-	cd_memory_pool_free(&context->highpass_filters, *filter);
-	*filter = NULL;
+	cd_context_t* render_context = cache->render_context;
+	if (cache->lowpass)
+	{
+		if (cache->lowpass->next)
+			cd_release_lowpass(render_context, &cache->lowpass->next);
+		cd_release_lowpass(render_context, &cache->lowpass);
+	}
+	if (cache->highpass)
+	{
+		if (cache->highpass->next)
+			cd_release_highpass(render_context, &cache->highpass->next);
+		cd_release_highpass(render_context, &cache->highpass);
+	}
+	if (cache->echo)
+	{
+		if (cache->echo->next)
+			cd_release_echo_filter(render_context, &cache->echo->next);
+		cd_release_echo_filter(render_context, &cache->echo);
+	}
 }
 
-static void cd_set_highpass_cutoff_frequency_radians(cd_highpass_t* filter, float cutoff_freq_in_rad)
+static void cd_render_slice(cd_render_cache_t* cache, cd_render_entry_t* entry, unsigned count)
 {
-	float T = cutoff_freq_in_rad / filter->sampling_rate;
-	float Y = 1.f / (1 + CUTE_DSP_SQRT_2 * T + T * T);
-	filter->x_coeff = Y;
-	filter->x1_coeff = -2.f * Y;
-	filter->y1_coeff = (2.f + CUTE_DSP_SQRT_2 * T) * Y;
-	filter->y2_coeff = -Y;
+	cd_context_t* render_context = cache->render_context;
+	float input[CUTE_DSP_MAX_FRAME_LENGTH];
+	unsigned total = entry->frames + entry->tail_frames;
+	unsigned start = entry->rendered;
+	unsigned channel;
+
+	for (channel = 0; channel < entry->channel_count; ++channel)
+	{
+		const float* source = (const float*)entry->key.sound->channels[channel];
+		const float* samples = input;
+		float* out;
+
+		// past the end of the sound the filters ring out on silence
+		if (start + count <= entry->frames)
+		{
+			samples = source + start;
+		}
+		else
+		{
+			unsigned available = start < entry->frames ? entry->frames - start : 0;
+			memcpy(input, source + start, sizeof(float) * available);
+			memset(input + available, 0, sizeof(float) * (count - available));
+		}
+
+		if (cache->lowpass)
+		{
+			cd_sample_lowpass(render_context, channel ? cache->lowpass->next : cache->lowpass, samples, &out, count);
+			samples = out;
+		}
+		if (cache->highpass)
+		{
+			cd_sample_highpass(render_context, channel ? cache->highpass->next : cache->highpass, samples, &out, count);
+			samples = out;
+		}
+		if (cache->echo)
+		{
+			cd_sample_echo(render_context, channel ? cache->echo->next : cache->echo, samples, &out, count);
+			samples = out;
+		}
+		memcpy(entry->samples + channel * total + start, samples, sizeof(float) * count);
+	}
+	entry->rendered += count;
 }
 
-void cd_set_highpass_cutoff_frequency(cd_highpass_t* filter, float cutoff_freq_in_hz)
+int cd_update_render_cache(cd_context_t* context, unsigned max_frames)
 {
-	filter->freq_cutoff = cutoff_freq_in_hz;
-	float freq_in_rad = 2.f * CUTE_DSP_PI * cutoff_freq_in_hz;
+	cd_render_cache_t* cache;
+	cd_render_entry_t* entry;
+	int pending = 0;
+	CUTE_DSP_ASSERT(context);
+
+	cache = &context->render_cache;
+	while (max_frames)
+	{
+		unsigned count;
+		if (!cache->rendering)
+		{
+			// oldest request first
+			cd_lock(&cache->lock);
+			for (entry = cache->oldest; entry && entry->ready; entry = entry->prev);
+			cache->rendering = entry;
+			cd_unlock(&cache->lock);
+			if (!entry)
+				break;
+			cd_begin_render(context, entry);
+		}
+
+		entry = cache->rendering;
+		count = entry->frames + entry->tail_frames - entry->rendered;
+		if (count > max_frames) count = max_frames;
+		if (count > CUTE_DSP_MAX_FRAME_LENGTH) count = CUTE_DSP_MAX_FRAME_LENGTH;
+		cd_render_slice(cache, entry, count);
+		max_frames -= count;
+
+		if (entry->rendered == entry->frames + entry->tail_frames)
+		{
+			cd_end_render(cache);
+			cd_lock(&cache->lock);
+			entry->ready = 1;
+			cache->rendering = 0;
+			cd_unlock(&cache->lock);
+		}
+	}
+
+	cd_lock(&cache->lock);
+	for (entry = cache->newest; entry; entry = entry->next)
+		pending += !entry->ready;
+	cd_unlock(&cache->lock);
+	return pending;
+}
+
+void cd_evict_render_cache(cd_context_t* context, const cs_loaded_sound_t* loaded_sound)
+{
+	cd_render_cache_t* cache;
+	cd_render_entry_t* entry;
+	cd_render_entry_t* evicted = 0;
+	CUTE_DSP_ASSERT(context);
+
+	cache = &context->render_cache;
+	cd_lock(&cache->lock);
+	if (cache->rendering && (!loaded_sound || cache->rendering->key.sound == loaded_sound))
+	{
+		cd_end_render(cache);
+		cache->rendering = 0;
+	}
 
-	cd_set_highpass_cutoff_frequency_radians(filter, freq_in_rad);
-	if(filter->next)
+	entry = cache->newest;
+	while (entry)
 	{
-		cd_set_highpass_cutoff_frequency_radians(filter->next, freq_in_rad);
+		cd_render_entry_t* next = entry->next;
+		if (!loaded_sound || entry->key.sound == loaded_sound)
+		{
+			if (entry->refs)
+			{
+				// still playing, never match again and let the LRU drop it once released
+				entry->key.sound = 0;
+			}
+			else
+			{
+				cd_unlink_render_entry(cache, entry);
+				cache->bytes -= entry->bytes;
+				entry->next = evicted;
+				evicted = entry;
+			}
+		}
+		entry = next;
 	}
+	cd_unlock(&cache->lock);
+
+	cd_free_render_entries(evicted);
 }
 
-void cd_set_highpass_cutoff(cs_playing_sound_t* playing_sound, float cutoff_freq_in_hz)
+cd_render_cache_stats_t cd_get_render_cache_stats(cd_context_t* context)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_render_cache_stats_t stats;
+	cd_render_cache_t* cache;
+	cd_render_entry_t* entry;
+	CUTE_DSP_ASSERT(context);
 
-	cd_highpass_t* filter = (cd_highpass_t*)playing_sound->plugin_udata[ctx->highpass_id];
-	cd_set_highpass_cutoff_frequency(filter, cutoff_freq_in_hz);
+	cache = &context->render_cache;
+	memset(&stats, 0, sizeof(stats));
+	cd_lock(&cache->lock);
+	for (entry = cache->newest; entry; entry = entry->next)
+	{
+		++stats.entries;
+		stats.pending += !entry->ready;
+	}
+	stats.bytes = cache->bytes;
+	stats.budget = cache->budget;
+	stats.hits = cache->hits;
+	stats.misses = cache->misses;
+	stats.evictions = cache->evictions;
+	cd_unlock(&cache->lock);
+	return stats;
 }
 
-float cd_get_highpass_cutoff_frequency(const cd_highpass_t* filter)
+static void cd_release_render_cache(cd_context_t* context)
 {
-	return filter->freq_cutoff;
+	cd_render_cache_t* cache = &context->render_cache;
+	if (cache->rendering)
+		cd_end_render(cache);
+	cd_free_render_entries(cache->newest);
+	if (cache->render_context)
+		cd_release_context(&cache->render_context);
+	memset(cache, 0, sizeof(cd_render_cache_t));
 }
 
-float cd_get_highpass_cutoff(const cs_playing_sound_t* playing_sound)
+static void cd_release_render_reference(cd_context_t* context, cd_voice_t* voice)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID);
-
-	const cd_highpass_t* filter = (const cd_highpass_t*)playing_sound->plugin_udata[ctx->highpass_id];
-	return cd_get_highpass_cutoff_frequency(filter);
+	cd_render_cache_t* cache = &context->render_cache;
+	cd_lock(&cache->lock);
+	--voice->cache->refs;
+	cd_unlock(&cache->lock);
+	voice->cache = 0;
 }
 
-void cd_sample_highpass(cd_context_t* context, cd_highpass_t* filter, const float* input, float** output, unsigned num_samples)
+static void cd_mix_cached_voice(cd_context_t* context, cd_voice_t* voice, int channel_index, int sample_count, float** samples_out)
 {
-	unsigned i = 0;
-	float* samples = context->current_output;
-
-	for(; i < num_samples; ++i)
+	const cd_render_entry_t* entry = voice->cache;
+	unsigned total = entry->frames + entry->tail_frames;
+	const float* source = entry->samples + ((unsigned)channel_index < entry->channel_count ? channel_index : 0) * total;
+	unsigned position = voice->cache_position;
+	unsigned loops = voice->cache_loops;
+	int i;
+
+	if (!loops && position + sample_count <= entry->frames)
 	{
-		*samples = filter->x_coeff  * *input +
-					filter->x1_coeff * filter->x1 +
-					filter->x_coeff  * filter->x2 +
-					filter->y1_coeff * filter->y1 +
-					filter->y2_coeff * filter->y2;
-		filter->x2 = filter->x1;
-		filter->x1 = *input++;
-		filter->y2 = filter->y1;
-		filter->y1 = *samples++;
+		// first pass through the sound, play straight out of the entry
+		*samples_out = (float*)source + position;
+		position += sample_count;
+	}
+	else
+	{
+		float* samples = context->current_output;
+		for (i = 0; i < sample_count; ++i)
+		{
+			float sample = 0.f;
+			if (position == entry->frames && voice->sound->looped)
+			{
+				position = 0;
+				++loops;
+			}
+			if (position < entry->frames)
+			{
+				// tails of the previous passes ring on into this one
+				unsigned tail = position + entry->frames;
+				unsigned pass;
+				sample = source[position++];
+				for (pass = 0; pass < loops && tail < total; ++pass, tail += entry->frames)
+					sample += source[tail];
+			}
+			samples[i] = sample;
+		}
+		*samples_out = samples;
+		cd_context_swap_buffers(context);
 	}
 
-	*output = context->current_output;
-	cd_context_swap_buffers(context);
+	// channels of a block share the playback position
+	if (channel_index == (int)voice->channel_count - 1)
+	{
+		voice->cache_position = position;
+		voice->cache_loops = loops;
+	}
 }
-/* END HIGHPASS IMPLEMENTATION */
-
-/* BEGIN ECHO IMPLEMENTATION */
 
-cd_echo_t* cd_make_echo_filter(cd_context_t* context)
+static void cd_parameter_changed(cd_context_t* context, const cs_playing_sound_t* playing_sound, int parameter, float value)
 {
-	cd_echo_t* filter = NULL;
-	CUTE_DSP_ASSERT(context);
+	cd_voice_t* voice = (cd_voice_t*)playing_sound->plugin_udata[context->voice_id];
+	if (voice->cache)
+		voice->cache_detach = 1;
+	cd_capture_parameter(context, playing_sound, parameter, value);
+}
 
-	filter = (cd_echo_t*)cd_memory_pool_alloc(&context->echo_filters);
-	CUTE_DSP_ASSERT(filter);
+/* END RENDER CACHE IMPLEMENTATION */
 
-	filter->sampling_rate = context->sampling_rate;
-	filter->max_samples = context->echo_max_delay_s * filter->sampling_rate;
-	filter->feedback = 0.f;
-	filter->offset = 0.f;
-	filter->mix = 0.f;
-	cd_ring_buffer_init(&filter->xvalues, (int)filter->max_samples);
-	cd_ring_buffer_init(&filter->yvalues, (int)filter->max_samples);
-	filter->next = NULL;
+/* BEGIN CAPTURE IMPLEMENTATION */
+/*
+	Capture file layout, every value is stored native (little) endian:
+		header  "CDCP", u32 version, f32 sampling_rate, u32 playing_pool_count, u32 flags (filter_order above bit 8),
+		        f32 echo_max_delay_s, u64 rand_seed, u64 prng a, u64 prng b
+		events  u8 event followed by
+		        SPAWN      u32 block, u32 voice, u8 channel_count
+		        FREE       u32 block, u32 voice
+		        PARAMETER  u32 block, u32 voice, u8 cd_capture_parameter_t, f32 value
+		        MIX        u32 voice, u8 channel, u16 sample_count, f32 samples[sample_count] if CD_CAPTURE_FLAG_INPUT
+	Mix events carry no block index, the replay recovers it the same way the voice plugin does.
+	Noise is keyed by the voice id, voices playing when the capture began record where their noise is at.
+*/
+#define CUTE_DSP_CAPTURE_VERSION (2)
+#define CUTE_DSP_CAPTURE_HEADER_SIZE (48)
+#define CUTE_DSP_CAPTURE_BUFFER_SIZE (1 << 20)
 
-	return filter;
+enum
+{
+	CD_CAPTURE_FLAG_LOWPASS        = 1 << 0,
+	CD_CAPTURE_FLAG_HIGHPASS       = 1 << 1,
+	CD_CAPTURE_FLAG_ECHO           = 1 << 2,
+	CD_CAPTURE_FLAG_NOISE          = 1 << 3,
+	CD_CAPTURE_FLAG_INPUT          = 1 << 4,
+	CD_CAPTURE_FLAG_LINKWITZ_RILEY = 1 << 5,
+	CD_CAPTURE_FLAG_CHORUS         = 1 << 6,
+	CD_CAPTURE_FILTER_ORDER_SHIFT  = 8
+};
+
+static unsigned char* cd_capture_write(unsigned char* at, const void* value, unsigned size)
+{
+	memcpy(at, value, size);
+	return at + size;
 }
 
-void cd_release_echo_filter(cd_context_t* context, cd_echo_t** filter)
+// while the capture lock is held, sets the buffer aside when it is full and the other one was written
+static void cd_capture_swap(cd_capture_t* capture)
 {
-	CUTE_DSP_ASSERT(context && filter && *filter);
-	cd_ring_buffer_release(&(*filter)->xvalues);
-	cd_ring_buffer_release(&(*filter)->yvalues);
-	cd_memory_pool_free(&context->echo_filters, *filter);
-	*filter = NULL;
+	unsigned char* empty = capture->pending;
+	capture->pending = capture->buffer;
+	capture->pending_size = capture->size;
+	capture->buffer = empty;
+	capture->size = 0;
 }
 
-void cd_set_echo_delay(cs_playing_sound_t* playing_sound, float t)
+// must be called with the capture lock held, NULL once both buffers are full, after which every event is dropped
+static unsigned char* cd_capture_reserve(cd_capture_t* capture, unsigned size)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
-	if (t > ctx->echo_max_delay_s) return;
-	cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
-	filter->offset = t * filter->sampling_rate;
+	unsigned char* at;
+	if (!capture->dropped && capture->size + size > CUTE_DSP_CAPTURE_BUFFER_SIZE && !capture->pending_size)
+		cd_capture_swap(capture);
+	if (capture->dropped || capture->size + size > CUTE_DSP_CAPTURE_BUFFER_SIZE)
+	{
+		++capture->dropped;
+		return NULL;
+	}
+	at = capture->buffer + capture->size;
+	capture->size += size;
+	return at;
 }
 
-void cd_set_echo_mix(cs_playing_sound_t* playing_sound, float a)
+static void cd_capture_voice(cd_context_t* context, const cd_voice_t* voice, int event)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_capture_t* capture = &context->capture;
+	unsigned char* at;
+	unsigned char type = (unsigned char)event;
+	unsigned char channel_count = (unsigned char)voice->channel_count;
 
-	cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
-	filter->mix = a;
+	cd_lock(&capture->lock);
+	if (capture->file && (at = cd_capture_reserve(capture, event == CD_CAPTURE_SPAWN ? 10 : 9)))
+	{
+		at = cd_capture_write(at, &type, 1);
+		at = cd_capture_write(at, &context->block_index, 4);
+		at = cd_capture_write(at, &voice->id, 4);
+		if (event == CD_CAPTURE_SPAWN)
+			cd_capture_write(at, &channel_count, 1);
+	}
+	cd_unlock(&capture->lock);
 }
 
-void cd_set_echo_feedback(cs_playing_sound_t* playing_sound, float b)
+static void cd_capture_voice_parameter(cd_context_t* context, const cd_voice_t* voice, int parameter, float value)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_capture_t* capture = &context->capture;
+	unsigned char* at;
+	unsigned char type = CD_CAPTURE_PARAMETER;
+	unsigned char param = (unsigned char)parameter;
 
-	cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
-	filter->feedback = b;
+	cd_lock(&capture->lock);
+	if (capture->file && (at = cd_capture_reserve(capture, 14)))
+	{
+		at = cd_capture_write(at, &type, 1);
+		at = cd_capture_write(at, &context->block_index, 4);
+		at = cd_capture_write(at, &voice->id, 4);
+		at = cd_capture_write(at, &param, 1);
+		cd_capture_write(at, &value, 4);
+	}
+	cd_unlock(&capture->lock);
 }
 
-float cd_get_echo_delay(const cs_playing_sound_t* playing_sound)
+static void cd_capture_parameter(cd_context_t* context, const cs_playing_sound_t* playing_sound, int parameter, float value)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
-
-	const cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
-	return filter->offset / filter->sampling_rate;
+	if (!context->capture.file)
+		return;
+	cd_capture_voice_parameter(context, (const cd_voice_t*)playing_sound->plugin_udata[context->voice_id], parameter, value);
 }
 
-float cd_get_echo_mix(const cs_playing_sound_t* playing_sound)
+static void cd_capture_parameters(cd_context_t* context, cs_playing_sound_t** playing_sounds, int parameter, const float* values, int count)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
-
-	const cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
-	return filter->mix;
+	cd_capture_t* capture = &context->capture;
+	unsigned char* at;
+	unsigned char type = CD_CAPTURE_PARAMETER;
+	unsigned char param = (unsigned char)parameter;
+	int i = 0;
+
+	cd_lock(&capture->lock);
+	for (; capture->file && i < count; ++i)
+	{
+		const cd_voice_t* voice = (const cd_voice_t*)playing_sounds[i]->plugin_udata[context->voice_id];
+		at = cd_capture_reserve(capture, 14);
+		if (!at)
+			continue;
+		at = cd_capture_write(at, &type, 1);
+		at = cd_capture_write(at, &context->block_index, 4);
+		at = cd_capture_write(at, &voice->id, 4);
+		at = cd_capture_write(at, &param, 1);
+		cd_capture_write(at, values + i, 4);
+	}
+	cd_unlock(&capture->lock);
 }
 
-float cd_get_echo_feedback(const cs_playing_sound_t* playing_sound)
+static void cd_capture_voice_mix(cd_context_t* context, const cd_voice_t* voice, int channel_index, const float* samples, int sample_count)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->echo_id != CUTE_DSP_INVALID_PLUGIN_ID);
+	cd_capture_t* capture = &context->capture;
+	unsigned char* at;
+	unsigned char type = CD_CAPTURE_MIX;
+	unsigned char channel = (unsigned char)channel_index;
+	unsigned short count = (unsigned short)sample_count;
+	unsigned input_size;
+
+	cd_lock(&capture->lock);
+	input_size = capture->capture_input ? sizeof(float) * count : 0;
+	if (capture->file && (at = cd_capture_reserve(capture, 8 + input_size)))
+	{
+		at = cd_capture_write(at, &type, 1);
+		at = cd_capture_write(at, &voice->id, 4);
+		at = cd_capture_write(at, &channel, 1);
+		at = cd_capture_write(at, &count, 2);
+		if (input_size)
+			cd_capture_write(at, samples, input_size);
+	}
+	cd_unlock(&capture->lock);
+}
 
-	const cd_echo_t* filter = (cd_echo_t*)playing_sound->plugin_udata[ctx->echo_id];
-	return filter->feedback;
+// records the parameters of a voice that was already playing when the capture began
+static void cd_capture_voice_snapshot(cd_context_t* context, const cd_voice_t* voice)
+{
+	const cs_playing_sound_t* sound = voice->sound;
+	unsigned i = 0;
+	cd_capture_voice(context, voice, CD_CAPTURE_SPAWN);
+	if (context->lowpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		const cd_lowpass_t* lowpass = (const cd_lowpass_t*)sound->plugin_udata[context->lowpass_id];
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_LOWPASS_CUTOFF, lowpass->freq_cutoff);
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_LOWPASS_RESONANCE, lowpass->resonance);
+	}
+	if (context->highpass_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		const cd_highpass_t* highpass = (const cd_highpass_t*)sound->plugin_udata[context->highpass_id];
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_HIGHPASS_CUTOFF, highpass->freq_cutoff);
+	}
+	if (context->echo_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		const cd_echo_t* echo = (const cd_echo_t*)sound->plugin_udata[context->echo_id];
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_ECHO_DELAY, echo->offset / echo->sampling_rate);
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_ECHO_MIX, echo->mix);
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_ECHO_FEEDBACK, echo->feedback);
+	}
+	if (context->noise_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		const cd_noise_t* noise = (const cd_noise_t*)sound->plugin_udata[context->noise_id];
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_NOISE_GAIN, noise->amplitude_gain);
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_NOISE_SEEK_HIGH, (float)(noise->position >> 16));
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_NOISE_SEEK_LOW, (float)(noise->position & 0xffff));
+		if (noise->color != CD_NOISE_WHITE)
+			cd_capture_voice_parameter(context, voice, CD_CAPTURE_NOISE_COLOR, (float)noise->color);
+	}
+	if (context->chorus_id != CUTE_DSP_INVALID_PLUGIN_ID)
+	{
+		const cd_chorus_t* chorus = (const cd_chorus_t*)sound->plugin_udata[context->chorus_id];
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_CHORUS_DELAY, chorus->delay / chorus->sampling_rate);
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_CHORUS_DEPTH, chorus->depth / chorus->sampling_rate);
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_CHORUS_RATE, chorus->rate);
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_CHORUS_MIX, chorus->mix);
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_CHORUS_FEEDBACK, chorus->feedback);
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_CHORUS_TAPS, (float)chorus->taps);
+	}
+	if (voice->dry_gain != 1.f)
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_DRY_GAIN, voice->dry_gain);
+	if (voice->quality.requested != CD_TIER_FULL)
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_QUALITY_TIER, (float)voice->quality.requested);
+	if (voice->quality.priority_db != 0.f)
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_PRIORITY, voice->quality.priority_db);
+	if (voice->quality.cap != CD_TIER_FULL)
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_GOVERNOR_CAP, (float)voice->quality.cap);
+	if (voice->multirate.limit > 1)
+		cd_capture_voice_parameter(context, voice, CD_CAPTURE_MULTIRATE_LIMIT, (float)voice->multirate.limit);
+	for (; i < context->bus_count; ++i)
+		if (voice->sends[i] != 0.f)
+			cd_capture_voice_parameter(context, voice, CD_CAPTURE_BUS_SEND + (int)i, voice->sends[i]);
 }
 
-float cd_get_echo_max_delay(const cs_playing_sound_t* playing_sound)
+int cd_begin_capture(cd_context_t* context, const char* path, int capture_input)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	(void)playing_sound; /* unused parameter */
-	return ctx->echo_max_delay_s;
+	unsigned char header[CUTE_DSP_CAPTURE_HEADER_SIZE];
+	unsigned char* at = header;
+	unsigned version = CUTE_DSP_CAPTURE_VERSION;
+	unsigned flags = 0;
+	unsigned long long seed = (unsigned long long)context->def.rand_seed;
+	unsigned long long prng_a = (unsigned long long)context->random_generator.a;
+	unsigned long long prng_b = (unsigned long long)context->random_generator.b;
+	const cd_voice_t* voice;
+	FILE* file;
+
+	CUTE_DSP_ASSERT(context && path && !context->capture.file);
+	file = fopen(path, "wb");
+	if (!file)
+		return 0;
+
+	if (context->def.use_lowpass) flags |= CD_CAPTURE_FLAG_LOWPASS;
+	if (context->def.use_highpass) flags |= CD_CAPTURE_FLAG_HIGHPASS;
+	if (context->def.use_echo) flags |= CD_CAPTURE_FLAG_ECHO;
+	if (context->def.use_noise) flags |= CD_CAPTURE_FLAG_NOISE;
+	if (context->def.use_chorus) flags |= CD_CAPTURE_FLAG_CHORUS;
+	if (capture_input) flags |= CD_CAPTURE_FLAG_INPUT;
+	if (context->def.filter_alignment == CD_FILTER_LINKWITZ_RILEY) flags |= CD_CAPTURE_FLAG_LINKWITZ_RILEY;
+	flags |= context->def.filter_order << CD_CAPTURE_FILTER_ORDER_SHIFT;
+
+	at = cd_capture_write(at, "CDCP", 4);
+	at = cd_capture_write(at, &version, 4);
+	at = cd_capture_write(at, &context->sampling_rate, 4);
+	at = cd_capture_write(at, &context->def.playing_pool_count, 4);
+	at = cd_capture_write(at, &flags, 4);
+	at = cd_capture_write(at, &context->echo_max_delay_s, 4);
+	at = cd_capture_write(at, &seed, 8);
+	at = cd_capture_write(at, &prng_a, 8);
+	cd_capture_write(at, &prng_b, 8);
+	fwrite(header, 1, sizeof(header), file);
+
+	context->capture.buffer = (unsigned char*)CUTE_DSP_ALLOC(CUTE_DSP_CAPTURE_BUFFER_SIZE, 0);
+	context->capture.pending = (unsigned char*)CUTE_DSP_ALLOC(CUTE_DSP_CAPTURE_BUFFER_SIZE, 0);
+	CUTE_DSP_ASSERT(context->capture.buffer && context->capture.pending);
+	context->capture.size = context->capture.pending_size = 0;
+	context->capture.dropped = 0;
+	context->capture.capture_input = capture_input;
+
+	cd_lock(&context->capture.lock);
+	context->capture.file = file;
+	cd_unlock(&context->capture.lock);
+
+	cd_lock(&context->voice_lock);
+	for (voice = context->active_voices; voice; voice = voice->next_active)
+		cd_capture_voice_snapshot(context, voice);
+	cd_unlock(&context->voice_lock);
+	return 1;
 }
 
-void cd_sample_echo(cd_context_t* context, cd_echo_t* filter, const float* input, float** output, unsigned num_samples)
+// the buffer set aside by the mix thread first, then the one it fills, the lock is let go while writing
+void cd_flush_capture(cd_context_t* context)
 {
-	int i = 0; 
-	float* samples = context->current_output;
-	float out;
-	float startInd, endInd, factor;
-	float ystart, yend, yresult;
-	float xstart, xend, xresult;
-	for (; i < (int)num_samples; ++i)
+	cd_capture_t* capture = &context->capture;
+	int i = 0;
+	for (; i < 2; ++i)
 	{
-		out = *input;
-		startInd = (float)(int)filter->offset; // floor
-		endInd = startInd + 1;
-		factor = filter->offset - startInd;
-
-		ystart = cd_ring_buffer_get(&filter->yvalues, (int)startInd);
-		yend = cd_ring_buffer_get(&filter->yvalues, (int)endInd);
-		yresult = CUTE_DSP_LERP_FLOAT(ystart, yend, (int)factor);
-
-		xstart = cd_ring_buffer_get(&filter->xvalues, (int)startInd);
-		xend = cd_ring_buffer_get(&filter->xvalues, (int)endInd);
-		xresult = CUTE_DSP_LERP_FLOAT(xstart, xend, factor);
-
-		out += (filter->mix - filter->feedback) * xresult + filter->feedback * yresult;
-
-		cd_ring_buffer_put(&filter->yvalues, out);
-		cd_ring_buffer_put(&filter->xvalues, *input++);
-
-		*samples++ = out;
+		const unsigned char* pending;
+		unsigned size;
+		FILE* file;
+		cd_lock(&capture->lock);
+		if (capture->file && !capture->pending_size && capture->size)
+			cd_capture_swap(capture);
+		file = capture->file;
+		pending = capture->pending;
+		size = capture->pending_size;
+		cd_unlock(&capture->lock);
+		if (!file || !size)
+			return;
+
+		// the mix thread leaves the pending buffer alone until its size is cleared
+		fwrite(pending, 1, size, file);
+		cd_lock(&capture->lock);
+		capture->pending_size = 0;
+		cd_unlock(&capture->lock);
 	}
-	
-	*output = context->current_output;
-	cd_context_swap_buffers(context);
 }
-/* END ECHO IMPLEMENTATION */
 
-/* BEGIN NOISE IMPLEMENTATION */
-cd_noise_t* cd_make_noise_generator(cd_context_t* context)
+unsigned cd_get_dropped_capture_events(const cd_context_t* context)
 {
-	cd_noise_t* filter = NULL;
 	CUTE_DSP_ASSERT(context);
-
-	filter = (cd_noise_t*)cd_memory_pool_alloc(&context->noise_generators);
-	CUTE_DSP_ASSERT(filter);
-
-	filter->amplitude_db = CUTE_DSP_NOISE_INAUDIBLE;
-	filter->amplitude_gain = CUTE_DSP_DB_TO_GAIN(filter->amplitude_db);
-	filter->next = 0;
-	return filter;
+	return context->capture.dropped;
 }
 
-void cd_release_noise(cd_context_t* context, cd_noise_t** filter)
+void cd_end_capture(cd_context_t* context)
 {
-	CUTE_DSP_ASSERT(context && filter && *filter);
-	cd_memory_pool_free(&context->noise_generators, *filter);
-	*filter = NULL;
+	cd_capture_t* capture = &context->capture;
+	FILE* file;
+	cd_flush_capture(context);
+
+	// events the mix thread added since are written once it can't add more
+	cd_lock(&capture->lock);
+	file = capture->file;
+	capture->file = NULL;
+	cd_unlock(&capture->lock);
+	if (!file)
+		return;
+	fwrite(capture->pending, 1, capture->pending_size, file);
+	fwrite(capture->buffer, 1, capture->size, file);
+	fclose(file);
+	CUTE_DSP_FREE(capture->buffer, 0);
+	CUTE_DSP_FREE(capture->pending, 0);
+	capture->buffer = capture->pending = NULL;
+	capture->size = capture->pending_size = 0;
 }
 
-void cd_set_noise_amplitude_db(cs_playing_sound_t* playing_sound, float db)
+/* END CAPTURE IMPLEMENTATION */
+
+/* BEGIN REPLAY IMPLEMENTATION */
+typedef struct cd_replay_voice_t
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
-	cd_noise_t* filter = (cd_noise_t*)playing_sound->plugin_udata[ctx->noise_id];
-	filter->amplitude_db = db;
-	filter->amplitude_gain = CUTE_DSP_DB_TO_GAIN(db);
+	unsigned id; // 0 marks an empty slot
+	unsigned mixed_block;
+	cd_lowpass_t* lowpass;
+	cd_highpass_t* highpass;
+	cd_echo_t* echo;
+	cd_noise_t* noise;
+	cd_chorus_t* chorus;
+	float dry_gain;
+	cd_quality_t quality;
+	cd_multirate_t multirate;
+} cd_replay_voice_t;
+
+#define cd_replay_hash(id, mask) (((id) * 2654435761u) & (mask))
+
+// open addressing with linear probing, returns the voice or the empty slot it belongs in
+static cd_replay_voice_t* cd_replay_find_voice(cd_replay_voice_t* voices, unsigned mask, unsigned id)
+{
+	unsigned i = cd_replay_hash(id, mask);
+	while (voices[i].id && voices[i].id != id)
+		i = (i + 1) & mask;
+	return voices + i;
 }
 
-void cd_set_noise_amplitude_gain(cs_playing_sound_t* playing_sound, float gain)
+// backward shift deletion keeps probe sequences intact without tombstones
+static void cd_replay_remove_voice(cd_replay_voice_t* voices, unsigned mask, cd_replay_voice_t* voice)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
-	cd_noise_t* filter = (cd_noise_t*)playing_sound->plugin_udata[ctx->noise_id];
-	filter->amplitude_gain = gain;
-	filter->amplitude_db = CUTE_DSP_GAIN_TO_DB(gain);
+	unsigned i = (unsigned)(voice - voices);
+	unsigned j = i;
+	voices[i].id = 0;
+	for (;;)
+	{
+		unsigned k;
+		j = (j + 1) & mask;
+		if (!voices[j].id)
+			break;
+		k = cd_replay_hash(voices[j].id, mask);
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+		voices[i] = voices[j];
+		voices[j].id = 0;
+		i = j;
+	}
 }
 
-float cd_get_noise_amplitude_db(const cs_playing_sound_t* playing_sound)
+// quality tiers aren't replayed while a tier is forced, see cd_replay_capture_at_tier
+static void cd_replay_parameter(cd_context_t* context, cd_replay_voice_t* voice, int parameter, float value, int forced_tier)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
-	cd_noise_t* filter = (cd_noise_t*)playing_sound->plugin_udata[ctx->noise_id];
-	return filter->amplitude_db;
+	switch (parameter)
+	{
+	case CD_CAPTURE_LOWPASS_CUTOFF:    if (voice->lowpass) cd_apply_lowpass_cutoff(voice->lowpass, value); break;
+	case CD_CAPTURE_LOWPASS_RESONANCE: if (voice->lowpass) cd_apply_lowpass_resonance(voice->lowpass, value); break;
+	case CD_CAPTURE_HIGHPASS_CUTOFF:   if (voice->highpass) cd_set_highpass_cutoff_frequency(voice->highpass, value); break;
+	case CD_CAPTURE_ECHO_DELAY:        if (voice->echo) cd_apply_echo_delay(context, voice->echo, value); break;
+	case CD_CAPTURE_ECHO_MIX:          if (voice->echo) cd_apply_echo_mix(voice->echo, value); break;
+	case CD_CAPTURE_ECHO_FEEDBACK:     if (voice->echo) cd_apply_echo_feedback(voice->echo, value); break;
+	case CD_CAPTURE_NOISE_DB:          if (voice->noise) cd_apply_noise_db(voice->noise, value); break;
+	case CD_CAPTURE_NOISE_GAIN:        if (voice->noise) cd_apply_noise_gain(voice->noise, value); break;
+	case CD_CAPTURE_DRY_GAIN:          voice->dry_gain = value; break;
+	case CD_CAPTURE_NOISE_COLOR:       if (voice->noise) cd_apply_noise_color(voice->noise, (cd_noise_color_t)(int)value); break;
+	case CD_CAPTURE_NOISE_SEEK_HIGH:   if (voice->noise) cd_seek_noise_generator(voice->noise, ((unsigned)value << 16) | (voice->noise->position & 0xffff)); break;
+	case CD_CAPTURE_NOISE_SEEK_LOW:    if (voice->noise) cd_seek_noise_generator(voice->noise, (voice->noise->position & 0xffff0000u) | (unsigned)value); break;
+	case CD_CAPTURE_QUALITY_TIER:      if (forced_tier < 0) voice->quality.requested = (cd_quality_tier_t)(int)value; break;
+	case CD_CAPTURE_PRIORITY:          voice->quality.priority_db = value; break;
+	case CD_CAPTURE_GOVERNOR_CAP:      if (forced_tier < 0) voice->quality.cap = (cd_quality_tier_t)(int)value; break;
+	case CD_CAPTURE_MULTIRATE_LIMIT:   cd_reduce_filters(voice->lowpass, voice->highpass, (unsigned)value); voice->multirate.limit = (unsigned)value; break;
+	case CD_CAPTURE_CHORUS_DELAY:      if (voice->chorus) cd_apply_chorus_delay(voice->chorus, value); break;
+	case CD_CAPTURE_CHORUS_DEPTH:      if (voice->chorus) cd_apply_chorus_depth(voice->chorus, value); break;
+	case CD_CAPTURE_CHORUS_RATE:       if (voice->chorus) cd_apply_chorus_rate(voice->chorus, value); break;
+	case CD_CAPTURE_CHORUS_MIX:        if (voice->chorus) cd_apply_chorus_mix(voice->chorus, value); break;
+	case CD_CAPTURE_CHORUS_FEEDBACK:   if (voice->chorus) cd_apply_chorus_feedback(voice->chorus, value); break;
+	case CD_CAPTURE_CHORUS_TAPS:       if (voice->chorus) cd_apply_chorus_taps(voice->chorus, (unsigned)value); break;
+	default:                           break; // bus sends aren't replayed, the buses aren't part of the voice chain
+	}
 }
 
-float cd_get_noise_amplitude_gain(const cs_playing_sound_t* playing_sound)
+// runs the filters in the order cd_make_context registers their plugins
+static const float* cd_replay_mix(cd_context_t* context, cd_replay_voice_t* voice, int channel_index, const float* samples, unsigned sample_count)
 {
-	CUTE_DSP_ASSERT(playing_sound);
-	cd_context_t* ctx = cd_get_context();
-	CUTE_DSP_ASSERT(ctx->noise_id != CUTE_DSP_INVALID_PLUGIN_ID);
-	cd_noise_t* filter = (cd_noise_t*)playing_sound->plugin_udata[ctx->noise_id];
-	return filter->amplitude_gain;
+	const cd_quality_t* quality = &voice->quality;
+	float* out;
+	if (voice->multirate.factor > 1 || voice->multirate.previous_factor > 1)
+	{
+		cd_mix_multirate(context, &voice->multirate, channel_index, voice->noise, voice->lowpass, voice->highpass, voice->echo, quality, samples, sample_count, &out);
+		samples = out;
+	}
+	else
+	{
+		if (voice->noise)
+		{
+			cd_noise_t* noise = channel_index ? voice->noise->next : voice->noise;
+			if (noise) { cd_sample_noise_tiers(context, noise, samples, &out, sample_count, quality); samples = out; }
+		}
+		if (voice->lowpass)
+		{
+			cd_lowpass_t* lowpass = channel_index ? voice->lowpass->next : voice->lowpass;
+			if (lowpass) { cd_sample_lowpass_tiers(context, lowpass, samples, &out, sample_count, quality); samples = out; }
+		}
+		if (voice->highpass)
+		{
+			cd_highpass_t* highpass = channel_index ? voice->highpass->next : voice->highpass;
+			if (highpass) { cd_sample_highpass_tiers(context, highpass, samples, &out, sample_count, quality); samples = out; }
+		}
+		if (voice->echo)
+		{
+			cd_echo_t* echo = channel_index ? voice->echo->next : voice->echo;
+			if (echo) { cd_sample_echo_tiers(context, echo, samples, &out, sample_count, quality); samples = out; }
+		}
+	}
+	if (voice->chorus)
+	{
+		cd_chorus_t* chorus = channel_index ? voice->chorus->next : voice->chorus;
+		if (chorus) { cd_sample_chorus_tiers(context, chorus, samples, &out, sample_count, quality); samples = out; }
+	}
+	if (voice->dry_gain != 1.f)
+	{
+		cd_apply_dry_gain(context, samples, &out, sample_count, voice->dry_gain);
+		samples = out;
+	}
+	return samples;
 }
 
-void cd_sample_noise(cd_context_t* context, cd_noise_t* filter, const float* input, float** output, unsigned num_samples)
+static int cd_replay(const void* data, size_t size, int forced_tier, cd_replay_stats_t* stats)
 {
-	unsigned i = 0;
-	float* samples = context->current_output;
-	cd_random_t* random = &context->random_generator;
-	float amplitude = filter->amplitude_gain;
+	const unsigned char* at = (const unsigned char*)data;
+	const unsigned char* end = at + size;
+	unsigned version, flags, capacity = 64, mask, i;
+	unsigned long long seed, prng_a, prng_b;
+	float input[CUTE_DSP_MAX_FRAME_LENGTH];
+	cd_replay_voice_t* voices;
+	cd_context_def_t def;
+	cd_context_t* context;
+	int valid = 1;
+
+	CUTE_DSP_ASSERT(data && stats);
+	memset(stats, 0, sizeof(cd_replay_stats_t));
+	stats->output_hash = 2166136261u;
+	if (size < CUTE_DSP_CAPTURE_HEADER_SIZE || memcmp(at, "CDCP", 4))
+		return 0;
+
+	memset(&def, 0, sizeof(def));
+	memcpy(&version, at + 4, 4);
+	memcpy(&def.sampling_rate, at + 8, 4);
+	memcpy(&def.playing_pool_count, at + 12, 4);
+	memcpy(&flags, at + 16, 4);
+	memcpy(&def.echo_max_delay_s, at + 20, 4);
+	memcpy(&seed, at + 24, 8);
+	memcpy(&prng_a, at + 32, 8);
+	memcpy(&prng_b, at + 40, 8);
+	at += CUTE_DSP_CAPTURE_HEADER_SIZE;
+	if (version != CUTE_DSP_CAPTURE_VERSION || !def.playing_pool_count)
+		return 0;
+
+	def.use_lowpass = (flags & CD_CAPTURE_FLAG_LOWPASS) != 0;
+	def.use_highpass = (flags & CD_CAPTURE_FLAG_HIGHPASS) != 0;
+	def.use_echo = (flags & CD_CAPTURE_FLAG_ECHO) != 0;
+	def.use_noise = (flags & CD_CAPTURE_FLAG_NOISE) != 0;
+	def.use_chorus = (flags & CD_CAPTURE_FLAG_CHORUS) != 0;
+	def.filter_alignment = (flags & CD_CAPTURE_FLAG_LINKWITZ_RILEY) ? CD_FILTER_LINKWITZ_RILEY : CD_FILTER_BUTTERWORTH;
+	def.filter_order = flags >> CD_CAPTURE_FILTER_ORDER_SHIFT;
+	def.rand_seed = (size_t)seed;
+	context = cd_make_context(NULL, def);
+	context->random_generator.a = (uint64_t)prng_a;
+	context->random_generator.b = (uint64_t)prng_b;
+
+	while (capacity < def.playing_pool_count * 4)
+		capacity *= 2;
+	mask = capacity - 1;
+	voices = (cd_replay_voice_t*)CUTE_DSP_ALLOC(sizeof(cd_replay_voice_t) * capacity, 0);
+	CUTE_DSP_ASSERT(voices);
+	memset(voices, 0, sizeof(cd_replay_voice_t) * capacity);
+	memset(input, 0, sizeof(input));
+
+	while (valid && at < end)
+	{
+		unsigned char event = *at++;
+		unsigned block, id;
+		cd_replay_voice_t* voice;
+		switch (event)
+		{
+		case CD_CAPTURE_SPAWN:
+		{
+			if (end - at < 9) { valid = 0; break; }
+			memcpy(&block, at, 4);
+			memcpy(&id, at + 4, 4);
+			int channel_count = at[8];
+			at += 9;
+			voice = cd_replay_find_voice(voices, mask, id);
+			CUTE_DSP_ASSERT(!voice->id);
+			memset(voice, 0, sizeof(cd_replay_voice_t));
+			voice->id = id;
+			voice->mixed_block = CUTE_DSP_INVALID_BLOCK;
+			voice->dry_gain = 1.f;
+			voice->quality.requested = forced_tier < 0 ? CD_TIER_FULL : (cd_quality_tier_t)forced_tier;
+			voice->quality.loudness_db = CUTE_DSP_QUALITY_REDUCED_DB;
+			voice->multirate.factor = voice->multirate.previous_factor = 1;
+			if (def.use_lowpass) voice->lowpass = cd_make_lowpass_channels(context, channel_count);
+			if (def.use_highpass) voice->highpass = cd_make_highpass_channels(context, channel_count);
+			if (def.use_echo) voice->echo = cd_make_echo_channels(context, channel_count);
+			if (def.use_noise)
+			{
+				voice->noise = cd_make_noise_channels(context, channel_count);
+				cd_set_noise_generator_stream(context, voice->noise, id, 0);
+			}
+			if (def.use_chorus) voice->chorus = cd_make_chorus_channels(context, channel_count);
+			++stats->spawns;
+			break;
+		}
+		case CD_CAPTURE_FREE:
+		{
+			if (end - at < 8) { valid = 0; break; }
+			memcpy(&block, at, 4);
+			memcpy(&id, at + 4, 4);
+			at += 8;
+			voice = cd_replay_find_voice(voices, mask, id);
+			if (!voice->id) break;
+			if (voice->lowpass) { if (voice->lowpass->next) cd_release_lowpass(context, &voice->lowpass->next); cd_release_lowpass(context, &voice->lowpass); }
+			if (voice->highpass) { if (voice->highpass->next) cd_release_highpass(context, &voice->highpass->next); cd_release_highpass(context, &voice->highpass); }
+			if (voice->echo) { if (voice->echo->next) cd_release_echo_filter(context, &voice->echo->next); cd_release_echo_filter(context, &voice->echo); }
+			if (voice->noise) { if (voice->noise->next) cd_release_noise(context, &voice->noise->next); cd_release_noise(context, &voice->noise); }
+			if (voice->chorus) { if (voice->chorus->next) cd_release_chorus(context, &voice->chorus->next); cd_release_chorus(context, &voice->chorus); }
+			cd_replay_remove_voice(voices, mask, voice);
+			++stats->frees;
+			break;
+		}
+		case CD_CAPTURE_PARAMETER:
+		{
+			float value;
+			if (end - at < 13) { valid = 0; break; }
+			memcpy(&block, at, 4);
+			memcpy(&id, at + 4, 4);
+			memcpy(&value, at + 9, 4);
+			voice = cd_replay_find_voice(voices, mask, id);
+			if (voice->id)
+				cd_replay_parameter(context, voice, at[8], value, forced_tier);
+			at += 13;
+			++stats->parameters;
+			break;
+		}
+		case CD_CAPTURE_MIX:
+		{
+			unsigned short count;
+			int channel_index;
+			const float* output;
+			if (end - at < 7) { valid = 0; break; }
+			memcpy(&id, at, 4);
+			channel_index = at[4];
+			memcpy(&count, at + 5, 2);
+			at += 7;
+			if (count > CUTE_DSP_MAX_FRAME_LENGTH) { valid = 0; break; }
+			if (flags & CD_CAPTURE_FLAG_INPUT)
+			{
+				if ((size_t)(end - at) < sizeof(float) * count) { valid = 0; break; }
+				memcpy(input, at, sizeof(float) * count);
+				at += sizeof(float) * count;
+			}
+
+			voice = cd_replay_find_voice(voices, mask, id);
+			if (!voice->id) break;
+			if (channel_index == 0)
+			{
+				if (voice->mixed_block == context->block_index)
+					++context->block_index;
+				voice->mixed_block = context->block_index;
+				cd_update_quality(&voice->quality, input, count);
+				cd_update_multirate(context, &voice->multirate, voice->lowpass, voice->highpass, &voice->quality, count);
+			}
+
+			output = cd_replay_mix(context, voice, channel_index, input, count);
+			stats->tier_samples[voice->quality.tier] += count;
+			for (i = 0; i < count; ++i)
+			{
+				unsigned bits;
+				memcpy(&bits, output + i, 4);
+				stats->output_hash = (stats->output_hash ^ bits) * 16777619u;
+			}
+			stats->samples += count;
+			++stats->mixes;
+			break;
+		}
+		default:
+			valid = 0;
+			break;
+		}
+	}
+	if (stats->mixes)
+		stats->blocks = context->block_index + 1;
 
-	for (; i < num_samples; ++i)
+	// release voices that were still playing when the capture ended
+	for (i = 0; i < capacity; ++i)
 	{
-		*samples++ = amplitude * cd_random_rand_between(random, -1.f, 1.f) + *input++;
+		cd_replay_voice_t* voice = voices + i;
+		if (!voice->id) continue;
+		if (voice->lowpass) { if (voice->lowpass->next) cd_release_lowpass(context, &voice->lowpass->next); cd_release_lowpass(context, &voice->lowpass); }
+		if (voice->highpass) { if (voice->highpass->next) cd_release_highpass(context, &voice->highpass->next); cd_release_highpass(context, &voice->highpass); }
+		if (voice->echo) { if (voice->echo->next) cd_release_echo_filter(context, &voice->echo->next); cd_release_echo_filter(context, &voice->echo); }
+		if (voice->noise) { if (voice->noise->next) cd_release_noise(context, &voice->noise->next); cd_release_noise(context, &voice->noise); }
+		if (voice->chorus) { if (voice->chorus->next) cd_release_chorus(context, &voice->chorus->next); cd_release_chorus(context, &voice->chorus); }
 	}
+	CUTE_DSP_FREE(voices, 0);
+	cd_release_context(&context);
+	return valid;
+}
 
-	*output = context->current_output;
-	cd_context_swap_buffers(context);
+int cd_replay_capture(const void* data, size_t size, cd_replay_stats_t* stats)
+{
+	return cd_replay(data, size, -1, stats);
 }
-/* END NOISE IMPLEMENTATION */
+
+int cd_replay_capture_at_tier(const void* data, size_t size, cd_quality_tier_t tier, cd_replay_stats_t* stats)
+{
+	CUTE_DSP_ASSERT(tier <= CD_TIER_AUTO);
+	return cd_replay(data, size, (int)tier, stats);
+}
+
+/* END REPLAY IMPLEMENTATION */
 
 /* END FUNCTION IMPLEMENTATION */
 
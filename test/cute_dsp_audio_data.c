@@ -10,6 +10,9 @@
 
     Revision history:
         1.0     (05/25/2019) initial release: implemented reading/writing wav files.
+        1.1     (10/18/2026) read files in binary mode, walk RIFF chunks, multichannel files.
+        1.2     (10/18/2026) memory mapped reading with tiled float conversion, buffered writing.
+        1.3     (10/18/2026) file mapping split out of the wav view.
 */
 #define _CRT_SECURE_NO_WARNINGS
 #include "cute_dsp_audio_data.h"
@@ -18,57 +21,235 @@
 #include <stdlib.h> /* malloc, free */
 #include <string.h> /* memcpy, memset */
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>    /* open */
+#include <unistd.h>   /* close */
+#include <sys/mman.h> /* mmap */
+#include <sys/stat.h> /* fstat */
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CUTE_DSP_AUDIO_DATA_SSE2
+#include <emmintrin.h>
+#endif
+
+#define CUTE_DSP_WAV_WRITER_CAPACITY (1 << 16) /* samples buffered before each fwrite */
+
 #define CUTE_DSP_ASSERT_INTERNAL *(int*)0 = 0
 #define CUTE_DSP_ASSERT(X) do { if(!(X)) CUTE_DSP_ASSERT_INTERNAL; } while (0)
 
 #define CUTE_DSP_ALLOC(size) malloc(size)
 #define CUTE_DSP_FREE(mem)   free(mem)
 
-cd_audio_data_t cd_read_wav_file(const char* filename)
+static unsigned cd_read_u32(const char* bytes)
 {
-    char header[44] = { 0 };
-    unsigned size, rate;
-    char* data = NULL;
-    cd_audio_data_t adata = { 0 };
-    FILE* file = fopen(filename, "r");
+    const unsigned char* b = (const unsigned char*)bytes;
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned)b[3] << 24);
+}
 
-    CUTE_DSP_ASSERT(file);
+static unsigned short cd_read_u16(const char* bytes)
+{
+    const unsigned char* b = (const unsigned char*)bytes;
+    return (unsigned short)(b[0] | (b[1] << 8));
+}
 
-    fread(header, sizeof(char), 44, file);
+int cd_open_file_view(cd_file_view_t* view, const char* filename, int sequential)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER size;
+    HANDLE file;
+#endif
+    CUTE_DSP_ASSERT(view);
+    memset(view, 0, sizeof(cd_file_view_t));
+#if defined(_WIN32)
+    file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) return 0;
+    if(!GetFileSizeEx(file, &size) || !size.QuadPart)
+    {
+        CloseHandle(file);
+        return 0;
+    }
+    view->file_handle = file;
+    view->mapping_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    view->mapping = view->mapping_handle ? MapViewOfFile(view->mapping_handle, FILE_MAP_READ, 0, 0, 0) : NULL;
+    view->mapping_size = (size_t)size.QuadPart;
+#else
+    struct stat info;
+    int file = open(filename, O_RDONLY);
+    if(file < 0) return 0;
+    if(fstat(file, &info) || !info.st_size)
+    {
+        close(file);
+        return 0;
+    }
+    view->mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    view->mapping_size = (size_t)info.st_size;
+    close(file); /* the mapping keeps its own reference */
+    if(view->mapping == MAP_FAILED)
+        view->mapping = NULL;
+    else if(sequential)
+        madvise(view->mapping, view->mapping_size, MADV_SEQUENTIAL);
+#endif
+    if(!view->mapping)
+    {
+        cd_close_file_view(view);
+        return 0;
+    }
+    return 1;
+}
 
-    size = *(unsigned*)(header + 40);
-    rate = *(unsigned*)(header + 24);
-    adata.sampling_rate = rate;
-    adata.bits_per_sample = *(short*)(header + 34);
-    adata.size_in_bytes = size;
-    adata.num_samples = size / (adata.bits_per_sample / 8.f);
-    data = (char *)CUTE_DSP_ALLOC(sizeof(char) * size);
-    CUTE_DSP_ASSERT(data);
+void cd_close_file_view(cd_file_view_t* view)
+{
+    CUTE_DSP_ASSERT(view);
+#if defined(_WIN32)
+    if(view->mapping) UnmapViewOfFile(view->mapping);
+    if(view->mapping_handle) CloseHandle(view->mapping_handle);
+    if(view->file_handle) CloseHandle(view->file_handle);
+#else
+    if(view->mapping) munmap(view->mapping, view->mapping_size);
+#endif
+    memset(view, 0, sizeof(cd_file_view_t));
+}
 
-    fread(data, sizeof(char), size, file);
+int cd_open_wav_view(cd_wav_view_t* view, const char* filename)
+{
+    const char* bytes;
+    const char* format = NULL;
+    size_t offset = 12;
+    unsigned short encoding;
 
-    if(adata.bits_per_sample == 16)
+    CUTE_DSP_ASSERT(view);
+    memset(view, 0, sizeof(cd_wav_view_t));
+    if(!cd_open_file_view(&view->file, filename, 1))
     {
-        unsigned i = 0;
-        adata.data = (float*)CUTE_DSP_ALLOC(sizeof(float) * adata.num_samples);
-        //const float denom = (float)((1 << (adata.bits_per_sample - 1)));
-        for(; i < adata.num_samples; ++i)
+        cd_close_wav_view(view);
+        return 0;
+    }
+
+    bytes = (const char*)view->file.mapping;
+    if(view->file.mapping_size < 12 || memcmp(bytes, "RIFF", 4) || memcmp(bytes + 8, "WAVE", 4))
+    {
+        cd_close_wav_view(view);
+        return 0;
+    }
+
+    /* walk the chunks, skipping anything that isn't the format or the data */
+    while(offset + 8 <= view->file.mapping_size)
+    {
+        const char* chunk = bytes + offset;
+        size_t chunk_size = cd_read_u32(chunk + 4);
+        size_t available = view->file.mapping_size - offset - 8;
+        if(!memcmp(chunk, "fmt ", 4) && chunk_size >= 16 && available >= 16)
+        {
+            format = chunk + 8;
+        }
+        else if(!memcmp(chunk, "data", 4))
+        {
+            /* tolerate truncated files, and streamed files that never patched their size */
+            view->pcm = chunk + 8;
+            view->size_in_bytes = (unsigned)(chunk_size < available ? chunk_size : available);
+            break;
+        }
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+
+    if(!format || !view->pcm)
+    {
+        cd_close_wav_view(view);
+        return 0;
+    }
+
+    encoding = cd_read_u16(format);
+    view->channel_count = (short)cd_read_u16(format + 2);
+    view->sampling_rate = (float)cd_read_u32(format + 4);
+    view->bits_per_sample = (short)cd_read_u16(format + 14);
+    if(encoding == 0xFFFE && cd_read_u32(format - 4) >= 26)
+        encoding = cd_read_u16(format + 24); /* WAVE_FORMAT_EXTENSIBLE sub format */
+    view->is_float = encoding == 3;
+
+    if(view->channel_count < 1 || !((encoding == 1 && view->bits_per_sample == 16) || (view->is_float && view->bits_per_sample == 32)))
+    {
+        cd_close_wav_view(view);
+        return 0;
+    }
+
+    view->num_samples = view->size_in_bytes / (view->bits_per_sample / 8);
+    return 1;
+}
+
+void cd_convert_wav_view(const cd_wav_view_t* view, unsigned first_sample, unsigned count, float* out, float scale)
+{
+    unsigned i = 0;
+    CUTE_DSP_ASSERT(view && view->pcm);
+    CUTE_DSP_ASSERT(first_sample + count <= view->num_samples);
+
+    if(view->is_float)
+    {
+        const float* in = (const float*)view->pcm + first_sample;
+#if defined(CUTE_DSP_AUDIO_DATA_SSE2)
+        __m128 s = _mm_set1_ps(scale);
+        for(; i + 8 <= count; i += 8)
         {
-            short val = *(short*)(data + i * sizeof(short));
-            //float nextVal = (float)(val) / denom;
-            float nextVal = (float)val;
-            adata.data[i] = nextVal;
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i), s));
+            _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_loadu_ps(in + i + 4), s));
         }
+#endif
+        for(; i < count; ++i)
+            out[i] = in[i] * scale;
     }
     else
     {
-        printf("Bits per sample was an unrecognized format: %d\n", adata.bits_per_sample);
-        printf("cd_audio_data_t only supports 16 bit audio.\n");
+        const short* in = (const short*)view->pcm + first_sample;
+        const float s16 = scale / 32768.f;
+#if defined(CUTE_DSP_AUDIO_DATA_SSE2)
+        __m128 s = _mm_set1_ps(s16);
+        for(; i + 8 <= count; i += 8)
+        {
+            /* sign extend 8 shorts to two sets of 4 ints */
+            __m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+            _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+        }
+#endif
+        for(; i < count; ++i)
+            out[i] = in[i] * s16;
+    }
+}
+
+void cd_close_wav_view(cd_wav_view_t* view)
+{
+    CUTE_DSP_ASSERT(view);
+    cd_close_file_view(&view->file);
+    memset(view, 0, sizeof(cd_wav_view_t));
+}
+
+cd_audio_data_t cd_read_wav_file(const char* filename)
+{
+    cd_audio_data_t adata = { 0 };
+    cd_wav_view_t view;
+
+    if(!cd_open_wav_view(&view, filename))
+    {
+        printf("Couldn't read %s\n", filename);
+        printf("cd_audio_data_t only supports 16 bit and 32 bit float audio.\n");
+        return adata;
     }
 
-    CUTE_DSP_FREE(data);
-    fclose(file);
+    adata.sampling_rate = view.sampling_rate;
+    adata.channel_count = view.channel_count;
+    adata.bits_per_sample = 16;
+    adata.num_samples = view.num_samples;
+    adata.size_in_bytes = view.num_samples * sizeof(short);
+    adata.data = (float*)CUTE_DSP_ALLOC(sizeof(float) * adata.num_samples);
+    CUTE_DSP_ASSERT(adata.data);
+    cd_convert_wav_view(&view, 0, view.num_samples, adata.data, 32768.f);
 
+    cd_close_wav_view(&view);
     return adata;
 }
 
@@ -77,6 +258,7 @@ cd_audio_data_t cd_make_audio_data(unsigned num_samples, short bits, float sampl
     cd_audio_data_t data = { 0 };
     data.num_samples = num_samples;
     data.bits_per_sample = bits;
+    data.channel_count = 1;
     data.sampling_rate = sampling_rate;
     data.size_in_bytes = bits / 8.f * num_samples;
     data.data = (float *)CUTE_DSP_ALLOC(sizeof(float) * num_samples);
@@ -96,6 +278,7 @@ void cd_copy_audio_data(cd_audio_data_t* lhs, const cd_audio_data_t* rhs)
     lhs->size_in_bytes = rhs->size_in_bytes;
     lhs->num_samples = rhs->num_samples;
     lhs->bits_per_sample = rhs->bits_per_sample;
+    lhs->channel_count = rhs->channel_count;
     if(lhs->data)
     {
         CUTE_DSP_FREE(lhs->data);
@@ -118,7 +301,7 @@ void cd_release_audio_data(cd_audio_data_t* data)
     memset(data, 0, sizeof(cd_audio_data_t));
 }
 
-static void cd_write_header(FILE** output, const cd_audio_data_t* data)
+static void cd_write_header(FILE* output, float sampling_rate, short channel_count, unsigned size_in_bytes)
 {
     struct
     {
@@ -137,52 +320,119 @@ static void cd_write_header(FILE** output, const cd_audio_data_t* data)
         unsigned data_chunk_size;
     }
     header = { {'R', 'I', 'F', 'F'},
-                0, /* chunk size = 36 + data->size_in_bytes */
+                0, /* chunk size = 36 + size_in_bytes */
                 {'W', 'A', 'V', 'E'},
                 {'f', 'm', 't', ' '},
                 16, 1, 1, 
-                0, /* sampling_rate = data->sampling_rate */
-                0, /* bytes per second = sizeof(short) * sampling_rate */
+                0, /* sampling_rate */
+                0, /* bytes per second = block_align * sampling_rate */
                 2, 
-                0, /* bits per sample = data->bits_per_sample */
+                16,
                 {'d', 'a', 't', 'a'},
-                0  /* data_chunk_size = data->size_in_bytes */
+                0  /* data_chunk_size = size_in_bytes */
     };
-
-    header.chunk_size = 36 + data->size_in_bytes;
-    header.sampling_rate = data->sampling_rate;
-    header.bytes_per_second = sizeof(short) * data->sampling_rate;
-    header.bits_per_sample = data->bits_per_sample;
-    header.data_chunk_size = data->size_in_bytes;
+    header.chunk_size = 36 + size_in_bytes;
+    header.number_of_channels = channel_count ? channel_count : 1;
+    header.sampling_rate = (unsigned)sampling_rate;
+    header.block_align = sizeof(short) * header.number_of_channels;
+    header.bytes_per_second = header.block_align * header.sampling_rate;
+    header.data_chunk_size = size_in_bytes;
     
-    fwrite((char*)(&header), sizeof(char), 44, *output);
+    fwrite((char*)(&header), sizeof(char), 44, output);
 }
 
-#define FLOAT_TO_SHORT(s) ((short)(s * (float)((1 << (16 - 1)) - 1)))
+int cd_open_wav_writer(cd_wav_writer_t* writer, const char* filename, float sampling_rate, short channel_count)
+{
+    CUTE_DSP_ASSERT(writer);
+    memset(writer, 0, sizeof(cd_wav_writer_t));
+    writer->file = fopen(filename, "wb");
+    if(!writer->file) return 0;
 
-void cd_write_wav_file(const char* filename, const cd_audio_data_t* data)
+    /* the buffer is handed straight to fwrite, so stdio's own buffering is redundant */
+    setvbuf(writer->file, NULL, _IONBF, 0);
+    writer->capacity = CUTE_DSP_WAV_WRITER_CAPACITY;
+    writer->buffer = (short*)CUTE_DSP_ALLOC(sizeof(short) * writer->capacity);
+    CUTE_DSP_ASSERT(writer->buffer);
+    writer->sampling_rate = sampling_rate;
+    writer->channel_count = channel_count ? channel_count : 1;
+    cd_write_header(writer->file, sampling_rate, writer->channel_count, 0);
+    return 1;
+}
+
+static void cd_flush_wav_writer(cd_wav_writer_t* writer)
 {
-    short* outData = NULL;
-    unsigned i = 0;
-    FILE* file = fopen(filename, "w");
-    CUTE_DSP_ASSERT(file);
-    CUTE_DSP_ASSERT(data);
+    fwrite(writer->buffer, sizeof(short), writer->buffered, writer->file);
+    writer->buffered = 0;
+}
+
+void cd_write_wav_samples(cd_wav_writer_t* writer, const float* samples, unsigned count, float scale)
+{
+    CUTE_DSP_ASSERT(writer && writer->file);
+    writer->num_samples += count;
+    while(count)
+    {
+        unsigned i = 0;
+        unsigned tile = writer->capacity - writer->buffered;
+        short* out = writer->buffer + writer->buffered;
+        if(tile > count) tile = count;
+
+#if defined(CUTE_DSP_AUDIO_DATA_SSE2)
+        {
+            __m128 s = _mm_set1_ps(scale);
+            for(; i + 8 <= tile; i += 8)
+            {
+                /* truncate like the scalar cast, then saturate to 16 bits */
+                __m128i lo = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(samples + i), s));
+                __m128i hi = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(samples + i + 4), s));
+                _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(lo, hi));
+            }
+        }
+#endif
+        for(; i < tile; ++i)
+        {
+            float next = samples[i] * scale;
+            next = next > 32767.f ? 32767.f : next < -32768.f ? -32768.f : next;
+            out[i] = (short)next;
+        }
+
+        writer->buffered += tile;
+        samples += tile;
+        count -= tile;
+        if(writer->buffered == writer->capacity)
+            cd_flush_wav_writer(writer);
+    }
+}
 
-    outData = (short*)CUTE_DSP_ALLOC(sizeof(short) * data->num_samples);
-    CUTE_DSP_ASSERT(outData);
+void cd_close_wav_writer(cd_wav_writer_t* writer)
+{
+    CUTE_DSP_ASSERT(writer);
+    if(writer->file)
+    {
+        cd_flush_wav_writer(writer);
+        fseek(writer->file, 0, SEEK_SET);
+        cd_write_header(writer->file, writer->sampling_rate, writer->channel_count, writer->num_samples * sizeof(short));
+        fclose(writer->file);
+    }
+    if(writer->buffer)
+    {
+        CUTE_DSP_FREE(writer->buffer);
+    }
+    memset(writer, 0, sizeof(cd_wav_writer_t));
+}
 
-    for(; i < data->num_samples; ++i)
+void cd_write_wav_file(const char* filename, const cd_audio_data_t* data)
+{
+    cd_wav_writer_t writer;
+    CUTE_DSP_ASSERT(data);
+    if(!cd_open_wav_writer(&writer, filename, data->sampling_rate, data->channel_count))
     {
-        float nextF = data->data[i];
-        //short nextS = FLOAT_TO_SHORT(nextF);
-        short nextS = (short)nextF;
-        outData[i] = nextS;
+        CUTE_DSP_ASSERT(0);
+        return;
     }
 
-    cd_write_header(&file, data);
-    fwrite((char*)(outData), sizeof(char), data->size_in_bytes, file);
-    CUTE_DSP_FREE(outData);
-    fclose(file);
+    /* samples are already in the 16 bit range */
+    cd_write_wav_samples(&writer, data->data, data->num_samples, 1.f);
+    cd_close_wav_writer(&writer);
 }
 
 /*
@@ -10,9 +10,15 @@
 
     Revision history:
         1.0     (05/25/2019) initial release: prototypes for audio_data.
+        1.1     (10/18/2026) added channel_count.
+        1.2     (10/18/2026) added memory mapped cd_wav_view_t and buffered cd_wav_writer_t.
+        1.3     (10/18/2026) added cd_file_view_t, for mapping any file such as preset banks.
 */
 #if !defined(CUTE_DSP_AUDIO_DATA_H)
 
+#include <stddef.h> /* size_t */
+#include <stdio.h>  /* FILE */
+
 /*
     Encapsulates a set of audio data.
     Can read in a .wav file, or can be used to manually generate audio data.
@@ -23,13 +29,15 @@ typedef struct cd_audio_data_t
     float sampling_rate;
     unsigned size_in_bytes;
     unsigned num_samples;
-    float* data;    /* dynamically allocated */
+    float* data;    /* dynamically allocated, channels interleaved */
     short bits_per_sample;
+    short channel_count;
 
 } cd_audio_data_t;
 
 /*
     Reads in a simple .wav file and returns the corresponding audio data.
+    Samples keep the 16 bit range, data is NULL if the file couldn't be read.
 */
 cd_audio_data_t cd_read_wav_file(const char* filename);
 
@@ -56,6 +64,96 @@ void cd_release_audio_data(cd_audio_data_t* data);
 */
 void cd_write_wav_file(const char* filename, const cd_audio_data_t* data);
 
+/*
+    Read only view of a whole file mapped into memory.
+*/
+typedef struct cd_file_view_t
+{
+    void* mapping;
+    size_t mapping_size;
+#if defined(_WIN32)
+    void* file_handle;
+    void* mapping_handle;
+#endif
+} cd_file_view_t;
+
+/*
+    Maps a file, hinting the OS to read ahead when it is read sequentially.
+    Returns 1 on success, 0 if the file couldn't be mapped or is empty.
+*/
+int cd_open_file_view(cd_file_view_t* view, const char* filename, int sequential);
+
+/*
+    Unmaps the file. Any pointers into the view are invalid afterwards.
+*/
+void cd_close_file_view(cd_file_view_t* view);
+
+/*
+    Read only view of a .wav file mapped into memory.
+    The PCM data is used in place, and converted to float in tiles on demand.
+    Supports 16 bit PCM and 32 bit float files.
+*/
+typedef struct cd_wav_view_t
+{
+    const void* pcm;        /* points into the mapping, channels interleaved */
+    unsigned num_samples;   /* across all channels */
+    unsigned size_in_bytes;
+    float sampling_rate;
+    short bits_per_sample;
+    short channel_count;
+    short is_float;
+
+    cd_file_view_t file;
+} cd_wav_view_t;
+
+/*
+    Maps a .wav file and finds its format and data chunks.
+    Returns 1 on success, 0 if the file couldn't be mapped or isn't a supported .wav.
+*/
+int cd_open_wav_view(cd_wav_view_t* view, const char* filename);
+
+/*
+    Converts count samples starting at first_sample into out.
+    Full scale maps to +/- scale, so 1 gives [-1, 1) and 32768 gives the values cd_read_wav_file uses.
+*/
+void cd_convert_wav_view(const cd_wav_view_t* view, unsigned first_sample, unsigned count, float* out, float scale);
+
+/*
+    Unmaps the file. Any pointers into the view are invalid afterwards.
+*/
+void cd_close_wav_view(cd_wav_view_t* view);
+
+/*
+    Streams 16 bit samples to a .wav file through a large buffer.
+    The header sizes are filled in when the writer is closed.
+*/
+typedef struct cd_wav_writer_t
+{
+    FILE* file;
+    short* buffer;
+    unsigned buffered;
+    unsigned capacity;
+    unsigned num_samples;   /* written so far, across all channels */
+    float sampling_rate;
+    short channel_count;
+} cd_wav_writer_t;
+
+/*
+    Creates the file and writes a placeholder header.
+    Returns 1 on success, 0 if the file couldn't be created.
+*/
+int cd_open_wav_writer(cd_wav_writer_t* writer, const char* filename, float sampling_rate, short channel_count);
+
+/*
+    Appends count interleaved samples, multiplied by scale then truncated and clamped to 16 bits.
+*/
+void cd_write_wav_samples(cd_wav_writer_t* writer, const float* samples, unsigned count, float scale);
+
+/*
+    Flushes the buffer, patches the header sizes and closes the file.
+*/
+void cd_close_wav_writer(cd_wav_writer_t* writer);
+
 #define CUTE_DSP_AUDIO_DATA_H
 #endif
 
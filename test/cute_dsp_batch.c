@@ -0,0 +1,572 @@
+/*
+    ------------------------------------------------------------------------------
+		Licensing information can be found at the end of the file.
+	------------------------------------------------------------------------------
+
+    cute_dsp_batch.c - v1.0
+
+    To compile (linux):
+
+        cc -O2 cute_dsp_batch.c cute_dsp_audio_data.c -lm -lpthread `sdl2-config --cflags --libs`
+
+    To run:
+
+        ./cute_dsp_batch [-j <threads>] <manifest>
+
+    Summary:
+        Offline batch renderer for baking filtered variants of sound assets, no audio device needed.
+        Every non empty line of the manifest is one job: an input .wav, an output .wav and a chain
+        of filters applied in order. Lines starting with # are comments.
+
+            <input.wav> <output.wav> [stage]...
+
+            lowpass <cutoff_hz> <resonance>
+            highpass <cutoff_hz>
+            echo <delay_s> <mix> <feedback>
+            noise <db>
+            tail <seconds>      renders extra silence through the chain so echoes can ring out
+
+        e.g.
+            music2.wav music2_muffled.wav lowpass 800 0.3 highpass 80
+            stinger1.wav stinger1_cave.wav echo 0.25 0.5 0.4 tail 1
+
+        Jobs run in parallel on all cores by default, each thread reusing its own detached context.
+        Files are streamed through in blocks: inputs are memory mapped and converted a tile at a
+        time, outputs are written through cd_wav_writer_t. The noise generators are keyed by the
+        output file name, so the baked files don't depend on the thread count or the job order.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define CUTE_SOUND_IMPLEMENTATION
+#include "../../cute_headers/cute_sound.h"
+
+#define CUTE_DSP_IMPLEMENTATION
+#include "../cute_dsp.h"
+
+#include "cute_dsp_audio_data.h"
+
+#define BATCH_BLOCK_SIZE CUTE_DSP_MAX_FRAME_LENGTH	// frames per cd_sample_* call
+#define BATCH_MAX_STAGES 8
+#define BATCH_MAX_CHANNELS 2
+#define BATCH_MAX_THREADS 64
+#define BATCH_DEFAULT_ECHO_DELAY (0.5f)
+
+/* BEGIN PLATFORM */
+#if defined(_WIN32)
+typedef HANDLE batch_thread_t;
+#define BATCH_ATOMIC_INCREMENT(x) (InterlockedIncrement(x) - 1)
+
+static double time_in_seconds(void)
+{
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+
+static int core_count(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+}
+#else
+typedef pthread_t batch_thread_t;
+#define BATCH_ATOMIC_INCREMENT(x) __sync_fetch_and_add(x, 1)
+
+static double time_in_seconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static int core_count(void)
+{
+	return (int)sysconf(_SC_NPROCESSORS_ONLN);
+}
+#endif
+/* END PLATFORM */
+
+/* BEGIN MANIFEST */
+typedef enum batch_effect_t
+{
+	BATCH_LOWPASS,
+	BATCH_HIGHPASS,
+	BATCH_ECHO,
+	BATCH_NOISE,
+} batch_effect_t;
+
+typedef struct batch_stage_t
+{
+	batch_effect_t effect;
+	float a, b, c;
+} batch_stage_t;
+
+typedef struct batch_job_t
+{
+	char input[260];
+	char output[260];
+	batch_stage_t stages[BATCH_MAX_STAGES];
+	int stage_count;
+	float tail_s;
+	float echo_max_delay_s;
+	int line;
+
+	// filled in by the worker
+	int failed;
+	unsigned frames;
+	unsigned channel_count;
+	float sampling_rate;
+	double seconds;
+} batch_job_t;
+
+typedef struct batch_effect_def_t
+{
+	const char* name;
+	int parameter_count;
+} batch_effect_def_t;
+
+static const batch_effect_def_t batch_effects[] = {
+	{ "lowpass", 2 },
+	{ "highpass", 1 },
+	{ "echo", 3 },
+	{ "noise", 1 },
+};
+
+#define BATCH_EFFECT_COUNT (sizeof(batch_effects) / sizeof(batch_effects[0]))
+
+static int parse_job(char* line, int line_number, batch_job_t* job)
+{
+	char* token;
+	memset(job, 0, sizeof(batch_job_t));
+	job->line = line_number;
+	job->echo_max_delay_s = BATCH_DEFAULT_ECHO_DELAY;
+
+	token = strtok(line, " \t\r\n");
+	if (!token || token[0] == '#')
+		return 0;
+	strncpy(job->input, token, sizeof(job->input) - 1);
+
+	token = strtok(NULL, " \t\r\n");
+	if (!token)
+	{
+		printf("manifest line %d: missing output file\n", line_number);
+		return -1;
+	}
+	strncpy(job->output, token, sizeof(job->output) - 1);
+
+	while ((token = strtok(NULL, " \t\r\n")))
+	{
+		float parameters[3] = { 0 };
+		unsigned effect;
+		int i, count;
+
+		if (!strcmp(token, "tail"))
+		{
+			token = strtok(NULL, " \t\r\n");
+			if (!token || sscanf(token, "%f", &job->tail_s) != 1 || job->tail_s < 0.f)
+			{
+				printf("manifest line %d: tail needs a length in seconds\n", line_number);
+				return -1;
+			}
+			continue;
+		}
+
+		for (effect = 0; effect < BATCH_EFFECT_COUNT; ++effect)
+			if (!strcmp(token, batch_effects[effect].name))
+				break;
+		if (effect == BATCH_EFFECT_COUNT)
+		{
+			printf("manifest line %d: unknown stage \"%s\"\n", line_number, token);
+			return -1;
+		}
+		if (job->stage_count == BATCH_MAX_STAGES)
+		{
+			printf("manifest line %d: more than %d stages\n", line_number, BATCH_MAX_STAGES);
+			return -1;
+		}
+
+		count = batch_effects[effect].parameter_count;
+		for (i = 0; i < count; ++i)
+		{
+			token = strtok(NULL, " \t\r\n");
+			if (!token || sscanf(token, "%f", parameters + i) != 1)
+			{
+				printf("manifest line %d: %s needs %d parameters\n", line_number, batch_effects[effect].name, count);
+				return -1;
+			}
+		}
+
+		job->stages[job->stage_count].effect = (batch_effect_t)effect;
+		job->stages[job->stage_count].a = parameters[0];
+		job->stages[job->stage_count].b = parameters[1];
+		job->stages[job->stage_count].c = parameters[2];
+		++job->stage_count;
+
+		if (effect == BATCH_ECHO && parameters[0] > job->echo_max_delay_s)
+			job->echo_max_delay_s = parameters[0];
+	}
+	return 1;
+}
+
+static batch_job_t* read_manifest(const char* filename, int* count)
+{
+	char line[1024];
+	int capacity = 64, line_number = 0;
+	batch_job_t* jobs;
+	FILE* file = fopen(filename, "r");
+
+	*count = 0;
+	if (!file)
+	{
+		printf("Couldn't open manifest %s\n", filename);
+		return NULL;
+	}
+
+	jobs = (batch_job_t*)malloc(sizeof(batch_job_t) * capacity);
+	while (fgets(line, sizeof(line), file))
+	{
+		int result;
+		if (*count == capacity)
+		{
+			capacity *= 2;
+			jobs = (batch_job_t*)realloc(jobs, sizeof(batch_job_t) * capacity);
+		}
+
+		result = parse_job(line, ++line_number, jobs + *count);
+		if (result < 0)
+		{
+			free(jobs);
+			fclose(file);
+			return NULL;
+		}
+		*count += result;
+	}
+	fclose(file);
+	return jobs;
+}
+/* END MANIFEST */
+
+/* BEGIN RENDERING */
+typedef struct batch_worker_t
+{
+	batch_thread_t thread;
+	cd_context_t* context;	// reused across jobs while the rate and max delay fit
+	cd_context_def_t def;
+	float input[BATCH_BLOCK_SIZE * BATCH_MAX_CHANNELS];
+	float output[BATCH_BLOCK_SIZE * BATCH_MAX_CHANNELS];
+	float channel[BATCH_BLOCK_SIZE];
+} batch_worker_t;
+
+static batch_job_t* g_jobs;
+static int g_job_count;
+static volatile long g_next_job;
+
+/* hashes the file name without its directory */
+static unsigned hash_file_name(const char* path)
+{
+	unsigned hash = 2166136261u;
+	const char* string = path;
+	for (; *path; ++path)
+		if (*path == '/' || *path == '\\')
+			string = path + 1;
+	while (*string)
+		hash = (hash ^ (unsigned char)*string++) * 16777619u;
+	return hash;
+}
+
+static cd_context_t* worker_context(batch_worker_t* worker, const batch_job_t* job, float sampling_rate)
+{
+	if (worker->context && worker->def.sampling_rate == sampling_rate && worker->def.echo_max_delay_s >= job->echo_max_delay_s)
+		return worker->context;
+
+	if (worker->context)
+		cd_release_context(&worker->context);
+
+	memset(&worker->def, 0, sizeof(worker->def));
+	worker->def.playing_pool_count = BATCH_MAX_STAGES * BATCH_MAX_CHANNELS;
+	worker->def.sampling_rate = sampling_rate;
+	worker->def.use_lowpass = 1;
+	worker->def.use_highpass = 1;
+	worker->def.use_echo = 1;
+	worker->def.use_noise = 1;
+	worker->def.echo_max_delay_s = job->echo_max_delay_s;
+	worker->def.rand_seed = 2;
+	worker->context = cd_make_context(NULL, worker->def);
+	return worker->context;
+}
+
+static void* make_stage(cd_context_t* context, const batch_stage_t* stage)
+{
+	switch (stage->effect)
+	{
+	case BATCH_LOWPASS:
+	{
+		cd_lowpass_t* filter = cd_make_lowpass_filter(context);
+		cd_set_lowpass_parameters(filter, stage->a, stage->b);
+		return filter;
+	}
+	case BATCH_HIGHPASS:
+	{
+		cd_highpass_t* filter = cd_make_highpass_filter(context);
+		cd_set_highpass_cutoff_frequency(filter, stage->a);
+		return filter;
+	}
+	case BATCH_ECHO:
+	{
+		cd_echo_t* filter = cd_make_echo_filter(context);
+		cd_set_echo_parameters(filter, stage->a, stage->b, stage->c);
+		return filter;
+	}
+	case BATCH_NOISE:
+	{
+		cd_noise_t* filter = cd_make_noise_generator(context);
+		cd_set_noise_generator_amplitude_db(filter, stage->a);
+		return filter;
+	}
+	}
+	return NULL;
+}
+
+static void sample_stage(cd_context_t* context, const batch_stage_t* stage, void* filter, const float* input, float** output, unsigned count)
+{
+	switch (stage->effect)
+	{
+	case BATCH_LOWPASS: cd_sample_lowpass(context, (cd_lowpass_t*)filter, input, output, count); break;
+	case BATCH_HIGHPASS: cd_sample_highpass(context, (cd_highpass_t*)filter, input, output, count); break;
+	case BATCH_ECHO: cd_sample_echo(context, (cd_echo_t*)filter, input, output, count); break;
+	case BATCH_NOISE: cd_sample_noise(context, (cd_noise_t*)filter, input, output, count); break;
+	}
+}
+
+static void release_stage(cd_context_t* context, const batch_stage_t* stage, void* filter)
+{
+	switch (stage->effect)
+	{
+	case BATCH_LOWPASS: { cd_lowpass_t* f = (cd_lowpass_t*)filter; cd_release_lowpass(context, &f); } break;
+	case BATCH_HIGHPASS: { cd_highpass_t* f = (cd_highpass_t*)filter; cd_release_highpass(context, &f); } break;
+	case BATCH_ECHO: { cd_echo_t* f = (cd_echo_t*)filter; cd_release_echo_filter(context, &f); } break;
+	case BATCH_NOISE: { cd_noise_t* f = (cd_noise_t*)filter; cd_release_noise(context, &f); } break;
+	}
+}
+
+static void render_job(batch_worker_t* worker, batch_job_t* job)
+{
+	void* filters[BATCH_MAX_CHANNELS][BATCH_MAX_STAGES] = { { 0 } };
+	cd_wav_view_t view;
+	cd_wav_writer_t writer;
+	cd_context_t* context;
+	unsigned frame, frames, total_frames, channels, c, s, i;
+	double start = time_in_seconds();
+
+	if (!cd_open_wav_view(&view, job->input))
+	{
+		printf("line %d: couldn't read %s\n", job->line, job->input);
+		job->failed = 1;
+		return;
+	}
+	channels = (unsigned)view.channel_count;
+	if (channels > BATCH_MAX_CHANNELS || !cd_open_wav_writer(&writer, job->output, view.sampling_rate, view.channel_count))
+	{
+		printf("line %d: couldn't write %s\n", job->line, job->output);
+		cd_close_wav_view(&view);
+		job->failed = 1;
+		return;
+	}
+
+	context = worker_context(worker, job, view.sampling_rate);
+	for (c = 0; c < channels; ++c)
+		for (s = 0; s < (unsigned)job->stage_count; ++s)
+		{
+			filters[c][s] = make_stage(context, job->stages + s);
+			if (job->stages[s].effect == BATCH_NOISE)
+				cd_set_noise_generator_stream(context, (cd_noise_t*)filters[c][s], hash_file_name(job->output), c * BATCH_MAX_STAGES + s);
+		}
+
+	frames = view.num_samples / channels;
+	total_frames = frames + (unsigned)(job->tail_s * view.sampling_rate);
+	for (frame = 0; frame < total_frames; frame += BATCH_BLOCK_SIZE)
+	{
+		unsigned count = total_frames - frame < BATCH_BLOCK_SIZE ? total_frames - frame : BATCH_BLOCK_SIZE;
+		unsigned available = frame < frames ? (frames - frame < count ? frames - frame : count) : 0;
+
+		// convert straight out of the mapping, padding the tail with silence
+		if (available)
+			cd_convert_wav_view(&view, frame * channels, available * channels, worker->input, 1.f);
+		memset(worker->input + available * channels, 0, sizeof(float) * (count - available) * channels);
+
+		for (c = 0; c < channels; ++c)
+		{
+			const float* samples = worker->channel;
+			for (i = 0; i < count; ++i)
+				worker->channel[i] = worker->input[i * channels + c];
+			for (s = 0; s < (unsigned)job->stage_count; ++s)
+			{
+				float* out;
+				sample_stage(context, job->stages + s, filters[c][s], samples, &out, count);
+				samples = out;
+			}
+			for (i = 0; i < count; ++i)
+				worker->output[i * channels + c] = samples[i];
+		}
+		cd_write_wav_samples(&writer, worker->output, count * channels, 32768.f);
+	}
+
+	for (c = 0; c < channels; ++c)
+		for (s = 0; s < (unsigned)job->stage_count; ++s)
+			release_stage(context, job->stages + s, filters[c][s]);
+	job->frames = total_frames;
+	job->channel_count = channels;
+	job->sampling_rate = view.sampling_rate;
+	cd_close_wav_writer(&writer);
+	cd_close_wav_view(&view);
+	job->seconds = time_in_seconds() - start;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI worker_main(LPVOID data)
+#else
+static void* worker_main(void* data)
+#endif
+{
+	batch_worker_t* worker = (batch_worker_t*)data;
+	long index;
+	while ((index = BATCH_ATOMIC_INCREMENT(&g_next_job)) < g_job_count)
+	{
+		batch_job_t* job = g_jobs + index;
+		render_job(worker, job);
+		if (!job->failed)
+			printf("%-40s %8.1f ms %10.1f x realtime\n", job->output, job->seconds * 1e3, job->frames / job->sampling_rate / job->seconds);
+	}
+	if (worker->context)
+		cd_release_context(&worker->context);
+	return 0;
+}
+/* END RENDERING */
+
+/* BEGIN MAIN */
+int main(int argc, char** argv)
+{
+	const char* manifest = NULL;
+	int thread_count = core_count(), failed = 0, i;
+	unsigned long long samples = 0;
+	double audio_seconds = 0.0, start, elapsed;
+	batch_worker_t* workers;
+
+	for (i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-j") && i + 1 < argc)
+			thread_count = atoi(argv[++i]);
+		else
+			manifest = argv[i];
+	}
+	if (!manifest)
+	{
+		printf("usage: %s [-j <threads>] <manifest>\n", argv[0]);
+		return 1;
+	}
+
+	g_jobs = read_manifest(manifest, &g_job_count);
+	if (!g_jobs)
+		return 1;
+
+	if (thread_count > g_job_count) thread_count = g_job_count;
+	if (thread_count > BATCH_MAX_THREADS) thread_count = BATCH_MAX_THREADS;
+	if (thread_count < 1) thread_count = 1;
+	workers = (batch_worker_t*)calloc(thread_count, sizeof(batch_worker_t));
+
+	printf("%d jobs on %d threads\n", g_job_count, thread_count);
+	start = time_in_seconds();
+	for (i = 0; i < thread_count; ++i)
+	{
+#if defined(_WIN32)
+		workers[i].thread = CreateThread(NULL, 0, worker_main, workers + i, 0, NULL);
+#else
+		pthread_create(&workers[i].thread, NULL, worker_main, workers + i);
+#endif
+	}
+	for (i = 0; i < thread_count; ++i)
+	{
+#if defined(_WIN32)
+		WaitForSingleObject(workers[i].thread, INFINITE);
+		CloseHandle(workers[i].thread);
+#else
+		pthread_join(workers[i].thread, NULL);
+#endif
+	}
+	elapsed = time_in_seconds() - start;
+
+	for (i = 0; i < g_job_count; ++i)
+	{
+		if (g_jobs[i].failed)
+		{
+			++failed;
+			continue;
+		}
+		samples += (unsigned long long)g_jobs[i].frames * g_jobs[i].channel_count;
+		audio_seconds += g_jobs[i].frames / g_jobs[i].sampling_rate;
+	}
+
+	printf("\n%d jobs, %d failed, %.1f s of audio in %.1f ms: %.2f Msamples/s, %.1f x realtime\n",
+		g_job_count, failed, audio_seconds, elapsed * 1e3, samples / elapsed * 1e-6, audio_seconds / elapsed);
+
+	free(workers);
+	free(g_jobs);
+	return failed ? 1 : 0;
+}
+/* END MAIN */
+
+/*
+	------------------------------------------------------------------------------
+	This software is available under 2 licenses - you may choose the one you like.
+	------------------------------------------------------------------------------
+	ALTERNATIVE A - zlib license
+	Copyright (c) 2019 Matthew Rosen
+	This software is provided 'as-is', without any express or implied warranty.
+	In no event will the authors be held liable for any damages arising from
+	the use of this software.
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+	  1. The origin of this software must not be misrepresented; you must not
+		 claim that you wrote the original software. If you use this software
+		 in a product, an acknowledgment in the product documentation would be
+		 appreciated but is not required.
+	  2. Altered source versions must be plainly marked as such, and must not
+		 be misrepresented as being the original software.
+	  3. This notice may not be removed or altered from any source distribution.
+	------------------------------------------------------------------------------
+	ALTERNATIVE B - Public Domain (www.unlicense.org)
+	This is free and unencumbered software released into the public domain.
+	Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+	software, either in source code form or as a compiled binary, for any purpose,
+	commercial or non-commercial, and by any means.
+	In jurisdictions that recognize copyright laws, the author or authors of this
+	software dedicate any and all copyright interest in the software to the public
+	domain. We make this dedication for the benefit of the public at large and to
+	the detriment of our heirs and successors. We intend this dedication to be an
+	overt act of relinquishment in perpetuity of all present and future rights to
+	this software under copyright law.
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+	ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+	------------------------------------------------------------------------------
+*/
+
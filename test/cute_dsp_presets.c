@@ -0,0 +1,419 @@
+/*
+    ------------------------------------------------------------------------------
+		Licensing information can be found at the end of the file.
+	------------------------------------------------------------------------------
+
+    cute_dsp_presets.c - v1.0
+
+    To compile (linux):
+
+        cc -O2 cute_dsp_presets.c cute_dsp_audio_data.c -lm -lpthread `sdl2-config --cflags --libs`
+
+    To run:
+
+        ./cute_dsp_presets [-r <rate>]... [-o <filter_order>] [-lr] <manifest> <bank>
+
+    Summary:
+        Bakes a preset bank with cd_write_preset_bank, for banks to be memory mapped and opened
+        with cd_open_preset_bank. Every non empty line of the manifest is one preset: a name and
+        the parameters it sets. Lines starting with # are comments.
+
+            <name> [parameter]...
+
+            lowpass <cutoff_hz> <resonance>     defaults to 20000 0
+            highpass <cutoff_hz>                defaults to 20
+            echo <delay_s> <mix> <feedback>     defaults to 0 0 0
+            noise <db>                          defaults to -96
+
+        e.g.
+            muffled lowpass 800 0.3 highpass 80
+            cave echo 0.25 0.5 0.4
+
+        Coefficients are computed for every -r rate, 44100 and 48000 if none are given, with the
+        filter order and alignment the contexts will use. The bank is then mapped back, and every
+        preset is checked to render the same as calling the setters, and both are timed.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CUTE_SOUND_IMPLEMENTATION
+#include "../../cute_headers/cute_sound.h"
+
+#define CUTE_DSP_IMPLEMENTATION
+#include "../cute_dsp.h"
+
+#include "cute_dsp_audio_data.h"
+
+#define PRESETS_MAX_RATES 8
+#define PRESETS_BLOCK_SIZE (512)	// frames rendered to check each preset
+#define PRESETS_TIMING_ROUNDS 64
+
+/* BEGIN TIMER */
+#if defined(_WIN32)
+#include <windows.h>
+static double time_in_seconds(void)
+{
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+#else
+#include <time.h>
+static double time_in_seconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+#endif
+/* END TIMER */
+
+/* BEGIN MANIFEST */
+typedef struct presets_parameter_t
+{
+	const char* name;
+	int parameter_count;
+	size_t offset;	// of the first parameter in cd_preset_t
+} presets_parameter_t;
+
+static const presets_parameter_t presets_parameters[] = {
+	{ "lowpass", 2, offsetof(cd_preset_t, lowpass_cutoff) },
+	{ "highpass", 1, offsetof(cd_preset_t, highpass_cutoff) },
+	{ "echo", 3, offsetof(cd_preset_t, echo_delay) },
+	{ "noise", 1, offsetof(cd_preset_t, noise_db) },
+};
+#define PRESETS_PARAMETER_COUNT (sizeof(presets_parameters) / sizeof(presets_parameters[0]))
+
+// returns 1 for a preset, 0 for a blank or comment line, -1 on errors
+static int parse_preset(char* line, int line_number, cd_preset_t* preset)
+{
+	char* token;
+	memset(preset, 0, sizeof(cd_preset_t));
+	preset->lowpass_cutoff = CUTE_DSP_DEFAULT_LOWPASS_CUTOFF;
+	preset->highpass_cutoff = CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF;
+	preset->noise_db = -96.f;
+
+	token = strtok(line, " \t\r\n");
+	if (!token || token[0] == '#')
+		return 0;
+	if (strlen(token) >= CUTE_DSP_MAX_PRESET_NAME)
+	{
+		printf("manifest line %d: name longer than %d characters\n", line_number, CUTE_DSP_MAX_PRESET_NAME - 1);
+		return -1;
+	}
+	preset->name = strdup(token);
+
+	while ((token = strtok(NULL, " \t\r\n")))
+	{
+		const presets_parameter_t* parameter = NULL;
+		float* values;
+		unsigned p;
+		int i;
+
+		for (p = 0; p < PRESETS_PARAMETER_COUNT; ++p)
+			if (!strcmp(token, presets_parameters[p].name))
+				parameter = presets_parameters + p;
+		if (!parameter)
+		{
+			printf("manifest line %d: unknown parameter \"%s\"\n", line_number, token);
+			return -1;
+		}
+
+		values = (float*)((char*)preset + parameter->offset);
+		for (i = 0; i < parameter->parameter_count; ++i)
+		{
+			token = strtok(NULL, " \t\r\n");
+			if (!token || sscanf(token, "%f", values + i) != 1)
+			{
+				printf("manifest line %d: %s needs %d parameters\n", line_number, parameter->name, parameter->parameter_count);
+				return -1;
+			}
+		}
+	}
+
+	if (preset->lowpass_cutoff < CUTE_DSP_DEFAULT_HIGHPASS_CUTOFF || preset->lowpass_cutoff > CUTE_DSP_DEFAULT_LOWPASS_CUTOFF
+		|| preset->lowpass_resonance < 0.f || preset->lowpass_resonance > 1.f)
+	{
+		printf("manifest line %d: lowpass out of range\n", line_number);
+		return -1;
+	}
+	return 1;
+}
+
+static cd_preset_t* read_manifest(const char* filename, unsigned* count)
+{
+	char line[1024];
+	unsigned capacity = 256;
+	int line_number = 0;
+	cd_preset_t* presets;
+	FILE* file = fopen(filename, "r");
+
+	*count = 0;
+	if (!file)
+	{
+		printf("Couldn't open manifest %s\n", filename);
+		return NULL;
+	}
+
+	presets = (cd_preset_t*)malloc(sizeof(cd_preset_t) * capacity);
+	while (fgets(line, sizeof(line), file))
+	{
+		int result;
+		if (*count == capacity)
+		{
+			capacity *= 2;
+			presets = (cd_preset_t*)realloc(presets, sizeof(cd_preset_t) * capacity);
+		}
+
+		result = parse_preset(line, ++line_number, presets + *count);
+		if (result < 0)
+		{
+			free(presets);
+			fclose(file);
+			return NULL;
+		}
+		*count += result;
+	}
+	fclose(file);
+	return presets;
+}
+/* END MANIFEST */
+
+/* BEGIN CHECK */
+typedef struct presets_chain_t
+{
+	cd_lowpass_t* lowpass;
+	cd_highpass_t* highpass;
+	cd_echo_t* echo;
+	cd_noise_t* noise;
+} presets_chain_t;
+
+static presets_chain_t make_chain(cd_context_t* context)
+{
+	presets_chain_t chain;
+	chain.lowpass = cd_make_lowpass_filter(context);
+	chain.highpass = cd_make_highpass_filter(context);
+	chain.echo = cd_make_echo_filter(context);
+	chain.noise = cd_make_noise_generator(context);
+	cd_set_noise_generator_stream(context, chain.noise, 0, 0);
+	return chain;
+}
+
+static void release_chain(cd_context_t* context, presets_chain_t* chain)
+{
+	cd_release_lowpass(context, &chain->lowpass);
+	cd_release_highpass(context, &chain->highpass);
+	cd_release_echo_filter(context, &chain->echo);
+	cd_release_noise(context, &chain->noise);
+}
+
+static void set_chain(presets_chain_t* chain, const cd_preset_t* preset)
+{
+	cd_set_lowpass_parameters(chain->lowpass, preset->lowpass_cutoff, preset->lowpass_resonance);
+	cd_set_highpass_cutoff_frequency(chain->highpass, preset->highpass_cutoff);
+	cd_set_echo_parameters(chain->echo, preset->echo_delay, preset->echo_mix, preset->echo_feedback);
+	cd_set_noise_generator_amplitude_db(chain->noise, preset->noise_db);
+}
+
+static void render_chain(cd_context_t* context, presets_chain_t* chain, const float* input, float* output)
+{
+	float* samples;
+	cd_sample_noise(context, chain->noise, input, &samples, PRESETS_BLOCK_SIZE);
+	cd_sample_lowpass(context, chain->lowpass, samples, &samples, PRESETS_BLOCK_SIZE);
+	cd_sample_highpass(context, chain->highpass, samples, &samples, PRESETS_BLOCK_SIZE);
+	cd_sample_echo(context, chain->echo, samples, &samples, PRESETS_BLOCK_SIZE);
+	memcpy(output, samples, sizeof(float) * PRESETS_BLOCK_SIZE);
+}
+
+// renders every preset through fresh filters, set once by the setters and once from the bank
+static int check_bank(const cd_file_view_t* file, const cd_preset_bank_def_t* def, float sampling_rate)
+{
+	static float input[PRESETS_BLOCK_SIZE], expected[PRESETS_BLOCK_SIZE], result[PRESETS_BLOCK_SIZE];
+	cd_context_def_t context_def;
+	cd_context_t* context;
+	cd_preset_bank_t* bank;
+	presets_chain_t setters, applied;
+	double start, set_time, apply_time;
+	unsigned i, mismatches = 0;
+	int round;
+
+	memset(&context_def, 0, sizeof(context_def));
+	context_def.playing_pool_count = 2;
+	context_def.sampling_rate = sampling_rate;
+	context_def.use_lowpass = context_def.use_highpass = context_def.use_echo = context_def.use_noise = 1;
+	context_def.echo_max_delay_s = CUTE_DSP_DEFAULT_ECHO_MAX_DELAY;
+	context_def.filter_order = def->filter_order;
+	context_def.filter_alignment = def->filter_alignment;
+	context_def.rand_seed = 2;
+	context = cd_make_context(NULL, context_def);
+
+	bank = cd_open_preset_bank(context, file->mapping, file->mapping_size);
+	if (!bank)
+	{
+		printf("%g hz: couldn't open the bank\n", sampling_rate);
+		cd_release_context(&context);
+		return 0;
+	}
+
+	for (i = 0; i < PRESETS_BLOCK_SIZE; ++i)
+		input[i] = (float)((i * 7919) % 65536) - 32768.f;
+
+	for (i = 0; i < def->preset_count; ++i)
+	{
+		int index = cd_find_preset(bank, def->presets[i].name);
+		if (index < 0)
+		{
+			printf("%g hz: preset %s is missing\n", sampling_rate, def->presets[i].name);
+			++mismatches;
+			continue;
+		}
+
+		setters = make_chain(context);
+		set_chain(&setters, def->presets + i);
+		render_chain(context, &setters, input, expected);
+		release_chain(context, &setters);
+
+		applied = make_chain(context);
+		cd_apply_preset_to_filters(bank, index, applied.lowpass, applied.highpass, applied.echo, applied.noise);
+		render_chain(context, &applied, input, result);
+		release_chain(context, &applied);
+
+		if (memcmp(expected, result, sizeof(expected)))
+		{
+			printf("%g hz: preset %s renders differently\n", sampling_rate, def->presets[i].name);
+			++mismatches;
+		}
+	}
+
+	setters = make_chain(context);
+	start = time_in_seconds();
+	for (round = 0; round < PRESETS_TIMING_ROUNDS; ++round)
+		for (i = 0; i < def->preset_count; ++i)
+			set_chain(&setters, def->presets + i);
+	set_time = time_in_seconds() - start;
+
+	start = time_in_seconds();
+	for (round = 0; round < PRESETS_TIMING_ROUNDS; ++round)
+		for (i = 0; i < def->preset_count; ++i)
+			cd_apply_preset_to_filters(bank, (int)i, setters.lowpass, setters.highpass, setters.echo, setters.noise);
+	apply_time = time_in_seconds() - start;
+	release_chain(context, &setters);
+
+	printf("%g hz: %u presets, %u mismatches, setters %.0f ns, bank %.0f ns per preset\n", sampling_rate, def->preset_count, mismatches,
+		set_time * 1e9 / (PRESETS_TIMING_ROUNDS * def->preset_count), apply_time * 1e9 / (PRESETS_TIMING_ROUNDS * def->preset_count));
+
+	cd_close_preset_bank(&bank);
+	cd_release_context(&context);
+	return mismatches == 0;
+}
+/* END CHECK */
+
+/* BEGIN MAIN */
+int main(int argc, char** argv)
+{
+	const char* manifest = NULL;
+	const char* output = NULL;
+	float rates[PRESETS_MAX_RATES] = { 44100.f, 48000.f };
+	cd_preset_bank_def_t def;
+	cd_file_view_t file;
+	int failed = 0, i;
+	unsigned r;
+
+	memset(&def, 0, sizeof(def));
+	def.sampling_rates = rates;
+	for (i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-r") && i + 1 < argc && def.sampling_rate_count < PRESETS_MAX_RATES)
+			rates[def.sampling_rate_count++] = (float)atof(argv[++i]);
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+			def.filter_order = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-lr"))
+			def.filter_alignment = CD_FILTER_LINKWITZ_RILEY;
+		else if (!manifest)
+			manifest = argv[i];
+		else
+			output = argv[i];
+	}
+	if (!manifest || !output)
+	{
+		printf("usage: %s [-r <rate>]... [-o <filter_order>] [-lr] <manifest> <bank>\n", argv[0]);
+		return 1;
+	}
+	if (!def.sampling_rate_count)
+		def.sampling_rate_count = 2;
+
+	def.presets = read_manifest(manifest, &def.preset_count);
+	if (!def.presets)
+		return 1;
+
+	if (!cd_write_preset_bank(output, def))
+	{
+		printf("Couldn't write %s, or two presets have the same name\n", output);
+		failed = 1;
+	}
+	else if (!cd_open_file_view(&file, output, 0))
+	{
+		printf("Couldn't map %s\n", output);
+		failed = 1;
+	}
+	else
+	{
+		printf("%s: %u presets at %u rates, %u bytes\n", output, def.preset_count, def.sampling_rate_count, (unsigned)file.mapping_size);
+		for (r = 0; r < def.sampling_rate_count; ++r)
+			failed |= !check_bank(&file, &def, rates[r]);
+		cd_close_file_view(&file);
+	}
+
+	for (r = 0; r < def.preset_count; ++r)
+		free((void*)def.presets[r].name);
+	free((void*)def.presets);
+	return failed;
+}
+/* END MAIN */
+
+/*
+	------------------------------------------------------------------------------
+	This software is available under 2 licenses - you may choose the one you like.
+	------------------------------------------------------------------------------
+	ALTERNATIVE A - zlib license
+	Copyright (c) 2019 Matthew Rosen
+	This software is provided 'as-is', without any express or implied warranty.
+	In no event will the authors be held liable for any damages arising from
+	the use of this software.
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+	  1. The origin of this software must not be misrepresented; you must not
+		 claim that you wrote the original software. If you use this software
+		 in a product, an acknowledgment in the product documentation would be
+		 appreciated but is not required.
+	  2. Altered source versions must be plainly marked as such, and must not
+		 be misrepresented as being the original software.
+	  3. This notice may not be removed or altered from any source distribution.
+	------------------------------------------------------------------------------
+	ALTERNATIVE B - Public Domain (www.unlicense.org)
+	This is free and unencumbered software released into the public domain.
+	Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+	software, either in source code form or as a compiled binary, for any purpose,
+	commercial or non-commercial, and by any means.
+	In jurisdictions that recognize copyright laws, the author or authors of this
+	software dedicate any and all copyright interest in the software to the public
+	domain. We make this dedication for the benefit of the public at large and to
+	the detriment of our heirs and successors. We intend this dedication to be an
+	overt act of relinquishment in perpetuity of all present and future rights to
+	this software under copyright law.
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+	ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+	------------------------------------------------------------------------------
+*/
+
@@ -0,0 +1,236 @@
+/*
+    ------------------------------------------------------------------------------
+		Licensing information can be found at the end of the file.
+	------------------------------------------------------------------------------
+
+    cute_dsp_replay.c - v1.1
+
+    To compile (linux):
+
+        cc -O2 -g cute_dsp_replay.c -lm -lpthread `sdl2-config --cflags --libs`
+
+    To run:
+
+        ./cute_dsp_replay <capture_file> [repeat_count] [--tiers]
+
+		<capture_file> = file recorded with cd_begin_capture, e.g. by ./cute_dsp_test <test_num> <capture_file>
+		[repeat_count] = number of times to replay the capture, defaults to 1
+		[--tiers]      = also replays it with every voice at each quality tier, and with automatic tiers
+
+		To profile a recorded session:
+
+		perf record -g ./cute_dsp_replay session.cdcp 50
+
+    Summary:
+        Re-drives a fresh cute_dsp context with a captured session, without an audio device.
+        Every replay is checked to hash to the same output so the profile matches the session bit for bit.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CUTE_SOUND_IMPLEMENTATION
+#include "../../cute_headers/cute_sound.h"
+
+#define CUTE_DSP_IMPLEMENTATION
+#include "../cute_dsp.h"
+
+/* BEGIN TIMER */
+#if defined(_WIN32)
+#include <windows.h>
+static double time_in_seconds(void)
+{
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+#else
+static double time_in_seconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+#endif
+/* END TIMER */
+
+static void* read_file(const char* path, size_t* size)
+{
+	void* data = NULL;
+	long length;
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return NULL;
+
+	fseek(file, 0, SEEK_END);
+	length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (length > 0)
+	{
+		data = malloc((size_t)length);
+		if (data && fread(data, 1, (size_t)length, file) != (size_t)length)
+		{
+			free(data);
+			data = NULL;
+		}
+	}
+	fclose(file);
+	*size = (size_t)length;
+	return data;
+}
+
+static const char* tier_names[] = { "full", "reduced", "minimal", "auto" };
+
+// best time of repeat_count replays at the given tier
+static double replay_at_tier(const void* capture, size_t size, cd_quality_tier_t tier, int repeat_count, cd_replay_stats_t* stats)
+{
+	double best_time = 0.0;
+	int i;
+	for (i = 0; i < repeat_count; ++i)
+	{
+		double start = time_in_seconds(), elapsed;
+		cd_replay_capture_at_tier(capture, size, tier, stats);
+		elapsed = time_in_seconds() - start;
+		if (i == 0 || elapsed < best_time)
+			best_time = elapsed;
+	}
+	return best_time;
+}
+
+/* BEGIN MAIN */
+int main(int argc, char** argv)
+{
+	size_t size = 0;
+	void* capture;
+	int repeat_count = 1;
+	int tiers = 0;
+	int i;
+	double total_time = 0.0, best_time = 0.0;
+	cd_replay_stats_t first, stats;
+
+	if (argc > 2 && !strcmp(argv[argc - 1], "--tiers"))
+	{
+		tiers = 1;
+		--argc;
+	}
+	if (argc != 2 && argc != 3)
+	{
+		printf("Invalid number of arguments!\n");
+		printf("Usage: \n");
+		printf("    ./cute_dsp_replay <capture_file> [repeat_count] [--tiers]\n\n");
+		return 1;
+	}
+
+	if (argc == 3)
+		repeat_count = atoi(argv[2]);
+	if (repeat_count < 1)
+		repeat_count = 1;
+
+	capture = read_file(argv[1], &size);
+	if (!capture)
+	{
+		printf("Couldn't read capture file %s\n", argv[1]);
+		return 1;
+	}
+
+	for (i = 0; i < repeat_count; ++i)
+	{
+		double start = time_in_seconds(), elapsed;
+		if (!cd_replay_capture(capture, size, &stats))
+		{
+			printf("%s is not a valid capture, or it is truncated.\n", argv[1]);
+			free(capture);
+			return 1;
+		}
+		elapsed = time_in_seconds() - start;
+		total_time += elapsed;
+		if (i == 0 || elapsed < best_time)
+			best_time = elapsed;
+
+		if (i == 0)
+		{
+			first = stats;
+		}
+		else if (stats.output_hash != first.output_hash)
+		{
+			printf("Replay %d diverged: output hash %08x, expected %08x\n", i, stats.output_hash, first.output_hash);
+			free(capture);
+			return 1;
+		}
+	}
+
+	printf("Capture:    %s (%lu bytes)\n", argv[1], (unsigned long)size);
+	printf("Events:     %u spawns, %u frees, %u parameters, %u mixes\n", first.spawns, first.frees, first.parameters, first.mixes);
+	printf("Blocks:     %u\n", first.blocks);
+	printf("Samples:    %llu\n", first.samples);
+	printf("Output:     %08x\n", first.output_hash);
+	printf("Replays:    %d, best %.3f ms, average %.3f ms\n", repeat_count, best_time * 1000.0, total_time * 1000.0 / repeat_count);
+	if (first.samples)
+		printf("Throughput: %.2f ns per sample\n", best_time * 1e9 / (double)first.samples);
+
+	if (tiers && first.samples)
+	{
+		int tier;
+		for (tier = CD_TIER_FULL; tier <= CD_TIER_AUTO; ++tier)
+		{
+			double time = replay_at_tier(capture, size, (cd_quality_tier_t)tier, repeat_count, &stats);
+			printf("Tier %-8s %.2f ns per sample", tier_names[tier], time * 1e9 / (double)stats.samples);
+			if (tier == CD_TIER_AUTO)
+				printf(", %.1f%% full, %.1f%% reduced, %.1f%% minimal",
+					100.0 * stats.tier_samples[CD_TIER_FULL] / stats.samples,
+					100.0 * stats.tier_samples[CD_TIER_REDUCED] / stats.samples,
+					100.0 * stats.tier_samples[CD_TIER_MINIMAL] / stats.samples);
+			printf("\n");
+		}
+	}
+
+	free(capture);
+	return 0;
+}
+/* END MAIN */
+
+/*
+	------------------------------------------------------------------------------
+	This software is available under 2 licenses - you may choose the one you like.
+	------------------------------------------------------------------------------
+	ALTERNATIVE A - zlib license
+	Copyright (c) 2019 Matthew Rosen
+	This software is provided 'as-is', without any express or implied warranty.
+	In no event will the authors be held liable for any damages arising from
+	the use of this software.
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+	  1. The origin of this software must not be misrepresented; you must not
+		 claim that you wrote the original software. If you use this software
+		 in a product, an acknowledgment in the product documentation would be
+		 appreciated but is not required.
+	  2. Altered source versions must be plainly marked as such, and must not
+		 be misrepresented as being the original software.
+	  3. This notice may not be removed or altered from any source distribution.
+	------------------------------------------------------------------------------
+	ALTERNATIVE B - Public Domain (www.unlicense.org)
+	This is free and unencumbered software released into the public domain.
+	Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+	software, either in source code form or as a compiled binary, for any purpose,
+	commercial or non-commercial, and by any means.
+	In jurisdictions that recognize copyright laws, the author or authors of this
+	software dedicate any and all copyright interest in the software to the public
+	domain. We make this dedication for the benefit of the public at large and to
+	the detriment of our heirs and successors. We intend this dedication to be an
+	overt act of relinquishment in perpetuity of all present and future rights to
+	this software under copyright law.
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+	ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+	------------------------------------------------------------------------------
+*/
+
@@ -0,0 +1,869 @@
+/*
+    ------------------------------------------------------------------------------
+		Licensing information can be found at the end of the file.
+	------------------------------------------------------------------------------
+
+    cute_dsp_suite.c - v1.0
+
+    To compile (linux):
+
+        cc -O2 cute_dsp_suite.c cute_dsp_audio_data.c -lm -lpthread `sdl2-config --cflags --libs`
+
+    To run (from the test folder, so the .wav files are found):
+
+        ./cute_dsp_suite [--bless] [--bench <repeats>] [--csv <file>] [case_filter]
+
+		--bless            rewrites cute_dsp_golden.txt with the current outputs
+		--bench <repeats>  renders every case <repeats> times and keeps the best time
+		--csv <file>       also writes the per case throughput to <file>
+		[case_filter]      only runs cases whose name contains this string
+
+    Summary:
+        Non-interactive regression suite for cute_dsp.h. Renders every test .wav through every
+        filter at many parameter settings with a detached context, compares the outputs against
+        the golden fingerprints in cute_dsp_golden.txt and reports the throughput of every case.
+        Returns nonzero if any case is missing or differs from its golden output.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define CUTE_SOUND_IMPLEMENTATION
+#include "../../cute_headers/cute_sound.h"
+
+#define CUTE_DSP_IMPLEMENTATION
+#include "../cute_dsp.h"
+
+#include "cute_dsp_audio_data.h"
+
+#define SUITE_GOLDEN_FILE "cute_dsp_golden.txt"
+#define SUITE_BLOCK_SIZE 512	// frames per cd_sample_* call, close to what cute_sound mixes
+#define SUITE_SEGMENTS 16		// fingerprint segments per channel
+#define SUITE_MAX_STAGES 4
+#define SUITE_MAX_CHANNELS 2
+#define SUITE_ABSOLUTE_TOLERANCE (1e-5f)
+#define SUITE_RELATIVE_TOLERANCE (1e-3f)
+
+/* BEGIN TIMER */
+#if defined(_WIN32)
+#include <windows.h>
+static double time_in_seconds(void)
+{
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+#else
+static double time_in_seconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+#endif
+/* END TIMER */
+
+/* BEGIN EFFECTS */
+typedef enum suite_effect_t
+{
+	SUITE_NONE,
+	SUITE_LOWPASS,
+	SUITE_HIGHPASS,
+	SUITE_ECHO,
+	SUITE_NOISE,
+	SUITE_CONVOLUTION,
+	SUITE_SVF,
+	SUITE_WIND,
+	SUITE_CHORUS,
+	SUITE_REFLECTIONS,
+	SUITE_REVERB,	// stereo, always the last stage of a case
+	SUITE_EFFECT_COUNT
+} suite_effect_t;
+
+typedef struct suite_stage_t
+{
+	suite_effect_t effect;
+	float a, b, c, d, e;	// effect parameters, see the make functions
+} suite_stage_t;
+
+typedef struct suite_effect_def_t
+{
+	void* (*make)(cd_context_t* context, const suite_stage_t* stage);
+	void (*sample)(cd_context_t* context, void* filter, const float* input, float** output, unsigned num_samples);
+	void (*release)(cd_context_t* context, void* filter);
+} suite_effect_def_t;
+
+/* a = cutoff in hz, b = resonance */
+static void* make_lowpass(cd_context_t* context, const suite_stage_t* stage)
+{
+	cd_lowpass_t* filter = cd_make_lowpass_filter(context);
+	cd_set_lowpass_parameters(filter, stage->a, stage->b);
+	return filter;
+}
+
+static void sample_lowpass(cd_context_t* context, void* filter, const float* input, float** output, unsigned num_samples)
+{
+	cd_sample_lowpass(context, (cd_lowpass_t*)filter, input, output, num_samples);
+}
+
+static void release_lowpass(cd_context_t* context, void* filter)
+{
+	cd_lowpass_t* lowpass = (cd_lowpass_t*)filter;
+	cd_release_lowpass(context, &lowpass);
+}
+
+/* a = cutoff in hz */
+static void* make_highpass(cd_context_t* context, const suite_stage_t* stage)
+{
+	cd_highpass_t* filter = cd_make_highpass_filter(context);
+	cd_set_highpass_cutoff_frequency(filter, stage->a);
+	return filter;
+}
+
+static void sample_highpass(cd_context_t* context, void* filter, const float* input, float** output, unsigned num_samples)
+{
+	cd_sample_highpass(context, (cd_highpass_t*)filter, input, output, num_samples);
+}
+
+static void release_highpass(cd_context_t* context, void* filter)
+{
+	cd_highpass_t* highpass = (cd_highpass_t*)filter;
+	cd_release_highpass(context, &highpass);
+}
+
+/* a = delay in seconds, b = mix, c = feedback */
+static void* make_echo(cd_context_t* context, const suite_stage_t* stage)
+{
+	cd_echo_t* filter = cd_make_echo_filter(context);
+	cd_set_echo_parameters(filter, stage->a, stage->b, stage->c);
+	return filter;
+}
+
+static void sample_echo(cd_context_t* context, void* filter, const float* input, float** output, unsigned num_samples)
+{
+	cd_sample_echo(context, (cd_echo_t*)filter, input, output, num_samples);
+}
+
+static void release_echo(cd_context_t* context, void* filter)
+{
+	cd_echo_t* echo = (cd_echo_t*)filter;
+	cd_release_echo_filter(context, &echo);
+}
+
+/* a = amplitude in db, b = cd_noise_color_t */
+static void* make_noise(cd_context_t* context, const suite_stage_t* stage)
+{
+	cd_noise_t* filter = cd_make_noise_generator(context);
+	cd_set_noise_generator_amplitude_db(filter, stage->a);
+	cd_set_noise_generator_color(filter, (cd_noise_color_t)(int)stage->b);
+	return filter;
+}
+
+static void sample_noise(cd_context_t* context, void* filter, const float* input, float** output, unsigned num_samples)
+{
+	cd_sample_noise(context, (cd_noise_t*)filter, input, output, num_samples);
+}
+
+static void release_noise(cd_context_t* context, void* filter)
+{
+	cd_noise_t* noise = (cd_noise_t*)filter;
+	cd_release_noise(context, &noise);
+}
+
+/* a = length of the impulse response in seconds, a synthetic tail of noise falling 60dB over its length */
+typedef struct suite_convolution_t
+{
+	cd_impulse_response_t* impulse_response;
+	cd_convolver_t* convolver;
+} suite_convolution_t;
+
+static void* make_convolution(cd_context_t* context, const suite_stage_t* stage)
+{
+	suite_convolution_t* convolution = (suite_convolution_t*)malloc(sizeof(suite_convolution_t));
+	unsigned i, frames = (unsigned)(stage->a * context->sampling_rate);
+	unsigned seed = 12345;
+	float* samples = (float*)malloc(sizeof(float) * frames);
+	const float* channels[1];
+	for (i = 0; i < frames; ++i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		samples[i] = ((float)(seed >> 8) / 8388608.f - 1.f) * powf(0.001f, (float)i / (float)frames) * 0.05f;
+	}
+	channels[0] = samples;
+	convolution->impulse_response = cd_make_impulse_response(context, channels, 1, frames);
+	convolution->convolver = cd_make_convolver(context, convolution->impulse_response, 0);
+	free(samples);
+	return convolution;
+}
+
+static void sample_convolution(cd_context_t* context, void* filter, const float* input, float** output, unsigned num_samples)
+{
+	cd_sample_convolver(context, ((suite_convolution_t*)filter)->convolver, input, output, num_samples);
+}
+
+static void release_convolution(cd_context_t* context, void* filter)
+{
+	suite_convolution_t* convolution = (suite_convolution_t*)filter;
+	cd_release_convolver(context, &convolution->convolver);
+	cd_release_impulse_response(context, &convolution->impulse_response);
+	free(convolution);
+}
+
+/* a = cutoff in hz, b = resonance, c = depth in octaves of a 0.5Hz triangle sweep of the cutoff, modulated every sample */
+typedef struct suite_svf_t
+{
+	cd_svf_t* filter;
+	float depth;
+	float octave;	// position of the sweep, in [-depth, depth]
+	float step;	// octaves per sample, negative on the way down
+	float cutoffs[SUITE_BLOCK_SIZE];
+} suite_svf_t;
+
+static void* make_svf(cd_context_t* context, const suite_stage_t* stage)
+{
+	suite_svf_t* svf = (suite_svf_t*)malloc(sizeof(suite_svf_t));
+	svf->filter = cd_make_svf(context);
+	cd_set_svf_parameters(svf->filter, stage->a, stage->b);
+	svf->depth = stage->c;
+	svf->octave = 0.f;
+	svf->step = 4.f * stage->c * 0.5f / context->sampling_rate;
+	return svf;
+}
+
+static void sample_svf(cd_context_t* context, void* filter, const float* input, float** output, unsigned num_samples)
+{
+	suite_svf_t* svf = (suite_svf_t*)filter;
+	float cutoff, ratio;
+	unsigned i;
+	if (svf->depth == 0.f)
+	{
+		cd_sample_svf(context, svf->filter, input, NULL, output, num_samples);
+		return;
+	}
+
+	// exponential within the block, so the harness costs one multiply per sample
+	cutoff = cd_get_svf_cutoff(svf->filter) * powf(2.f, svf->octave);
+	ratio = powf(2.f, svf->step);
+	for (i = 0; i < num_samples; ++i, cutoff *= ratio)
+		svf->cutoffs[i] = cutoff;
+	svf->octave += svf->step * (float)num_samples;
+	if ((svf->step > 0.f && svf->octave >= svf->depth) || (svf->step < 0.f && svf->octave <= -svf->depth))
+		svf->step = -svf->step;
+	cd_sample_svf(context, svf->filter, input, svf->cutoffs, output, num_samples);
+}
+
+static void release_svf(cd_context_t* context, void* filter)
+{
+	suite_svf_t* svf = (suite_svf_t*)filter;
+	cd_release_svf(context, &svf->filter);
+	free(svf);
+}
+
+/* a = cd_wind_preset_t, b = resonance and c = whistle resonance when above 0, added to the input */
+static void* make_wind(cd_context_t* context, const suite_stage_t* stage)
+{
+	cd_wind_def_t def = cd_get_wind_preset((cd_wind_preset_t)(int)stage->a);
+	if (stage->b > 0.f)
+		def.resonance = stage->b;
+	if (stage->c > 0.f)
+		def.whistle_resonance = stage->c;
+	return cd_make_wind(context, def);
+}
+
+static void sample_wind(cd_context_t* context, void* filter, const float* input, float** output, unsigned num_samples)
+{
+	cd_sample_wind(context, (cd_wind_t*)filter, input, output, num_samples);
+}
+
+static void release_wind(cd_context_t* context, void* filter)
+{
+	cd_wind_t* wind = (cd_wind_t*)filter;
+	cd_release_wind(context, &wind);
+}
+
+/* a = delay in seconds, b = depth in seconds, c = rate in hz, d = feedback, e = taps, mixed at 0.5 */
+static void* make_chorus(cd_context_t* context, const suite_stage_t* stage)
+{
+	cd_chorus_t* filter = cd_make_chorus(context);
+	cd_set_chorus_parameters(filter, stage->a, stage->b, stage->c, 0.5f, stage->d, (unsigned)stage->e);
+	return filter;
+}
+
+static void sample_chorus(cd_context_t* context, void* filter, const float* input, float** output, unsigned num_samples)
+{
+	cd_sample_chorus(context, (cd_chorus_t*)filter, input, output, num_samples);
+}
+
+static void release_chorus(cd_context_t* context, void* filter)
+{
+	cd_chorus_t* chorus = (cd_chorus_t*)filter;
+	cd_release_chorus(context, &chorus);
+}
+
+/* a = tap count, b = damping of every other tap in hz, synthetic reflections between 5 and 80 ms falling with their delay */
+typedef struct suite_reflections_t
+{
+	cd_tap_set_t* tap_set;
+	cd_multitap_t* multitap;
+} suite_reflections_t;
+
+static void* make_reflections(cd_context_t* context, const suite_stage_t* stage)
+{
+	suite_reflections_t* reflections = (suite_reflections_t*)malloc(sizeof(suite_reflections_t));
+	cd_tap_def_t taps[32];
+	int i, count = (int)stage->a;
+	unsigned seed = 54321;
+	for (i = 0; i < count; ++i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		taps[i].delay = 0.005f + 0.075f * (float)(seed >> 8) / 16777216.f;
+		taps[i].gains[0] = taps[i].gains[1] = ((i & 2) ? -0.6f : 0.6f) * (1.f - taps[i].delay * 10.f);
+		taps[i].damping_hz = (i & 1) ? stage->b : 0.f;
+	}
+	reflections->tap_set = cd_make_tap_set(context, taps, count);
+	reflections->multitap = cd_make_multitap(context, reflections->tap_set, 0);
+	return reflections;
+}
+
+static void sample_reflections(cd_context_t* context, void* filter, const float* input, float** output, unsigned num_samples)
+{
+	cd_sample_multitap(context, ((suite_reflections_t*)filter)->multitap, input, output, num_samples);
+}
+
+static void release_reflections(cd_context_t* context, void* filter)
+{
+	suite_reflections_t* reflections = (suite_reflections_t*)filter;
+	cd_release_multitap(context, &reflections->multitap);
+	cd_release_tap_set(context, &reflections->tap_set);
+	free(reflections);
+}
+
+static const suite_effect_def_t suite_effects[SUITE_EFFECT_COUNT] = {
+	{ NULL, NULL, NULL },
+	{ make_lowpass, sample_lowpass, release_lowpass },
+	{ make_highpass, sample_highpass, release_highpass },
+	{ make_echo, sample_echo, release_echo },
+	{ make_noise, sample_noise, release_noise },
+	{ make_convolution, sample_convolution, release_convolution },
+	{ make_svf, sample_svf, release_svf },
+	{ make_wind, sample_wind, release_wind },
+	{ make_chorus, sample_chorus, release_chorus },
+	{ make_reflections, sample_reflections, release_reflections },
+	{ NULL, NULL, NULL },	// run by render_case over both channels at once
+};
+/* END EFFECTS */
+
+/* BEGIN CASES */
+typedef struct suite_case_t
+{
+	const char* name;
+	suite_stage_t stages[SUITE_MAX_STAGES];
+	unsigned filter_order;	// cd_context_def_t options, 0 for the defaults
+	cd_filter_alignment_t filter_alignment;
+} suite_case_t;
+
+/* every case is rendered for every file */
+static const suite_case_t suite_cases[] = {
+	{ "dry", { { SUITE_NONE } } },
+	{ "lowpass_200", { { SUITE_LOWPASS, 200.f, 0.f } } },
+	{ "lowpass_1000", { { SUITE_LOWPASS, 1000.f, 0.f } } },
+	{ "lowpass_5000", { { SUITE_LOWPASS, 5000.f, 0.f } } },
+	{ "lowpass_20000", { { SUITE_LOWPASS, 20000.f, 0.f } } },
+	{ "lowpass_200_res_0.5", { { SUITE_LOWPASS, 200.f, 0.5f } } },
+	{ "lowpass_1000_res_0.5", { { SUITE_LOWPASS, 1000.f, 0.5f } } },
+	{ "lowpass_1000_res_0.9", { { SUITE_LOWPASS, 1000.f, 0.9f } } },
+	{ "lowpass_5000_res_0.9", { { SUITE_LOWPASS, 5000.f, 0.9f } } },
+	{ "highpass_20", { { SUITE_HIGHPASS, 20.f } } },
+	{ "highpass_200", { { SUITE_HIGHPASS, 200.f } } },
+	{ "highpass_2000", { { SUITE_HIGHPASS, 2000.f } } },
+	{ "highpass_8000", { { SUITE_HIGHPASS, 8000.f } } },
+	{ "lowpass_1000_order_4", { { SUITE_LOWPASS, 1000.f, 0.f } }, 4 },
+	{ "lowpass_1000_order_8", { { SUITE_LOWPASS, 1000.f, 0.f } }, 8 },
+	{ "lowpass_1000_res_0.5_order_4", { { SUITE_LOWPASS, 1000.f, 0.5f } }, 4 },
+	{ "highpass_200_order_4", { { SUITE_HIGHPASS, 200.f } }, 4 },
+	{ "highpass_200_order_8", { { SUITE_HIGHPASS, 200.f } }, 8 },
+	{ "lowpass_1000_lr_4", { { SUITE_LOWPASS, 1000.f, 0.f } }, 4, CD_FILTER_LINKWITZ_RILEY },
+	{ "highpass_1000_lr_4", { { SUITE_HIGHPASS, 1000.f } }, 4, CD_FILTER_LINKWITZ_RILEY },
+	{ "svf_1000", { { SUITE_SVF, 1000.f, 0.f } } },
+	{ "svf_1000_res_0.9", { { SUITE_SVF, 1000.f, 0.9f } } },
+	{ "svf_sweep_1000_2", { { SUITE_SVF, 1000.f, 0.f, 2.f } } },
+	{ "svf_sweep_1000_3_res_0.7", { { SUITE_SVF, 1000.f, 0.7f, 3.f } } },
+	{ "echo_0.1_0.5_0.3", { { SUITE_ECHO, 0.1f, 0.5f, 0.3f } } },
+	{ "echo_0.25_0.7_0.6", { { SUITE_ECHO, 0.25f, 0.7f, 0.6f } } },
+	{ "echo_0.5_0.3_0", { { SUITE_ECHO, 0.5f, 0.3f, 0.f } } },
+	{ "echo_0.0371_0.5_0.5", { { SUITE_ECHO, 0.0371f, 0.5f, 0.5f } } },
+	{ "noise_-96", { { SUITE_NOISE, -96.f } } },
+	{ "noise_-40", { { SUITE_NOISE, -40.f } } },
+	{ "noise_-12", { { SUITE_NOISE, -12.f } } },
+	{ "noise_pink_-40", { { SUITE_NOISE, -40.f, CD_NOISE_PINK } } },
+	{ "noise_brown_-40", { { SUITE_NOISE, -40.f, CD_NOISE_BROWN } } },
+	{ "noise_velvet_-40", { { SUITE_NOISE, -40.f, CD_NOISE_VELVET } } },
+	{ "wind_breeze", { { SUITE_WIND, CD_WIND_BREEZE } } },
+	{ "wind_gale", { { SUITE_WIND, CD_WIND_GALE } } },
+	{ "wind_howling", { { SUITE_WIND, CD_WIND_HOWLING } } },
+	{ "wind_breeze_res_1", { { SUITE_WIND, CD_WIND_BREEZE, 1.f } } },
+	{ "wind_howling_whistle_res_1", { { SUITE_WIND, CD_WIND_HOWLING, 0.f, 1.f } } },
+	{ "chorus_0.02_0.005_0.8_3", { { SUITE_CHORUS, 0.02f, 0.005f, 0.8f, 0.f, 3.f } } },
+	{ "chorus_0.015_0.003_2_4", { { SUITE_CHORUS, 0.015f, 0.003f, 2.f, 0.f, 4.f } } },
+	{ "flanger_0.002_0.0015_0.25_0.7", { { SUITE_CHORUS, 0.002f, 0.0015f, 0.25f, 0.7f, 1.f } } },
+	{ "flanger_0.001_0.0008_0.5_-0.6", { { SUITE_CHORUS, 0.001f, 0.0008f, 0.5f, -0.6f, 1.f } } },
+	{ "reflections_8", { { SUITE_REFLECTIONS, 8.f, 0.f } } },
+	{ "reflections_16_4000", { { SUITE_REFLECTIONS, 16.f, 4000.f } } },
+	{ "reflections_32_2500", { { SUITE_REFLECTIONS, 32.f, 2500.f } } },
+	{ "chain_muffled", { { SUITE_NOISE, -60.f }, { SUITE_LOWPASS, 800.f, 0.3f }, { SUITE_HIGHPASS, 80.f }, { SUITE_ECHO, 0.15f, 0.4f, 0.3f } } },
+	{ "chain_radio", { { SUITE_HIGHPASS, 500.f }, { SUITE_LOWPASS, 3000.f, 0.7f }, { SUITE_NOISE, -30.f } } },
+	{ "reverb_0.3_0", { { SUITE_REVERB, 0.3f, 0.f } } },
+	{ "reverb_1.5_0.3", { { SUITE_REVERB, 1.5f, 0.3f } } },
+	{ "reverb_4_0.8", { { SUITE_REVERB, 4.f, 0.8f } } },
+	{ "chain_hall", { { SUITE_HIGHPASS, 120.f }, { SUITE_LOWPASS, 6000.f, 0.f }, { SUITE_REVERB, 2.5f, 0.5f } } },
+	{ "convolution_0.01", { { SUITE_CONVOLUTION, 0.01f } } },
+	{ "convolution_0.5", { { SUITE_CONVOLUTION, 0.5f } } },
+	{ "convolution_2", { { SUITE_CONVOLUTION, 2.f } } },
+	{ "convolution_4", { { SUITE_CONVOLUTION, 4.f } } },
+};
+
+static const char* suite_files[] = {
+	"music2.wav",
+	"stinger1.wav",
+	"stinger2.wav",
+	"example-input.wav",
+};
+
+#define SUITE_CASE_COUNT (sizeof(suite_cases) / sizeof(suite_cases[0]))
+#define SUITE_FILE_COUNT (sizeof(suite_files) / sizeof(suite_files[0]))
+/* END CASES */
+
+/* BEGIN RENDERING */
+typedef struct suite_audio_t
+{
+	float sampling_rate;
+	unsigned channel_count;
+	unsigned frames;
+	float* channels[SUITE_MAX_CHANNELS];	// deinterleaved, in [-1, 1]
+} suite_audio_t;
+
+static int load_audio(const char* filename, suite_audio_t* audio)
+{
+	float tile[SUITE_BLOCK_SIZE * SUITE_MAX_CHANNELS];
+	unsigned i, c, frame;
+	cd_wav_view_t view;
+	if (!cd_open_wav_view(&view, filename))
+		return 0;
+	if (view.channel_count > SUITE_MAX_CHANNELS)
+	{
+		cd_close_wav_view(&view);
+		return 0;
+	}
+
+	audio->sampling_rate = view.sampling_rate;
+	audio->channel_count = (unsigned)view.channel_count;
+	audio->frames = view.num_samples / audio->channel_count;
+	for (c = 0; c < audio->channel_count; ++c)
+		audio->channels[c] = (float*)malloc(sizeof(float) * audio->frames);
+
+	// convert straight out of the mapping a tile at a time, then deinterleave
+	for (frame = 0; frame < audio->frames; frame += SUITE_BLOCK_SIZE)
+	{
+		unsigned count = audio->frames - frame < SUITE_BLOCK_SIZE ? audio->frames - frame : SUITE_BLOCK_SIZE;
+		cd_convert_wav_view(&view, frame * audio->channel_count, count * audio->channel_count, tile, 1.f);
+		for (c = 0; c < audio->channel_count; ++c)
+			for (i = 0; i < count; ++i)
+				audio->channels[c][frame + i] = tile[i * audio->channel_count + c];
+	}
+	cd_close_wav_view(&view);
+	return 1;
+}
+
+static void release_audio(suite_audio_t* audio)
+{
+	unsigned c;
+	for (c = 0; c < audio->channel_count; ++c)
+		free(audio->channels[c]);
+	memset(audio, 0, sizeof(suite_audio_t));
+}
+
+/* a = decay in seconds, b = damping, the output is only the reverberated signal */
+static cd_reverb_t* make_reverb(cd_context_t* context, const suite_case_t* test)
+{
+	unsigned s;
+	cd_reverb_t* reverb;
+	for (s = 0; s < SUITE_MAX_STAGES && test->stages[s].effect != SUITE_REVERB; ++s);
+	if (s == SUITE_MAX_STAGES)
+		return NULL;
+	reverb = cd_make_reverb(context);
+	cd_set_reverb_parameters(reverb, test->stages[s].a, test->stages[s].b);
+	return reverb;
+}
+
+/* renders the case block by block through a fresh detached context, channels interleaved per block like cute_sound */
+static void render_case(const suite_case_t* test, const suite_audio_t* input, float** output)
+{
+	void* filters[SUITE_MAX_CHANNELS][SUITE_MAX_STAGES] = { { 0 } };
+	unsigned start, c, s;
+	cd_context_def_t def;
+	cd_context_t* context;
+	cd_reverb_t* reverb;
+
+	memset(&def, 0, sizeof(def));
+	def.playing_pool_count = SUITE_MAX_CHANNELS * SUITE_MAX_STAGES;
+	def.sampling_rate = input->sampling_rate;
+	def.use_lowpass = 1;
+	def.use_highpass = 1;
+	def.use_echo = 1;
+	def.use_noise = 1;
+	def.use_chorus = 1;
+	def.rand_seed = 2;
+	def.filter_order = test->filter_order;
+	def.filter_alignment = test->filter_alignment;
+	context = cd_make_context(NULL, def);
+
+	for (c = 0; c < input->channel_count; ++c)
+		for (s = 0; s < SUITE_MAX_STAGES && test->stages[s].effect != SUITE_NONE && test->stages[s].effect != SUITE_REVERB; ++s)
+			filters[c][s] = suite_effects[test->stages[s].effect].make(context, test->stages + s);
+	reverb = make_reverb(context, test);
+
+	for (start = 0; start < input->frames; start += SUITE_BLOCK_SIZE)
+	{
+		unsigned count = input->frames - start < SUITE_BLOCK_SIZE ? input->frames - start : SUITE_BLOCK_SIZE;
+		for (c = 0; c < input->channel_count; ++c)
+		{
+			const float* samples = input->channels[c] + start;
+			for (s = 0; s < SUITE_MAX_STAGES && filters[c][s]; ++s)
+			{
+				float* out;
+				suite_effects[test->stages[s].effect].sample(context, filters[c][s], samples, &out, count);
+				samples = out;
+			}
+			memcpy(output[c] + start, samples, sizeof(float) * count);
+		}
+
+		// mono files feed both sides of the reverb and keep the left output
+		if (reverb)
+		{
+			float* left;
+			float* right;
+			cd_sample_reverb(context, reverb, output[0] + start, output[input->channel_count - 1] + start, &left, &right, count);
+			memcpy(output[0] + start, left, sizeof(float) * count);
+			if (input->channel_count > 1)
+				memcpy(output[1] + start, right, sizeof(float) * count);
+		}
+	}
+
+	for (c = 0; c < input->channel_count; ++c)
+		for (s = 0; s < SUITE_MAX_STAGES && filters[c][s]; ++s)
+			suite_effects[test->stages[s].effect].release(context, filters[c][s]);
+	if (reverb)
+		cd_release_reverb(context, &reverb);
+	cd_release_context(&context);
+}
+/* END RENDERING */
+
+/* BEGIN GOLDEN OUTPUTS */
+typedef struct suite_fingerprint_t
+{
+	float rms;
+	float mean;
+	float peak;
+} suite_fingerprint_t;
+
+typedef struct suite_golden_t
+{
+	char name[128];
+	unsigned channel_count;
+	unsigned frames;
+	suite_fingerprint_t segments[SUITE_MAX_CHANNELS][SUITE_SEGMENTS];
+} suite_golden_t;
+
+static void fingerprint(float** output, unsigned channel_count, unsigned frames, suite_golden_t* golden)
+{
+	unsigned c, s, i;
+	golden->channel_count = channel_count;
+	golden->frames = frames;
+	for (c = 0; c < channel_count; ++c)
+	{
+		for (s = 0; s < SUITE_SEGMENTS; ++s)
+		{
+			unsigned begin = (unsigned)((unsigned long long)frames * s / SUITE_SEGMENTS);
+			unsigned end = (unsigned)((unsigned long long)frames * (s + 1) / SUITE_SEGMENTS);
+			double sum = 0.0, sum_squares = 0.0;
+			float peak = 0.f;
+			for (i = begin; i < end; ++i)
+			{
+				float x = output[c][i];
+				sum += x;
+				sum_squares += (double)x * x;
+				if (fabsf(x) > peak) peak = fabsf(x);
+			}
+			golden->segments[c][s].rms = end > begin ? (float)sqrt(sum_squares / (end - begin)) : 0.f;
+			golden->segments[c][s].mean = end > begin ? (float)(sum / (end - begin)) : 0.f;
+			golden->segments[c][s].peak = peak;
+		}
+	}
+}
+
+static int within_tolerance(float value, float expected)
+{
+	return fabsf(value - expected) <= SUITE_ABSOLUTE_TOLERANCE + SUITE_RELATIVE_TOLERANCE * fabsf(expected);
+}
+
+static int compare_fingerprints(const suite_golden_t* result, const suite_golden_t* golden)
+{
+	unsigned c, s;
+	if (result->channel_count != golden->channel_count || result->frames != golden->frames)
+		return 0;
+	for (c = 0; c < golden->channel_count; ++c)
+	{
+		for (s = 0; s < SUITE_SEGMENTS; ++s)
+		{
+			const suite_fingerprint_t* a = &result->segments[c][s];
+			const suite_fingerprint_t* b = &golden->segments[c][s];
+			if (!within_tolerance(a->rms, b->rms) || !within_tolerance(a->mean, b->mean) || !within_tolerance(a->peak, b->peak))
+				return 0;
+		}
+	}
+	return 1;
+}
+
+static suite_golden_t* read_goldens(const char* filename, unsigned* count)
+{
+	char line[256];
+	unsigned capacity = 64;
+	suite_golden_t* goldens = (suite_golden_t*)malloc(sizeof(suite_golden_t) * capacity);
+	suite_golden_t* golden = NULL;
+	unsigned segment = 0;
+	FILE* file = fopen(filename, "r");
+
+	*count = 0;
+	if (!file)
+		return goldens;
+
+	while (fgets(line, sizeof(line), file))
+	{
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+
+		if (!strncmp(line, "case ", 5))
+		{
+			if (*count == capacity)
+			{
+				capacity *= 2;
+				goldens = (suite_golden_t*)realloc(goldens, sizeof(suite_golden_t) * capacity);
+			}
+			golden = goldens + (*count)++;
+			memset(golden, 0, sizeof(suite_golden_t));
+			sscanf(line + 5, "%127s %u %u", golden->name, &golden->channel_count, &golden->frames);
+			segment = 0;
+		}
+		else if (golden && segment < golden->channel_count * SUITE_SEGMENTS)
+		{
+			suite_fingerprint_t* f = &golden->segments[segment / SUITE_SEGMENTS][segment % SUITE_SEGMENTS];
+			sscanf(line, "%g %g %g", &f->rms, &f->mean, &f->peak);
+			++segment;
+		}
+	}
+	fclose(file);
+	return goldens;
+}
+
+static void write_goldens(const char* filename, const suite_golden_t* goldens, unsigned count)
+{
+	unsigned i, c, s;
+	FILE* file = fopen(filename, "w");
+	if (!file)
+	{
+		printf("Couldn't write %s\n", filename);
+		return;
+	}
+
+	fprintf(file, "# cute_dsp golden outputs, regenerate with ./cute_dsp_suite --bless\n");
+	fprintf(file, "# case <name> <channels> <frames>, then rms mean peak for %d segments per channel\n", SUITE_SEGMENTS);
+	for (i = 0; i < count; ++i)
+	{
+		fprintf(file, "case %s %u %u\n", goldens[i].name, goldens[i].channel_count, goldens[i].frames);
+		for (c = 0; c < goldens[i].channel_count; ++c)
+			for (s = 0; s < SUITE_SEGMENTS; ++s)
+				fprintf(file, "%.7g %.7g %.7g\n", goldens[i].segments[c][s].rms, goldens[i].segments[c][s].mean, goldens[i].segments[c][s].peak);
+	}
+	fclose(file);
+}
+
+static const suite_golden_t* find_golden(const suite_golden_t* goldens, unsigned count, const char* name)
+{
+	unsigned i;
+	for (i = 0; i < count; ++i)
+		if (!strcmp(goldens[i].name, name))
+			return goldens + i;
+	return NULL;
+}
+/* END GOLDEN OUTPUTS */
+
+/* BEGIN MAIN */
+int main(int argc, char** argv)
+{
+	int bless = 0, repeats = 1, i;
+	const char* filter = NULL;
+	const char* csv_path = NULL;
+	FILE* csv = NULL;
+	unsigned f, t, r, c, s, golden_count, result_count = 0, passed = 0, failed = 0, missing = 0;
+	suite_golden_t* goldens;
+	suite_golden_t* results;
+
+	for (i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--bless"))
+			bless = 1;
+		else if (!strcmp(argv[i], "--bench") && i + 1 < argc)
+			repeats = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--csv") && i + 1 < argc)
+			csv_path = argv[++i];
+		else
+			filter = argv[i];
+	}
+	if (repeats < 1)
+		repeats = 1;
+
+	goldens = read_goldens(SUITE_GOLDEN_FILE, &golden_count);
+	results = (suite_golden_t*)malloc(sizeof(suite_golden_t) * SUITE_CASE_COUNT * SUITE_FILE_COUNT);
+	if (csv_path)
+	{
+		csv = fopen(csv_path, "w");
+		if (csv)
+			fprintf(csv, "case,status,seconds,msamples_per_second,realtime_factor\n");
+	}
+
+	printf("%-48s %-8s %12s %12s\n", "case", "status", "Msamples/s", "x realtime");
+	for (f = 0; f < SUITE_FILE_COUNT; ++f)
+	{
+		suite_audio_t input;
+		float* output[SUITE_MAX_CHANNELS] = { 0 };
+		if (!load_audio(suite_files[f], &input))
+		{
+			printf("Couldn't load %s, run the suite from the test folder.\n", suite_files[f]);
+			return 1;
+		}
+		for (c = 0; c < input.channel_count; ++c)
+			output[c] = (float*)malloc(sizeof(float) * input.frames);
+
+		for (t = 0; t < SUITE_CASE_COUNT; ++t)
+		{
+			char name[128];
+			double best = 0.0, samples;
+			const char* status;
+			const suite_golden_t* golden;
+			suite_golden_t* result = results + result_count;
+
+			snprintf(name, sizeof(name), "%s/%s", suite_files[f], suite_cases[t].name);
+			if (filter && !strstr(name, filter))
+				continue;
+
+			for (r = 0; r < (unsigned)repeats; ++r)
+			{
+				double start = time_in_seconds(), elapsed;
+				render_case(suite_cases + t, &input, output);
+				elapsed = time_in_seconds() - start;
+				if (r == 0 || elapsed < best)
+					best = elapsed;
+			}
+
+			memset(result, 0, sizeof(suite_golden_t));
+			strcpy(result->name, name);
+			fingerprint(output, input.channel_count, input.frames, result);
+			++result_count;
+
+			golden = find_golden(goldens, golden_count, name);
+			if (bless)
+				status = "blessed";
+			else if (!golden)
+				status = "MISSING", ++missing;
+			else if (compare_fingerprints(result, golden))
+				status = "ok", ++passed;
+			else
+				status = "FAILED", ++failed;
+
+			samples = (double)input.frames * input.channel_count;
+			printf("%-48s %-8s %12.2f %12.1f\n", name, status, samples / best * 1e-6, input.frames / input.sampling_rate / best);
+
+			// convolution scales with the length of the impulse response, so also report its cost per second of it
+			for (s = 0; s < SUITE_MAX_STAGES; ++s)
+				if (suite_cases[t].stages[s].effect == SUITE_CONVOLUTION)
+					printf("%-48s %8.3f%% of a core per channel and impulse response second\n", "", 100.0 * best / (samples / input.sampling_rate) / suite_cases[t].stages[s].a);
+			if (csv)
+				fprintf(csv, "%s,%s,%.9f,%.3f,%.2f\n", name, status, best, samples / best * 1e-6, input.frames / input.sampling_rate / best);
+		}
+
+		for (c = 0; c < input.channel_count; ++c)
+			free(output[c]);
+		release_audio(&input);
+	}
+
+	if (csv)
+		fclose(csv);
+
+	if (bless)
+	{
+		// keep the goldens of the cases the filter skipped
+		unsigned total = result_count;
+		results = (suite_golden_t*)realloc(results, sizeof(suite_golden_t) * (result_count + golden_count));
+		for (t = 0; t < golden_count; ++t)
+			if (!find_golden(results, result_count, goldens[t].name))
+				results[total++] = goldens[t];
+		write_goldens(SUITE_GOLDEN_FILE, results, total);
+		printf("\nBlessed %u cases into %s\n", result_count, SUITE_GOLDEN_FILE);
+	}
+	else
+	{
+		printf("\n%u passed, %u failed, %u missing\n", passed, failed, missing);
+	}
+
+	free(results);
+	free(goldens);
+	return failed || missing ? 1 : 0;
+}
+/* END MAIN */
+
+/*
+	------------------------------------------------------------------------------
+	This software is available under 2 licenses - you may choose the one you like.
+	------------------------------------------------------------------------------
+	ALTERNATIVE A - zlib license
+	Copyright (c) 2019 Matthew Rosen
+	This software is provided 'as-is', without any express or implied warranty.
+	In no event will the authors be held liable for any damages arising from
+	the use of this software.
+	Permission is granted to anyone to use this software for any purpose,
+	including commercial applications, and to alter it and redistribute it
+	freely, subject to the following restrictions:
+	  1. The origin of this software must not be misrepresented; you must not
+		 claim that you wrote the original software. If you use this software
+		 in a product, an acknowledgment in the product documentation would be
+		 appreciated but is not required.
+	  2. Altered source versions must be plainly marked as such, and must not
+		 be misrepresented as being the original software.
+	  3. This notice may not be removed or altered from any source distribution.
+	------------------------------------------------------------------------------
+	ALTERNATIVE B - Public Domain (www.unlicense.org)
+	This is free and unencumbered software released into the public domain.
+	Anyone is free to copy, modify, publish, use, compile, sell, or distribute this
+	software, either in source code form or as a compiled binary, for any purpose,
+	commercial or non-commercial, and by any means.
+	In jurisdictions that recognize copyright laws, the author or authors of this
+	software dedicate any and all copyright interest in the software to the public
+	domain. We make this dedication for the benefit of the public at large and to
+	the detriment of our heirs and successors. We intend this dedication to be an
+	overt act of relinquishment in perpetuity of all present and future rights to
+	this software under copyright law.
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+	ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+	WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+	------------------------------------------------------------------------------
+*/
+
@@ -11,9 +11,10 @@
 
     To run:
 
-        ./cute_dsp_test <test_num>
+        ./cute_dsp_test <test_num> [capture_file]
 
 		<test_num> = 0 for lowpass, 1 for highpass, 2 for echo, 3 for noise
+		[capture_file] = optional path to record the session to, for use with cute_dsp_replay
 
 		More testing options will be added later as new features and tools become available.
 		
@@ -71,6 +72,14 @@ int input_get_key_triggered(int key)
 /* BEGIN INTEGRATION TEST */
 #define PLAYING_POOL_SIZE 10
 
+static const char* g_capture_path = NULL;
+
+static void begin_capture(cd_context_t* dsp_ctx)
+{
+	if (g_capture_path && !cd_begin_capture(dsp_ctx, g_capture_path, 1))
+		printf("Couldn't open capture file %s\n", g_capture_path);
+}
+
 static void lowpass_test(void)
 {
 	unsigned frequency = 44100; // a good standard frequency for playing commonly saved OGG + wav files
@@ -92,10 +101,19 @@ static void lowpass_test(void)
 	context_definition.use_lowpass = 1;
 	context_definition.use_echo = 0;
 	context_definition.use_noise = 1;
+	context_definition.use_reverb = 0;
+	context_definition.use_chorus = 0;
 	context_definition.echo_max_delay_s = 0.f;
 	context_definition.rand_seed = 2;
+	context_definition.render_cache_bytes = 0;
+	context_definition.filter_order = 0;
+	context_definition.filter_alignment = CD_FILTER_BUTTERWORTH;
+	context_definition.multirate_limit = 0;
+	context_definition.cpu_budget = 0.f;
+	context_definition.quality_tier = CD_TIER_FULL;
 	cd_context_t* dsp_ctx = cd_make_context(sound_ctx, context_definition);
 	CUTE_DSP_ASSERT(dsp_ctx);
+	begin_capture(dsp_ctx);
 
 	// load audio files
 	cs_loaded_sound_t music1 = cs_load_wav("music2.wav");
@@ -135,6 +153,7 @@ static void lowpass_test(void)
 	for (;;)
 	{
 		input_update();
+		cd_flush_capture(dsp_ctx);
 
 		// if user ever presses escape, break out
 		if (GetAsyncKeyState(VK_ESCAPE))
@@ -261,10 +280,19 @@ static void highpass_test(void)
 	context_definition.use_lowpass = 0;
 	context_definition.use_echo = 0;
 	context_definition.use_noise = 1;
+	context_definition.use_reverb = 0;
+	context_definition.use_chorus = 0;
 	context_definition.echo_max_delay_s = 0.f;
 	context_definition.rand_seed = 2;
+	context_definition.render_cache_bytes = 0;
+	context_definition.filter_order = 0;
+	context_definition.filter_alignment = CD_FILTER_BUTTERWORTH;
+	context_definition.multirate_limit = 0;
+	context_definition.cpu_budget = 0.f;
+	context_definition.quality_tier = CD_TIER_FULL;
 	cd_context_t* dsp_ctx = cd_make_context(sound_ctx, context_definition);
 	CUTE_DSP_ASSERT(dsp_ctx);
+	begin_capture(dsp_ctx);
 
 	// load audio files
 	cs_loaded_sound_t music1 = cs_load_wav("music2.wav");
@@ -301,6 +329,7 @@ static void highpass_test(void)
 	for (;;)
 	{
 		input_update();
+		cd_flush_capture(dsp_ctx);
 
 		// if user ever presses escape, break out
 		if (GetAsyncKeyState(VK_ESCAPE))
@@ -403,10 +432,19 @@ static void echo_test(void)
 	context_definition.use_lowpass = 0;
 	context_definition.use_echo = 1;
 	context_definition.use_noise = 1;
+	context_definition.use_reverb = 1;
+	context_definition.use_chorus = 0;
 	context_definition.echo_max_delay_s = 0.f;
 	context_definition.rand_seed = 2;
+	context_definition.render_cache_bytes = 32 * 1024 * 1024; // stingers replay their cached echo
+	context_definition.filter_order = 0;
+	context_definition.filter_alignment = CD_FILTER_BUTTERWORTH;
+	context_definition.multirate_limit = 0;
+	context_definition.cpu_budget = 0.f;
+	context_definition.quality_tier = CD_TIER_FULL;
 	cd_context_t* dsp_ctx = cd_make_context(sound_ctx, context_definition);
 	CUTE_DSP_ASSERT(dsp_ctx);
+	begin_capture(dsp_ctx);
 
 	// load audio files
 	cs_loaded_sound_t music1 = cs_load_wav("music2.wav");
@@ -433,6 +471,8 @@ static void echo_test(void)
 	printf(" '6' to decrease the echo feedback.\n");
 	printf(" 'E' to increase background noise amplitude DB and \n");
 	printf(" 'Q' to decrease background noise amplitude DB.\n");
+	printf(" 'R' to increase the reverb send and \n");
+	printf(" 'F' to decrease the reverb send.\n");
 	printf("-Pressing 'A' will prompt you to pick parameters\n");
 	printf(" for stinger1, which will then play with those coefficients.\n");
 	printf("-Pressing 'D' will prompt you to pick parameters\n");
@@ -440,7 +480,13 @@ static void echo_test(void)
 	printf("\n-To quit, press ESCAPE\n");
 	printf("--------------------\n\n");
 
+	// the shared reverb is heard through its looped return sound
+	cs_play_sound_def_t reverb_def = cs_make_def(cd_get_reverb_return(dsp_ctx));
+	reverb_def.looped = 1;
+	cs_play_sound(sound_ctx, reverb_def);
+
 	cs_playing_sound_t* music_sound = cs_play_sound(sound_ctx, def0);
+	float music_reverb = cd_get_reverb_send(music_sound);
 	float music_mix = cd_get_echo_mix(music_sound);
 	float music_feedback = cd_get_echo_feedback(music_sound);
 	float music_delay = cd_get_echo_delay(music_sound);
@@ -449,6 +495,8 @@ static void echo_test(void)
 	for (;;)
 	{
 		input_update();
+		cd_flush_capture(dsp_ctx);
+		cd_update_render_cache(dsp_ctx, 44100); // about a second of audio per frame
 
 		// if user ever presses escape, break out
 		if (GetAsyncKeyState(VK_ESCAPE))
@@ -515,6 +563,20 @@ static void echo_test(void)
 			cd_set_noise_amplitude_db(music_sound, music_noise);
 		}
 
+		if (input_get_key_released('R'))
+		{
+			music_reverb += 0.05f;
+			printf("New music reverb send: %f\n", music_reverb);
+			cd_set_reverb_send(music_sound, music_reverb);
+		}
+
+		if (input_get_key_released('F'))
+		{
+			music_reverb -= 0.05f;
+			printf("New music reverb send: %f\n", music_reverb);
+			cd_set_reverb_send(music_sound, music_reverb);
+		}
+
 		if (input_get_key_released('A'))
 		{
 			float delay = 0.f;
@@ -535,6 +597,8 @@ static void echo_test(void)
 			cd_set_echo_feedback(stinger_sound, feedback);
 			cd_set_echo_mix(stinger_sound, mix);
 			cd_set_noise_amplitude_db(stinger_sound, db);
+			if (cd_use_render_cache(stinger_sound))
+				printf("(from the render cache)\n");
 		}
 
 		if (input_get_key_released('D'))
@@ -557,6 +621,8 @@ static void echo_test(void)
 			cd_set_echo_feedback(stinger_sound, feedback);
 			cd_set_echo_mix(stinger_sound, mix);
 			cd_set_noise_amplitude_db(stinger_sound, db);
+			if (cd_use_render_cache(stinger_sound))
+				printf("(from the render cache)\n");
 		}
 	}
 
@@ -591,10 +657,19 @@ static void noise_test(void)
 	context_definition.use_lowpass = 0;
 	context_definition.use_echo = 0;
 	context_definition.use_noise = 1;
+	context_definition.use_reverb = 0;
+	context_definition.use_chorus = 0;
 	context_definition.echo_max_delay_s = 0.f;
 	context_definition.rand_seed = 2;
+	context_definition.render_cache_bytes = 0;
+	context_definition.filter_order = 0;
+	context_definition.filter_alignment = CD_FILTER_BUTTERWORTH;
+	context_definition.multirate_limit = 0;
+	context_definition.cpu_budget = 0.f;
+	context_definition.quality_tier = CD_TIER_FULL;
 	cd_context_t* dsp_ctx = cd_make_context(sound_ctx, context_definition);
 	CUTE_DSP_ASSERT(dsp_ctx);
+	begin_capture(dsp_ctx);
 
 	// load audio files
 	cs_loaded_sound_t music1 = cs_load_wav("music2.wav");
@@ -631,6 +706,7 @@ static void noise_test(void)
 	for (;;)
 	{
 		input_update();
+		cd_flush_capture(dsp_ctx);
 
 		// if user ever presses escape, break out
 		if (GetAsyncKeyState(VK_ESCAPE))
@@ -712,18 +788,22 @@ test_func tests[] = {
 int main(int argc, char** argv)
 {
 	// usage
-	if (argc != 2)
+	if (argc != 2 && argc != 3)
 	{
 		printf("Invalid number of arguments!\n");
 		printf("Usage: \n");
-		printf("    ./cute_dsp_test <test_num>\n");
+		printf("    ./cute_dsp_test <test_num> [capture_file]\n");
 		printf("    <test_num> = 0 for lowpass test,\n");
 		printf("                 1 for highpass test,\n");
 		printf("                 2 for echo test\n");
-		printf("                 3 for noise test\n\n");
+		printf("                 3 for noise test\n");
+		printf("    [capture_file] = records the session for cute_dsp_replay\n\n");
 		return 1;
 	}
 
+	if (argc == 3)
+		g_capture_path = argv[2];
+
 	int test_num = atoi(argv[1]);
 	input_init();
 	tests[test_num]();